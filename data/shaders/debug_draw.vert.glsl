@@ -0,0 +1,32 @@
+#version 460 core
+
+layout(location = 0) in vec3 a_pos;
+
+layout(location = 0) out vec3 v_color;
+
+layout(binding = 0, std140) uniform UBO0
+{
+  mat4 viewProj;
+};
+
+struct DebugInstance
+{
+  mat4 transform;
+  vec4 color;
+};
+
+layout(binding = 0, std430) readonly buffer DebugInstances
+{
+  DebugInstance instances[];
+};
+
+void main()
+{
+  // Every shape type is one draw of the multi draw, gl_BaseInstance is where its instances start
+  DebugInstance instance = instances[gl_BaseInstance + gl_InstanceID];
+
+  // w is only not 1 for frustums, which are drawn through an inverse projection
+  vec4 world = instance.transform * vec4(a_pos, 1.0);
+  gl_Position = viewProj * vec4(world.xyz / world.w, 1.0);
+  v_color = instance.color.rgb;
+}
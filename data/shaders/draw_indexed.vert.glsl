@@ -12,6 +12,8 @@ layout(location = 1) out vec3 v_normal;
 layout(location = 2) out vec2 v_uv;
 layout(location = 3) out vec3 v_eye;
 layout(location = 4) out vec3 v_position;
+// For the pick pass, which object this is
+layout(location = 5) flat out uint v_object;
 
 
 
@@ -32,9 +34,16 @@ layout(binding = 1, std430) readonly buffer SSBO0
   ObjectUniforms objects[];
 };
 
+// Written by gpu_cull.comp.glsl, only the objects that survived culling
+layout(binding = 2, std430) readonly buffer SSBO1
+{
+  uint instanceIndices[];
+};
+
 void main()
 {
-  int i = gl_InstanceID;
+  uint i = instanceIndices[gl_BaseInstance + gl_InstanceID];
+  v_object = i;
   v_position = (objects[i].model * vec4(a_pos, 1.0)).xyz;
   v_normal = normalize(inverse(transpose(mat3(objects[i].model))) * a_normal);
   v_uv = a_uv;
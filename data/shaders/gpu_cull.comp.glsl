@@ -0,0 +1,187 @@
+#version 460 core
+
+// Tests every object against the frustum and, when there is one, last frame's Hi-Z pyramid, then appends the
+// visible ones to their mesh's range of the instance indices. gpu_cull_compact.comp.glsl turns the counts into
+// the indirect draws afterwards. The occlusion test is the same as HiZ.cpp on the CPU
+
+layout(local_size_x = 64) in;
+
+const uint CULL_HIDDEN = 1u;
+
+struct CullObject
+{
+  vec3 center;
+  float radius;
+  vec3 halfExtents;
+  uint meshIndex;
+  uint objectIndex;
+  uint flags;
+  uint padding0;
+  uint padding1;
+};
+
+struct DrawCommand
+{
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout(binding = 0, std140) uniform CullUniforms
+{
+  vec4 planes[6];
+  mat4 hizViewProj;
+  vec2 hizSize;
+  uint hizMipCount;
+  uint hizEnabled;
+  uint objectCount;
+  uint meshCount;
+};
+
+layout(binding = 0, std430) readonly buffer Objects
+{
+  CullObject objects[];
+};
+
+layout(binding = 1, std430) buffer Commands
+{
+  DrawCommand commands[];
+};
+
+layout(binding = 2, std430) writeonly buffer InstanceIndices
+{
+  uint instanceIndices[];
+};
+
+layout(binding = 3, std430) buffer DrawCount
+{
+  uint drawCount;
+};
+
+// Zeroed by the CPU before every cull, read back a few frames later
+layout(binding = 5, std430) buffer CullStats
+{
+  uint visibleCount;
+  uint frustumCulledCount;
+  uint occlusionCulledCount;
+};
+
+// Farthest depth of last frame in every mip
+layout(binding = 0) uniform sampler2D s_hiz;
+
+bool IsVisible(CullObject object)
+{
+  for (int i = 0; i < 6; ++i)
+  {
+    float distance = dot(planes[i].xyz, object.center) + planes[i].w;
+    if (distance < -object.radius)
+    {
+      return false;
+    }
+
+    // How far the box reaches towards the plane
+    float boxRadius = dot(abs(planes[i].xyz), object.halfExtents);
+    if (distance < -boxRadius)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool IsOccluded(CullObject object)
+{
+  if (hizEnabled == 0u)
+  {
+    return false;
+  }
+
+  vec2 uvMin = vec2(1.0);
+  vec2 uvMax = vec2(0.0);
+  float nearest = 1.0;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    vec3 side = vec3((corner & 1) != 0 ? 1.0 : -1.0, (corner & 2) != 0 ? 1.0 : -1.0, (corner & 4) != 0 ? 1.0 : -1.0);
+    vec4 clip = hizViewProj * vec4(object.center + object.halfExtents * side, 1.0);
+
+    // Behind the camera last frame, nothing to compare against
+    if (clip.w <= 1e-5)
+    {
+      return false;
+    }
+
+    vec3 ndc = clip.xyz / clip.w;
+    vec2 uv = ndc.xy * 0.5 + 0.5;
+    uvMin = min(uvMin, uv);
+    uvMax = max(uvMax, uv);
+    nearest = min(nearest, ndc.z * 0.5 + 0.5);
+  }
+
+  uvMin = clamp(uvMin, vec2(0.0), vec2(1.0));
+  uvMax = clamp(uvMax, vec2(0.0), vec2(1.0));
+  if (any(greaterThan(uvMin, uvMax)))
+  {
+    return false;
+  }
+
+  // Smallest mip where the rectangle is at most a texel across
+  vec2 sizePx = (uvMax - uvMin) * hizSize;
+  uint mip = min(uint(ceil(log2(max(max(sizePx.x, sizePx.y), 1.0)))), hizMipCount - 1u);
+
+  ivec2 levelSize = textureSize(s_hiz, int(mip));
+  ivec2 texelMin = min(ivec2(uvMin * vec2(levelSize)), levelSize - 1);
+  ivec2 texelMax = min(ivec2(uvMax * vec2(levelSize)), levelSize - 1);
+
+  float farthest = 0.0;
+  for (int y = texelMin.y; y <= texelMax.y; ++y)
+  {
+    for (int x = texelMin.x; x <= texelMax.x; ++x)
+    {
+      farthest = max(farthest, texelFetch(s_hiz, ivec2(x, y), int(mip)).r);
+    }
+  }
+
+  return nearest > farthest;
+}
+
+void main()
+{
+  uint index = gl_GlobalInvocationID.x;
+
+  // Last frame's draw has read it by now, the compact pass counts it up again
+  if (index == 0)
+  {
+    drawCount = 0;
+  }
+
+  if (index >= objectCount)
+  {
+    return;
+  }
+
+  CullObject object = objects[index];
+  if ((object.flags & CULL_HIDDEN) != 0u)
+  {
+    return;
+  }
+
+  if (!IsVisible(object))
+  {
+    atomicAdd(frustumCulledCount, 1u);
+    return;
+  }
+
+  if (IsOccluded(object))
+  {
+    atomicAdd(occlusionCulledCount, 1u);
+    return;
+  }
+
+  atomicAdd(visibleCount, 1u);
+
+  uint slot = atomicAdd(commands[object.meshIndex].instanceCount, 1u);
+  instanceIndices[commands[object.meshIndex].baseInstance + slot] = object.objectIndex;
+}
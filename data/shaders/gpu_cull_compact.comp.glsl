@@ -0,0 +1,61 @@
+#version 460 core
+
+// Copies the meshes that have anything visible into a tightly packed list for glMultiDrawElementsIndirectCount
+
+layout(local_size_x = 64) in;
+
+struct DrawCommand
+{
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout(binding = 0, std140) uniform CullUniforms
+{
+  vec4 planes[6];
+  mat4 hizViewProj;
+  vec2 hizSize;
+  uint hizMipCount;
+  uint hizEnabled;
+  uint objectCount;
+  uint meshCount;
+};
+
+layout(binding = 1, std430) buffer Commands
+{
+  DrawCommand commands[];
+};
+
+layout(binding = 3, std430) buffer DrawCount
+{
+  uint drawCount;
+};
+
+layout(binding = 4, std430) writeonly buffer Draws
+{
+  DrawCommand draws[];
+};
+
+void main()
+{
+  uint mesh = gl_GlobalInvocationID.x;
+  if (mesh >= meshCount)
+  {
+    return;
+  }
+
+  DrawCommand command = commands[mesh];
+
+  // Ready for the next frame's cull pass
+  commands[mesh].instanceCount = 0u;
+
+  if (command.instanceCount == 0u)
+  {
+    return;
+  }
+
+  draws[atomicAdd(drawCount, 1u)] = command;
+}
@@ -0,0 +1,19 @@
+#version 460 core
+
+// Copies the depth buffer into mip 0 of the Hi-Z pyramid, hiz_downsample.comp.glsl builds the rest
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D s_depth;
+layout(binding = 0, r32f) uniform restrict writeonly image2D i_dst;
+
+void main()
+{
+  ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+  if (any(greaterThanEqual(texel, imageSize(i_dst))))
+  {
+    return;
+  }
+
+  imageStore(i_dst, texel, vec4(texelFetch(s_depth, texel, 0).r));
+}
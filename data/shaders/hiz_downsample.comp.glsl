@@ -0,0 +1,43 @@
+#version 460 core
+
+// Halves one level of the Hi-Z pyramid keeping the farthest depth. Same as HiZ::Downsample on the CPU
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0, r32f) uniform restrict readonly image2D i_src;
+layout(binding = 1, r32f) uniform restrict writeonly image2D i_dst;
+
+void main()
+{
+  ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+  ivec2 dstSize = imageSize(i_dst);
+  if (any(greaterThanEqual(texel, dstSize)))
+  {
+    return;
+  }
+
+  ivec2 srcSize = imageSize(i_src);
+  ivec2 first = texel * 2;
+  ivec2 last = min(first + 1, srcSize - 1);
+
+  // Odd sizes fold the leftover row or column into the last texel
+  if (texel.x == dstSize.x - 1)
+  {
+    last.x = srcSize.x - 1;
+  }
+  if (texel.y == dstSize.y - 1)
+  {
+    last.y = srcSize.y - 1;
+  }
+
+  float farthest = 0.0;
+  for (int y = first.y; y <= last.y; ++y)
+  {
+    for (int x = first.x; x <= last.x; ++x)
+    {
+      farthest = max(farthest, imageLoad(i_src, ivec2(x, y)).r);
+    }
+  }
+
+  imageStore(i_dst, texel, vec4(farthest));
+}
@@ -0,0 +1,17 @@
+#version 460 core
+
+// Object ids for the mouse pick pass, see Albuquerque/GpuPicking.hpp. The kind
+// goes in the top 8 bits, 0 is left for nothing
+
+layout(location = 5) flat in uint v_object;
+layout(location = 0) out uint o_id;
+
+layout(binding = 3, std140) uniform PickUBO
+{
+  uint kind;
+};
+
+void main()
+{
+  o_id = (kind << 24) | v_object;
+}
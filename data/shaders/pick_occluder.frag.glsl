@@ -0,0 +1,11 @@
+#version 460 core
+
+// For things that can't be picked but still hide what's behind them, like the
+// terrain
+
+layout(location = 0) out uint o_id;
+
+void main()
+{
+  o_id = 0u;
+}
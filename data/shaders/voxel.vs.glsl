@@ -25,9 +25,15 @@ layout(binding = 1, std430) readonly buffer SSBO0
   ObjectUniforms objects[];
 };
 
+// Written by gpu_cull.comp.glsl, only the voxels that survived culling
+layout(binding = 2, std430) readonly buffer SSBO1
+{
+  uint instanceIndices[];
+};
+
 void main()
 {
-  int i = gl_InstanceID + gl_BaseInstance;
+  uint i = instanceIndices[gl_BaseInstance + gl_InstanceID];
 
   v_position =  (objects[i].model * vec4(a_pos, 1.0)).xyz;
   gl_Position =  viewProj * objects[i].model * vec4(a_pos, 1.0);
@@ -1,4 +1,10 @@
 #include <Albuquerque/Application.hpp>
+#include <Albuquerque/FrameCapture.hpp>
+#include <Albuquerque/TripleBuffer.hpp>
+#include <Albuquerque/JobSystem.hpp>
+#include <Albuquerque/Memory.hpp>
+#include <Albuquerque/Profiler.hpp>
+#include <Albuquerque/UniformRing.hpp>
 
 //Release mode can disable it
 #include <spdlog/spdlog.h>
@@ -14,31 +20,116 @@
 
 #include <iostream>
 #include <string>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
 
 #include <Fwog/Context.h>
 #include <Fwog/DebugMarker.h>
 
 namespace Albuquerque
 {
-    
+    //ImGui reuses its draw lists every frame so the render thread gets its own copy
+    struct UiDrawSnapshot
+    {
+        std::vector<std::unique_ptr<ImDrawList>> draw_lists;
+        std::vector<ImDrawList*> draw_list_pointers;
+        ImDrawData draw_data;
+        bool valid = false;
+
+        void CopyFrom(ImDrawData const* source)
+        {
+            valid = source != nullptr && source->Valid;
+            if (!valid)
+                return;
+
+            //Grows once to the most lists ImGui has used, after that the ImVector copies reuse their capacity
+            while (draw_lists.size() < static_cast<size_t>(source->CmdListsCount))
+            {
+                draw_lists.push_back(std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData()));
+            }
+
+            draw_list_pointers.clear();
+            for (int i = 0; i < source->CmdListsCount; ++i)
+            {
+                ImDrawList const* source_list = source->CmdLists[i];
+                ImDrawList* list = draw_lists[i].get();
+                list->CmdBuffer = source_list->CmdBuffer;
+                list->IdxBuffer = source_list->IdxBuffer;
+                list->VtxBuffer = source_list->VtxBuffer;
+                list->Flags = source_list->Flags;
+                draw_list_pointers.push_back(list);
+            }
+
+            draw_data = *source;
+            draw_data.CmdLists = draw_list_pointers.data();
+        }
+    };
 
-    void Application::Run()
+    struct Application::PipelineState
+    {
+        std::thread render_thread;
+
+        std::mutex mutex;
+        std::condition_variable frame_published;
+        uint64_t published_frames = 0;
+        bool stop = false;
+
+        TripleBuffer<UiDrawSnapshot> ui_snapshots;
+    };
+
+    Application::Application()
+    {
+        //Create the shared job pool now so the main thread is always worker 0
+        JobSystem::Instance();
+    }
+    Application::~Application() = default;
+
+    int Application::Run()
     {
-        FrameMarkStart("App Run");
         if (!Initialize())
         {
-            return;
+            return 1;
         }
 
         spdlog::info("App: Initialized");
 
         if (!Load())
         {
-            return;
+            return 1;
         }
 
         spdlog::info("App: Loaded");
 
+        if (!StartInput())
+        {
+            return 1;
+        }
+
+        if (headless_settings.enabled)
+        {
+            int exit_code = RunHeadless();
+
+            FinishBenchmark();
+            Unload();
+            return exit_code;
+        }
+
+        if (pipelined_rendering)
+        {
+            RunPipelined();
+            FinishBenchmark();
+
+            spdlog::info("App: Unloading");
+            Unload();
+            spdlog::info("App: Unloaded");
+            return 0;
+        }
+
         double prevFrame = glfwGetTime();
         while (!glfwWindowShouldClose(_windowHandle))
         {
@@ -46,18 +137,473 @@ namespace Albuquerque
             double dt = curFrame - prevFrame;
             prevFrame = curFrame;
 
+            BeginFrameMemory();
+
+            profiler->BeginFrame();
+            uniform_ring->BeginFrame();
 
-            glfwPollEvents();
-            Update(dt);
+            {
+                ALBUQUERQUE_PROFILE_CPU("Simulation");
+                glfwPollEvents();
+                dt = BeginFrameInput(dt);
+                EndFrameInput(dt, RunFixedUpdates(dt));
+                Update(dt);
+            }
             Render(dt);
+
+            uniform_ring->EndFrame();
+            profiler->EndFrame();
+
+            {
+                ZoneScopedN("Swap");
+                glfwSwapBuffers(_windowHandle);
+            }
+            FrameMark;
+
+            if (replaying && input_replay.Finished())
+                Close();
+
+            frame_pacer.WaitForNextFrame();
         }
 
+        FinishBenchmark();
         spdlog::info("App: Unloading");
 
         Unload();
 
         spdlog::info("App: Unloaded");
-        FrameMarkEnd("App Run");
+        return 0;
+    }
+
+    uint32_t Application::RunFixedUpdates(double dt)
+    {
+        ALBUQUERQUE_PROFILE_CPU("Fixed Update");
+        uint32_t steps = fixed_timestep.Advance(dt);
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            FixedUpdate(fixed_timestep.StepDt());
+        }
+        return steps;
+    }
+
+    bool Application::StartInput()
+    {
+        if (!input_settings.replay_path.empty())
+        {
+            if (!input_replay.Open(input_settings.replay_path))
+                return false;
+
+            //Any other rate splits the same frames into different ticks
+            if (input_replay.TickRate() != fixed_timestep.TickRate())
+            {
+                spdlog::error("Input: Recording is at {} Hz but the app runs at {} Hz", input_replay.TickRate(), fixed_timestep.TickRate());
+                return false;
+            }
+            replaying = true;
+        }
+
+        if (!input_settings.record_path.empty() && !input_recorder.Open(input_settings.record_path, fixed_timestep.TickRate()))
+            return false;
+
+        if (input_settings.benchmark)
+        {
+            spdlog::info("App: Benchmarking {} frames of {}", input_replay.FrameCount(), input_settings.replay_path);
+            frame_pacer.SetTargetFps(0.0);
+            glfwSwapInterval(0);
+            profiler->StartRecording();
+        }
+
+        return true;
+    }
+
+    double Application::BeginFrameInput(double dt)
+    {
+        if (replaying)
+        {
+            InputFrame frame;
+            if (!input_replay.NextFrame(frame))
+                return 0.0;
+
+            current_input = frame.state;
+            replay_expected_steps = frame.steps;
+            return frame.dt;
+        }
+
+        //Every key GLFW knows, it is a few hundred array reads
+        for (int32_t key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; ++key)
+        {
+            current_input.SetKey(key, glfwGetKey(_windowHandle, key) == GLFW_PRESS);
+        }
+        for (int32_t button = 0; button <= GLFW_MOUSE_BUTTON_LAST; ++button)
+        {
+            current_input.SetMouseButton(button, glfwGetMouseButton(_windowHandle, button) == GLFW_PRESS);
+        }
+        glfwGetCursorPos(_windowHandle, &current_input.mouse_x, &current_input.mouse_y);
+
+        return dt;
+    }
+
+    void Application::EndFrameInput(double dt, uint32_t steps)
+    {
+        if (input_recorder.IsOpen())
+            input_recorder.WriteFrame(InputFrame{dt, steps, current_input});
+
+        if (replaying && steps != replay_expected_steps && !replay_diverged)
+        {
+            replay_diverged = true;
+            spdlog::warn("Input: Frame {} ran {} ticks but the recording has {}, the replay no longer matches", input_replay.FramesPlayed() - 1,
+                steps, replay_expected_steps);
+        }
+    }
+
+    void Application::FinishBenchmark()
+    {
+        input_recorder.Close();
+        if (!input_settings.benchmark)
+            return;
+
+        //Waits for the last frames so their GPU zones make it into the report
+        glFinish();
+        profiler->ResolvePendingGpuFrames();
+        profiler->StopRecording();
+        profiler->ExportJson(input_settings.benchmark_report_path);
+
+        Profiler::Percentiles percentiles = profiler->FrameTimePercentiles();
+        spdlog::info("App: Benchmark played {} of {} frames, last {} frames p50 {:.3f} ms p95 {:.3f} ms p99 {:.3f} ms", input_replay.FramesPlayed(),
+            input_replay.FrameCount(), std::min<size_t>(profiler->RecordedFrames(), 512), percentiles.p50, percentiles.p95, percentiles.p99);
+        if (replay_diverged)
+            spdlog::warn("App: The replay diverged, these timings are not from the recorded run");
+    }
+
+    void Application::BeginFrameMemory()
+    {
+        last_frame_allocations = MemoryTracking::EndFrame();
+        last_frame_arena_bytes = frame_arena.Used();
+        frame_arena.Reset();
+
+        TracyPlot("Heap Allocations", static_cast<int64_t>(last_frame_allocations.allocations));
+        TracyPlot("Heap Bytes", static_cast<int64_t>(last_frame_allocations.bytes));
+        TracyPlot("Frame Arena Bytes", static_cast<int64_t>(last_frame_arena_bytes));
+    }
+
+    void Application::RenderMemoryStatsUI()
+    {
+        ImGui::Begin("Memory");
+
+        if (MemoryTracking::IsEnabled())
+        {
+            AllocationStats totals = MemoryTracking::Totals();
+            ImGui::Text("Heap allocations last frame: %llu", static_cast<unsigned long long>(last_frame_allocations.allocations));
+            ImGui::Text("Heap bytes last frame: %llu", static_cast<unsigned long long>(last_frame_allocations.bytes));
+            ImGui::Text("Heap frees last frame: %llu", static_cast<unsigned long long>(last_frame_allocations.frees));
+            ImGui::Text("Live heap allocations: %llu", static_cast<unsigned long long>(totals.allocations - totals.frees));
+        }
+        else
+        {
+            ImGui::TextUnformatted("Heap tracking is off (ALBUQUERQUE_TRACK_ALLOCATIONS)");
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Frame arena: %zu / %zu KB", last_frame_arena_bytes / 1024, frame_arena.Capacity() / 1024);
+        ImGui::Text("Frame arena high water: %zu KB", frame_arena.HighWater() / 1024);
+
+        //The render thread owns the ring in pipelined mode
+        if (!pipelined_rendering)
+        {
+            UniformRing::Stats const& ring_stats = uniform_ring->GetStats();
+            ImGui::Separator();
+            ImGui::Text("Uniform ring: %zu / %zu KB last frame, %u frames in flight", ring_stats.last_frame_bytes / 1024, uniform_ring->BytesPerFrame() / 1024, uniform_ring->FramesInFlight());
+            ImGui::Text("Fence waits: %llu Stalls: %llu (%.3f ms total, %.3f ms last)", static_cast<unsigned long long>(ring_stats.fence_waits),
+                static_cast<unsigned long long>(ring_stats.stalls), ring_stats.stall_ms, ring_stats.last_stall_ms);
+            ImGui::Text("Grows: %llu", static_cast<unsigned long long>(ring_stats.grows));
+        }
+
+        ImGui::End();
+    }
+
+    void Application::RenderProfilerUI()
+    {
+        profiler->RenderUI();
+    }
+
+    void Application::SetHeadless(HeadlessSettings const& settings)
+    {
+        headless_settings = settings;
+    }
+
+    void Application::SetPipelinedRendering(bool enabled)
+    {
+        pipelined_rendering = enabled;
+    }
+
+    void Application::SetInput(InputSettings const& settings)
+    {
+        input_settings = settings;
+    }
+
+    void Application::RunPipelined()
+    {
+        using clock_t = std::chrono::high_resolution_clock;
+
+        spdlog::info("App: Running with a separate render thread");
+        tracy::SetThreadName("Main/Simulation Thread");
+
+        pipeline = std::make_unique<PipelineState>();
+
+        //Creates the font texture. ImGui::NewFrame on this thread asserts if the atlas has not been built yet
+        ImGui_ImplOpenGL3_NewFrame();
+
+        //The render thread owns the context from here until it exits
+        glfwMakeContextCurrent(nullptr);
+        pipeline->render_thread = std::thread(&Application::RenderThreadMain, this);
+
+        double prevFrame = glfwGetTime();
+        while (!glfwWindowShouldClose(_windowHandle))
+        {
+            FrameMarkStart("Simulation");
+            auto frame_start = clock_t::now();
+
+            double curFrame = glfwGetTime();
+            double dt = curFrame - prevFrame;
+            prevFrame = curFrame;
+
+            BeginFrameMemory();
+
+            {
+                ALBUQUERQUE_PROFILE_CPU("Simulation");
+                glfwPollEvents();
+                dt = BeginFrameInput(dt);
+                EndFrameInput(dt, RunFixedUpdates(dt));
+                Update(dt);
+            }
+
+            {
+                //Only builds the draw lists. Nothing here touches GL
+                ZoneScopedN("Build UI");
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+                RenderUI(dt);
+                ImGui::Render();
+                pipeline->ui_snapshots.WriteSlot().CopyFrom(ImGui::GetDrawData());
+            }
+
+            {
+                ZoneScopedN("Publish Snapshot");
+                PublishFrameSnapshot();
+                pipeline->ui_snapshots.Publish();
+
+                std::lock_guard lock(pipeline->mutex);
+                pipeline->published_frames += 1;
+            }
+            pipeline->frame_published.notify_one();
+
+            double simulation_ms = std::chrono::duration<double, std::milli>(clock_t::now() - frame_start).count();
+            TracyPlot("Simulation Thread ms", simulation_ms);
+            FrameMarkEnd("Simulation");
+
+            if (replaying && input_replay.Finished())
+                Close();
+
+            frame_pacer.WaitForNextFrame();
+        }
+
+        {
+            std::lock_guard lock(pipeline->mutex);
+            pipeline->stop = true;
+        }
+        pipeline->frame_published.notify_one();
+        pipeline->render_thread.join();
+
+        //Unload and the app's destructor free GL objects so the context comes back to the main thread
+        glfwMakeContextCurrent(_windowHandle);
+        pipeline.reset();
+    }
+
+    void Application::RenderThreadMain()
+    {
+        using clock_t = std::chrono::high_resolution_clock;
+
+        tracy::SetThreadName("Render Thread");
+        glfwMakeContextCurrent(_windowHandle);
+
+        uint64_t rendered_frames = 0;
+        double prevFrame = glfwGetTime();
+        while (true)
+        {
+            {
+                std::unique_lock lock(pipeline->mutex);
+                pipeline->frame_published.wait(lock, [&]() { return pipeline->stop || pipeline->published_frames > rendered_frames; });
+                if (pipeline->stop)
+                    break;
+
+                //If the simulation got more than a frame ahead the older snapshots were skipped anyways
+                rendered_frames = pipeline->published_frames;
+            }
+
+            FrameMarkStart("Render");
+            auto frame_start = clock_t::now();
+
+            double curFrame = glfwGetTime();
+            double dt = curFrame - prevFrame;
+            prevFrame = curFrame;
+
+            pipeline->ui_snapshots.Acquire();
+            UiDrawSnapshot const& ui = pipeline->ui_snapshots.ReadSlot();
+
+            //The profiler's frames are the rendered ones, the simulation thread's zones land in whichever is open
+            profiler->BeginFrame();
+            {
+                ALBUQUERQUE_PROFILE_CPU("Render Scene");
+                ALBUQUERQUE_PROFILE_GPU("Render Scene");
+                glEnable(GL_FRAMEBUFFER_SRGB);
+                uniform_ring->BeginFrame();
+                RenderScene(dt);
+                uniform_ring->EndFrame();
+            }
+
+            if (ui.valid)
+            {
+                ALBUQUERQUE_PROFILE_CPU("Render UI");
+                ALBUQUERQUE_PROFILE_GPU("Render UI");
+                ImGui_ImplOpenGL3_NewFrame();
+                glDisable(GL_FRAMEBUFFER_SRGB);
+                ImGui_ImplOpenGL3_RenderDrawData(const_cast<ImDrawData*>(&ui.draw_data));
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+            profiler->EndFrame();
+
+            {
+                ZoneScopedN("Swap");
+                glfwSwapBuffers(_windowHandle);
+            }
+
+            double render_ms = std::chrono::duration<double, std::milli>(clock_t::now() - frame_start).count();
+            TracyPlot("Render Thread ms", render_ms);
+            FrameMarkEnd("Render");
+            FrameMark;
+        }
+
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    int Application::RunHeadless()
+    {
+        using clock_t = std::chrono::high_resolution_clock;
+
+        HeadlessSettings const& settings = headless_settings;
+        //A replay decides how many frames there are and how long each one is
+        uint32_t frame_count = replaying ? static_cast<uint32_t>(input_replay.FrameCount()) : settings.frame_count;
+        spdlog::info("App: Headless run of {} frames at dt {}", frame_count, settings.fixed_dt);
+
+        HeadlessReport report;
+        report.frame_cpu_ms.reserve(frame_count);
+
+        bool has_goldens = !settings.golden_directory.empty();
+
+        if (!settings.profile_path.empty())
+            profiler->StartRecording();
+
+        for (uint32_t frame = 0; frame < frame_count && !glfwWindowShouldClose(_windowHandle); ++frame)
+        {
+            double time = static_cast<double>(frame) * settings.fixed_dt;
+            double frame_dt = settings.fixed_dt;
+
+            //UI is skipped, the framerate text alone would make every golden comparison fail
+            auto frame_start = clock_t::now();
+            BeginFrameMemory();
+            profiler->BeginFrame();
+            uniform_ring->BeginFrame();
+            {
+                ALBUQUERQUE_PROFILE_CPU("Simulation");
+                glfwPollEvents();
+                frame_dt = BeginFrameInput(frame_dt);
+                if (!replaying)
+                    UpdateScriptedCamera(frame, time);
+                EndFrameInput(frame_dt, RunFixedUpdates(frame_dt));
+                Update(frame_dt);
+            }
+            Render(frame_dt, false);
+            uniform_ring->EndFrame();
+            profiler->EndFrame();
+            report.frame_cpu_ms.push_back(std::chrono::duration<double, std::milli>(clock_t::now() - frame_start).count());
+
+            bool is_last_frame = frame + 1 == frame_count;
+            bool is_capture_frame = settings.capture_every != 0 && frame % settings.capture_every == 0;
+            if (is_capture_frame || is_last_frame)
+            {
+                char file_name[32];
+                std::snprintf(file_name, sizeof(file_name), "frame_%04u.png", frame);
+
+                HeadlessCaptureResult capture;
+                capture.frame_index = frame;
+                capture.file_path = (std::filesystem::path(settings.capture_directory) / file_name).string();
+
+                CapturedImage image = CaptureBackBuffer(windowWidth, windowHeight);
+                WritePng(capture.file_path, image);
+
+                if (has_goldens)
+                {
+                    capture.golden_path = (std::filesystem::path(settings.golden_directory) / file_name).string();
+
+                    CapturedImage golden;
+                    if (settings.update_goldens)
+                    {
+                        WritePng(capture.golden_path, image);
+                    }
+                    else if (!LoadPng(capture.golden_path, golden))
+                    {
+                        spdlog::error("Headless: Missing golden image {}", capture.golden_path);
+                        capture.passed = false;
+                    }
+                    else
+                    {
+                        ImageCompareResult compare = CompareImages(image, golden, settings.pixel_tolerance, settings.max_failed_pixel_fraction);
+                        capture.compared = true;
+                        capture.passed = compare.passed;
+                        capture.failed_pixel_fraction = compare.failed_pixel_fraction;
+                        capture.mean_difference = compare.mean_difference;
+                        capture.max_difference = compare.max_difference;
+
+                        if (!compare.passed)
+                        {
+                            spdlog::error("Headless: Frame {} differs from golden ({} of pixels failed)", frame, compare.failed_pixel_fraction);
+
+                            std::snprintf(file_name, sizeof(file_name), "frame_%04u_diff.png", frame);
+                            WritePng((std::filesystem::path(settings.capture_directory) / file_name).string(), MakeDifferenceImage(image, golden, settings.pixel_tolerance));
+                        }
+                    }
+                }
+
+                report.captures.push_back(std::move(capture));
+            }
+
+            glfwSwapBuffers(_windowHandle);
+            FrameMark;
+        }
+
+        if (!settings.profile_path.empty())
+        {
+            //Waits for the last frames so their GPU zones make it into the file
+            glFinish();
+            profiler->ResolvePendingGpuFrames();
+            profiler->StopRecording();
+
+            if (std::filesystem::path(settings.profile_path).extension() == ".csv")
+                profiler->ExportCsv(settings.profile_path);
+            else
+                profiler->ExportJson(settings.profile_path);
+        }
+
+        FinalizeHeadlessReport(report, settings);
+        WriteHeadlessReport(settings.report_path, report, settings);
+
+        spdlog::info("App: Headless cpu frame ms mean {:.3f} p95 {:.3f} max {:.3f}", report.mean_ms, report.p95_ms, report.max_ms);
+        if (!report.timing_passed)
+        {
+            spdlog::error("Headless: p95 frame time {:.3f} ms is over the budget of {:.3f} ms", report.p95_ms, settings.frame_budget_ms);
+        }
+
+        return report.Passed() ? 0 : 1;
     }
 
     void Application::Close()
@@ -65,29 +611,31 @@ namespace Albuquerque
         glfwSetWindowShouldClose(_windowHandle, 1);
     }
 
+    //All of these read this frame's input snapshot, which is what makes them replayable
     bool Application::IsKeyPressed(int32_t key)
     {
-        return glfwGetKey(_windowHandle, key) == GLFW_PRESS;
+        return current_input.Key(key);
     }
 
     bool Application::IsMouseKeyPressed(int32_t key)
     {
-        return glfwGetMouseButton(_windowHandle, key) == GLFW_PRESS;
+        return current_input.MouseButton(key);
     }
 
     bool Application::IsMouseKeyReleased(int32_t key)
     {
-        return glfwGetMouseButton(_windowHandle, key) == GLFW_RELEASE;
+        return !current_input.MouseButton(key);
     }
 
     bool Application::IsKeyRelease(int32_t key)
     {
-        return glfwGetKey(_windowHandle, key) == GLFW_RELEASE;
+        return !current_input.Key(key);
     }
 
     void Application::GetMousePosition(double& mouseX, double& mouseY)
     {
-        glfwGetCursorPos(_windowHandle, &mouseX, &mouseY);  
+        mouseX = current_input.mouse_x;
+        mouseY = current_input.mouse_y;
     }
 
     bool Application::Initialize()
@@ -106,10 +654,8 @@ namespace Albuquerque
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
         glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_FALSE);
 
-
-        const auto primaryMonitor = glfwGetPrimaryMonitor();
-        const auto primaryMonitorVideoMode = glfwGetVideoMode(primaryMonitor);
-
+        //Still needs a window for the context. Works on Mesa/llvmpipe under a virtual display
+        glfwWindowHint(GLFW_VISIBLE, headless_settings.enabled ? GLFW_FALSE : GLFW_TRUE);
 
 
         _windowHandle = glfwCreateWindow(windowWidth, windowHeight, "Albuquerque Project Template", nullptr, nullptr);
@@ -120,14 +666,22 @@ namespace Albuquerque
             return false;
         }
 
-        const auto screenWidth = primaryMonitorVideoMode->width;
-        const auto screenHeight = primaryMonitorVideoMode->height;
-        glfwSetWindowPos(_windowHandle, screenWidth / 2 - windowWidth / 2, screenHeight / 2 - windowHeight / 2);
+        //Virtual displays might not report a monitor at all
+        const auto primaryMonitor = glfwGetPrimaryMonitor();
+        if (!headless_settings.enabled && primaryMonitor != nullptr)
+        {
+            const auto primaryMonitorVideoMode = glfwGetVideoMode(primaryMonitor);
+            const auto screenWidth = primaryMonitorVideoMode->width;
+            const auto screenHeight = primaryMonitorVideoMode->height;
+            glfwSetWindowPos(_windowHandle, screenWidth / 2 - windowWidth / 2, screenHeight / 2 - windowHeight / 2);
+        }
 
         glfwMakeContextCurrent(_windowHandle);
         gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 
         Fwog::Initialize();
+        uniform_ring = std::make_unique<UniformRing>();
+        profiler = std::make_unique<Profiler>();
 
         ImGui::CreateContext();
         AfterCreatedUiContext();
@@ -157,7 +711,8 @@ namespace Albuquerque
             }, nullptr);
         glClearColor(0.7f, 0.5f, 0.2f, 1.0f);
 
-        glfwSwapInterval(1);
+        //No reason to wait on vsync when nobody is looking
+        glfwSwapInterval(headless_settings.enabled ? 0 : 1);
 
         return true;
     }
@@ -169,15 +724,25 @@ namespace Albuquerque
         BeforeDestroyUiContext();
         ImGui::DestroyContext();
 
+        uniform_ring.reset();
+        profiler.reset();
         glfwTerminate();
     }
 
-    void Application::Render(double dt)
+    void Application::Render(double dt, bool render_ui)
     {
         glEnable(GL_FRAMEBUFFER_SRGB);
 
+        {
+            ALBUQUERQUE_PROFILE_CPU("Render Scene");
+            ALBUQUERQUE_PROFILE_GPU("Render Scene");
+            RenderScene(dt);
+        }
+        if (!render_ui)
+            return;
 
-        RenderScene(dt);
+        ALBUQUERQUE_PROFILE_CPU("Render UI");
+        ALBUQUERQUE_PROFILE_GPU("Render UI");
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -189,8 +754,6 @@ namespace Albuquerque
             ImGui::EndFrame();
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        glfwSwapBuffers(_windowHandle);
     }
 
     void Application::RenderScene(double dt)
@@ -206,6 +769,19 @@ namespace Albuquerque
     {
     }
 
+    void Application::FixedUpdate([[maybe_unused]] double fixed_dt)
+    {
+    }
+
+    void Application::PublishFrameSnapshot()
+    {
+    }
+
+    void Application::UpdateScriptedCamera([[maybe_unused]] uint32_t frame_index,
+                                           [[maybe_unused]] double time)
+    {
+    }
+
     void Application::SetWindowTitle(const char*  winTitle)
     {
         glfwSetWindowTitle(_windowHandle, winTitle);
@@ -0,0 +1,804 @@
+#include <Albuquerque/Audio.hpp>
+
+//OGG Vorbis through the stb_vorbis that ships with miniaudio, the implementation is at the bottom of the file
+#define STB_VORBIS_HEADER_ONLY
+#include <extras/stb_vorbis.c>
+#define MINIAUDIO_IMPLEMENTATION
+#include <miniaudio.h>
+
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <numbers>
+#include <tuple>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr uint64_t cursor_one = uint64_t(1) << 32;
+        constexpr float cursor_fraction_scale = 1.0f / float(cursor_one);
+        constexpr float sample_scale = 1.0f / 32768.0f;
+
+        //Stereo frames per music chunk, both for decoding and for mixing
+        constexpr uint32_t music_chunk_frames = 1024;
+
+        uint64_t PitchStep(float pitch)
+        {
+            return static_cast<uint64_t>(std::clamp(pitch, 0.01f, 16.0f) * float(cursor_one));
+        }
+    }
+
+    //A decoder and the ring it decodes into. Fill runs on the streaming thread, the mixer pops from the ring
+    class AudioStream
+    {
+    public:
+        AudioStream(size_t ring_frames, AudioMusicParams const& params)
+            : params(params), ring(ring_frames * 2)
+        {
+        }
+
+        ~AudioStream()
+        {
+            if (has_decoder)
+                ma_decoder_uninit(&decoder);
+        }
+
+        bool Open(std::string const& file_path, uint32_t sample_rate)
+        {
+            //Always stereo floats at the mixer's rate, so the mixer only ever adds them in
+            ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, sample_rate);
+            has_decoder = ma_decoder_init_file(file_path.c_str(), &config, &decoder) == MA_SUCCESS;
+            return has_decoder;
+        }
+
+        //Decodes until the ring is full or the track ran out
+        void Fill()
+        {
+            if (ended.load(std::memory_order_relaxed))
+                return;
+
+            while (ring.FreeSpace() >= music_chunk_frames * 2)
+            {
+                ma_uint64 read = 0;
+                ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk.data(), music_chunk_frames, &read);
+                ring.Push(chunk.data(), size_t(read) * 2);
+                pass_frames += read;
+
+                if (result != MA_SUCCESS || read < music_chunk_frames)
+                {
+                    //A whole pass without a single frame (an empty file) would loop here forever, the ring never fills
+                    if (!params.loop || pass_frames == 0 || ma_decoder_seek_to_pcm_frame(&decoder, 0) != MA_SUCCESS)
+                    {
+                        ended.store(true, std::memory_order_release);
+                        return;
+                    }
+                    pass_frames = 0;
+                }
+            }
+        }
+
+        size_t RingBytes() const { return ring.Capacity() * sizeof(float); }
+
+        AudioMusicParams params;
+        SpscQueue<float> ring;
+        //Set by the streaming thread once there is nothing left to decode, so an empty ring is the end and not
+        //an underrun
+        std::atomic<bool> ended{false};
+
+    private:
+        ma_decoder decoder;
+        bool has_decoder = false;
+        //Decoded since the track last started over
+        uint64_t pass_frames = 0;
+        std::array<float, music_chunk_frames * 2> chunk;
+    };
+
+    double AudioMixer::Stats::CpuPercentPer100Voices(uint32_t sample_rate) const
+    {
+        if (mixed_voice_frames == 0 || sample_rate == 0)
+            return 0.0;
+
+        double voice_seconds = double(mixed_voice_frames) / double(sample_rate);
+        return mix_seconds / voice_seconds * 100.0 * 100.0;
+    }
+
+    AudioMixer::AudioMixer(uint32_t sample_rate, uint32_t max_voices, size_t command_capacity)
+        : sample_rate(sample_rate), voices(max_voices), commands(command_capacity), music_scratch(music_chunk_frames * 2)
+    {
+    }
+
+    AudioMixer::Voice* AudioMixer::Find(uint32_t voice_id)
+    {
+        for (Voice& voice : voices)
+        {
+            if (voice.id == voice_id && voice.clip != nullptr)
+                return &voice;
+        }
+        return nullptr;
+    }
+
+    void AudioMixer::Start(AudioCommand const& command)
+    {
+        if (command.clip == nullptr || command.clip->frame_count == 0)
+            return;
+
+        //A free voice if there is one, otherwise the lowest priority one, the quietest of those so the steal is
+        //the least noticeable and then the oldest
+        auto steal_order = [](Voice const& voice) { return std::tuple(voice.params.priority, voice.left + voice.right, voice.sequence); };
+        Voice* target = nullptr;
+        for (Voice& voice : voices)
+        {
+            if (voice.clip == nullptr)
+            {
+                target = &voice;
+                break;
+            }
+
+            if (target == nullptr || steal_order(voice) < steal_order(*target))
+                target = &voice;
+        }
+
+        if (target == nullptr)
+            return;
+
+        if (target->clip != nullptr)
+        {
+            if (target->params.priority > command.params.priority)
+            {
+                rejected_voices.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            stolen_voices.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        *target = Voice{};
+        target->id = command.voice_id;
+        target->clip = command.clip;
+        target->step = PitchStep(command.params.pitch);
+        target->sequence = next_sequence++;
+        target->params = command.params;
+        //Starts at its real level, a fade in would soften every transient
+        TargetGains(*target, target->left, target->right);
+    }
+
+    void AudioMixer::Apply(AudioCommand const& command)
+    {
+        switch (command.type)
+        {
+        case AudioCommand::Type::play:
+            Start(command);
+            break;
+        case AudioCommand::Type::stop:
+            if (Voice* voice = Find(command.voice_id))
+                voice->clip = nullptr;
+            break;
+        case AudioCommand::Type::set_gain:
+            if (Voice* voice = Find(command.voice_id))
+                voice->params.gain = command.params.gain;
+            break;
+        case AudioCommand::Type::set_pitch:
+            if (Voice* voice = Find(command.voice_id))
+            {
+                voice->params.pitch = command.params.pitch;
+                voice->step = PitchStep(command.params.pitch);
+            }
+            break;
+        case AudioCommand::Type::set_position:
+            if (Voice* voice = Find(command.voice_id))
+                voice->params.position = command.params.position;
+            break;
+        case AudioCommand::Type::set_listener:
+            listener_position = command.params.position;
+            listener_forward = command.forward;
+            listener_up = command.up;
+            break;
+        case AudioCommand::Type::translate:
+            listener_position += command.forward;
+            for (Voice& voice : voices)
+                voice.params.position += command.forward;
+            break;
+        case AudioCommand::Type::stop_all:
+            for (Voice& voice : voices)
+                voice.clip = nullptr;
+            break;
+        case AudioCommand::Type::play_music:
+            StartMusic(command);
+            break;
+        case AudioCommand::Type::stop_music:
+            StopMusic(command);
+            break;
+        }
+    }
+
+    void AudioMixer::StartMusic(AudioCommand const& command)
+    {
+        MusicSlot* target = nullptr;
+        for (MusicSlot& slot : music)
+        {
+            if (slot.stream == command.stream)
+            {
+                target = &slot;
+                break;
+            }
+            if (slot.stream == nullptr && target == nullptr)
+                target = &slot;
+        }
+
+        if (target == nullptr)
+            return;
+
+        if (target->stream == nullptr)
+        {
+            target->stream = command.stream;
+            target->gain = 0.0f;
+        }
+
+        target->target = command.stream->params.gain;
+        float fade_frames = std::max(command.fade_seconds * float(sample_rate), 1.0f);
+        target->step = std::abs(target->target - target->gain) / fade_frames;
+    }
+
+    void AudioMixer::StopMusic(AudioCommand const& command)
+    {
+        for (MusicSlot& slot : music)
+        {
+            if (slot.stream != command.stream)
+                continue;
+
+            slot.target = 0.0f;
+            float fade_frames = std::max(command.fade_seconds * float(sample_rate), 1.0f);
+            slot.step = slot.gain / fade_frames;
+        }
+    }
+
+    bool AudioMixer::MixMusic(MusicSlot& slot, float* output, uint32_t frame_count)
+    {
+        AudioStream& stream = *slot.stream;
+        for (uint32_t first = 0; first < frame_count; first += music_chunk_frames)
+        {
+            uint32_t frames = std::min(frame_count - first, music_chunk_frames);
+            uint32_t got = static_cast<uint32_t>(stream.ring.Pop(music_scratch.data(), size_t(frames) * 2) / 2);
+            music_frames.fetch_add(got, std::memory_order_relaxed);
+            if (got < frames)
+            {
+                if (stream.ended.load(std::memory_order_acquire) && got == 0)
+                    return false;
+                if (!stream.ended.load(std::memory_order_acquire))
+                    music_underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            float* out = output + size_t(first) * 2;
+            for (uint32_t i = 0; i < got; ++i)
+            {
+                if (slot.gain < slot.target)
+                    slot.gain = std::min(slot.gain + slot.step, slot.target);
+                else if (slot.gain > slot.target)
+                    slot.gain = std::max(slot.gain - slot.step, slot.target);
+
+                out[i * 2] += music_scratch[i * 2] * slot.gain;
+                out[i * 2 + 1] += music_scratch[i * 2 + 1] * slot.gain;
+            }
+        }
+
+        //Faded all the way out, it stays paused where it got to
+        return slot.target > 0.0f || slot.gain > 0.0f;
+    }
+
+    void AudioMixer::TargetGains(Voice const& voice, float& left, float& right) const
+    {
+        float gain = voice.params.gain;
+        if (!voice.params.spatial)
+        {
+            left = gain;
+            right = gain;
+            return;
+        }
+
+        glm::vec3 offset = voice.params.position - listener_position;
+        float distance = glm::length(offset);
+        if (distance >= voice.params.max_distance)
+        {
+            left = 0.0f;
+            right = 0.0f;
+            return;
+        }
+
+        float min_distance = std::max(voice.params.min_distance, 0.001f);
+        gain *= min_distance / std::max(distance, min_distance);
+
+        //Equal power pan, so a sound moving across the listener keeps the same loudness. Right on top of the
+        //listener it's centered
+        float pan = 0.0f;
+        glm::vec3 listener_right = glm::cross(listener_forward, listener_up);
+        float right_length = glm::length(listener_right);
+        if (distance > 0.001f && right_length > 0.0f)
+            pan = glm::dot(offset / distance, listener_right / right_length);
+
+        float angle = (pan + 1.0f) * std::numbers::pi_v<float> * 0.25f;
+        left = gain * std::cos(angle);
+        right = gain * std::sin(angle);
+    }
+
+    bool AudioMixer::MixVoice(Voice& voice, float* output, uint32_t frame_count)
+    {
+        AudioClip const& clip = *voice.clip;
+        int16_t const* samples = clip.samples.data();
+        uint32_t const channels = clip.channels;
+        uint64_t const end = uint64_t(clip.frame_count) << 32;
+
+        float target_left = 0.0f;
+        float target_right = 0.0f;
+        TargetGains(voice, target_left, target_right);
+
+        //Ramped over the block so gain, distance and pan changes don't step
+        float left = voice.left;
+        float right = voice.right;
+        float const left_step = (target_left - left) / float(frame_count);
+        float const right_step = (target_right - right) / float(frame_count);
+        voice.left = target_left;
+        voice.right = target_right;
+
+        uint64_t cursor = voice.cursor;
+        for (uint32_t i = 0; i < frame_count; ++i)
+        {
+            if (cursor >= end)
+            {
+                if (!voice.params.loop)
+                    return false;
+                cursor %= end;
+            }
+
+            uint32_t frame = static_cast<uint32_t>(cursor >> 32);
+            uint32_t next = frame + 1;
+            if (next >= clip.frame_count)
+                next = voice.params.loop ? 0 : frame;
+            float fraction = float(cursor & (cursor_one - 1)) * cursor_fraction_scale;
+
+            float sample_left = 0.0f;
+            float sample_right = 0.0f;
+            if (channels == 1)
+            {
+                float a = samples[frame];
+                float b = samples[next];
+                sample_left = (a + (b - a) * fraction) * sample_scale;
+                sample_right = sample_left;
+            }
+            else
+            {
+                float a_left = samples[frame * 2];
+                float b_left = samples[next * 2];
+                float a_right = samples[frame * 2 + 1];
+                float b_right = samples[next * 2 + 1];
+                sample_left = (a_left + (b_left - a_left) * fraction) * sample_scale;
+                sample_right = (a_right + (b_right - a_right) * fraction) * sample_scale;
+            }
+
+            left += left_step;
+            right += right_step;
+            output[i * 2] += sample_left * left;
+            output[i * 2 + 1] += sample_right * right;
+
+            cursor += voice.step;
+        }
+
+        voice.cursor = cursor;
+        return voice.params.loop || cursor < end;
+    }
+
+    void AudioMixer::Mix(float* output, uint32_t frame_count)
+    {
+        ZoneScopedN("Audio Mix");
+        auto start = std::chrono::steady_clock::now();
+
+        AudioCommand command;
+        while (commands.Pop(command))
+            Apply(command);
+
+        std::fill(output, output + size_t(frame_count) * 2, 0.0f);
+
+        uint32_t active = 0;
+        for (Voice& voice : voices)
+        {
+            if (voice.clip == nullptr)
+                continue;
+
+            active += 1;
+            if (!MixVoice(voice, output, frame_count))
+                voice.clip = nullptr;
+        }
+
+        uint32_t music_playing = 0;
+        for (MusicSlot& slot : music)
+        {
+            if (slot.stream == nullptr)
+                continue;
+
+            music_playing += 1;
+            if (!MixMusic(slot, output, frame_count))
+                slot = MusicSlot{};
+        }
+
+        for (size_t i = 0; i < size_t(frame_count) * 2; ++i)
+            output[i] = std::clamp(output[i], -1.0f, 1.0f);
+
+        auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        active_voices.store(active, std::memory_order_relaxed);
+        active_music.store(music_playing, std::memory_order_relaxed);
+        mixed_frames.fetch_add(frame_count, std::memory_order_relaxed);
+        mixed_voice_frames.fetch_add(uint64_t(active) * frame_count, std::memory_order_relaxed);
+        mix_nanoseconds.fetch_add(static_cast<uint64_t>(nanoseconds), std::memory_order_relaxed);
+    }
+
+    AudioMixer::Stats AudioMixer::GetStats() const
+    {
+        Stats stats;
+        stats.active_voices = active_voices.load(std::memory_order_relaxed);
+        stats.max_voices = static_cast<uint32_t>(voices.size());
+        stats.stolen_voices = stolen_voices.load(std::memory_order_relaxed);
+        stats.rejected_voices = rejected_voices.load(std::memory_order_relaxed);
+        stats.mixed_frames = mixed_frames.load(std::memory_order_relaxed);
+        stats.mixed_voice_frames = mixed_voice_frames.load(std::memory_order_relaxed);
+        stats.mix_seconds = double(mix_nanoseconds.load(std::memory_order_relaxed)) * 1e-9;
+        stats.active_music = active_music.load(std::memory_order_relaxed);
+        stats.music_underruns = music_underruns.load(std::memory_order_relaxed);
+        stats.music_frames = music_frames.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    struct AudioSystem::Device
+    {
+        ma_context context;
+        ma_device device;
+        bool has_context = false;
+        bool has_device = false;
+
+        ~Device()
+        {
+            if (has_device)
+                ma_device_uninit(&device);
+            if (has_context)
+                ma_context_uninit(&context);
+        }
+
+        static void Callback(ma_device* device, void* output, void const*, ma_uint32 frame_count)
+        {
+            static_cast<AudioMixer*>(device->pUserData)->Mix(static_cast<float*>(output), frame_count);
+        }
+
+        bool Open(AudioMixer& mixer, uint32_t sample_rate, bool null_backend)
+        {
+            ma_backend null_backends[] = {ma_backend_null};
+            if (ma_context_init(null_backend ? null_backends : nullptr, null_backend ? 1 : 0, nullptr, &context) != MA_SUCCESS)
+                return false;
+            has_context = true;
+
+            ma_device_config config = ma_device_config_init(ma_device_type_playback);
+            config.playback.format = ma_format_f32;
+            config.playback.channels = 2;
+            config.sampleRate = sample_rate;
+            config.dataCallback = Callback;
+            config.pUserData = &mixer;
+            if (ma_device_init(&context, &config, &device) != MA_SUCCESS)
+                return false;
+            has_device = true;
+
+            return ma_device_start(&device) == MA_SUCCESS;
+        }
+    };
+
+    AudioSystem::AudioSystem() = default;
+
+    AudioSystem::~AudioSystem()
+    {
+        Shutdown();
+    }
+
+    bool AudioSystem::Initialize(AudioSettings const& audio_settings)
+    {
+        Shutdown();
+        settings = audio_settings;
+        mixer = std::make_unique<AudioMixer>(settings.sample_rate, settings.max_voices, settings.command_capacity);
+
+        device = std::make_unique<Device>();
+        if (!device->Open(*mixer, settings.sample_rate, settings.null_backend))
+        {
+            device.reset();
+            if (settings.null_backend)
+            {
+                spdlog::error("Audio: Unable to start the null backend");
+                mixer.reset();
+                return false;
+            }
+
+            //No sound card shouldn't stop the game, everything still runs, just silently
+            spdlog::warn("Audio: Unable to open an output device, falling back to the null backend");
+            settings.null_backend = true;
+            device = std::make_unique<Device>();
+            if (!device->Open(*mixer, settings.sample_rate, true))
+            {
+                spdlog::error("Audio: Unable to start the null backend");
+                device.reset();
+                mixer.reset();
+                return false;
+            }
+        }
+
+        spdlog::info("Audio: {} voices at {} Hz{}", settings.max_voices, settings.sample_rate, settings.null_backend ? " on the null backend" : "");
+        return true;
+    }
+
+    void AudioSystem::Shutdown()
+    {
+        //The device first, the mixer, clips and streams have to outlive its callback. The streaming thread
+        //before the streams
+        device.reset();
+        streaming = false;
+        if (streamer.joinable())
+            streamer.join();
+
+        mixer.reset();
+        clips.clear();
+        clips_by_path.clear();
+        clip_bytes = 0;
+        streams.clear();
+        music_bytes = 0;
+    }
+
+    void AudioSystem::StreamMusic()
+    {
+        //The ring holds a good few wakeups worth, so a sleep is all the scheduling this needs
+        while (streaming)
+        {
+            {
+                std::lock_guard lock(streams_mutex);
+                for (auto& stream : streams)
+                    stream->Fill();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    AudioMusicId AudioSystem::OpenMusic(std::string const& file_path, AudioMusicParams const& params)
+    {
+        ZoneScopedN("Open Music");
+        if (!mixer)
+            return invalid_audio_music;
+
+        auto start = std::chrono::steady_clock::now();
+
+        size_t ring_frames = static_cast<size_t>(settings.music_buffer_seconds * settings.sample_rate);
+        auto stream = std::make_unique<AudioStream>(std::max<size_t>(ring_frames, music_chunk_frames * 2), params);
+        if (!stream->Open(file_path, settings.sample_rate))
+        {
+            spdlog::error("Audio: Unable to open music {}", file_path);
+            return invalid_audio_music;
+        }
+
+        //The first chunk here so it can start playing right away
+        stream->Fill();
+        size_t bytes = stream->RingBytes() + sizeof(AudioStream);
+
+        std::error_code error;
+        uintmax_t file_bytes = std::filesystem::file_size(file_path, error);
+        spdlog::info("Audio: Opened {} for streaming in {:.2f} ms, {} KiB buffered of a {} KiB file", file_path,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), bytes / 1024,
+            error ? 0 : file_bytes / 1024);
+
+        AudioMusicId id = 0;
+        {
+            std::lock_guard lock(streams_mutex);
+            streams.push_back(std::move(stream));
+            id = static_cast<AudioMusicId>(streams.size() - 1);
+        }
+        music_bytes += bytes;
+
+        if (!streaming.exchange(true))
+            streamer = std::thread([this]() { StreamMusic(); });
+        return id;
+    }
+
+    void AudioSystem::PlayMusic(AudioMusicId music, float fade_seconds)
+    {
+        if (!mixer || music >= streams.size())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::play_music;
+        command.stream = streams[music].get();
+        command.fade_seconds = fade_seconds;
+        Submit(command);
+    }
+
+    void AudioSystem::StopMusic(AudioMusicId music, float fade_seconds)
+    {
+        if (!mixer || music >= streams.size())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::stop_music;
+        command.stream = streams[music].get();
+        command.fade_seconds = fade_seconds;
+        Submit(command);
+    }
+
+    AudioClipId AudioSystem::LoadClip(std::string const& file_path)
+    {
+        if (!mixer)
+            return invalid_audio_clip;
+
+        if (auto found = clips_by_path.find(file_path); found != clips_by_path.end())
+            return found->second;
+
+        //Native channel count unless there are more than two, converted to 16 bit at the mixer's rate
+        ma_decoder decoder;
+        ma_decoder_config config = ma_decoder_config_init(ma_format_s16, 0, settings.sample_rate);
+        if (ma_decoder_init_file(file_path.c_str(), &config, &decoder) != MA_SUCCESS)
+        {
+            spdlog::error("Audio: Unable to decode {}", file_path);
+            return invalid_audio_clip;
+        }
+
+        if (decoder.outputChannels > 2)
+        {
+            ma_decoder_uninit(&decoder);
+            config.channels = 2;
+            if (ma_decoder_init_file(file_path.c_str(), &config, &decoder) != MA_SUCCESS)
+            {
+                spdlog::error("Audio: Unable to decode {}", file_path);
+                return invalid_audio_clip;
+            }
+        }
+
+        uint32_t channels = decoder.outputChannels;
+        std::vector<int16_t> samples;
+        ma_uint64 length = 0;
+        if (ma_decoder_get_length_in_pcm_frames(&decoder, &length) == MA_SUCCESS && length > 0)
+            samples.reserve(size_t(length) * channels);
+
+        //Some formats don't know their length, so read in chunks either way
+        int16_t chunk[4096];
+        ma_uint64 chunk_frames = std::size(chunk) / channels;
+        while (true)
+        {
+            ma_uint64 read = 0;
+            ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk, chunk_frames, &read);
+            samples.insert(samples.end(), chunk, chunk + read * channels);
+            if (result != MA_SUCCESS || read == 0)
+                break;
+        }
+        ma_decoder_uninit(&decoder);
+
+        AudioClipId id = AddClip(samples, channels);
+        if (id != invalid_audio_clip)
+            clips_by_path.emplace(file_path, id);
+        return id;
+    }
+
+    AudioClipId AudioSystem::AddClip(std::span<int16_t const> samples, uint32_t channels)
+    {
+        if (!mixer || channels < 1 || channels > 2 || samples.size() < channels)
+            return invalid_audio_clip;
+
+        auto clip = std::make_unique<AudioClip>();
+        clip->samples.assign(samples.begin(), samples.end());
+        clip->channels = channels;
+        clip->frame_count = static_cast<uint32_t>(samples.size() / channels);
+        clip_bytes += clip->samples.size() * sizeof(int16_t);
+
+        clips.push_back(std::move(clip));
+        return static_cast<AudioClipId>(clips.size() - 1);
+    }
+
+    void AudioSystem::Submit(AudioCommand const& command)
+    {
+        if (!mixer)
+            return;
+
+        if (!mixer->Submit(command))
+            dropped_commands += 1;
+    }
+
+    AudioVoice AudioSystem::Play(AudioClipId clip, AudioPlayParams const& params)
+    {
+        if (!mixer || clip >= clips.size())
+            return {};
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::play;
+        command.voice_id = next_voice_id++;
+        if (next_voice_id == 0)
+            next_voice_id = 1;
+        command.clip = clips[clip].get();
+        command.params = params;
+        Submit(command);
+
+        return AudioVoice{command.voice_id};
+    }
+
+    void AudioSystem::Stop(AudioVoice voice)
+    {
+        if (!voice.IsValid())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::stop;
+        command.voice_id = voice.id;
+        Submit(command);
+    }
+
+    void AudioSystem::SetGain(AudioVoice voice, float gain)
+    {
+        if (!voice.IsValid())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::set_gain;
+        command.voice_id = voice.id;
+        command.params.gain = gain;
+        Submit(command);
+    }
+
+    void AudioSystem::SetPitch(AudioVoice voice, float pitch)
+    {
+        if (!voice.IsValid())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::set_pitch;
+        command.voice_id = voice.id;
+        command.params.pitch = pitch;
+        Submit(command);
+    }
+
+    void AudioSystem::SetPosition(AudioVoice voice, glm::vec3 position)
+    {
+        if (!voice.IsValid())
+            return;
+
+        AudioCommand command;
+        command.type = AudioCommand::Type::set_position;
+        command.voice_id = voice.id;
+        command.params.position = position;
+        Submit(command);
+    }
+
+    void AudioSystem::SetListener(glm::vec3 position, glm::vec3 forward, glm::vec3 up)
+    {
+        AudioCommand command;
+        command.type = AudioCommand::Type::set_listener;
+        command.params.position = position;
+        command.forward = forward;
+        command.up = up;
+        Submit(command);
+    }
+
+    void AudioSystem::Translate(glm::vec3 offset)
+    {
+        AudioCommand command;
+        command.type = AudioCommand::Type::translate;
+        command.forward = offset;
+        Submit(command);
+    }
+
+    void AudioSystem::StopAll()
+    {
+        AudioCommand command;
+        command.type = AudioCommand::Type::stop_all;
+        Submit(command);
+    }
+
+    AudioMixer::Stats AudioSystem::GetStats() const
+    {
+        return mixer ? mixer->GetStats() : AudioMixer::Stats{};
+    }
+}
+
+#undef STB_VORBIS_HEADER_ONLY
+#include <extras/stb_vorbis.c>
@@ -0,0 +1,297 @@
+#include <Albuquerque/DebugDraw.hpp>
+#include <Albuquerque/Profiler.hpp>
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numbers>
+#include <span>
+#include <string>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr char vertex_shader_path[] = "./data/shaders/debug_draw.vert.glsl";
+        constexpr char fragment_shader_path[] = "./data/shaders/lines.frag.glsl";
+
+        constexpr size_t initial_instance_capacity = 4096;
+        constexpr uint32_t sphere_circle_segments = 32;
+
+        std::string LoadFile(std::string_view path)
+        {
+            std::ifstream file{path.data()};
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        //Line list of the 12 edges of the cube from -1 to 1
+        void AppendBoxMesh(std::vector<glm::vec3>& vertices)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                int u = (axis + 1) % 3;
+                int v = (axis + 2) % 3;
+                for (int corner = 0; corner < 4; ++corner)
+                {
+                    glm::vec3 start(0.0f);
+                    start[u] = (corner & 1) ? 1.0f : -1.0f;
+                    start[v] = (corner & 2) ? 1.0f : -1.0f;
+                    start[axis] = -1.0f;
+
+                    glm::vec3 end = start;
+                    end[axis] = 1.0f;
+
+                    vertices.push_back(start);
+                    vertices.push_back(end);
+                }
+            }
+        }
+
+        //Three unit circles, one around each axis
+        void AppendSphereMesh(std::vector<glm::vec3>& vertices)
+        {
+            constexpr float step = 2.0f * std::numbers::pi_v<float> / sphere_circle_segments;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                int u = (axis + 1) % 3;
+                int v = (axis + 2) % 3;
+                for (uint32_t i = 0; i < sphere_circle_segments; ++i)
+                {
+                    glm::vec3 start(0.0f);
+                    start[u] = std::cos(step * i);
+                    start[v] = std::sin(step * i);
+
+                    glm::vec3 end(0.0f);
+                    end[u] = std::cos(step * (i + 1));
+                    end[v] = std::sin(step * (i + 1));
+
+                    vertices.push_back(start);
+                    vertices.push_back(end);
+                }
+            }
+        }
+    }
+
+    DebugDraw::DebugDraw(bool depth_test)
+    {
+        std::vector<glm::vec3> vertices;
+
+        mesh_first_vertex[shape_line] = 0;
+        vertices.push_back(glm::vec3(0.0f));
+        vertices.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
+
+        mesh_first_vertex[shape_box] = static_cast<uint32_t>(vertices.size());
+        AppendBoxMesh(vertices);
+
+        mesh_first_vertex[shape_sphere] = static_cast<uint32_t>(vertices.size());
+        AppendSphereMesh(vertices);
+
+        mesh_vertex_count[shape_line] = mesh_first_vertex[shape_box] - mesh_first_vertex[shape_line];
+        mesh_vertex_count[shape_box] = mesh_first_vertex[shape_sphere] - mesh_first_vertex[shape_box];
+        mesh_vertex_count[shape_sphere] = static_cast<uint32_t>(vertices.size()) - mesh_first_vertex[shape_sphere];
+
+        mesh_buffer = Fwog::Buffer(std::span<glm::vec3 const>(vertices));
+
+        auto vertex_shader = Fwog::Shader(Fwog::PipelineStage::VERTEX_SHADER, LoadFile(vertex_shader_path));
+        auto fragment_shader = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER, LoadFile(fragment_shader_path));
+
+        auto input_descs = std::array{
+            Fwog::VertexInputBindingDescription{
+                .location = 0,
+                .binding = 0,
+                .format = Fwog::Format::R32G32B32_FLOAT,
+                .offset = 0,
+            },
+        };
+
+        pipeline = Fwog::GraphicsPipeline{{
+            .vertexShader = &vertex_shader,
+            .fragmentShader = &fragment_shader,
+            .inputAssemblyState = {Fwog::PrimitiveTopology::LINE_LIST},
+            .vertexInputState = {input_descs},
+            .rasterizationState = {.cullMode = Fwog::CullMode::NONE},
+            .depthState = {.depthTestEnable = depth_test, .depthWriteEnable = false, .depthCompareOp = Fwog::CompareOp::LESS_OR_EQUAL},
+        }};
+
+        CreateRing(initial_instance_capacity);
+    }
+
+    DebugDraw::~DebugDraw()
+    {
+        for (void*& fence : segment_fences)
+        {
+            if (fence)
+                glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+
+    void DebugDraw::Line(glm::vec3 start, glm::vec3 end, glm::vec3 color)
+    {
+        //The unit segment goes from the origin to +x, so the x column stretches it onto start -> end
+        glm::mat4 transform(0.0f);
+        transform[0] = glm::vec4(end - start, 0.0f);
+        transform[3] = glm::vec4(start, 1.0f);
+        instances[shape_line].push_back({transform, glm::vec4(color, 1.0f)});
+    }
+
+    void DebugDraw::Box(glm::vec3 center, glm::vec3 half_extents, glm::vec3 color)
+    {
+        glm::mat4 transform(1.0f);
+        transform[0][0] = half_extents.x;
+        transform[1][1] = half_extents.y;
+        transform[2][2] = half_extents.z;
+        transform[3] = glm::vec4(center, 1.0f);
+        instances[shape_box].push_back({transform, glm::vec4(color, 1.0f)});
+    }
+
+    void DebugDraw::Box(glm::mat4 const& transform, glm::vec3 color)
+    {
+        instances[shape_box].push_back({transform, glm::vec4(color, 1.0f)});
+    }
+
+    void DebugDraw::Sphere(glm::vec3 center, float radius, glm::vec3 color)
+    {
+        glm::mat4 transform(radius);
+        transform[3] = glm::vec4(center, 1.0f);
+        instances[shape_sphere].push_back({transform, glm::vec4(color, 1.0f)});
+    }
+
+    void DebugDraw::Frustum(glm::mat4 const& view_proj, glm::vec3 color)
+    {
+        //The inverse takes the clip space cube back to the world. The shader does the divide by w
+        Box(glm::inverse(view_proj), color);
+    }
+
+    void DebugDraw::Clear()
+    {
+        for (auto& shape_instances : instances)
+        {
+            shape_instances.clear();
+        }
+    }
+
+    size_t DebugDraw::InstanceCount() const
+    {
+        size_t count = 0;
+        for (auto const& shape_instances : instances)
+        {
+            count += shape_instances.size();
+        }
+        return count;
+    }
+
+    void DebugDraw::CreateRing(size_t instance_capacity)
+    {
+        segment_instance_capacity = instance_capacity;
+        segment_stride = AlignUp(segment_alignment + instance_capacity * sizeof(Instance), segment_alignment);
+        current_segment = 0;
+
+        ring_buffer = Fwog::Buffer(segment_stride * frames_in_flight, Fwog::BufferStorageFlag::MAP_MEMORY);
+        ring_memory = static_cast<std::byte*>(ring_buffer->GetMappedPointer());
+    }
+
+    void DebugDraw::WaitForSegment(uint32_t segment)
+    {
+        auto fence = static_cast<GLsync>(segment_fences[segment]);
+        if (!fence)
+            return;
+
+        ZoneScopedN("Debug Draw Fence Wait");
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fence);
+        segment_fences[segment] = nullptr;
+    }
+
+    void DebugDraw::WaitForAllSegments()
+    {
+        for (uint32_t segment = 0; segment < frames_in_flight; ++segment)
+        {
+            WaitForSegment(segment);
+        }
+    }
+
+    void DebugDraw::Render(Fwog::Buffer const& view_uniforms)
+    {
+        RenderWithView(view_uniforms, 0, Fwog::WHOLE_BUFFER);
+    }
+
+    void DebugDraw::Render(UniformSlice const& view_uniforms)
+    {
+        RenderWithView(*view_uniforms.buffer, view_uniforms.offset, view_uniforms.size);
+    }
+
+    void DebugDraw::RenderWithView(Fwog::Buffer const& view_uniforms, uint64_t view_offset, uint64_t view_size)
+    {
+        size_t total_instances = InstanceCount();
+        if (total_instances == 0)
+            return;
+
+        ALBUQUERQUE_PROFILE_CPU("Debug Draw");
+        ALBUQUERQUE_PROFILE_GPU("Debug Draw");
+
+        if (total_instances > segment_instance_capacity)
+        {
+            //The GPU may still read the old buffer so it can only go once every segment is done
+            WaitForAllSegments();
+            CreateRing(std::bit_ceil(total_instances));
+            spdlog::info("DebugDraw: Grew the ring to {} instances per frame", segment_instance_capacity);
+        }
+
+        WaitForSegment(current_segment);
+
+        size_t segment_offset = current_segment * segment_stride;
+        std::byte* segment = ring_memory + segment_offset;
+        auto* commands = reinterpret_cast<DrawCommand*>(segment);
+        auto* segment_instances = reinterpret_cast<Instance*>(segment + segment_alignment);
+
+        uint32_t first_instance = 0;
+        for (uint32_t shape = 0; shape < shape_count; ++shape)
+        {
+            auto const& shape_instances = instances[shape];
+            std::memcpy(segment_instances + first_instance, shape_instances.data(), shape_instances.size() * sizeof(Instance));
+
+            commands[shape] = DrawCommand{
+                .vertex_count = mesh_vertex_count[shape],
+                .instance_count = static_cast<uint32_t>(shape_instances.size()),
+                .first_vertex = mesh_first_vertex[shape],
+                .first_instance = first_instance,
+            };
+            first_instance += static_cast<uint32_t>(shape_instances.size());
+        }
+
+        Fwog::Cmd::BindGraphicsPipeline(pipeline.value());
+        Fwog::Cmd::BindUniformBuffer(0, view_uniforms, view_offset, view_size);
+        Fwog::Cmd::BindStorageBuffer(0, ring_buffer.value(), segment_offset + segment_alignment, total_instances * sizeof(Instance));
+        Fwog::Cmd::BindVertexBuffer(0, mesh_buffer.value(), 0, sizeof(glm::vec3));
+        Fwog::Cmd::DrawIndirect(ring_buffer.value(), segment_offset, shape_count, sizeof(DrawCommand));
+
+        segment_fences[current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        current_segment = (current_segment + 1) % frames_in_flight;
+
+        TracyPlot("Debug Draw Instances", static_cast<int64_t>(total_instances));
+        Clear();
+    }
+}
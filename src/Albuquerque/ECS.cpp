@@ -0,0 +1,318 @@
+#include <Albuquerque/ECS.hpp>
+
+#include <cstdlib>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+namespace Albuquerque
+{
+    namespace ECSDetail
+    {
+        namespace
+        {
+            std::mutex registry_mutex;
+            std::array<ComponentInfo, max_component_types> registry{};
+            uint32_t registered_count = 0;
+        }
+
+        ComponentId RegisterComponent(uint32_t size, uint32_t alignment)
+        {
+            std::lock_guard lock(registry_mutex);
+            //The id goes straight into masks and column offsets, there is nothing sane to hand back instead
+            if (registered_count >= max_component_types)
+            {
+                spdlog::critical("ECS: Out of component ids ({} in use), bump max_component_types", max_component_types);
+                std::abort();
+            }
+
+            ComponentId id = registered_count++;
+            registry[id] = ComponentInfo{size, alignment};
+            return id;
+        }
+
+        ComponentInfo const& GetComponentInfo(ComponentId id)
+        {
+            return registry[id];
+        }
+    }
+
+    namespace
+    {
+        uint32_t AlignUp(uint32_t value, uint32_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    Archetype::Archetype(ComponentMask mask)
+        : mask(mask)
+    {
+        uint32_t bytes_per_entity = sizeof(Entity);
+        for (ComponentId id = 0; id < max_component_types; ++id)
+        {
+            if (mask.test(id))
+            {
+                components.push_back(id);
+                bytes_per_entity += ECSDetail::GetComponentInfo(id).size;
+            }
+        }
+
+        //Start from the best case and back off until the alignment padding fits too
+        auto layout_fits = [&](uint32_t capacity)
+        {
+            uint32_t offset = sizeof(Entity) * capacity;
+            for (ComponentId id : components)
+            {
+                ComponentInfo const& info = ECSDetail::GetComponentInfo(id);
+                offset = AlignUp(offset, info.alignment);
+                column_offsets[id] = offset;
+                offset += info.size * capacity;
+            }
+            return offset <= Chunk::size;
+        };
+
+        chunk_capacity = static_cast<uint32_t>(Chunk::size / bytes_per_entity);
+        while (chunk_capacity > 0 && !layout_fits(chunk_capacity))
+        {
+            chunk_capacity -= 1;
+        }
+
+        assert(chunk_capacity > 0 && "Component set doesn't fit in a single chunk");
+    }
+
+    size_t Archetype::EntityCount() const
+    {
+        if (chunks.empty())
+            return 0;
+
+        return (chunks.size() - 1) * chunk_capacity + chunks.back()->count;
+    }
+
+    World::World()
+    {
+        empty_archetype = GetOrCreateArchetype(ComponentMask{});
+    }
+
+    World::~World() = default;
+
+    Entity World::AllocateEntity()
+    {
+        alive_count += 1;
+
+        if (!free_indices.empty())
+        {
+            uint32_t index = free_indices.back();
+            free_indices.pop_back();
+            return Entity{index, records[index].generation};
+        }
+
+        records.emplace_back();
+        return Entity{static_cast<uint32_t>(records.size() - 1), 0};
+    }
+
+    Entity World::Create()
+    {
+        Entity entity = AllocateEntity();
+        AllocateRow(empty_archetype, entity);
+        return entity;
+    }
+
+    void World::Destroy(Entity entity)
+    {
+        if (!IsAlive(entity))
+            return;
+
+        EntityRecord& record = records[entity.index];
+        FreeRow(record.archetype, record.chunk_index, record.row);
+
+        record.archetype = nullptr;
+        record.generation += 1;
+        free_indices.push_back(entity.index);
+        alive_count -= 1;
+    }
+
+    bool World::IsAlive(Entity entity) const
+    {
+        return entity.index < records.size()
+            && records[entity.index].generation == entity.generation
+            && records[entity.index].archetype != nullptr;
+    }
+
+    Archetype* World::GetOrCreateArchetype(ComponentMask mask)
+    {
+        auto it = archetype_lookup.find(mask);
+        if (it != archetype_lookup.end())
+            return it->second;
+
+        archetypes.push_back(std::make_unique<Archetype>(mask));
+        Archetype* archetype = archetypes.back().get();
+        archetype_lookup.emplace(mask, archetype);
+        return archetype;
+    }
+
+    Archetype* World::GetAddTarget(Archetype* archetype, ComponentId id)
+    {
+        if (archetype->add_edges[id] == nullptr)
+        {
+            ComponentMask mask = archetype->mask;
+            mask.set(id);
+            archetype->add_edges[id] = GetOrCreateArchetype(mask);
+        }
+        return archetype->add_edges[id];
+    }
+
+    Archetype* World::GetRemoveTarget(Archetype* archetype, ComponentId id)
+    {
+        if (archetype->remove_edges[id] == nullptr)
+        {
+            ComponentMask mask = archetype->mask;
+            mask.reset(id);
+            archetype->remove_edges[id] = GetOrCreateArchetype(mask);
+        }
+        return archetype->remove_edges[id];
+    }
+
+    void World::AllocateRow(Archetype* archetype, Entity entity)
+    {
+        if (archetype->chunks.empty() || archetype->chunks.back()->count == archetype->chunk_capacity)
+        {
+            archetype->chunks.push_back(std::make_unique<Chunk>());
+        }
+
+        Chunk& chunk = *archetype->chunks.back();
+        uint32_t row = chunk.count++;
+        archetype->Entities(chunk)[row] = entity;
+
+        EntityRecord& record = records[entity.index];
+        record.archetype = archetype;
+        record.chunk_index = static_cast<uint32_t>(archetype->chunks.size() - 1);
+        record.row = row;
+    }
+
+    void World::FreeRow(Archetype* archetype, uint32_t chunk_index, uint32_t row)
+    {
+        Chunk& chunk = *archetype->chunks[chunk_index];
+        Chunk& last_chunk = *archetype->chunks.back();
+        uint32_t last_row = last_chunk.count - 1;
+
+        if (&chunk != &last_chunk || row != last_row)
+        {
+            Entity moved = archetype->Entities(last_chunk)[last_row];
+            archetype->Entities(chunk)[row] = moved;
+
+            for (ComponentId id : archetype->components)
+            {
+                uint32_t size = ECSDetail::GetComponentInfo(id).size;
+                std::memcpy(static_cast<std::byte*>(archetype->Column(chunk, id)) + size * row,
+                    static_cast<std::byte*>(archetype->Column(last_chunk, id)) + size * last_row, size);
+            }
+
+            records[moved.index].chunk_index = chunk_index;
+            records[moved.index].row = row;
+        }
+
+        last_chunk.count -= 1;
+        if (last_chunk.count == 0)
+        {
+            archetype->chunks.pop_back();
+        }
+    }
+
+    void World::MoveEntity(Entity entity, Archetype* destination)
+    {
+        EntityRecord& record = records[entity.index];
+        Archetype* source = record.archetype;
+        uint32_t source_chunk_index = record.chunk_index;
+        uint32_t source_row = record.row;
+
+        AllocateRow(destination, entity);
+
+        Chunk& source_chunk = *source->chunks[source_chunk_index];
+        Chunk& destination_chunk = *destination->chunks[record.chunk_index];
+        for (ComponentId id : source->components)
+        {
+            if (!destination->HasComponent(id))
+                continue;
+
+            uint32_t size = ECSDetail::GetComponentInfo(id).size;
+            std::memcpy(static_cast<std::byte*>(destination->Column(destination_chunk, id)) + size * record.row,
+                static_cast<std::byte*>(source->Column(source_chunk, id)) + size * source_row, size);
+        }
+
+        FreeRow(source, source_chunk_index, source_row);
+    }
+
+    void World::AddRaw(Entity entity, ComponentId id, void const* data)
+    {
+        if (!IsAlive(entity))
+            return;
+
+        EntityRecord& record = records[entity.index];
+        if (!record.archetype->HasComponent(id))
+        {
+            MoveEntity(entity, GetAddTarget(record.archetype, id));
+        }
+
+        uint32_t size = ECSDetail::GetComponentInfo(id).size;
+        Chunk& chunk = *record.archetype->chunks[record.chunk_index];
+        std::memcpy(static_cast<std::byte*>(record.archetype->Column(chunk, id)) + size * record.row, data, size);
+    }
+
+    void World::RemoveRaw(Entity entity, ComponentId id)
+    {
+        if (!IsAlive(entity))
+            return;
+
+        EntityRecord& record = records[entity.index];
+        if (record.archetype->HasComponent(id))
+        {
+            MoveEntity(entity, GetRemoveTarget(record.archetype, id));
+        }
+    }
+
+    void CommandBuffer::Create()
+    {
+        commands.push_back({CommandType::Create, 0, Entity{}, 0});
+    }
+
+    void CommandBuffer::Destroy(Entity entity)
+    {
+        commands.push_back({CommandType::Destroy, 0, entity, 0});
+    }
+
+    void CommandBuffer::Playback(World& world)
+    {
+        ZoneScopedC(tracy::Color::Purple);
+
+        Entity last_created;
+        for (Command const& command : commands)
+        {
+            Entity entity = command.entity.IsValid() ? command.entity : last_created;
+
+            switch (command.type)
+            {
+            case CommandType::Create:
+                last_created = world.Create();
+                break;
+            case CommandType::Destroy:
+                world.Destroy(entity);
+                break;
+            case CommandType::Add:
+                world.AddRaw(entity, command.component, payload.data() + command.payload_offset);
+                break;
+            case CommandType::Remove:
+                world.RemoveRaw(entity, command.component);
+                break;
+            }
+        }
+
+        Clear();
+    }
+
+    void CommandBuffer::Clear()
+    {
+        commands.clear();
+        payload.clear();
+    }
+}
@@ -0,0 +1,32 @@
+#include <Albuquerque/FloatingOrigin.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Albuquerque
+{
+    FloatingOrigin::FloatingOrigin(float rebase_distance, double snap)
+        : rebase_distance(rebase_distance), snap(std::max(snap, 1.0))
+    {
+    }
+
+    std::optional<glm::vec3> FloatingOrigin::Update(glm::vec3 local_focus)
+    {
+        if (std::abs(local_focus.x) < rebase_distance && std::abs(local_focus.z) < rebase_distance)
+            return std::nullopt;
+
+        //Snapped in world space so the origin only ever sits on the snap grid
+        glm::dvec3 world_focus = ToWorld(local_focus);
+        glm::dvec3 new_origin(std::round(world_focus.x / snap) * snap, origin.y, std::round(world_focus.z / snap) * snap);
+
+        glm::vec3 shift = glm::vec3(new_origin - origin);
+        origin = new_origin;
+        rebase_count += 1;
+        return shift;
+    }
+
+    void FloatingOrigin::Reset(glm::dvec3 origin)
+    {
+        this->origin = origin;
+    }
+}
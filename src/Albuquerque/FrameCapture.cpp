@@ -0,0 +1,190 @@
+#include <Albuquerque/FrameCapture.hpp>
+
+#include <glad/glad.h>
+#include <spdlog/spdlog.h>
+
+//Static so these don't clash with the apps that define the implementations themselves
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        float PixelDifference(uint8_t const* a, uint8_t const* b)
+        {
+            //Cheap perceptual weighting, the weights shift with how red the pixels are
+            static const float max_distance = std::sqrt(9.0f * 255.0f * 255.0f);
+
+            float red_mean = (static_cast<float>(a[0]) + static_cast<float>(b[0])) * 0.5f;
+            float dr = static_cast<float>(a[0]) - static_cast<float>(b[0]);
+            float dg = static_cast<float>(a[1]) - static_cast<float>(b[1]);
+            float db = static_cast<float>(a[2]) - static_cast<float>(b[2]);
+
+            float distance = std::sqrt((2.0f + red_mean / 256.0f) * dr * dr + 4.0f * dg * dg + (2.0f + (255.0f - red_mean) / 256.0f) * db * db);
+            return distance / max_distance;
+        }
+
+        //Smallest difference against the golden's 3x3 neighbourhood around (x, y)
+        float NeighbourhoodDifference(CapturedImage const& image, CapturedImage const& golden, int32_t x, int32_t y)
+        {
+            uint8_t const* pixel = image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+
+            float smallest = 1.0f;
+            for (int32_t ny = std::max(y - 1, 0); ny <= std::min(y + 1, golden.height - 1); ++ny)
+            {
+                for (int32_t nx = std::max(x - 1, 0); nx <= std::min(x + 1, golden.width - 1); ++nx)
+                {
+                    uint8_t const* golden_pixel = golden.pixels.data() + (static_cast<size_t>(ny) * golden.width + nx) * 4;
+                    smallest = std::min(smallest, PixelDifference(pixel, golden_pixel));
+                }
+            }
+            return smallest;
+        }
+    }
+
+    CapturedImage CaptureBackBuffer(int32_t width, int32_t height)
+    {
+        CapturedImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+        GLint previous_read_fbo = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_fbo);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.data());
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previous_read_fbo);
+
+        //GL has the origin at the bottom left
+        size_t row_size = static_cast<size_t>(width) * 4;
+        std::vector<uint8_t> row(row_size);
+        for (int32_t y = 0; y < height / 2; ++y)
+        {
+            uint8_t* top = image.pixels.data() + static_cast<size_t>(y) * row_size;
+            uint8_t* bottom = image.pixels.data() + static_cast<size_t>(height - 1 - y) * row_size;
+            std::memcpy(row.data(), top, row_size);
+            std::memcpy(top, bottom, row_size);
+            std::memcpy(bottom, row.data(), row_size);
+        }
+
+        return image;
+    }
+
+    bool WritePng(std::string const& file_path, CapturedImage const& image)
+    {
+        std::filesystem::path path(file_path);
+        if (path.has_parent_path())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+
+        if (!stbi_write_png(file_path.c_str(), image.width, image.height, 4, image.pixels.data(), image.width * 4))
+        {
+            spdlog::error("FrameCapture: Unable to write {}", file_path);
+            return false;
+        }
+        return true;
+    }
+
+    bool LoadPng(std::string const& file_path, CapturedImage& image)
+    {
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t channels = 0;
+
+        unsigned char* pixels = stbi_load(file_path.c_str(), &width, &height, &channels, 4);
+        if (pixels == nullptr)
+            return false;
+
+        image.width = width;
+        image.height = height;
+        image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    ImageCompareResult CompareImages(CapturedImage const& image, CapturedImage const& golden, float pixel_tolerance, float max_failed_pixel_fraction)
+    {
+        ImageCompareResult result;
+        if (image.width != golden.width || image.height != golden.height || image.pixels.empty())
+            return result;
+
+        result.size_matches = true;
+
+        double difference_sum = 0.0;
+        float max_difference = 0.0f;
+        uint32_t failed_pixels = 0;
+
+        for (int32_t y = 0; y < image.height; ++y)
+        {
+            for (int32_t x = 0; x < image.width; ++x)
+            {
+                size_t index = (static_cast<size_t>(y) * image.width + x) * 4;
+                float difference = PixelDifference(image.pixels.data() + index, golden.pixels.data() + index);
+
+                difference_sum += difference;
+                max_difference = std::max(max_difference, difference);
+
+                if (difference > pixel_tolerance && NeighbourhoodDifference(image, golden, x, y) > pixel_tolerance)
+                {
+                    failed_pixels += 1;
+                }
+            }
+        }
+
+        float pixel_count = static_cast<float>(image.width) * static_cast<float>(image.height);
+        result.failed_pixels = failed_pixels;
+        result.failed_pixel_fraction = static_cast<float>(failed_pixels) / pixel_count;
+        result.mean_difference = static_cast<float>(difference_sum / pixel_count);
+        result.max_difference = max_difference;
+        result.passed = result.failed_pixel_fraction <= max_failed_pixel_fraction;
+        return result;
+    }
+
+    CapturedImage MakeDifferenceImage(CapturedImage const& image, CapturedImage const& golden, float pixel_tolerance)
+    {
+        CapturedImage difference_image = image;
+        if (image.width != golden.width || image.height != golden.height)
+            return difference_image;
+
+        for (int32_t y = 0; y < image.height; ++y)
+        {
+            for (int32_t x = 0; x < image.width; ++x)
+            {
+                uint8_t* pixel = difference_image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+                if (NeighbourhoodDifference(image, golden, x, y) > pixel_tolerance)
+                {
+                    pixel[0] = 255;
+                    pixel[1] = 0;
+                    pixel[2] = 0;
+                }
+                else
+                {
+                    pixel[0] /= 4;
+                    pixel[1] /= 4;
+                    pixel[2] /= 4;
+                }
+                pixel[3] = 255;
+            }
+        }
+
+        return difference_image;
+    }
+}
@@ -0,0 +1,109 @@
+#include <Albuquerque/FrameTiming.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Albuquerque
+{
+    FixedTimestep::FixedTimestep(double tick_rate_hz, uint32_t max_steps_per_frame)
+        : step_dt(1.0 / tick_rate_hz), max_steps_per_frame(max_steps_per_frame)
+    {
+    }
+
+    void FixedTimestep::SetTickRate(double tick_rate_hz)
+    {
+        if (tick_rate_hz <= 0.0)
+            return;
+
+        //Keep the same fraction of a step so interpolation does not jump
+        double alpha = Alpha();
+        step_dt = 1.0 / tick_rate_hz;
+        accumulator = alpha * step_dt;
+    }
+
+    void FixedTimestep::SetMaxStepsPerFrame(uint32_t max_steps)
+    {
+        max_steps_per_frame = std::max(max_steps, 1u);
+    }
+
+    uint32_t FixedTimestep::Advance(double frame_dt)
+    {
+        accumulator += std::max(frame_dt, 0.0);
+
+        uint32_t steps = 0;
+        while (accumulator >= step_dt && steps < max_steps_per_frame)
+        {
+            accumulator -= step_dt;
+            steps += 1;
+        }
+
+        if (accumulator >= step_dt)
+        {
+            //Keep the leftover fraction so interpolation still lines up
+            double leftover = std::fmod(accumulator, step_dt);
+            dropped_time += accumulator - leftover;
+            accumulator = leftover;
+        }
+
+        tick_count += steps;
+        return steps;
+    }
+
+    void FixedTimestep::Reset()
+    {
+        accumulator = 0.0;
+        tick_count = 0;
+        dropped_time = 0.0;
+    }
+
+    void FramePacer::SetTargetFps(double fps)
+    {
+        target_fps = std::max(fps, 0.0);
+        has_deadline = false;
+    }
+
+    void FramePacer::SetSpinThreshold(double milliseconds)
+    {
+        spin_threshold = std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double, std::milli>(std::max(milliseconds, 0.0)));
+    }
+
+    void FramePacer::WaitForNextFrame()
+    {
+        if (target_fps <= 0.0)
+        {
+            has_deadline = false;
+            return;
+        }
+
+        auto frame_duration = std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(1.0 / target_fps));
+        auto now = clock_t::now();
+
+        if (!has_deadline)
+        {
+            next_frame_deadline = now + frame_duration;
+            has_deadline = true;
+        }
+
+        if (now < next_frame_deadline - spin_threshold)
+        {
+            std::this_thread::sleep_for(next_frame_deadline - spin_threshold - now);
+        }
+
+        while (clock_t::now() < next_frame_deadline)
+        {
+            std::this_thread::yield();
+        }
+
+        now = clock_t::now();
+        last_overshoot_ms = std::chrono::duration<double, std::milli>(now - next_frame_deadline).count();
+
+        //Deadlines advance by exactly one frame so the average rate is exact. If a frame was so slow it missed the
+        //next deadline too, start over from now instead of rushing to catch up
+        next_frame_deadline += frame_duration;
+        if (next_frame_deadline < now)
+        {
+            next_frame_deadline = now + frame_duration;
+        }
+    }
+}
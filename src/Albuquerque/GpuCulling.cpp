@@ -0,0 +1,342 @@
+#include <Albuquerque/GpuCulling.hpp>
+#include <Albuquerque/HiZ.hpp>
+#include <Albuquerque/Profiler.hpp>
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr char cull_shader_path[] = "./data/shaders/gpu_cull.comp.glsl";
+        constexpr char compact_shader_path[] = "./data/shaders/gpu_cull_compact.comp.glsl";
+
+        //Matches local_size_x in both shaders
+        constexpr uint32_t workgroup_size = 64;
+
+        std::string LoadFile(std::string_view path)
+        {
+            std::ifstream file{path.data()};
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        Fwog::ComputePipeline MakeComputePipeline(std::string_view path)
+        {
+            auto shader = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, LoadFile(path));
+            return Fwog::ComputePipeline{{.shader = &shader}};
+        }
+
+        uint32_t GroupCount(uint32_t count)
+        {
+            return (count + workgroup_size - 1) / workgroup_size;
+        }
+    }
+
+    GpuCullObject GpuCulling::PackAABB(glm::vec3 center, glm::vec3 half_extents, uint32_t mesh_index, uint32_t object_index, uint32_t flags)
+    {
+        GpuCullObject object;
+        object.center = center;
+        object.radius = glm::length(half_extents);
+        object.half_extents = half_extents;
+        object.mesh_index = mesh_index;
+        object.object_index = object_index;
+        object.flags = flags;
+        return object;
+    }
+
+    GpuCullObject GpuCulling::PackSphere(glm::vec3 center, float radius, uint32_t mesh_index, uint32_t object_index, uint32_t flags)
+    {
+        //The box around the sphere never culls more than the sphere itself, so the shader can run both tests
+        return PackAABB(center, glm::vec3(radius), mesh_index, object_index, flags);
+    }
+
+    std::vector<DrawElementsIndirectCommand> GpuCulling::BuildCommandLayout(std::span<GpuCullMesh const> meshes, std::span<GpuCullObject const> objects)
+    {
+        std::vector<uint32_t> objects_per_mesh(meshes.size(), 0);
+        for (GpuCullObject const& object : objects)
+        {
+            objects_per_mesh[object.mesh_index] += 1;
+        }
+
+        return BuildCommandLayout(meshes, std::span<uint32_t const>(objects_per_mesh));
+    }
+
+    std::vector<DrawElementsIndirectCommand> GpuCulling::BuildCommandLayout(std::span<GpuCullMesh const> meshes, std::span<uint32_t const> objects_per_mesh)
+    {
+        std::vector<DrawElementsIndirectCommand> commands;
+        commands.reserve(meshes.size());
+
+        uint32_t base_instance = 0;
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            commands.push_back(DrawElementsIndirectCommand{
+                .index_count = meshes[i].index_count,
+                .instance_count = 0,
+                .first_index = meshes[i].first_index,
+                .base_vertex = meshes[i].base_vertex,
+                .base_instance = base_instance,
+            });
+            base_instance += objects_per_mesh[i];
+        }
+
+        return commands;
+    }
+
+    std::array<glm::vec4, 6> GpuCulling::ExtractFrustumPlanes(glm::mat4 const& view_proj)
+    {
+        //glm is column major, so the rows have to be put together by hand
+        auto row = [&](int i) { return glm::vec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]); };
+
+        std::array<glm::vec4, 6> planes = {
+            row(3) + row(0),
+            row(3) - row(0),
+            row(3) + row(1),
+            row(3) - row(1),
+            row(3) + row(2),
+            row(3) - row(2),
+        };
+
+        for (glm::vec4& plane : planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return planes;
+    }
+
+    bool GpuCulling::IsVisible(std::array<glm::vec4, 6> const& planes, GpuCullObject const& object)
+    {
+        if (object.flags & gpu_cull_hidden)
+            return false;
+
+        for (glm::vec4 const& plane : planes)
+        {
+            glm::vec3 normal = glm::vec3(plane);
+            float distance = glm::dot(normal, object.center) + plane.w;
+            if (distance < -object.radius)
+                return false;
+
+            //How far the box reaches towards the plane
+            float box_radius = glm::dot(glm::abs(normal), object.half_extents);
+            if (distance < -box_radius)
+                return false;
+        }
+
+        return true;
+    }
+
+    GpuCuller::GpuCuller(std::vector<GpuCullMesh> meshes)
+        : meshes(std::move(meshes)), objects_per_mesh(this->meshes.size(), 0)
+    {
+        cull_pipeline = MakeComputePipeline(cull_shader_path);
+        compact_pipeline = MakeComputePipeline(compact_shader_path);
+
+        auto mesh_count = std::max<size_t>(this->meshes.size(), 1);
+        command_buffer = Fwog::Buffer(mesh_count * sizeof(DrawElementsIndirectCommand), Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+        draw_buffer = Fwog::Buffer(mesh_count * sizeof(DrawElementsIndirectCommand));
+        draw_count_buffer = Fwog::Buffer(sizeof(uint32_t), Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+        draw_count_buffer->UpdateData(uint32_t(0), 0);
+
+        stats_buffer = Fwog::Buffer(stats_slots * stats_slot_size, Fwog::BufferStorageFlag::MAP_MEMORY);
+        stats_mapped = static_cast<uint32_t*>(stats_buffer->GetMappedPointer());
+        std::fill_n(stats_mapped, stats_slots * stats_slot_size / sizeof(uint32_t), 0u);
+
+        CreateBuffers();
+    }
+
+    GpuCuller::~GpuCuller()
+    {
+        for (void* fence : stats_fences)
+        {
+            if (fence)
+                glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+
+    void GpuCuller::CreateBuffers()
+    {
+        //At least double, so growing one object at a time stays amortized O(1)
+        object_capacity = std::max<size_t>({objects.size(), object_capacity * 2, 1});
+        object_buffer = Fwog::Buffer(object_capacity * sizeof(GpuCullObject), Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+        instance_index_buffer = Fwog::Buffer(object_capacity * sizeof(uint32_t));
+    }
+
+    void GpuCuller::UploadCommands()
+    {
+        //The ranges each mesh gets in the instance index buffer depend on how many objects use it
+        auto commands = GpuCulling::BuildCommandLayout(meshes, std::span<uint32_t const>(objects_per_mesh));
+        if (!commands.empty())
+            command_buffer->UpdateData(std::span<DrawElementsIndirectCommand const>(commands), 0);
+    }
+
+    void GpuCuller::SetObjects(std::span<GpuCullObject const> new_objects)
+    {
+        objects.assign(new_objects.begin(), new_objects.end());
+        if (objects.size() > object_capacity)
+            CreateBuffers();
+
+        if (!objects.empty())
+            object_buffer->UpdateData(std::span<GpuCullObject const>(objects), 0);
+
+        std::fill(objects_per_mesh.begin(), objects_per_mesh.end(), 0u);
+        for (GpuCullObject const& object : objects)
+        {
+            objects_per_mesh[object.mesh_index] += 1;
+        }
+        UploadCommands();
+    }
+
+    void GpuCuller::UpdateObject(uint32_t index, GpuCullObject const& object)
+    {
+        bool mesh_changed = objects[index].mesh_index != object.mesh_index;
+        if (mesh_changed)
+        {
+            objects_per_mesh[objects[index].mesh_index] -= 1;
+            objects_per_mesh[object.mesh_index] += 1;
+        }
+
+        objects[index] = object;
+        object_buffer->UpdateData(object, index * sizeof(GpuCullObject));
+
+        if (mesh_changed)
+            UploadCommands();
+    }
+
+    uint32_t GpuCuller::AddObject(GpuCullObject const& object)
+    {
+        auto index = ObjectCount();
+        objects.push_back(object);
+        objects_per_mesh[object.mesh_index] += 1;
+
+        if (objects.size() > object_capacity)
+        {
+            CreateBuffers();
+            object_buffer->UpdateData(std::span<GpuCullObject const>(objects), 0);
+        }
+        else
+        {
+            object_buffer->UpdateData(object, index * sizeof(GpuCullObject));
+        }
+
+        UploadCommands();
+        return index;
+    }
+
+    void GpuCuller::RemoveObject(uint32_t index)
+    {
+        auto last = ObjectCount() - 1;
+        objects_per_mesh[objects[index].mesh_index] -= 1;
+
+        if (index != last)
+        {
+            objects[index] = objects[last];
+            object_buffer->UpdateData(objects[index], index * sizeof(GpuCullObject));
+        }
+        objects.pop_back();
+
+        //Nothing past the count gets read, so the old last object can stay in the buffer
+        UploadCommands();
+    }
+
+    void GpuCuller::SetHidden(uint32_t index, bool hidden)
+    {
+        GpuCullObject object = objects[index];
+        object.flags = hidden ? (object.flags | gpu_cull_hidden) : (object.flags & ~gpu_cull_hidden);
+        UpdateObject(index, object);
+    }
+
+    void GpuCuller::ReadStats(uint32_t slot)
+    {
+        void*& fence = stats_fences[slot];
+        if (fence == nullptr)
+            return;
+
+        //Three culls ago, so this is almost never an actual wait
+        auto sync = static_cast<GLsync>(fence);
+        while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+        glDeleteSync(sync);
+        fence = nullptr;
+
+        uint32_t* counters = stats_mapped + slot * stats_slot_size / sizeof(uint32_t);
+        last_stats = Stats{
+            .visible = counters[0],
+            .frustum_culled = counters[1],
+            .occlusion_culled = counters[2],
+        };
+        std::fill_n(counters, 4, 0u);
+    }
+
+    void GpuCuller::Cull(glm::mat4 const& view_proj, UniformRing& frame_uniforms, HiZPyramid const* hiz)
+    {
+        if (objects.empty() || meshes.empty())
+            return;
+
+        ALBUQUERQUE_PROFILE_CPU("GPU Cull");
+        ALBUQUERQUE_PROFILE_GPU("GPU Cull");
+
+        uint32_t slot = static_cast<uint32_t>(cull_index % stats_slots);
+        ReadStats(slot);
+
+        bool use_hiz = hiz && hiz->IsValid();
+        CullUniforms uniforms{
+            .planes = GpuCulling::ExtractFrustumPlanes(view_proj),
+            .hiz_view_proj = use_hiz ? hiz->ViewProj() : glm::mat4(1.0f),
+            .hiz_size = use_hiz ? glm::vec2(hiz->Width(), hiz->Height()) : glm::vec2(0.0f),
+            .hiz_mip_count = use_hiz ? hiz->MipCount() : 0u,
+            .hiz_enabled = use_hiz ? 1u : 0u,
+            .object_count = ObjectCount(),
+            .mesh_count = MeshCount(),
+        };
+        UniformSlice uniform_slice = frame_uniforms.Push(uniforms);
+
+        Fwog::Compute("GPU Culling", [&]
+        {
+            UniformRing::BindUniform(0, uniform_slice);
+            Fwog::Cmd::BindStorageBuffer(0, object_buffer.value());
+            Fwog::Cmd::BindStorageBuffer(1, command_buffer.value());
+            Fwog::Cmd::BindStorageBuffer(2, instance_index_buffer.value());
+            Fwog::Cmd::BindStorageBuffer(3, draw_count_buffer.value());
+            Fwog::Cmd::BindStorageBuffer(4, draw_buffer.value());
+            Fwog::Cmd::BindStorageBuffer(5, stats_buffer.value(), slot * stats_slot_size, 4 * sizeof(uint32_t));
+            if (use_hiz)
+                Fwog::Cmd::BindSampledImage(0, hiz->Texture(), hiz->NearestSampler());
+
+            Fwog::Cmd::BindComputePipeline(cull_pipeline.value());
+            Fwog::Cmd::Dispatch(GroupCount(ObjectCount()), 1, 1);
+            Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT);
+
+            Fwog::Cmd::BindComputePipeline(compact_pipeline.value());
+            Fwog::Cmd::Dispatch(GroupCount(MeshCount()), 1, 1);
+            Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::COMMAND_BUFFER_BIT | Fwog::MemoryBarrierBit::SHADER_STORAGE_BIT);
+        });
+
+        //Shader writes to a persistently mapped buffer need this before the fence to be seen by the CPU
+        glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+        stats_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        cull_index += 1;
+    }
+
+    void GpuCuller::Draw(uint32_t instance_index_binding) const
+    {
+        if (objects.empty() || meshes.empty())
+            return;
+
+        Fwog::Cmd::BindStorageBuffer(instance_index_binding, instance_index_buffer.value());
+        Fwog::Cmd::DrawIndexedIndirectCount(draw_buffer.value(), 0, draw_count_buffer.value(), 0, MeshCount(), sizeof(DrawElementsIndirectCommand));
+    }
+}
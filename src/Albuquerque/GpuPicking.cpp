@@ -0,0 +1,152 @@
+#include <Albuquerque/GpuPicking.hpp>
+#include <Albuquerque/Profiler.hpp>
+
+#include <Fwog/Rendering.h>
+
+#include <glad/glad.h>
+
+#include <tracy/Tracy.hpp>
+
+#include <limits>
+
+namespace Albuquerque
+{
+    glm::mat4 GpuPicking::PickMatrix(glm::vec2 cursor, glm::vec2 viewport_size, uint32_t region_size)
+    {
+        //Where the cursor is in NDC, y flipped since GL counts from the bottom
+        glm::vec2 center = glm::vec2(2.0f * cursor.x / viewport_size.x - 1.0f, 1.0f - 2.0f * cursor.y / viewport_size.y);
+        glm::vec2 scale = viewport_size / static_cast<float>(region_size);
+
+        //x' = scale * (x - center * w), so the region ends up at -1 to 1 after the divide
+        glm::mat4 pick(1.0f);
+        pick[0][0] = scale.x;
+        pick[1][1] = scale.y;
+        pick[3][0] = -scale.x * center.x;
+        pick[3][1] = -scale.y * center.y;
+        return pick;
+    }
+
+    uint32_t GpuPicking::ResolveRegion(std::span<uint32_t const> ids, uint32_t region_size)
+    {
+        //The middle pixel is the one under the cursor, region_size is odd so there is one
+        auto middle = static_cast<int32_t>(region_size / 2);
+
+        uint32_t closest = 0;
+        int32_t closest_distance = std::numeric_limits<int32_t>::max();
+        for (uint32_t y = 0; y < region_size; ++y)
+        {
+            for (uint32_t x = 0; x < region_size; ++x)
+            {
+                uint32_t id = ids[y * region_size + x];
+                int32_t dx = static_cast<int32_t>(x) - middle;
+                int32_t dy = static_cast<int32_t>(y) - middle;
+                int32_t distance = dx * dx + dy * dy;
+                if (id != 0 && distance < closest_distance)
+                {
+                    closest = id;
+                    closest_distance = distance;
+                }
+            }
+        }
+
+        return closest;
+    }
+
+    GpuPicker::GpuPicker(uint32_t region_size)
+        : region_size(region_size | 1u)
+    {
+        Fwog::Extent2D extent{this->region_size, this->region_size};
+        id_texture = Fwog::CreateTexture2D(extent, Fwog::Format::R32_UINT, "Pick Ids");
+        depth_texture = Fwog::CreateTexture2D(extent, Fwog::Format::D32_FLOAT, "Pick Depth");
+
+        size_t region_bytes = this->region_size * this->region_size * sizeof(uint32_t);
+        readback_buffer = Fwog::Buffer(readback_slots * region_bytes, Fwog::BufferStorageFlag::MAP_MEMORY);
+        readback_mapped = static_cast<uint32_t const*>(readback_buffer->GetMappedPointer());
+    }
+
+    GpuPicker::~GpuPicker()
+    {
+        for (Readback& readback : readbacks)
+        {
+            if (readback.fence)
+                glDeleteSync(static_cast<GLsync>(readback.fence));
+        }
+    }
+
+    void GpuPicker::Request(glm::vec2 cursor)
+    {
+        requested_cursor = cursor;
+        has_request = true;
+    }
+
+    void GpuPicker::Render(glm::mat4 const& view_proj, glm::vec2 viewport_size, std::function<void(glm::mat4 const&)> const& draw)
+    {
+        //Every slot still waiting on the GPU, the request keeps until one lands
+        if (!has_request || started - polled >= readback_slots)
+            return;
+
+        ALBUQUERQUE_PROFILE_CPU("Mouse Pick");
+        ALBUQUERQUE_PROFILE_GPU("Mouse Pick");
+
+        has_request = false;
+        glm::mat4 pick_view_proj = GpuPicking::PickMatrix(requested_cursor, viewport_size, region_size) * view_proj;
+
+        Fwog::RenderAttachment id_attachment{
+            .texture = &id_texture.value(),
+            .clearValue = Fwog::ClearColorValue{0u, 0u, 0u, 0u},
+            .loadOp = Fwog::AttachmentLoadOp::CLEAR};
+        Fwog::RenderAttachment depth_attachment{
+            .texture = &depth_texture.value(),
+            .clearValue = Fwog::ClearDepthStencilValue{.depth = 1.0f},
+            .loadOp = Fwog::AttachmentLoadOp::CLEAR};
+
+        Fwog::Render(Fwog::RenderInfo{
+            .name = "Mouse Pick",
+            .colorAttachments = {&id_attachment, 1},
+            .depthAttachment = &depth_attachment},
+        [&]
+        {
+            draw(pick_view_proj);
+        });
+
+        //Straight into the mapped buffer, nothing waits for it here
+        auto slot = static_cast<uint32_t>(started % readback_slots);
+        size_t region_bytes = region_size * region_size * sizeof(uint32_t);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffer->Handle());
+        glGetTextureImage(id_texture->Handle(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, static_cast<GLsizei>(region_bytes),
+            reinterpret_cast<void*>(slot * region_bytes));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+
+        readbacks[slot] = Readback{
+            .fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+            .cursor = requested_cursor,
+        };
+        started += 1;
+    }
+
+    bool GpuPicker::Poll(Result& result)
+    {
+        if (polled == started)
+            return false;
+
+        auto slot = static_cast<uint32_t>(polled % readback_slots);
+        Readback& readback = readbacks[slot];
+        auto sync = static_cast<GLsync>(readback.fence);
+        //Flushing so a fence that is still only queued up gets to the GPU, but no waiting
+        GLenum status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return false;
+
+        glDeleteSync(sync);
+        readback.fence = nullptr;
+        polled += 1;
+
+        size_t region_pixels = region_size * region_size;
+        result = Result{
+            .id = GpuPicking::ResolveRegion({readback_mapped + slot * region_pixels, region_pixels}, region_size),
+            .cursor = readback.cursor,
+        };
+        return true;
+    }
+}
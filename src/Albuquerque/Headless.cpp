@@ -0,0 +1,185 @@
+#include <Albuquerque/Headless.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string_view>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        template <typename T, typename ParseFunc>
+        bool ParseValue(int argc, char* argv[], int& i, T& out, ParseFunc&& parse)
+        {
+            if (i + 1 >= argc)
+            {
+                spdlog::error("Headless: {} is missing a value", argv[i]);
+                return false;
+            }
+
+            try
+            {
+                out = static_cast<T>(parse(argv[i + 1]));
+            }
+            catch (...)
+            {
+                spdlog::error("Headless: Bad value '{}' for {}", argv[i + 1], argv[i]);
+                return false;
+            }
+
+            i += 1;
+            return true;
+        }
+
+        std::string EscapeJson(std::string_view text)
+        {
+            std::string escaped;
+            escaped.reserve(text.size());
+            for (char c : text)
+            {
+                if (c == '\\' || c == '"')
+                    escaped.push_back('\\');
+                escaped.push_back(c);
+            }
+            return escaped;
+        }
+
+        //Nearest rank, the list has to be sorted
+        double Percentile(std::vector<double> const& sorted, double percent)
+        {
+            if (sorted.empty())
+                return 0.0;
+
+            size_t rank = static_cast<size_t>(percent / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[std::min(rank, sorted.size() - 1)];
+        }
+    }
+
+    bool ParseHeadlessArguments(int argc, char* argv[], HeadlessSettings& settings)
+    {
+        auto to_uint = [](char const* s) { return std::stoul(s); };
+        auto to_double = [](char const* s) { return std::stod(s); };
+        auto to_string = [](char const* s) { return std::string(s); };
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+
+            bool ok = true;
+            if (arg == "--headless")
+                settings.enabled = true;
+            else if (arg == "--update-goldens")
+                settings.update_goldens = true;
+            else if (arg == "--frames")
+                ok = ParseValue(argc, argv, i, settings.frame_count, to_uint);
+            else if (arg == "--dt")
+                ok = ParseValue(argc, argv, i, settings.fixed_dt, to_double);
+            else if (arg == "--capture-every")
+                ok = ParseValue(argc, argv, i, settings.capture_every, to_uint);
+            else if (arg == "--capture-dir")
+                ok = ParseValue(argc, argv, i, settings.capture_directory, to_string);
+            else if (arg == "--golden-dir")
+                ok = ParseValue(argc, argv, i, settings.golden_directory, to_string);
+            else if (arg == "--tolerance")
+                ok = ParseValue(argc, argv, i, settings.pixel_tolerance, to_double);
+            else if (arg == "--max-failed-fraction")
+                ok = ParseValue(argc, argv, i, settings.max_failed_pixel_fraction, to_double);
+            else if (arg == "--report")
+                ok = ParseValue(argc, argv, i, settings.report_path, to_string);
+            else if (arg == "--frame-budget-ms")
+                ok = ParseValue(argc, argv, i, settings.frame_budget_ms, to_double);
+            else if (arg == "--profile")
+                ok = ParseValue(argc, argv, i, settings.profile_path, to_string);
+
+            if (!ok)
+                return false;
+        }
+
+        if (settings.fixed_dt <= 0.0)
+        {
+            spdlog::error("Headless: --dt has to be positive");
+            return false;
+        }
+
+        return true;
+    }
+
+    void FinalizeHeadlessReport(HeadlessReport& report, HeadlessSettings const& settings)
+    {
+        if (report.frame_cpu_ms.empty())
+            return;
+
+        std::vector<double> sorted = report.frame_cpu_ms;
+        std::sort(sorted.begin(), sorted.end());
+
+        report.mean_ms = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+        report.p50_ms = Percentile(sorted, 50.0);
+        report.p95_ms = Percentile(sorted, 95.0);
+        report.p99_ms = Percentile(sorted, 99.0);
+        report.max_ms = sorted.back();
+
+        //p95 rather than the max so one hitch from the OS does not fail the run
+        report.timing_passed = settings.frame_budget_ms <= 0.0 || report.p95_ms <= settings.frame_budget_ms;
+
+        report.images_passed = std::all_of(report.captures.begin(), report.captures.end(),
+            [](HeadlessCaptureResult const& capture) { return capture.passed; });
+    }
+
+    bool WriteHeadlessReport(std::string const& file_path, HeadlessReport const& report, HeadlessSettings const& settings)
+    {
+        std::filesystem::path path(file_path);
+        if (path.has_parent_path())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+
+        std::ofstream file(path);
+        if (!file.is_open())
+        {
+            spdlog::error("Headless: Unable to write report {}", file_path);
+            return false;
+        }
+
+        file << "{\n";
+        file << "  \"frames\": " << report.frame_cpu_ms.size() << ",\n";
+        file << "  \"fixed_dt\": " << settings.fixed_dt << ",\n";
+        file << "  \"frame_budget_ms\": " << settings.frame_budget_ms << ",\n";
+        file << "  \"cpu_ms\": { \"mean\": " << report.mean_ms << ", \"p50\": " << report.p50_ms << ", \"p95\": " << report.p95_ms
+             << ", \"p99\": " << report.p99_ms << ", \"max\": " << report.max_ms << " },\n";
+
+        file << "  \"frame_cpu_ms\": [";
+        for (size_t i = 0; i < report.frame_cpu_ms.size(); ++i)
+        {
+            file << (i == 0 ? "" : ", ") << report.frame_cpu_ms[i];
+        }
+        file << "],\n";
+
+        file << "  \"captures\": [\n";
+        for (size_t i = 0; i < report.captures.size(); ++i)
+        {
+            auto const& capture = report.captures[i];
+            file << "    { \"frame\": " << capture.frame_index
+                 << ", \"file\": \"" << EscapeJson(capture.file_path) << "\""
+                 << ", \"golden\": \"" << EscapeJson(capture.golden_path) << "\""
+                 << ", \"compared\": " << (capture.compared ? "true" : "false")
+                 << ", \"passed\": " << (capture.passed ? "true" : "false")
+                 << ", \"failed_pixel_fraction\": " << capture.failed_pixel_fraction
+                 << ", \"mean_difference\": " << capture.mean_difference
+                 << ", \"max_difference\": " << capture.max_difference << " }"
+                 << (i + 1 == report.captures.size() ? "\n" : ",\n");
+        }
+        file << "  ],\n";
+
+        file << "  \"timing_passed\": " << (report.timing_passed ? "true" : "false") << ",\n";
+        file << "  \"images_passed\": " << (report.images_passed ? "true" : "false") << ",\n";
+        file << "  \"passed\": " << (report.Passed() ? "true" : "false") << "\n";
+        file << "}\n";
+
+        return true;
+    }
+}
@@ -0,0 +1,299 @@
+#include <Albuquerque/HiZ.hpp>
+#include <Albuquerque/Profiler.hpp>
+
+#include <Fwog/Rendering.h>
+#include <Fwog/Shader.h>
+
+#include <glm/glm.hpp>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr char copy_shader_path[] = "./data/shaders/hiz_copy.comp.glsl";
+        constexpr char downsample_shader_path[] = "./data/shaders/hiz_downsample.comp.glsl";
+
+        //Matches local_size_x and local_size_y in both shaders
+        constexpr uint32_t workgroup_size = 8;
+
+        //Corners are numbered by bits, x is bit 0, y bit 1 and z bit 2
+        constexpr std::array<std::array<int, 3>, 12> box_triangles = {{
+            {0, 2, 6}, {0, 6, 4},
+            {1, 3, 7}, {1, 7, 5},
+            {0, 1, 5}, {0, 5, 4},
+            {2, 3, 7}, {2, 7, 6},
+            {0, 1, 3}, {0, 3, 2},
+            {4, 5, 7}, {4, 7, 6},
+        }};
+
+        std::string LoadFile(std::string_view path)
+        {
+            std::ifstream file{path.data()};
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        Fwog::ComputePipeline MakeComputePipeline(std::string_view path)
+        {
+            auto shader = Fwog::Shader(Fwog::PipelineStage::COMPUTE_SHADER, LoadFile(path));
+            return Fwog::ComputePipeline{{.shader = &shader}};
+        }
+
+        uint32_t GroupCount(uint32_t count)
+        {
+            return (count + workgroup_size - 1) / workgroup_size;
+        }
+
+        glm::vec3 BoxCorner(glm::vec3 center, glm::vec3 half_extents, int corner)
+        {
+            return center + half_extents * glm::vec3((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        }
+
+        float EdgeFunction(glm::vec2 a, glm::vec2 b, glm::vec2 p)
+        {
+            return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        }
+    }
+
+    HiZ::ScreenBounds HiZ::ProjectBox(glm::mat4 const& view_proj, glm::vec3 center, glm::vec3 half_extents)
+    {
+        ScreenBounds bounds;
+        bounds.uv_min = glm::vec2(1.0f);
+        bounds.uv_max = glm::vec2(0.0f);
+        bounds.nearest_depth = 1.0f;
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec4 clip = view_proj * glm::vec4(BoxCorner(center, half_extents, corner), 1.0f);
+            if (clip.w <= 1e-5f)
+            {
+                bounds.crosses_near_plane = true;
+                return bounds;
+            }
+
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            glm::vec2 uv = glm::vec2(ndc) * 0.5f + 0.5f;
+            bounds.uv_min = glm::min(bounds.uv_min, uv);
+            bounds.uv_max = glm::max(bounds.uv_max, uv);
+            bounds.nearest_depth = std::min(bounds.nearest_depth, ndc.z * 0.5f + 0.5f);
+        }
+
+        bounds.uv_min = glm::clamp(bounds.uv_min, glm::vec2(0.0f), glm::vec2(1.0f));
+        bounds.uv_max = glm::clamp(bounds.uv_max, glm::vec2(0.0f), glm::vec2(1.0f));
+        return bounds;
+    }
+
+    uint32_t HiZ::MipCount(uint32_t width, uint32_t height)
+    {
+        return 1 + static_cast<uint32_t>(std::floor(std::log2(static_cast<float>(std::max({width, height, 1u})))));
+    }
+
+    uint32_t HiZ::SelectMip(ScreenBounds const& bounds, uint32_t width, uint32_t height, uint32_t mip_count)
+    {
+        glm::vec2 size = (bounds.uv_max - bounds.uv_min) * glm::vec2(width, height);
+        float longest = std::max({size.x, size.y, 1.0f});
+        auto mip = static_cast<uint32_t>(std::ceil(std::log2(longest)));
+        return std::min(mip, mip_count - 1);
+    }
+
+    void HiZ::Downsample(std::vector<float> const& source, uint32_t source_width, uint32_t source_height,
+        std::vector<float>& destination, uint32_t destination_width, uint32_t destination_height)
+    {
+        destination.assign(static_cast<size_t>(destination_width) * destination_height, 0.0f);
+
+        for (uint32_t y = 0; y < destination_height; ++y)
+        {
+            //The last row also takes the leftover row of an odd sized source
+            uint32_t y_first = y * 2;
+            uint32_t y_last = (y + 1 == destination_height) ? source_height - 1 : std::min(y_first + 1, source_height - 1);
+
+            for (uint32_t x = 0; x < destination_width; ++x)
+            {
+                uint32_t x_first = x * 2;
+                uint32_t x_last = (x + 1 == destination_width) ? source_width - 1 : std::min(x_first + 1, source_width - 1);
+
+                float farthest = 0.0f;
+                for (uint32_t sy = y_first; sy <= y_last; ++sy)
+                {
+                    for (uint32_t sx = x_first; sx <= x_last; ++sx)
+                    {
+                        farthest = std::max(farthest, source[sy * source_width + sx]);
+                    }
+                }
+                destination[y * destination_width + x] = farthest;
+            }
+        }
+    }
+
+    HiZPyramid::HiZPyramid()
+    {
+        copy_pipeline = MakeComputePipeline(copy_shader_path);
+        downsample_pipeline = MakeComputePipeline(downsample_shader_path);
+
+        Fwog::SamplerState ss;
+        ss.minFilter = Fwog::Filter::NEAREST;
+        ss.magFilter = Fwog::Filter::NEAREST;
+        ss.mipmapFilter = Fwog::Filter::NEAREST;
+        ss.addressModeU = Fwog::AddressMode::CLAMP_TO_EDGE;
+        ss.addressModeV = Fwog::AddressMode::CLAMP_TO_EDGE;
+        nearest_sampler = Fwog::Sampler(ss);
+    }
+
+    void HiZPyramid::Build(Fwog::Texture const& depth, glm::mat4 const& view_proj)
+    {
+        ALBUQUERQUE_PROFILE_CPU("Hi-Z Build");
+        ALBUQUERQUE_PROFILE_GPU("Hi-Z Build");
+
+        Fwog::Extent3D extent = depth.Extent();
+        if (!pyramid || extent.width != width || extent.height != height)
+        {
+            width = extent.width;
+            height = extent.height;
+            mip_count = HiZ::MipCount(width, height);
+            pyramid = Fwog::CreateTexture2DMip({width, height}, Fwog::Format::R32_FLOAT, mip_count, "Hi-Z Pyramid");
+        }
+
+        Fwog::Compute("Hi-Z Build", [&]
+        {
+            Fwog::Cmd::BindComputePipeline(copy_pipeline.value());
+            Fwog::Cmd::BindSampledImage(0, depth, nearest_sampler.value());
+            Fwog::Cmd::BindImage(0, pyramid.value(), 0);
+            Fwog::Cmd::Dispatch(GroupCount(width), GroupCount(height), 1);
+
+            Fwog::Cmd::BindComputePipeline(downsample_pipeline.value());
+            for (uint32_t level = 1; level < mip_count; ++level)
+            {
+                Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::IMAGE_ACCESS_BIT);
+
+                Fwog::Cmd::BindImage(0, pyramid.value(), level - 1);
+                Fwog::Cmd::BindImage(1, pyramid.value(), level);
+                Fwog::Cmd::Dispatch(GroupCount(std::max(width >> level, 1u)), GroupCount(std::max(height >> level, 1u)), 1);
+            }
+
+            Fwog::MemoryBarrier(Fwog::MemoryBarrierBit::TEXTURE_FETCH_BIT);
+        });
+
+        this->view_proj = view_proj;
+        valid = true;
+    }
+
+    SoftwareOcclusion::SoftwareOcclusion(uint32_t width, uint32_t height)
+        : width(width), height(height)
+    {
+        uint32_t mip_count = HiZ::MipCount(width, height);
+        levels.resize(mip_count);
+        level_sizes.resize(mip_count);
+
+        for (uint32_t level = 0; level < mip_count; ++level)
+        {
+            level_sizes[level] = glm::uvec2(std::max(width >> level, 1u), std::max(height >> level, 1u));
+            levels[level].assign(static_cast<size_t>(level_sizes[level].x) * level_sizes[level].y, 1.0f);
+        }
+    }
+
+    void SoftwareOcclusion::Begin(glm::mat4 const& view_proj)
+    {
+        this->view_proj = view_proj;
+        std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+    }
+
+    void SoftwareOcclusion::AddOccluder(glm::vec3 center, glm::vec3 half_extents)
+    {
+        std::array<glm::vec3, 8> screen;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec4 clip = view_proj * glm::vec4(BoxCorner(center, half_extents, corner), 1.0f);
+
+            //Clipping isn't worth it for an occluder, leaving one out only means less gets culled
+            if (clip.w <= 1e-5f)
+                return;
+
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            if (ndc.z < -1.0f)
+                return;
+
+            screen[corner] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+        }
+
+        for (auto const& triangle : box_triangles)
+        {
+            RasterizeTriangle(screen[triangle[0]], screen[triangle[1]], screen[triangle[2]]);
+        }
+    }
+
+    void SoftwareOcclusion::RasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        float area = EdgeFunction(glm::vec2(a), glm::vec2(b), glm::vec2(c));
+        if (std::abs(area) < 1e-8f)
+            return;
+
+        float min_x = std::max(std::floor(std::min({a.x, b.x, c.x})), 0.0f);
+        float min_y = std::max(std::floor(std::min({a.y, b.y, c.y})), 0.0f);
+        float max_x = std::min(std::ceil(std::max({a.x, b.x, c.x})), static_cast<float>(width) - 1.0f);
+        float max_y = std::min(std::ceil(std::max({a.y, b.y, c.y})), static_cast<float>(height) - 1.0f);
+        if (min_x > max_x || min_y > max_y)
+            return;
+
+        std::vector<float>& depth = levels[0];
+        for (auto y = static_cast<uint32_t>(min_y); y <= static_cast<uint32_t>(max_y); ++y)
+        {
+            for (auto x = static_cast<uint32_t>(min_x); x <= static_cast<uint32_t>(max_x); ++x)
+            {
+                glm::vec2 p(x + 0.5f, y + 0.5f);
+
+                //Divided by the area so they come out positive inside either winding
+                float w0 = EdgeFunction(glm::vec2(b), glm::vec2(c), p) / area;
+                float w1 = EdgeFunction(glm::vec2(c), glm::vec2(a), p) / area;
+                float w2 = EdgeFunction(glm::vec2(a), glm::vec2(b), p) / area;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    continue;
+
+                //Depth after the divide is linear in screen space
+                float z = w0 * a.z + w1 * b.z + w2 * c.z;
+                float& stored = depth[y * width + x];
+                stored = std::min(stored, z);
+            }
+        }
+    }
+
+    void SoftwareOcclusion::Finish()
+    {
+        ALBUQUERQUE_PROFILE_CPU("Software Occlusion Raster");
+        for (size_t level = 1; level < levels.size(); ++level)
+        {
+            HiZ::Downsample(levels[level - 1], level_sizes[level - 1].x, level_sizes[level - 1].y, levels[level], level_sizes[level].x, level_sizes[level].y);
+        }
+    }
+
+    bool SoftwareOcclusion::IsOccluded(glm::vec3 center, glm::vec3 half_extents) const
+    {
+        HiZ::ScreenBounds bounds = HiZ::ProjectBox(view_proj, center, half_extents);
+        if (bounds.crosses_near_plane || bounds.uv_min.x > bounds.uv_max.x || bounds.uv_min.y > bounds.uv_max.y)
+            return false;
+
+        uint32_t level = HiZ::SelectMip(bounds, width, height, static_cast<uint32_t>(levels.size()));
+        glm::uvec2 size = level_sizes[level];
+
+        glm::uvec2 texel_min = glm::min(glm::uvec2(bounds.uv_min * glm::vec2(size)), size - 1u);
+        glm::uvec2 texel_max = glm::min(glm::uvec2(bounds.uv_max * glm::vec2(size)), size - 1u);
+
+        float farthest = 0.0f;
+        for (uint32_t y = texel_min.y; y <= texel_max.y; ++y)
+        {
+            for (uint32_t x = texel_min.x; x <= texel_max.x; ++x)
+            {
+                farthest = std::max(farthest, levels[level][y * size.x + x]);
+            }
+        }
+
+        return bounds.nearest_depth > farthest;
+    }
+}
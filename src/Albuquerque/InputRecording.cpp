@@ -0,0 +1,240 @@
+#include <Albuquerque/InputRecording.hpp>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr char recording_magic[4] = {'A', 'Q', 'I', 'R'};
+        constexpr uint32_t recording_version = 1;
+
+        //Per frame flag, the full InputState follows
+        constexpr uint8_t frame_state_changed = 1u << 0;
+
+        template <typename T>
+        bool Write(std::FILE* file, T const& value)
+        {
+            return std::fwrite(&value, sizeof(T), 1, file) == 1;
+        }
+
+        template <typename T>
+        bool Read(std::FILE* file, T& value)
+        {
+            return std::fread(&value, sizeof(T), 1, file) == 1;
+        }
+
+        //Field by field so padding never ends up in the file
+        bool WriteState(std::FILE* file, InputState const& state)
+        {
+            bool ok = true;
+            for (uint64_t bits : state.keys)
+                ok &= Write(file, bits);
+            ok &= Write(file, state.mouse_buttons);
+            ok &= Write(file, state.mouse_x);
+            ok &= Write(file, state.mouse_y);
+            return ok;
+        }
+
+        bool ReadState(std::FILE* file, InputState& state)
+        {
+            bool ok = true;
+            for (uint64_t& bits : state.keys)
+                ok &= Read(file, bits);
+            ok &= Read(file, state.mouse_buttons);
+            ok &= Read(file, state.mouse_x);
+            ok &= Read(file, state.mouse_y);
+            return ok;
+        }
+    }
+
+    bool InputState::Key(int32_t key) const
+    {
+        if (key < 0 || key >= key_count)
+            return false;
+        return (keys[key / 64] >> (key % 64)) & 1u;
+    }
+
+    void InputState::SetKey(int32_t key, bool down)
+    {
+        if (key < 0 || key >= key_count)
+            return;
+
+        uint64_t bit = uint64_t(1) << (key % 64);
+        keys[key / 64] = down ? (keys[key / 64] | bit) : (keys[key / 64] & ~bit);
+    }
+
+    bool InputState::MouseButton(int32_t button) const
+    {
+        if (button < 0 || button >= mouse_button_count)
+            return false;
+        return (mouse_buttons >> button) & 1u;
+    }
+
+    void InputState::SetMouseButton(int32_t button, bool down)
+    {
+        if (button < 0 || button >= mouse_button_count)
+            return;
+
+        uint8_t bit = static_cast<uint8_t>(1u << button);
+        mouse_buttons = static_cast<uint8_t>(down ? (mouse_buttons | bit) : (mouse_buttons & ~bit));
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        Close();
+    }
+
+    bool InputRecorder::Open(std::string const& file_path, double tick_rate)
+    {
+        Close();
+
+        std::filesystem::path path(file_path);
+        if (path.has_parent_path())
+        {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+
+        file = std::fopen(file_path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            spdlog::error("Input: Unable to write recording {}", file_path);
+            return false;
+        }
+
+        std::fwrite(recording_magic, 1, sizeof(recording_magic), file);
+        Write(file, recording_version);
+        Write(file, tick_rate);
+
+        frame_count = 0;
+        previous_state = InputState{};
+        return true;
+    }
+
+    void InputRecorder::WriteFrame(InputFrame const& frame)
+    {
+        if (file == nullptr)
+            return;
+
+        //The first frame always has the state so a replay never depends on the defaults
+        bool changed = frame_count == 0 || frame.state != previous_state;
+        uint8_t flags = changed ? frame_state_changed : 0;
+
+        Write(file, frame.dt);
+        Write(file, static_cast<uint8_t>(std::min(frame.steps, 255u)));
+        Write(file, flags);
+        if (changed)
+            WriteState(file, frame.state);
+
+        previous_state = frame.state;
+        frame_count += 1;
+    }
+
+    void InputRecorder::Close()
+    {
+        if (file == nullptr)
+            return;
+
+        std::fclose(file);
+        file = nullptr;
+        spdlog::info("Input: Recorded {} frames", frame_count);
+    }
+
+    bool InputReplay::Open(std::string const& file_path)
+    {
+        frames.clear();
+        next_frame = 0;
+
+        std::FILE* file = std::fopen(file_path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            spdlog::error("Input: Unable to open recording {}", file_path);
+            return false;
+        }
+
+        char magic[4] = {};
+        uint32_t version = 0;
+        bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, recording_magic, sizeof(magic)) == 0;
+        ok = ok && Read(file, version) && version == recording_version;
+        ok = ok && Read(file, tick_rate);
+        if (!ok)
+        {
+            spdlog::error("Input: {} is not a recording this version can read", file_path);
+            std::fclose(file);
+            return false;
+        }
+
+        InputState state;
+        double dt = 0.0;
+        while (Read(file, dt))
+        {
+            uint8_t steps = 0;
+            uint8_t flags = 0;
+            if (!Read(file, steps) || !Read(file, flags) || ((flags & frame_state_changed) && !ReadState(file, state)))
+            {
+                //A recording cut short by a crash still plays up to there
+                spdlog::warn("Input: {} ends in the middle of a frame", file_path);
+                break;
+            }
+
+            frames.push_back(InputFrame{dt, steps, state});
+        }
+
+        std::fclose(file);
+        spdlog::info("Input: Loaded {} frames from {}", frames.size(), file_path);
+        return true;
+    }
+
+    bool InputReplay::NextFrame(InputFrame& frame)
+    {
+        if (Finished())
+            return false;
+
+        frame = frames[next_frame++];
+        return true;
+    }
+
+    bool ParseInputArguments(int argc, char* argv[], InputSettings& settings)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string_view arg = argv[i];
+            bool takes_value = arg == "--record" || arg == "--replay" || arg == "--benchmark" || arg == "--benchmark-report";
+            if (!takes_value)
+                continue;
+
+            if (i + 1 >= argc)
+            {
+                spdlog::error("Input: {} is missing a value", arg);
+                return false;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--record")
+                settings.record_path = value;
+            else if (arg == "--replay")
+                settings.replay_path = value;
+            else if (arg == "--benchmark")
+            {
+                settings.replay_path = value;
+                settings.benchmark = true;
+            }
+            else
+                settings.benchmark_report_path = value;
+        }
+
+        if (!settings.record_path.empty() && !settings.replay_path.empty())
+        {
+            spdlog::error("Input: Can't record and replay in the same run");
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,257 @@
+#include <Albuquerque/JobSystem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <tracy/Tracy.hpp>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        thread_local int32_t current_thread_index = -1;
+
+        //How many times an idle worker looks for work before going to sleep
+        constexpr uint32_t idle_spin_count = 64;
+    }
+
+    bool WorkStealingDeque::Push(Job* job)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+
+        if (b - t >= capacity)
+            return false;
+
+        buffer[b & mask].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Job* WorkStealingDeque::Pop()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            //Was empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* job = buffer[b & mask].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            //Last job, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return job;
+    }
+
+    Job* WorkStealingDeque::Steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return nullptr;
+
+        Job* job = buffer[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return job;
+    }
+
+    JobSystem& JobSystem::Instance()
+    {
+        //The main thread runs jobs too while it waits, so it takes one core. Leave another for whatever else the
+        //OS (or our render thread) is doing, but always start at least one worker
+        static JobSystem instance(std::max(std::thread::hardware_concurrency(), 3u) - 2u);
+        return instance;
+    }
+
+    JobSystem::JobSystem(uint32_t worker_thread_count)
+    {
+        workers.reserve(worker_thread_count + 1);
+        for (uint32_t i = 0; i < worker_thread_count + 1; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>());
+        }
+
+        current_thread_index = 0;
+
+        for (uint32_t i = 1; i < workers.size(); ++i)
+        {
+            workers[i]->thread = std::thread(&JobSystem::WorkerMain, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock(sleep_mutex);
+            stopping.store(true);
+        }
+        sleep_condition.notify_all();
+
+        for (auto& worker : workers)
+        {
+            if (worker->thread.joinable())
+                worker->thread.join();
+        }
+    }
+
+    int32_t JobSystem::CurrentThreadIndex()
+    {
+        return current_thread_index;
+    }
+
+    Job* JobSystem::AllocateJob(Worker& worker)
+    {
+        Job& job = (*worker.job_pool)[worker.job_pool_cursor];
+        if (job.in_use.load(std::memory_order_acquire))
+            return nullptr;
+
+        worker.job_pool_cursor = (worker.job_pool_cursor + 1) % job_pool_size;
+        job.in_use.store(true, std::memory_order_relaxed);
+        return &job;
+    }
+
+    void JobSystem::Submit(Worker& worker, Job* job)
+    {
+        //Counted before the push so a thief can never take it before it's counted
+        queued_jobs.fetch_add(1, std::memory_order_seq_cst);
+
+        if (!worker.deque.Push(job))
+        {
+            //Deque is full, no point queueing more
+            queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+            Execute(job);
+            return;
+        }
+
+        //Only pay for the lock when someone is actually asleep. Taking it makes sure a worker that is between
+        //checking for work and going to sleep doesn't miss the notify
+        if (sleeping_workers.load(std::memory_order_seq_cst) > 0)
+        {
+            std::lock_guard lock(sleep_mutex);
+        }
+        sleep_condition.notify_one();
+    }
+
+    Job* JobSystem::FindJob(uint32_t thread_index)
+    {
+        if (Job* job = workers[thread_index]->deque.Pop())
+            return job;
+
+        //Random victim so the thieves don't all pile onto the same deque
+        thread_local std::minstd_rand random_engine(thread_index + 1);
+        uint32_t thread_count = ThreadCount();
+        uint32_t start = random_engine() % thread_count;
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            uint32_t victim = (start + i) % thread_count;
+            if (victim == thread_index)
+                continue;
+
+            if (Job* job = workers[victim]->deque.Steal())
+            {
+                jobs_stolen.fetch_add(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void JobSystem::Execute(Job* job)
+    {
+        //Helping with other jobs while waiting is what keeps dependencies from deadlocking
+        if (job->dependency)
+            Wait(*job->dependency);
+
+        {
+            ZoneScopedC(tracy::Color::Orange);
+            if (job->name)
+            {
+                ZoneName(job->name, std::strlen(job->name));
+            }
+
+            job->function(job->storage);
+            job->destroy(job->storage);
+        }
+
+        JobCounter* counter = job->counter;
+        job->in_use.store(false, std::memory_order_release);
+        jobs_executed.fetch_add(1, std::memory_order_relaxed);
+
+        if (counter)
+            counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void JobSystem::Wait(JobCounter const& counter)
+    {
+        int32_t thread_index = CurrentThreadIndex();
+
+        while (!counter.IsDone())
+        {
+            Job* job = thread_index >= 0 ? FindJob(static_cast<uint32_t>(thread_index)) : nullptr;
+            if (job)
+            {
+                queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+                Execute(job);
+            }
+            else
+            {
+                //Whatever we're waiting for is running on another thread
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::WorkerMain(uint32_t thread_index)
+    {
+        current_thread_index = static_cast<int32_t>(thread_index);
+
+        std::string thread_name = "Job Worker " + std::to_string(thread_index);
+        tracy::SetThreadName(thread_name.c_str());
+
+        uint32_t idle_count = 0;
+        while (!stopping.load(std::memory_order_relaxed))
+        {
+            if (Job* job = FindJob(thread_index))
+            {
+                queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+                Execute(job);
+                idle_count = 0;
+                continue;
+            }
+
+            if (++idle_count < idle_spin_count)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mutex);
+            sleeping_workers.fetch_add(1, std::memory_order_seq_cst);
+            sleep_condition.wait(lock, [&]()
+            {
+                return stopping.load(std::memory_order_relaxed) || queued_jobs.load(std::memory_order_seq_cst) > 0;
+            });
+            sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+            idle_count = 0;
+        }
+    }
+}
@@ -0,0 +1,341 @@
+#include <Albuquerque/Memory.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        std::atomic<uint64_t> total_allocations{0};
+        std::atomic<uint64_t> total_frees{0};
+        std::atomic<uint64_t> total_bytes{0};
+
+        //Totals at the previous EndFrame
+        AllocationStats frame_start_totals;
+
+        size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    namespace MemoryTracking
+    {
+        bool IsEnabled()
+        {
+#ifdef ALBUQUERQUE_TRACK_ALLOCATIONS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        AllocationStats Totals()
+        {
+            AllocationStats stats;
+            stats.allocations = total_allocations.load(std::memory_order_relaxed);
+            stats.frees = total_frees.load(std::memory_order_relaxed);
+            stats.bytes = total_bytes.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        AllocationStats EndFrame()
+        {
+            AllocationStats totals = Totals();
+
+            AllocationStats frame;
+            frame.allocations = totals.allocations - frame_start_totals.allocations;
+            frame.frees = totals.frees - frame_start_totals.frees;
+            frame.bytes = totals.bytes - frame_start_totals.bytes;
+
+            frame_start_totals = totals;
+            return frame;
+        }
+    }
+
+    FrameArena::FrameArena(size_t capacity, std::pmr::memory_resource* upstream)
+        : upstream(upstream), capacity(capacity)
+    {
+        if (capacity > 0)
+            buffer = static_cast<std::byte*>(upstream->allocate(capacity, alignof(std::max_align_t)));
+    }
+
+    FrameArena::~FrameArena()
+    {
+        Reset();
+
+        if (buffer)
+            upstream->deallocate(buffer, capacity, alignof(std::max_align_t));
+    }
+
+    void* FrameArena::Allocate(size_t bytes, size_t alignment)
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+    {
+        size_t offset = AlignUp(used, alignment);
+        if (buffer && offset + bytes <= capacity)
+        {
+            used = offset + bytes;
+            return buffer + offset;
+        }
+
+        //Out of room, this frame gets the rest from upstream
+        void* memory = upstream->allocate(bytes, alignment);
+        overflow_blocks.push_back({memory, bytes, alignment});
+        overflow_bytes += bytes;
+        return memory;
+    }
+
+    void FrameArena::Reset()
+    {
+        high_water = std::max(high_water, used + overflow_bytes);
+
+        for (OverflowBlock const& block : overflow_blocks)
+        {
+            upstream->deallocate(block.memory, block.bytes, block.alignment);
+        }
+
+        //Grow once with some headroom so the next frame like this one fits
+        if (!overflow_blocks.empty())
+        {
+            if (buffer)
+                upstream->deallocate(buffer, capacity, alignof(std::max_align_t));
+
+            capacity = high_water + high_water / 2;
+            buffer = static_cast<std::byte*>(upstream->allocate(capacity, alignof(std::max_align_t)));
+        }
+
+        overflow_blocks.clear();
+        overflow_bytes = 0;
+        used = 0;
+    }
+
+    PoolAllocator::PoolAllocator(size_t block_size, size_t blocks_per_page, std::pmr::memory_resource* upstream)
+        : upstream(upstream),
+          block_size(AlignUp(std::max(block_size, sizeof(FreeBlock)), block_alignment)),
+          blocks_per_page(std::max<size_t>(blocks_per_page, 1))
+    {
+    }
+
+    PoolAllocator::~PoolAllocator()
+    {
+        for (void* page : pages)
+        {
+            upstream->deallocate(page, block_size * blocks_per_page, block_alignment);
+        }
+    }
+
+    void PoolAllocator::AddPage()
+    {
+        auto* page = static_cast<std::byte*>(upstream->allocate(block_size * blocks_per_page, block_alignment));
+        pages.push_back(page);
+
+        //Threaded back to front so blocks come out in address order
+        for (size_t i = blocks_per_page; i-- > 0;)
+        {
+            auto* block = reinterpret_cast<FreeBlock*>(page + i * block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+    }
+
+    void* PoolAllocator::Allocate()
+    {
+        if (free_list == nullptr)
+            AddPage();
+
+        FreeBlock* block = free_list;
+        free_list = block->next;
+        blocks_in_use += 1;
+        return block;
+    }
+
+    void PoolAllocator::Free(void* pointer)
+    {
+        if (pointer == nullptr)
+            return;
+
+        auto* block = static_cast<FreeBlock*>(pointer);
+        block->next = free_list;
+        free_list = block;
+        blocks_in_use -= 1;
+    }
+
+    void* PoolAllocator::do_allocate(size_t bytes, size_t alignment)
+    {
+        if (bytes > block_size || alignment > block_alignment)
+            return upstream->allocate(bytes, alignment);
+
+        return Allocate();
+    }
+
+    void PoolAllocator::do_deallocate(void* pointer, size_t bytes, size_t alignment)
+    {
+        if (bytes > block_size || alignment > block_alignment)
+        {
+            upstream->deallocate(pointer, bytes, alignment);
+            return;
+        }
+
+        Free(pointer);
+    }
+}
+
+#ifdef ALBUQUERQUE_TRACK_ALLOCATIONS
+
+//Replacing the global operator new is the only way to see allocations made inside the standard library and third
+//party code too. Sizes of frees aren't known for unsized delete so only allocated bytes are counted
+namespace
+{
+    void CountAllocation(std::size_t size)
+    {
+        Albuquerque::total_allocations.fetch_add(1, std::memory_order_relaxed);
+        Albuquerque::total_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void CountFree(void* pointer)
+    {
+        if (pointer)
+            Albuquerque::total_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* AlignedAllocate(std::size_t size, std::size_t alignment)
+    {
+#ifdef _MSC_VER
+        return _aligned_malloc(size ? size : 1, alignment);
+#else
+        //aligned_alloc wants the size to be a multiple of the alignment
+        std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+        return std::aligned_alloc(alignment, rounded);
+#endif
+    }
+
+    void AlignedFree(void* pointer)
+    {
+#ifdef _MSC_VER
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    CountAllocation(size);
+    if (void* pointer = std::malloc(size ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    CountAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    CountAllocation(size);
+    if (void* pointer = AlignedAllocate(size, static_cast<std::size_t>(alignment)))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept
+{
+    CountAllocation(size);
+    return AlignedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const& tag) noexcept
+{
+    return operator new(size, alignment, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    CountFree(pointer);
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::nothrow_t const&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::nothrow_t const&) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    CountFree(pointer);
+    AlignedFree(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment, std::nothrow_t const&) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment, std::nothrow_t const&) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+#endif
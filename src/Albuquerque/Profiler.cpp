@@ -0,0 +1,549 @@
+#include <Albuquerque/Profiler.hpp>
+
+#include <glad/glad.h>
+#include <imgui.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        constexpr uint64_t no_frame = std::numeric_limits<uint64_t>::max();
+        //Pushed for zones started outside a frame so the matching end has something to pop
+        constexpr uint32_t skipped_gpu_zone = std::numeric_limits<uint32_t>::max();
+
+        Profiler* active_profiler = nullptr;
+
+        struct ZoneRegistry
+        {
+            std::mutex mutex;
+            std::vector<std::pair<std::string, bool>> zones;
+        };
+
+        ZoneRegistry& Registry()
+        {
+            static ZoneRegistry registry;
+            return registry;
+        }
+
+        std::pair<std::string, bool> ZoneInfo(uint32_t zone)
+        {
+            ZoneRegistry& registry = Registry();
+            std::lock_guard lock(registry.mutex);
+            return registry.zones[zone];
+        }
+
+        //Nearest rank, the list has to be sorted
+        double Percentile(std::vector<double> const& sorted, double percent)
+        {
+            if (sorted.empty())
+                return 0.0;
+
+            size_t rank = static_cast<size_t>(percent / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[std::min(rank, sorted.size() - 1)];
+        }
+
+        std::ofstream OpenExportFile(std::string const& file_path)
+        {
+            std::filesystem::path path(file_path);
+            if (path.has_parent_path())
+            {
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+            }
+
+            std::ofstream file(path);
+            if (!file.is_open())
+            {
+                spdlog::error("Profiler: Unable to write {}", file_path);
+            }
+            return file;
+        }
+
+        float ZoneValue(Profiler::FrameRecord const& record, uint32_t zone)
+        {
+            return zone < record.zone_ms.size() ? record.zone_ms[zone] : 0.0f;
+        }
+    }
+
+    Profiler::Profiler(uint32_t history_size, uint32_t gpu_frames_in_flight)
+        : history(std::max(history_size, 1u)), gpu_frames(std::max(gpu_frames_in_flight, 1u))
+    {
+        for (FrameRecord& record : history)
+        {
+            record.frame = no_frame;
+        }
+
+        frame_gpu_zone = RegisterZone("GPU Frame", true);
+        active_profiler = this;
+    }
+
+    Profiler::~Profiler()
+    {
+        for (GpuFrame& gpu_frame : gpu_frames)
+        {
+            if (!gpu_frame.queries.empty())
+                glDeleteQueries(static_cast<GLsizei>(gpu_frame.queries.size()), gpu_frame.queries.data());
+        }
+
+        if (active_profiler == this)
+            active_profiler = nullptr;
+    }
+
+    Profiler* Profiler::Active()
+    {
+        return active_profiler;
+    }
+
+    uint32_t Profiler::RegisterZone(char const* name, bool gpu)
+    {
+        ZoneRegistry& registry = Registry();
+        std::lock_guard lock(registry.mutex);
+        for (uint32_t i = 0; i < registry.zones.size(); ++i)
+        {
+            if (registry.zones[i].second == gpu && registry.zones[i].first == name)
+                return i;
+        }
+
+        registry.zones.emplace_back(name, gpu);
+        return static_cast<uint32_t>(registry.zones.size() - 1);
+    }
+
+    uint32_t Profiler::ZoneCount()
+    {
+        ZoneRegistry& registry = Registry();
+        std::lock_guard lock(registry.mutex);
+        return static_cast<uint32_t>(registry.zones.size());
+    }
+
+    template <typename Function>
+    void Profiler::UpdateFrame(uint64_t frame, Function&& update)
+    {
+        FrameRecord& record = history[frame % history.size()];
+        if (record.frame == frame)
+            update(record);
+
+        if (recording && frame >= recording_first_frame && frame - recording_first_frame < recorded.size())
+            update(recorded[frame - recording_first_frame]);
+    }
+
+    void Profiler::BeginFrame()
+    {
+        clock_t::time_point now = clock_t::now();
+        if (frame_index > 0)
+        {
+            double frame_ms = std::chrono::duration<double, std::milli>(now - frame_start).count();
+            std::lock_guard lock(mutex);
+            UpdateFrame(frame_index - 1, [frame_ms](FrameRecord& record) { record.frame_ms = frame_ms; });
+        }
+        frame_start = now;
+
+        //This slot was last used gpu_frames.size() frames ago, long enough that it is usually done
+        GpuFrame& gpu_frame = gpu_frames[frame_index % gpu_frames.size()];
+        if (gpu_frame.pending)
+            ResolveGpuFrame(gpu_frame);
+        gpu_frame.frame = frame_index;
+        gpu_frame.used_zones = 0;
+
+        frame_open = true;
+        BeginGpuZone(frame_gpu_zone);
+    }
+
+    void Profiler::EndFrame()
+    {
+        EndGpuZone();
+        if (!open_gpu_zones.empty())
+        {
+            spdlog::warn("Profiler: {} GPU zones still open at the end of the frame", open_gpu_zones.size());
+            open_gpu_zones.clear();
+        }
+        frame_open = false;
+
+        GpuFrame& gpu_frame = gpu_frames[frame_index % gpu_frames.size()];
+        gpu_frame.pending = gpu_frame.used_zones > 0;
+
+        double cpu_ms = std::chrono::duration<double, std::milli>(clock_t::now() - frame_start).count();
+        TracyPlot("Frame CPU ms", cpu_ms);
+
+        {
+            std::lock_guard lock(mutex);
+            FrameRecord& record = history[frame_index % history.size()];
+            record.frame = frame_index;
+            record.frame_ms = 0.0;
+            record.cpu_ms = cpu_ms;
+            record.gpu_ms = -1.0;
+            record.zone_ms.assign(open_zone_ms.begin(), open_zone_ms.end());
+            std::fill(open_zone_ms.begin(), open_zone_ms.end(), 0.0f);
+
+            if (recording)
+                recorded.push_back(record);
+        }
+
+        frame_index += 1;
+    }
+
+    void Profiler::AddCpuSample(uint32_t zone, double ms)
+    {
+        std::lock_guard lock(mutex);
+        if (zone >= open_zone_ms.size())
+            open_zone_ms.resize(zone + 1, 0.0f);
+        open_zone_ms[zone] += static_cast<float>(ms);
+    }
+
+    void Profiler::BeginGpuZone(uint32_t zone)
+    {
+        if (!frame_open)
+        {
+            open_gpu_zones.push_back(skipped_gpu_zone);
+            return;
+        }
+
+        GpuFrame& gpu_frame = gpu_frames[frame_index % gpu_frames.size()];
+        uint32_t index = gpu_frame.used_zones++;
+        //Grows once to the most zones a frame has had, after that the queries are reused
+        if (gpu_frame.queries.size() < 2 * gpu_frame.used_zones)
+        {
+            size_t first = gpu_frame.queries.size();
+            gpu_frame.queries.resize(first + 2);
+            glGenQueries(2, gpu_frame.queries.data() + first);
+            gpu_frame.zones.resize(gpu_frame.used_zones);
+        }
+
+        gpu_frame.zones[index] = zone;
+        glQueryCounter(gpu_frame.queries[2 * index], GL_TIMESTAMP);
+        open_gpu_zones.push_back(index);
+    }
+
+    void Profiler::EndGpuZone()
+    {
+        if (open_gpu_zones.empty())
+            return;
+
+        uint32_t index = open_gpu_zones.back();
+        open_gpu_zones.pop_back();
+        if (index == skipped_gpu_zone)
+            return;
+
+        GpuFrame& gpu_frame = gpu_frames[frame_index % gpu_frames.size()];
+        glQueryCounter(gpu_frame.queries[2 * index + 1], GL_TIMESTAMP);
+    }
+
+    void Profiler::ResolveGpuFrame(GpuFrame& gpu_frame)
+    {
+        gpu_frame.pending = false;
+
+        //The frame zone's end is the last timestamp the frame wrote, once it is there all of them are
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(gpu_frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+        {
+            //Waiting here would stall the CPU on the GPU, which is the thing this is meant to measure
+            dropped_gpu_frames += 1;
+            return;
+        }
+
+        std::vector<std::pair<uint32_t, float>> results;
+        results.reserve(gpu_frame.used_zones);
+        for (uint32_t i = 0; i < gpu_frame.used_zones; ++i)
+        {
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            glGetQueryObjectui64v(gpu_frame.queries[2 * i], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(gpu_frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+            results.emplace_back(gpu_frame.zones[i], static_cast<float>(static_cast<double>(end - begin) / 1.0e6));
+        }
+
+        std::lock_guard lock(mutex);
+        UpdateFrame(gpu_frame.frame, [this, &results](FrameRecord& record)
+        {
+            for (auto const& [zone, ms] : results)
+            {
+                if (zone >= record.zone_ms.size())
+                    record.zone_ms.resize(zone + 1, 0.0f);
+                record.zone_ms[zone] += ms;
+                if (zone == frame_gpu_zone)
+                    record.gpu_ms = ms;
+            }
+        });
+    }
+
+    void Profiler::ResolvePendingGpuFrames()
+    {
+        for (GpuFrame& gpu_frame : gpu_frames)
+        {
+            if (gpu_frame.pending)
+                ResolveGpuFrame(gpu_frame);
+        }
+    }
+
+    Profiler::Percentiles Profiler::FrameTimePercentiles() const
+    {
+        std::vector<double> sorted;
+        {
+            std::lock_guard lock(mutex);
+            for (FrameRecord const& record : history)
+            {
+                if (record.frame != no_frame && record.frame_ms > 0.0)
+                    sorted.push_back(record.frame_ms);
+            }
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        Percentiles percentiles;
+        percentiles.p50 = Percentile(sorted, 50.0);
+        percentiles.p95 = Percentile(sorted, 95.0);
+        percentiles.p99 = Percentile(sorted, 99.0);
+        percentiles.max = sorted.empty() ? 0.0 : sorted.back();
+        return percentiles;
+    }
+
+    void Profiler::StartRecording()
+    {
+        std::lock_guard lock(mutex);
+        recorded.clear();
+        recording_first_frame = frame_index;
+        recording = true;
+    }
+
+    void Profiler::StopRecording()
+    {
+        std::lock_guard lock(mutex);
+        recording = false;
+    }
+
+    size_t Profiler::RecordedFrames() const
+    {
+        std::lock_guard lock(mutex);
+        return recorded.size();
+    }
+
+    //Copied so the file can be written without holding the lock
+    std::vector<Profiler::FrameRecord> Profiler::ExportedFrames() const
+    {
+        std::lock_guard lock(mutex);
+        if (!recorded.empty())
+            return recorded;
+
+        std::vector<FrameRecord> frames;
+        for (FrameRecord const& record : history)
+        {
+            if (record.frame != no_frame)
+                frames.push_back(record);
+        }
+        std::sort(frames.begin(), frames.end(), [](FrameRecord const& a, FrameRecord const& b) { return a.frame < b.frame; });
+        return frames;
+    }
+
+    bool Profiler::ExportCsv(std::string const& file_path) const
+    {
+        std::vector<FrameRecord> frames = ExportedFrames();
+        uint32_t zone_count = ZoneCount();
+
+        std::ofstream file = OpenExportFile(file_path);
+        if (!file.is_open())
+            return false;
+
+        file << "frame,frame_ms,cpu_ms,gpu_ms";
+        for (uint32_t zone = 0; zone < zone_count; ++zone)
+        {
+            auto [name, gpu] = ZoneInfo(zone);
+            file << ",\"" << (gpu ? "gpu:" : "cpu:") << name << "\"";
+        }
+        file << "\n";
+
+        for (FrameRecord const& record : frames)
+        {
+            file << record.frame << "," << record.frame_ms << "," << record.cpu_ms << "," << record.gpu_ms;
+            for (uint32_t zone = 0; zone < zone_count; ++zone)
+            {
+                file << "," << ZoneValue(record, zone);
+            }
+            file << "\n";
+        }
+
+        spdlog::info("Profiler: Wrote {} frames to {}", frames.size(), file_path);
+        return true;
+    }
+
+    bool Profiler::ExportJson(std::string const& file_path) const
+    {
+        std::vector<FrameRecord> frames = ExportedFrames();
+        uint32_t zone_count = ZoneCount();
+
+        std::vector<double> sorted;
+        for (FrameRecord const& record : frames)
+        {
+            if (record.frame_ms > 0.0)
+                sorted.push_back(record.frame_ms);
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        std::ofstream file = OpenExportFile(file_path);
+        if (!file.is_open())
+            return false;
+
+        file << "{\n";
+        file << "  \"frames\": " << frames.size() << ",\n";
+        file << "  \"dropped_gpu_frames\": " << dropped_gpu_frames.load() << ",\n";
+        file << "  \"frame_ms\": { \"p50\": " << Percentile(sorted, 50.0) << ", \"p95\": " << Percentile(sorted, 95.0)
+             << ", \"p99\": " << Percentile(sorted, 99.0) << ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << " },\n";
+
+        //Names are code literals, nothing in them needs escaping
+        file << "  \"zones\": [";
+        for (uint32_t zone = 0; zone < zone_count; ++zone)
+        {
+            auto [name, gpu] = ZoneInfo(zone);
+            file << (zone == 0 ? "" : ", ") << "{ \"name\": \"" << name << "\", \"gpu\": " << (gpu ? "true" : "false") << " }";
+        }
+        file << "],\n";
+
+        file << "  \"records\": [\n";
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            FrameRecord const& record = frames[i];
+            file << "    { \"frame\": " << record.frame << ", \"frame_ms\": " << record.frame_ms << ", \"cpu_ms\": " << record.cpu_ms
+                 << ", \"gpu_ms\": " << record.gpu_ms << ", \"zone_ms\": [";
+            for (uint32_t zone = 0; zone < zone_count; ++zone)
+            {
+                file << (zone == 0 ? "" : ", ") << ZoneValue(record, zone);
+            }
+            file << "] }" << (i + 1 == frames.size() ? "\n" : ",\n");
+        }
+        file << "  ]\n";
+        file << "}\n";
+
+        spdlog::info("Profiler: Wrote {} frames to {}", frames.size(), file_path);
+        return true;
+    }
+
+    void Profiler::RenderUI()
+    {
+        constexpr int histogram_buckets = 32;
+
+        Percentiles percentiles = FrameTimePercentiles();
+        uint32_t zone_count = ZoneCount();
+
+        //Gathered into scratch space that is kept around, so the overlay doesn't allocate every frame
+        ui_frame_ms.clear();
+        ui_zone_total.assign(zone_count, 0.0);
+        ui_zone_max.assign(zone_count, 0.0f);
+        ui_zone_last.assign(zone_count, 0.0f);
+        double gpu_total = 0.0;
+        uint32_t gpu_count = 0;
+        uint32_t frame_count = 0;
+        {
+            std::lock_guard lock(mutex);
+            //Oldest first
+            for (size_t i = 0; i < history.size(); ++i)
+            {
+                FrameRecord const& record = history[(frame_index + i) % history.size()];
+                if (record.frame == no_frame)
+                    continue;
+
+                frame_count += 1;
+                if (record.frame_ms > 0.0)
+                    ui_frame_ms.push_back(static_cast<float>(record.frame_ms));
+                if (record.gpu_ms >= 0.0)
+                {
+                    gpu_total += record.gpu_ms;
+                    gpu_count += 1;
+                }
+
+                for (uint32_t zone = 0; zone < zone_count; ++zone)
+                {
+                    float ms = ZoneValue(record, zone);
+                    ui_zone_total[zone] += ms;
+                    ui_zone_max[zone] = std::max(ui_zone_max[zone], ms);
+                    if (ms > 0.0f)
+                        ui_zone_last[zone] = ms;
+                }
+            }
+        }
+
+        ImGui::Begin("Profiler");
+
+        ImGui::Text("Frame: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", percentiles.p50, percentiles.p95, percentiles.p99, percentiles.max);
+        ImGui::Text("GPU frame: %.2f ms average, %llu frames dropped", gpu_count > 0 ? gpu_total / gpu_count : 0.0,
+            static_cast<unsigned long long>(dropped_gpu_frames.load()));
+
+        float graph_max = static_cast<float>(percentiles.max) * 1.1f;
+        ImGui::PlotLines("Frame ms", ui_frame_ms.data(), static_cast<int>(ui_frame_ms.size()), 0, nullptr, 0.0f, graph_max, ImVec2(0.0f, 60.0f));
+
+        //Anything past 1.5x p99 lands in the last bucket so one hitch doesn't squash the rest
+        float bucket_range = std::max(static_cast<float>(percentiles.p99) * 1.5f, 0.001f);
+        float buckets[histogram_buckets] = {};
+        for (float ms : ui_frame_ms)
+        {
+            int bucket = std::min(static_cast<int>(ms / bucket_range * histogram_buckets), histogram_buckets - 1);
+            buckets[bucket] += 1.0f;
+        }
+        char histogram_label[64];
+        std::snprintf(histogram_label, sizeof(histogram_label), "0 - %.1f ms", bucket_range);
+        ImGui::PlotHistogram("Distribution", buckets, histogram_buckets, 0, histogram_label, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+
+        if (ImGui::BeginTable("Profiler Zones", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Kind");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Average ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            for (uint32_t zone = 0; zone < zone_count; ++zone)
+            {
+                auto [name, gpu] = ZoneInfo(zone);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(gpu ? "GPU" : "CPU");
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", ui_zone_last[zone]);
+                ImGui::TableNextColumn();
+                //Per frame, counting the frames the zone didn't run in, so the averages add up to the frame
+                ImGui::Text("%.3f", frame_count > 0 ? ui_zone_total[zone] / frame_count : 0.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", ui_zone_max[zone]);
+            }
+            ImGui::EndTable();
+        }
+
+        if (!recording)
+        {
+            if (ImGui::Button("Record"))
+                StartRecording();
+        }
+        else
+        {
+            if (ImGui::Button("Stop Recording"))
+                StopRecording();
+        }
+        ImGui::SameLine();
+        ImGui::Text("%zu frames recorded", RecordedFrames());
+
+        //Exports the recording, or the history window when nothing was recorded
+        char file_path[64];
+        if (ImGui::Button("Export CSV"))
+        {
+            std::snprintf(file_path, sizeof(file_path), "profiles/profile_%03u.csv", export_count++);
+            ExportCsv(file_path);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export JSON"))
+        {
+            std::snprintf(file_path, sizeof(file_path), "profiles/profile_%03u.json", export_count++);
+            ExportJson(file_path);
+        }
+
+        ImGui::End();
+    }
+}
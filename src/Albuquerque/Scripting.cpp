@@ -0,0 +1,517 @@
+#include <Albuquerque/Scripting.hpp>
+
+extern "C"
+{
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+}
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+
+namespace Albuquerque
+{
+    struct ScriptArrayView
+    {
+        float* data = nullptr;
+        lua_Integer count = 0;
+    };
+
+    namespace
+    {
+        constexpr char const* view_metatable = "Albuquerque.ScriptArrayView";
+
+        //The only parts of the base library a sandbox gets. Nothing that loads code, touches metatables or files
+        constexpr char const* sandbox_functions[] = {
+            "assert", "error", "ipairs", "next", "pairs", "rawequal", "rawget", "rawlen", "rawset", "select",
+            "tonumber", "tostring", "type",
+        };
+        constexpr char const* sandbox_libraries[] = {LUA_MATHLIBNAME, LUA_STRLIBNAME, LUA_TABLIBNAME};
+
+        //Only ever called with our userdata, the metatable isn't reachable from scripts, so no type check needed
+        ScriptArrayView* ToView(lua_State* L)
+        {
+            return static_cast<ScriptArrayView*>(lua_touserdata(L, 1));
+        }
+
+        lua_Integer CheckIndex(lua_State* L, ScriptArrayView const* view)
+        {
+            lua_Integer const index = luaL_checkinteger(L, 2);
+            luaL_argcheck(L, static_cast<lua_Unsigned>(index) < static_cast<lua_Unsigned>(view->count), 2, "index out of range");
+            return index;
+        }
+
+        int ViewIndex(lua_State* L)
+        {
+            ScriptArrayView const* view = ToView(L);
+            lua_pushnumber(L, view->data[CheckIndex(L, view)]);
+            return 1;
+        }
+
+        int ViewNewIndex(lua_State* L)
+        {
+            ScriptArrayView* view = ToView(L);
+            lua_Integer const index = CheckIndex(L, view);
+            view->data[index] = static_cast<float>(luaL_checknumber(L, 3));
+            return 0;
+        }
+
+        int ViewLength(lua_State* L)
+        {
+            lua_pushinteger(L, ToView(L)->count);
+            return 1;
+        }
+
+        //Pushes a shallow copy of the table at index
+        void PushCopy(lua_State* L, int index)
+        {
+            index = lua_absindex(L, index);
+            lua_newtable(L);
+            lua_pushnil(L);
+            while (lua_next(L, index) != 0)
+            {
+                lua_pushvalue(L, -2);
+                lua_insert(L, -2);
+                lua_rawset(L, -4);
+            }
+        }
+    }
+
+    ScriptAllocator::ScriptAllocator(size_t memory_limit)
+        : memory_limit(memory_limit)
+    {
+        for (size_t i = 0; i < size_class_count; i++)
+        {
+            pools[i] = std::make_unique<PoolAllocator>(smallest_class << i);
+        }
+    }
+
+    ScriptAllocator::~ScriptAllocator() = default;
+
+    //size_class_count for anything too big for the pools
+    size_t ScriptAllocator::SizeClass(size_t bytes)
+    {
+        size_t size_class = 0;
+        size_t class_bytes = smallest_class;
+        while (class_bytes < bytes && size_class < size_class_count)
+        {
+            class_bytes <<= 1;
+            size_class++;
+        }
+        return size_class;
+    }
+
+    void* ScriptAllocator::Allocate(size_t bytes)
+    {
+        size_t const size_class = SizeClass(bytes);
+        void* pointer = nullptr;
+        if (size_class < size_class_count)
+        {
+            PoolAllocator& pool = *pools[size_class];
+            size_t const pages = pool.PageCount();
+            //A new page comes from operator new, and an exception can't unwind through Lua's C frames,
+            //so running out of memory has to come back as the nullptr Lua expects
+            try
+            {
+                pointer = pool.Allocate();
+            }
+            catch (std::bad_alloc const&)
+            {
+                return nullptr;
+            }
+            if (pool.PageCount() != pages)
+            {
+                stats.heap_allocations++;
+            }
+        }
+        else
+        {
+            pointer = std::malloc(bytes);
+            stats.heap_allocations++;
+            if (pointer == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        stats.allocations++;
+        stats.bytes_in_use += bytes;
+        stats.high_water = std::max(stats.high_water, stats.bytes_in_use);
+        return pointer;
+    }
+
+    void ScriptAllocator::Free(void* pointer, size_t bytes)
+    {
+        size_t const size_class = SizeClass(bytes);
+        if (size_class < size_class_count)
+        {
+            pools[size_class]->Free(pointer);
+        }
+        else
+        {
+            std::free(pointer);
+        }
+        stats.frees++;
+        stats.bytes_in_use -= bytes;
+    }
+
+    void* ScriptAllocator::LuaAlloc(void* user_data, void* pointer, size_t old_size, size_t new_size)
+    {
+        auto& allocator = *static_cast<ScriptAllocator*>(user_data);
+        auto& stats = allocator.stats;
+
+        //Without a block old_size is the type of object being made, not a size
+        if (pointer == nullptr)
+        {
+            old_size = 0;
+        }
+
+        if (new_size == 0)
+        {
+            if (pointer != nullptr)
+            {
+                allocator.Free(pointer, old_size);
+            }
+            return nullptr;
+        }
+
+        //Only growing can fail, Lua counts on shrinking going through
+        if (new_size > old_size && stats.bytes_in_use - old_size + new_size > allocator.memory_limit)
+        {
+            stats.refused++;
+            return nullptr;
+        }
+
+        if (pointer != nullptr)
+        {
+            size_t const old_class = SizeClass(old_size);
+            size_t const new_class = SizeClass(new_size);
+            if (old_class == new_class && old_class < size_class_count)
+            {
+                //Still fits its block
+                stats.bytes_in_use = stats.bytes_in_use - old_size + new_size;
+                stats.high_water = std::max(stats.high_water, stats.bytes_in_use);
+                return pointer;
+            }
+            if (old_class == size_class_count && new_class == size_class_count)
+            {
+                void* moved = std::realloc(pointer, new_size);
+                if (moved == nullptr)
+                {
+                    return nullptr;
+                }
+                stats.allocations++;
+                stats.frees++;
+                stats.heap_allocations++;
+                stats.bytes_in_use = stats.bytes_in_use - old_size + new_size;
+                stats.high_water = std::max(stats.high_water, stats.bytes_in_use);
+                return moved;
+            }
+        }
+
+        void* fresh = allocator.Allocate(new_size);
+        if (fresh != nullptr && pointer != nullptr)
+        {
+            std::memcpy(fresh, pointer, std::min(old_size, new_size));
+            allocator.Free(pointer, old_size);
+        }
+        return fresh;
+    }
+
+    ScriptRuntime::ScriptRuntime() = default;
+
+    ScriptRuntime::~ScriptRuntime()
+    {
+        Shutdown();
+    }
+
+    bool ScriptRuntime::Initialize(ScriptSettings const& script_settings)
+    {
+        Shutdown();
+
+        settings = script_settings;
+        settings.instruction_budget = std::clamp<uint32_t>(settings.instruction_budget, 1, std::numeric_limits<int>::max());
+        settings.strikes_to_disable = std::max(settings.strikes_to_disable, 1u);
+
+        allocator = std::make_unique<ScriptAllocator>(settings.memory_limit);
+        state = lua_newstate(&ScriptAllocator::LuaAlloc, allocator.get());
+        if (state == nullptr)
+        {
+            spdlog::error("Scripting: Unable to create a Lua state");
+            allocator.reset();
+            return false;
+        }
+        *static_cast<ScriptRuntime**>(lua_getextraspace(state)) = this;
+
+        //Into the real globals, which no script ever sees. Sandboxes copy what they need from here
+        luaL_requiref(state, LUA_GNAME, luaopen_base, 1);
+        luaL_requiref(state, LUA_MATHLIBNAME, luaopen_math, 1);
+        luaL_requiref(state, LUA_STRLIBNAME, luaopen_string, 1);
+        luaL_requiref(state, LUA_TABLIBNAME, luaopen_table, 1);
+        lua_pop(state, 4);
+
+        //Scripts called every tick make lots of short lived garbage if they make any, which is what generational is for
+        lua_gc(state, LUA_GCGEN, 0, 0);
+
+        luaL_newmetatable(state, view_metatable);
+        lua_pushcfunction(state, &ViewIndex);
+        lua_setfield(state, -2, "__index");
+        lua_pushcfunction(state, &ViewNewIndex);
+        lua_setfield(state, -2, "__newindex");
+        lua_pushcfunction(state, &ViewLength);
+        lua_setfield(state, -2, "__len");
+        lua_pop(state, 1);
+
+        lua_newtable(state);
+        shared_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+
+        spdlog::info("Scripting: {}, {} instructions per script per tick", LUA_RELEASE, settings.instruction_budget);
+        return true;
+    }
+
+    void ScriptRuntime::Shutdown()
+    {
+        if (state != nullptr)
+        {
+            lua_close(state);
+            state = nullptr;
+        }
+        allocator.reset();
+        views.clear();
+        scripts.clear();
+        update_refs.clear();
+        stats = {};
+    }
+
+    void ScriptRuntime::BindArray(std::string const& name, float* data, size_t count)
+    {
+        if (state == nullptr)
+        {
+            return;
+        }
+
+        auto it = views.find(name);
+        if (it == views.end())
+        {
+            lua_rawgeti(state, LUA_REGISTRYINDEX, shared_ref);
+            auto* view = static_cast<ScriptArrayView*>(lua_newuserdatauv(state, sizeof(ScriptArrayView), 0));
+            luaL_setmetatable(state, view_metatable);
+            lua_setfield(state, -2, name.c_str());
+            lua_pop(state, 1);
+            it = views.emplace(name, view).first;
+        }
+
+        it->second->data = data;
+        it->second->count = static_cast<lua_Integer>(count);
+    }
+
+    void ScriptRuntime::NewSandbox()
+    {
+        lua_createtable(state, 0, std::size(sandbox_functions) + std::size(sandbox_libraries));
+        lua_pushglobaltable(state);
+        for (char const* name : sandbox_functions)
+        {
+            lua_getfield(state, -1, name);
+            lua_setfield(state, -3, name);
+        }
+        //Copies so one script replacing math.floor can't break another
+        for (char const* name : sandbox_libraries)
+        {
+            lua_getfield(state, -1, name);
+            PushCopy(state, -1);
+            lua_setfield(state, -4, name);
+            lua_pop(state, 1);
+        }
+        lua_pop(state, 1);
+
+        //Globals a script doesn't have itself are looked up in the views
+        lua_createtable(state, 0, 1);
+        lua_rawgeti(state, LUA_REGISTRYINDEX, shared_ref);
+        lua_setfield(state, -2, "__index");
+        lua_setmetatable(state, -2);
+    }
+
+    void ScriptRuntime::BudgetHook(lua_State* L, lua_Debug*)
+    {
+        ScriptRuntime* runtime = *static_cast<ScriptRuntime**>(lua_getextraspace(L));
+        runtime->over_budget = true;
+        luaL_error(L, "went over its budget of %d instructions", static_cast<int>(runtime->settings.instruction_budget));
+    }
+
+    ScriptId ScriptRuntime::Load(std::string const& name, std::string_view source)
+    {
+        if (state == nullptr)
+        {
+            return invalid_script;
+        }
+
+        //Text only, broken bytecode can crash the VM
+        std::string const chunk_name = "=" + name;
+        if (luaL_loadbufferx(state, source.data(), source.size(), chunk_name.c_str(), "t") != LUA_OK)
+        {
+            spdlog::error("Scripting: Unable to load {}: {}", name, lua_tostring(state, -1));
+            lua_pop(state, 1);
+            return invalid_script;
+        }
+
+        //The chunk's only upvalue is its _ENV
+        NewSandbox();
+        lua_pushvalue(state, -1);
+        lua_setupvalue(state, -3, 1);
+        lua_insert(state, -2);
+
+        //The top level gets a budget too, a script can't hang the game while loading either
+        over_budget = false;
+        lua_sethook(state, &BudgetHook, LUA_MASKCOUNT, static_cast<int>(settings.instruction_budget));
+        int const result = lua_pcall(state, 0, 0, 0);
+        lua_sethook(state, nullptr, 0, 0);
+        if (result != LUA_OK)
+        {
+            spdlog::error("Scripting: Unable to load {}: {}", name, lua_tostring(state, -1) ? lua_tostring(state, -1) : "error object is not a string");
+            lua_pop(state, 2);
+            return invalid_script;
+        }
+
+        lua_getfield(state, -1, "update");
+        if (!lua_isfunction(state, -1))
+        {
+            spdlog::error("Scripting: {} doesn't define update(first, last, dt)", name);
+            lua_pop(state, 2);
+            return invalid_script;
+        }
+
+        int const update_ref = luaL_ref(state, LUA_REGISTRYINDEX);
+        lua_pop(state, 1);
+
+        ScriptId const id = static_cast<ScriptId>(scripts.size());
+        ScriptInfo info;
+        info.name = name;
+        scripts.push_back(std::move(info));
+        update_refs.push_back(update_ref);
+        return id;
+    }
+
+    ScriptId ScriptRuntime::LoadFile(std::string const& file_path)
+    {
+        std::ifstream file(file_path);
+        if (!file)
+        {
+            spdlog::error("Scripting: Unable to open {}", file_path);
+            return invalid_script;
+        }
+
+        std::stringstream source;
+        source << file.rdbuf();
+        return Load(file_path, source.str());
+    }
+
+    void ScriptRuntime::SetRange(ScriptId script, uint32_t first, uint32_t count)
+    {
+        if (script < scripts.size())
+        {
+            scripts[script].first = first;
+            scripts[script].count = count;
+        }
+    }
+
+    void ScriptRuntime::Enable(ScriptId script)
+    {
+        if (script < scripts.size())
+        {
+            scripts[script].disabled = false;
+            scripts[script].strikes = 0;
+        }
+    }
+
+    void ScriptRuntime::Strike(ScriptInfo& script, std::string error)
+    {
+        script.last_error = std::move(error);
+        script.strikes++;
+        if (!script.disabled && script.strikes >= settings.strikes_to_disable)
+        {
+            script.disabled = true;
+            spdlog::warn("Scripting: Disabled {} after {} bad ticks in a row: {}", script.name, script.strikes, script.last_error);
+        }
+    }
+
+    void ScriptRuntime::Tick(double dt)
+    {
+        if (state == nullptr)
+        {
+            return;
+        }
+
+        ZoneScopedN("Scripts Tick");
+        auto const start = std::chrono::steady_clock::now();
+        ScriptAllocator::Stats const before = allocator->GetStats();
+
+        uint32_t scripts_run = 0;
+        for (ScriptId id = 0; id < scripts.size(); id++)
+        {
+            ScriptInfo& script = scripts[id];
+            if (script.disabled || script.count == 0)
+            {
+                continue;
+            }
+
+            lua_rawgeti(state, LUA_REGISTRYINDEX, update_refs[id]);
+            lua_pushinteger(state, script.first);
+            lua_pushinteger(state, static_cast<lua_Integer>(script.first) + script.count - 1);
+            lua_pushnumber(state, dt);
+
+            //Setting the hook restarts its count, so every script gets the whole budget
+            over_budget = false;
+            lua_sethook(state, &BudgetHook, LUA_MASKCOUNT, static_cast<int>(settings.instruction_budget));
+            int const result = lua_pcall(state, 3, 0, 0);
+            lua_sethook(state, nullptr, 0, 0);
+            scripts_run++;
+
+            if (result == LUA_OK)
+            {
+                script.strikes = 0;
+                continue;
+            }
+
+            char const* message = lua_tostring(state, -1);
+            std::string error = message ? message : "error object is not a string";
+            lua_pop(state, 1);
+            if (over_budget)
+            {
+                script.budget_overruns++;
+                stats.budget_overruns++;
+            }
+            else
+            {
+                script.errors++;
+                stats.errors++;
+            }
+            Strike(script, std::move(error));
+        }
+
+        ScriptAllocator::Stats const& after = allocator->GetStats();
+        stats.tick_allocations = after.allocations - before.allocations;
+        stats.tick_heap_allocations = after.heap_allocations - before.heap_allocations;
+        stats.scripts_run = scripts_run;
+        stats.disabled_scripts = static_cast<uint32_t>(std::count_if(scripts.begin(), scripts.end(), [](ScriptInfo const& script) { return script.disabled; }));
+        stats.last_tick_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    ScriptRuntime::Stats ScriptRuntime::GetStats() const
+    {
+        Stats result = stats;
+        if (allocator)
+        {
+            result.memory = allocator->GetStats();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,445 @@
+#include <Albuquerque/Terrain.hpp>
+#include <Albuquerque/Profiler.hpp>
+
+#include <Fwog/Rendering.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        uint32_t HashLattice(int64_t x, int64_t z, uint32_t seed)
+        {
+            //murmur3's mixing steps, good enough that the octaves don't show the grid
+            auto mix = [](uint32_t hash, uint32_t value)
+            {
+                value *= 0xcc9e2d51u;
+                value = (value << 15) | (value >> 17);
+                value *= 0x1b873593u;
+                hash ^= value;
+                hash = (hash << 13) | (hash >> 19);
+                return hash * 5 + 0xe6546b64u;
+            };
+
+            uint32_t hash = mix(seed, static_cast<uint32_t>(x));
+            hash = mix(hash, static_cast<uint32_t>(z));
+            hash ^= hash >> 16;
+            hash *= 0x85ebca6bu;
+            hash ^= hash >> 13;
+            hash *= 0xc2b2ae35u;
+            hash ^= hash >> 16;
+            return hash;
+        }
+
+        double Lattice(int64_t x, int64_t z, uint32_t seed)
+        {
+            return static_cast<double>(HashLattice(x, z, seed) & 0xffffffu) / static_cast<double>(0xffffffu);
+        }
+
+        //0 to 1, smooth between the lattice points
+        double ValueNoise(double x, double z, uint32_t seed)
+        {
+            double floor_x = std::floor(x);
+            double floor_z = std::floor(z);
+            auto ix = static_cast<int64_t>(floor_x);
+            auto iz = static_cast<int64_t>(floor_z);
+
+            double tx = x - floor_x;
+            double tz = z - floor_z;
+            double sx = tx * tx * (3.0 - 2.0 * tx);
+            double sz = tz * tz * (3.0 - 2.0 * tz);
+
+            double a = Lattice(ix, iz, seed);
+            double b = Lattice(ix + 1, iz, seed);
+            double c = Lattice(ix, iz + 1, seed);
+            double d = Lattice(ix + 1, iz + 1, seed);
+
+            return glm::mix(glm::mix(a, b, sx), glm::mix(c, d, sx), sz);
+        }
+
+        constexpr std::array<std::array<int32_t, 2>, 4> child_offsets = {{{0, 0}, {1, 0}, {0, 1}, {1, 1}}};
+    }
+
+    float TerrainNoise::Height(TerrainNoiseSettings const& settings, double x, double z)
+    {
+        double sum = 0.0;
+        double total = 0.0;
+        double amplitude = 1.0;
+        double frequency = settings.frequency;
+        for (uint32_t octave = 0; octave < settings.octaves; ++octave)
+        {
+            sum += amplitude * ValueNoise(x * frequency, z * frequency, settings.seed + octave);
+            total += amplitude;
+            amplitude *= settings.gain;
+            frequency *= settings.lacunarity;
+        }
+
+        double height = total > 0.0 ? sum / total : 0.0;
+        //Squared so valleys are wide and peaks are sharp
+        height *= height;
+
+        double distance = std::sqrt(x * x + z * z);
+        double mask = glm::smoothstep(static_cast<double>(settings.flat_radius),
+            static_cast<double>(settings.flat_radius + settings.blend_distance), distance);
+
+        return static_cast<float>(settings.amplitude * height * mask);
+    }
+
+    glm::vec3 TerrainNoise::Normal(TerrainNoiseSettings const& settings, double x, double z, double step)
+    {
+        float left = Height(settings, x - step, z);
+        float right = Height(settings, x + step, z);
+        float back = Height(settings, x, z - step);
+        float front = Height(settings, x, z + step);
+        return glm::normalize(glm::vec3(left - right, 2.0f * static_cast<float>(step), back - front));
+    }
+
+    double TerrainMesh::NodeSize(TerrainSettings const& settings, int32_t lod)
+    {
+        return std::ldexp(static_cast<double>(settings.leaf_size), lod);
+    }
+
+    glm::dvec2 TerrainMesh::NodeOrigin(TerrainSettings const& settings, TerrainTileKey key)
+    {
+        double size = NodeSize(settings, key.lod);
+        return glm::dvec2(key.x * size, key.z * size);
+    }
+
+    void TerrainMesh::BuildVertices(TerrainSettings const& settings, TerrainTileKey key, std::vector<TerrainVertex>& vertices)
+    {
+        ZoneScoped;
+
+        uint32_t quads = settings.patch_quads;
+        uint32_t side = quads + 1;
+        vertices.resize(static_cast<size_t>(side) * side);
+
+        //Every lod samples the same lattice of leaf sized steps, so the vertices two patches share are computed
+        //from the same integers and come out bit for bit the same
+        double leaf_step = static_cast<double>(settings.leaf_size) / quads;
+        int64_t lod_scale = int64_t(1) << key.lod;
+        int64_t origin_x = static_cast<int64_t>(key.x) * quads * lod_scale;
+        int64_t origin_z = static_cast<int64_t>(key.z) * quads * lod_scale;
+
+        //The texture repeats, so the uvs can start at whole periods below the node and stay small
+        glm::dvec2 origin = NodeOrigin(settings, key);
+        double period = settings.uv_period;
+        glm::dvec2 uv_origin = glm::floor(origin / period) * period;
+
+        for (uint32_t j = 0; j < side; ++j)
+        {
+            for (uint32_t i = 0; i < side; ++i)
+            {
+                int64_t local_x = static_cast<int64_t>(i) * lod_scale;
+                int64_t local_z = static_cast<int64_t>(j) * lod_scale;
+                double world_x = static_cast<double>(origin_x + local_x) * leaf_step;
+                double world_z = static_cast<double>(origin_z + local_z) * leaf_step;
+
+                TerrainVertex& vertex = vertices[j * side + i];
+                vertex.position = glm::vec3(static_cast<float>(local_x * leaf_step),
+                    TerrainNoise::Height(settings.noise, world_x, world_z),
+                    static_cast<float>(local_z * leaf_step));
+                vertex.normal = TerrainNoise::Normal(settings.noise, world_x, world_z, leaf_step);
+                vertex.uv = glm::vec2((world_x - uv_origin.x) / period, (world_z - uv_origin.y) / period);
+            }
+        }
+    }
+
+    std::vector<uint32_t> TerrainMesh::BuildIndices(uint32_t patch_quads, uint32_t stitch_mask)
+    {
+        uint32_t side = patch_quads + 1;
+        auto index = [&](uint32_t i, uint32_t j)
+        {
+            if ((stitch_mask & terrain_edge_neg_x) && i == 0 && (j & 1))
+                j -= 1;
+            if ((stitch_mask & terrain_edge_pos_x) && i == patch_quads && (j & 1))
+                j -= 1;
+            if ((stitch_mask & terrain_edge_neg_z) && j == 0 && (i & 1))
+                i -= 1;
+            if ((stitch_mask & terrain_edge_pos_z) && j == patch_quads && (i & 1))
+                i -= 1;
+            return j * side + i;
+        };
+
+        std::vector<uint32_t> indices;
+        indices.reserve(static_cast<size_t>(patch_quads) * patch_quads * 6);
+        for (uint32_t j = 0; j < patch_quads; ++j)
+        {
+            for (uint32_t i = 0; i < patch_quads; ++i)
+            {
+                uint32_t a = index(i, j);
+                uint32_t b = index(i + 1, j);
+                uint32_t c = index(i + 1, j + 1);
+                uint32_t d = index(i, j + 1);
+
+                //Counter clockwise seen from above. Folded vertices just leave degenerate triangles behind
+                indices.insert(indices.end(), {a, c, b, a, d, c});
+            }
+        }
+
+        return indices;
+    }
+
+    Terrain::Terrain(TerrainSettings settings)
+        : settings(settings)
+    {
+        this->settings.patch_quads = std::max(2u, (this->settings.patch_quads + 1) & ~1u);
+        this->settings.lod_count = std::max(this->settings.lod_count, 1u);
+
+        std::vector<uint32_t> indices;
+        indices.reserve(static_cast<size_t>(IndexCount()) * terrain_stitch_variants);
+        for (uint32_t mask = 0; mask < terrain_stitch_variants; ++mask)
+        {
+            std::vector<uint32_t> variant = TerrainMesh::BuildIndices(this->settings.patch_quads, mask);
+            indices.insert(indices.end(), variant.begin(), variant.end());
+        }
+        index_buffer = Fwog::Buffer(std::span<uint32_t const>(indices));
+    }
+
+    Terrain::~Terrain()
+    {
+        //The builds write into memory owned by this
+        JobSystem::Instance().Wait(build_counter);
+    }
+
+    size_t Terrain::TileBytes() const
+    {
+        size_t side = settings.patch_quads + 1;
+        return side * side * sizeof(TerrainVertex);
+    }
+
+    uint32_t Terrain::IndexCount() const
+    {
+        return settings.patch_quads * settings.patch_quads * 6;
+    }
+
+    float Terrain::HeightAt(double x, double z) const
+    {
+        return TerrainNoise::Height(settings.noise, x, z);
+    }
+
+    void Terrain::Update(glm::dvec3 const& camera_position)
+    {
+        ALBUQUERQUE_PROFILE_CPU("Terrain Update");
+
+        frame_index += 1;
+        FinishBuilds();
+
+        draw_nodes.clear();
+        drawn_keys.clear();
+
+        auto root_lod = static_cast<int32_t>(settings.lod_count - 1);
+        double root_size = TerrainMesh::NodeSize(settings, root_lod);
+        auto camera_x = static_cast<int32_t>(std::floor(camera_position.x / root_size));
+        auto camera_z = static_cast<int32_t>(std::floor(camera_position.z / root_size));
+        auto radius = static_cast<int32_t>(settings.root_radius);
+
+        for (int32_t z = -radius; z <= radius; ++z)
+        {
+            for (int32_t x = -radius; x <= radius; ++x)
+            {
+                Select(TerrainTileKey{root_lod, camera_x + x, camera_z + z}, camera_position);
+            }
+        }
+
+        //Only now is it known which lod every neighbour ended up at
+        for (DrawNode& node : draw_nodes)
+        {
+            node.stitch_mask = StitchMask(node.key);
+        }
+
+        size_t side = settings.patch_quads + 1;
+        stats.resident_tiles = static_cast<uint32_t>(tiles.size());
+        stats.builds_in_flight = static_cast<uint32_t>(builds.size());
+        stats.resident_bytes = (tiles.size() + builds.size()) * TileBytes();
+        stats.drawn_nodes = static_cast<uint32_t>(draw_nodes.size());
+        stats.drawn_vertices = draw_nodes.size() * side * side;
+
+        TracyPlot("Terrain Nodes", static_cast<int64_t>(stats.drawn_nodes));
+        TracyPlot("Terrain Resident Tiles", static_cast<int64_t>(stats.resident_tiles));
+    }
+
+    void Terrain::FinishBuilds()
+    {
+        uint32_t uploads = 0;
+        for (size_t i = 0; i < builds.size() && uploads < settings.max_uploads_per_frame;)
+        {
+            TileBuild& build = *builds[i];
+            if (!build.done.load(std::memory_order_acquire))
+            {
+                ++i;
+                continue;
+            }
+
+            Tile& tile = tiles[build.key];
+            tile.vertex_buffer = Fwog::Buffer(std::span<TerrainVertex const>(build.vertices));
+            tile.last_used_frame = frame_index;
+
+            uploads += 1;
+            stats.tiles_built += 1;
+
+            builds[i] = std::move(builds.back());
+            builds.pop_back();
+        }
+    }
+
+    void Terrain::Select(TerrainTileKey key, glm::dvec3 const& camera_position)
+    {
+        double size = TerrainMesh::NodeSize(settings, key.lod);
+        glm::dvec2 origin = TerrainMesh::NodeOrigin(settings, key);
+
+        //Distance to the node's box, which reaches from 0 up to the highest the noise can go
+        double dx = std::max({origin.x - camera_position.x, 0.0, camera_position.x - (origin.x + size)});
+        double dz = std::max({origin.y - camera_position.z, 0.0, camera_position.z - (origin.y + size)});
+        double dy = std::max({-camera_position.y, 0.0, camera_position.y - settings.noise.amplitude});
+        double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        if (key.lod > 0 && distance < settings.split_distance * size)
+        {
+            bool children_ready = true;
+            for (auto const& offset : child_offsets)
+            {
+                TerrainTileKey child{key.lod - 1, key.x * 2 + offset[0], key.z * 2 + offset[1]};
+                if (!Touch(child))
+                {
+                    RequestTile(child);
+                    children_ready = false;
+                }
+            }
+
+            if (children_ready)
+            {
+                for (auto const& offset : child_offsets)
+                {
+                    Select(TerrainTileKey{key.lod - 1, key.x * 2 + offset[0], key.z * 2 + offset[1]}, camera_position);
+                }
+                return;
+            }
+        }
+
+        if (Touch(key))
+        {
+            draw_nodes.push_back(DrawNode{key});
+            drawn_keys.insert(key);
+        }
+        else
+        {
+            RequestTile(key);
+        }
+    }
+
+    bool Terrain::Touch(TerrainTileKey key)
+    {
+        auto it = tiles.find(key);
+        if (it == tiles.end())
+            return false;
+
+        it->second.last_used_frame = frame_index;
+        return true;
+    }
+
+    void Terrain::RequestTile(TerrainTileKey key)
+    {
+        if (tiles.contains(key))
+            return;
+
+        for (auto const& build : builds)
+        {
+            if (build->key == key)
+                return;
+        }
+
+        if (builds.size() >= settings.max_builds_in_flight)
+            return;
+
+        while ((tiles.size() + builds.size() + 1) * TileBytes() > settings.memory_budget_bytes)
+        {
+            if (!EvictLeastRecentlyUsed())
+            {
+                stats.budget_overruns += 1;
+                return;
+            }
+        }
+
+        builds.push_back(std::make_unique<TileBuild>());
+        TileBuild* build = builds.back().get();
+        build->key = key;
+
+        JobSystem::Instance().Run("Terrain Tile", [this, build]()
+        {
+            TerrainMesh::BuildVertices(settings, build->key, build->vertices);
+            build->done.store(true, std::memory_order_release);
+        }, &build_counter);
+    }
+
+    bool Terrain::EvictLeastRecentlyUsed()
+    {
+        //Never anything drawn or needed this frame
+        auto oldest = tiles.end();
+        uint64_t oldest_frame = frame_index;
+        for (auto it = tiles.begin(); it != tiles.end(); ++it)
+        {
+            if (it->second.last_used_frame < oldest_frame)
+            {
+                oldest = it;
+                oldest_frame = it->second.last_used_frame;
+            }
+        }
+
+        if (oldest == tiles.end())
+            return false;
+
+        tiles.erase(oldest);
+        stats.tiles_evicted += 1;
+        return true;
+    }
+
+    uint32_t Terrain::StitchMask(TerrainTileKey key) const
+    {
+        //With a split distance of 2 or more neighbours end up at most one lod coarser, apart from while tiles are
+        //still streaming in. A sibling maps to this node's own parent, which is never drawn alongside it
+        auto coarser = [&](int32_t x, int32_t z) { return drawn_keys.contains(TerrainTileKey{key.lod + 1, x >> 1, z >> 1}); };
+
+        uint32_t mask = 0;
+        if (coarser(key.x - 1, key.z))
+            mask |= terrain_edge_neg_x;
+        if (coarser(key.x + 1, key.z))
+            mask |= terrain_edge_pos_x;
+        if (coarser(key.x, key.z - 1))
+            mask |= terrain_edge_neg_z;
+        if (coarser(key.x, key.z + 1))
+            mask |= terrain_edge_pos_z;
+        return mask;
+    }
+
+    void Terrain::Draw(UniformRing& frame_uniforms, glm::dvec3 const& render_origin, uint32_t model_binding) const
+    {
+        if (draw_nodes.empty())
+            return;
+
+        ALBUQUERQUE_PROFILE_CPU("Terrain Draw");
+        ALBUQUERQUE_PROFILE_GPU("Terrain Draw");
+
+        Fwog::Cmd::BindIndexBuffer(index_buffer.value(), Fwog::IndexType::UNSIGNED_INT);
+        for (DrawNode const& node : draw_nodes)
+        {
+            Tile const& tile = tiles.at(node.key);
+
+            //Subtracted in doubles, only the small difference becomes a float
+            glm::dvec2 origin = TerrainMesh::NodeOrigin(settings, node.key);
+            glm::vec3 offset(origin.x - render_origin.x, -render_origin.y, origin.y - render_origin.z);
+            TerrainPatchUniforms patch{.model = glm::translate(glm::mat4(1.0f), offset)};
+            UniformRing::BindUniform(model_binding, frame_uniforms.Push(patch));
+
+            Fwog::Cmd::BindVertexBuffer(0, tile.vertex_buffer.value(), 0, sizeof(TerrainVertex));
+            Fwog::Cmd::DrawIndexed(IndexCount(), 1, node.stitch_mask * IndexCount(), 0, 0);
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <Albuquerque/UniformRing.hpp>
+
+#include <Fwog/Rendering.h>
+
+#include <glad/glad.h>
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Albuquerque
+{
+    namespace
+    {
+        size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    UniformRing::UniformRing(size_t bytes_per_frame, uint32_t frames_in_flight)
+        : bytes_per_frame(bytes_per_frame), frames_in_flight(std::max<uint32_t>(frames_in_flight, 1)), frame_fences(this->frames_in_flight, nullptr)
+    {
+        GLint uniform_alignment = 0;
+        GLint storage_alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+        alignment = std::max<size_t>({static_cast<size_t>(uniform_alignment), static_cast<size_t>(storage_alignment), 16});
+
+        CreateBuffer(AlignUp(bytes_per_frame, alignment));
+    }
+
+    UniformRing::~UniformRing()
+    {
+        for (void* fence : frame_fences)
+        {
+            if (fence)
+                glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+
+    void UniformRing::CreateBuffer(size_t new_bytes_per_frame)
+    {
+        bytes_per_frame = new_bytes_per_frame;
+        buffer = std::make_unique<Fwog::Buffer>(bytes_per_frame * frames_in_flight, Fwog::BufferStorageFlag::MAP_MEMORY);
+        mapped = static_cast<std::byte*>(buffer->GetMappedPointer());
+    }
+
+    void UniformRing::BeginFrame()
+    {
+        frame_offset = 0;
+
+        void*& fence = frame_fences[frame_index % frames_in_flight];
+        if (fence == nullptr)
+            return;
+
+        auto sync = static_cast<GLsync>(fence);
+        stats.fence_waits += 1;
+        stats.last_stall_ms = 0.0;
+
+        //Polling first tells apart the usual case (GPU long done) from an actual stall
+        GLenum result = glClientWaitSync(sync, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            ZoneScopedN("Uniform Ring Stall");
+            auto wait_start = std::chrono::high_resolution_clock::now();
+            do
+            {
+                result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+
+            stats.stalls += 1;
+            stats.last_stall_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wait_start).count();
+            stats.stall_ms += stats.last_stall_ms;
+        }
+
+        glDeleteSync(sync);
+        fence = nullptr;
+
+        //The frame that last used this segment is done, so is anything retired before it
+        uint64_t finished_frame = frame_index - frames_in_flight;
+        std::erase_if(retired_buffers, [&](RetiredBuffer const& retired) { return retired.last_frame <= finished_frame; });
+    }
+
+    void UniformRing::EndFrame()
+    {
+        frame_fences[frame_index % frames_in_flight] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        stats.last_frame_bytes = frame_offset;
+        TracyPlot("Uniform Ring Bytes", static_cast<int64_t>(frame_offset));
+        TracyPlot("Uniform Ring Stall ms", stats.last_stall_ms);
+
+        frame_index += 1;
+    }
+
+    UniformSlice UniformRing::Allocate(size_t size, void** data)
+    {
+        size_t offset = AlignUp(frame_offset, alignment);
+        if (offset + size > bytes_per_frame)
+        {
+            //Slices handed out earlier this frame keep pointing at the old buffer, so it has to outlive this frame
+            retired_buffers.push_back({std::move(buffer), frame_index});
+            CreateBuffer(AlignUp(std::max(bytes_per_frame * 2, size), alignment));
+            stats.grows += 1;
+            spdlog::warn("UniformRing: Frame did not fit, grew to {} bytes per frame", bytes_per_frame);
+
+            offset = 0;
+        }
+
+        frame_offset = offset + size;
+
+        size_t buffer_offset = (frame_index % frames_in_flight) * bytes_per_frame + offset;
+        *data = mapped + buffer_offset;
+        return UniformSlice{buffer.get(), buffer_offset, size};
+    }
+
+    void UniformRing::BindUniform(uint32_t index, UniformSlice const& slice)
+    {
+        Fwog::Cmd::BindUniformBuffer(index, *slice.buffer, slice.offset, slice.size);
+    }
+
+    void UniformRing::BindStorage(uint32_t index, UniformSlice const& slice)
+    {
+        Fwog::Cmd::BindStorageBuffer(index, *slice.buffer, slice.offset, slice.size);
+    }
+}
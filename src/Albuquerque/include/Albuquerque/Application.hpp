@@ -1,13 +1,35 @@
 #pragma once
+#include <Albuquerque/Headless.hpp>
+#include <Albuquerque/FrameTiming.hpp>
+#include <Albuquerque/InputRecording.hpp>
+#include <Albuquerque/Memory.hpp>
 #include <cstdint>
+#include <memory>
 struct GLFWwindow;
 
 namespace Albuquerque
 {
+    class UniformRing;
+    class Profiler;
+
     class Application
     {
     public:
-        void Run();
+        Application();
+        virtual ~Application();
+
+        //Returns the process exit code. Only a failed headless run returns anything other than 0
+        int Run();
+
+        //Has to be called before Run
+        void SetHeadless(HeadlessSettings const& settings);
+
+        //Has to be called before Run. Update and the UI run on the main thread while RenderScene runs on a render
+        //thread that owns the GL context, one frame behind. Ignored for headless runs.
+        void SetPipelinedRendering(bool enabled);
+
+        //Has to be called before Run. Recording, replaying or benchmarking a recording
+        void SetInput(InputSettings const& settings);
 
     protected:
 
@@ -35,6 +57,30 @@ namespace Albuquerque
         virtual void RenderUI(double dt);
         virtual void Update(double dt);
 
+        //Runs zero or more times per frame before Update, always with the same dt (fixed_timestep.StepDt()).
+        //Anything that has to be deterministic (physics, collision) goes here and Update only does per frame things.
+        virtual void FixedUpdate(double fixed_dt);
+
+        //For rendering between the previous and the current fixed update state
+        float GetInterpolationAlpha() const { return static_cast<float>(fixed_timestep.Alpha()); }
+
+        //Headless runs call this before Update every frame so the app can put its camera on a fixed path.
+        //time is frame_index * fixed_dt so the same frame always gets the same camera.
+        virtual void UpdateScriptedCamera(uint32_t frame_index, double time);
+
+        bool IsHeadless() const { return headless_settings.enabled; }
+
+        //The input comes from a recording, so it has to stay out of anything that isn't replayed (the UI)
+        bool IsReplaying() const { return replaying; }
+
+        //When this is true RenderScene is called on the render thread and must only read what PublishFrameSnapshot
+        //handed over. Update and RenderUI are on the main thread without a GL context.
+        bool IsPipelined() const { return pipelined_rendering; }
+
+        //Pipelined mode only. Called on the main thread after Update and the UI every frame, the app copies
+        //whatever RenderScene needs into its own TripleBuffer here
+        virtual void PublishFrameSnapshot();
+
         //I think this only called once in awhile so copy is fine. No ownership anyways
         void SetWindowTitle(const char* winTitle);
 
@@ -42,12 +88,69 @@ namespace Albuquerque
         void SetMouseCursorDisabled(bool mouseHidden);
         void ToggleMouseCursorMode();
 
+        //Heap allocations of the last frame, the frame arena usage and the uniform ring counters. Apps call it from RenderUI
+        void RenderMemoryStatsUI();
+
+        //Frame time percentiles and the zone table of the profiler, with the record and export buttons
+        void RenderProfilerUI();
+
+        //Per-frame uniforms go here instead of UpdateData on their own buffers. Only on the GL thread, which is the
+        //render thread in pipelined mode
+        UniformRing& FrameUniforms() { return *uniform_ring; }
+
         GLFWwindow* _windowHandle = nullptr;
 
+        //Apps can change the tick rate, step clamp and fps cap from Load
+        FixedTimestep fixed_timestep;
+        FramePacer frame_pacer;
+
+        //Reset at the start of every frame, for temporaries that don't outlive it. Main thread only, so in
+        //pipelined mode RenderScene can't use it
+        FrameArena frame_arena;
+
     private:
 
-        void Render(double dt);
+        //Scene and UI but no swap, so the frame can still be read back before it is presented
+        void Render(double dt, bool render_ui = true);
+        int RunHeadless();
+        //Returns how many fixed updates ran
+        uint32_t RunFixedUpdates(double dt);
+
+        //After polling events. Samples the devices into current_input, or takes the next frame of the replay and
+        //returns its dt instead of the measured one
+        double BeginFrameInput(double dt);
+        //After the fixed updates, writes the frame to the recording
+        void EndFrameInput(double dt, uint32_t steps);
+        bool StartInput();
+        //Writes the benchmark report, GL thread
+        void FinishBenchmark();
+
+        //Samples the allocation counters and resets the frame arena
+        void BeginFrameMemory();
+
+        void RunPipelined();
+        void RenderThreadMain();
+
         bool cursor_hidden = false;
+
+        AllocationStats last_frame_allocations;
+        size_t last_frame_arena_bytes = 0;
+        HeadlessSettings headless_settings;
+
+        bool pipelined_rendering = false;
+        struct PipelineState;
+        std::unique_ptr<PipelineState> pipeline;
+
+        std::unique_ptr<UniformRing> uniform_ring;
+        std::unique_ptr<Profiler> profiler;
+
+        InputSettings input_settings;
+        InputState current_input;
+        InputRecorder input_recorder;
+        InputReplay input_replay;
+        bool replaying = false;
+        uint32_t replay_expected_steps = 0;
+        bool replay_diverged = false;
     };
 
 }
@@ -0,0 +1,286 @@
+#pragma once
+#include <Albuquerque/SpscQueue.hpp>
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Albuquerque
+{
+    //A sound decoded up front at the mixer's sample rate. Kept as 16 bit, half the memory of floats, and only
+    //turned into floats as it is mixed. Never changes or moves once loaded, the mixer holds plain pointers to it
+    struct AudioClip
+    {
+        std::vector<int16_t> samples;
+        //1 or 2, interleaved
+        uint32_t channels = 1;
+        uint32_t frame_count = 0;
+    };
+
+    using AudioClipId = uint32_t;
+    inline constexpr AudioClipId invalid_audio_clip = std::numeric_limits<uint32_t>::max();
+
+    //A long track decoded bit by bit while it plays, see AudioSystem::OpenMusic
+    class AudioStream;
+    using AudioMusicId = uint32_t;
+    inline constexpr AudioMusicId invalid_audio_music = std::numeric_limits<uint32_t>::max();
+
+    struct AudioMusicParams
+    {
+        float gain = 1.0f;
+        bool loop = true;
+    };
+
+    //Names a playing sound. Stays safe to use after the sound ended or was stolen, commands for it do nothing then
+    struct AudioVoice
+    {
+        uint32_t id = 0;
+
+        bool IsValid() const { return id != 0; }
+    };
+
+    struct AudioPlayParams
+    {
+        float gain = 1.0f;
+        //Playback rate, 2 is an octave up
+        float pitch = 1.0f;
+        //When every voice is busy a new sound takes the voice of the lowest priority one, if that isn't higher
+        uint8_t priority = 128;
+        bool loop = false;
+
+        //Attenuated by distance and panned around the listener
+        bool spatial = false;
+        glm::vec3 position{0.0f};
+        //Full volume inside min_distance, then 1/distance, silent past max_distance
+        float min_distance = 10.0f;
+        float max_distance = 2000.0f;
+    };
+
+    //What the game thread sends the mixer
+    struct AudioCommand
+    {
+        enum class Type : uint8_t
+        {
+            play,
+            stop,
+            set_gain,
+            set_pitch,
+            set_position,
+            set_listener,
+            //Moves the listener and every spatial voice, for the floating origin
+            translate,
+            stop_all,
+            //Fades a stream in to its gain, or out and pauses it. Played again it carries on where it was
+            play_music,
+            stop_music,
+        };
+
+        Type type = Type::stop;
+        uint32_t voice_id = 0;
+        AudioClip const* clip = nullptr;
+        AudioStream* stream = nullptr;
+        float fade_seconds = 0.0f;
+        AudioPlayParams params;
+        //Listener forward and up for set_listener, the offset for translate
+        glm::vec3 forward{0.0f};
+        glm::vec3 up{0.0f};
+    };
+
+    //Mixes up to max_voices voices into stereo floats. Commands come in through a lock free queue and are applied
+    //at the start of every Mix, so Mix never locks or allocates and can run in the audio callback. Submit is the
+    //producer side and has to stay on one thread, Mix is the consumer side.
+    class AudioMixer
+    {
+    public:
+        //Music streams that can play at once, two is enough to crossfade
+        static constexpr uint32_t max_music = 4;
+
+        struct Stats
+        {
+            uint32_t active_voices = 0;
+            uint32_t max_voices = 0;
+            uint64_t stolen_voices = 0;
+            //Plays turned away because every voice had a higher priority
+            uint64_t rejected_voices = 0;
+            uint64_t mixed_frames = 0;
+            //Sum of the active voices over every mixed frame, so mix time over it is the cost of one voice
+            uint64_t mixed_voice_frames = 0;
+            double mix_seconds = 0.0;
+            //Music streams playing or fading
+            uint32_t active_music = 0;
+            //Blocks a stream had less decoded than the mixer needed, it plays silence for the rest
+            uint64_t music_underruns = 0;
+            //Frames taken from the music streams, added up over every stream
+            uint64_t music_frames = 0;
+
+            //Share of one core it takes to mix 100 voices in real time
+            double CpuPercentPer100Voices(uint32_t sample_rate) const;
+        };
+
+        AudioMixer(uint32_t sample_rate, uint32_t max_voices, size_t command_capacity);
+
+        bool Submit(AudioCommand const& command) { return commands.Push(command); }
+
+        //Interleaved stereo, frame_count frames
+        void Mix(float* output, uint32_t frame_count);
+
+        //Any thread
+        Stats GetStats() const;
+        uint32_t SampleRate() const { return sample_rate; }
+
+    private:
+        struct Voice
+        {
+            uint32_t id = 0;
+            AudioClip const* clip = nullptr;
+            //32.32 fixed point frames, exact over any clip length
+            uint64_t cursor = 0;
+            uint64_t step = 0;
+            //Order of starting, the oldest goes first when a steal is a tie
+            uint64_t sequence = 0;
+            AudioPlayParams params;
+            //Gains at the end of the last block, the next block ramps from them so changes don't click
+            float left = 0.0f;
+            float right = 0.0f;
+        };
+
+        void Apply(AudioCommand const& command);
+        void Start(AudioCommand const& command);
+        Voice* Find(uint32_t voice_id);
+        void TargetGains(Voice const& voice, float& left, float& right) const;
+        //False once a one shot voice has run off the end
+        bool MixVoice(Voice& voice, float* output, uint32_t frame_count);
+
+        struct MusicSlot
+        {
+            AudioStream* stream = nullptr;
+            float gain = 0.0f;
+            float target = 0.0f;
+            //Gain change per frame while fading
+            float step = 0.0f;
+        };
+
+        void StartMusic(AudioCommand const& command);
+        void StopMusic(AudioCommand const& command);
+        //False once it faded out or a stream that doesn't loop has run out
+        bool MixMusic(MusicSlot& slot, float* output, uint32_t frame_count);
+
+        uint32_t sample_rate;
+        std::vector<Voice> voices;
+        SpscQueue<AudioCommand> commands;
+        std::array<MusicSlot, max_music> music;
+        //A chunk of stereo frames popped from a stream
+        std::vector<float> music_scratch;
+
+        glm::vec3 listener_position{0.0f};
+        glm::vec3 listener_forward{0.0f, 0.0f, -1.0f};
+        glm::vec3 listener_up{0.0f, 1.0f, 0.0f};
+        uint64_t next_sequence = 0;
+
+        std::atomic<uint32_t> active_voices{0};
+        std::atomic<uint64_t> stolen_voices{0};
+        std::atomic<uint64_t> rejected_voices{0};
+        std::atomic<uint64_t> mixed_frames{0};
+        std::atomic<uint64_t> mixed_voice_frames{0};
+        std::atomic<uint64_t> mix_nanoseconds{0};
+        std::atomic<uint32_t> active_music{0};
+        std::atomic<uint64_t> music_underruns{0};
+        std::atomic<uint64_t> music_frames{0};
+    };
+
+    struct AudioSettings
+    {
+        uint32_t sample_rate = 48000;
+        uint32_t max_voices = 64;
+        size_t command_capacity = 1024;
+        //Decoded music kept ahead of each stream. It only has to cover the streaming thread's wakeups and the
+        //odd slow disk read
+        float music_buffer_seconds = 0.5f;
+        //miniaudio's null backend runs the mixer on its own thread at real time but plays nothing. For headless
+        //runs and tests, and it is what a failed device falls back to
+        bool null_backend = false;
+    };
+
+    //Clips, voices and the output device. Everything but GetStats is for one thread only, the game thread, which
+    //is what makes the command queue single producer.
+    class AudioSystem
+    {
+    public:
+        AudioSystem();
+        ~AudioSystem();
+
+        AudioSystem(AudioSystem const&) = delete;
+        AudioSystem& operator=(AudioSystem const&) = delete;
+
+        bool Initialize(AudioSettings const& settings = {});
+        void Shutdown();
+        bool IsInitialized() const { return mixer != nullptr; }
+
+        //Decodes the whole file. Loading the same path again gives back the same clip
+        AudioClipId LoadClip(std::string const& file_path);
+        //Samples at the mixer's sample rate
+        AudioClipId AddClip(std::span<int16_t const> samples, uint32_t channels);
+
+        AudioVoice Play(AudioClipId clip, AudioPlayParams const& params = {});
+        void Stop(AudioVoice voice);
+        void SetGain(AudioVoice voice, float gain);
+        void SetPitch(AudioVoice voice, float pitch);
+        void SetPosition(AudioVoice voice, glm::vec3 position);
+        void SetListener(glm::vec3 position, glm::vec3 forward, glm::vec3 up);
+        void Translate(glm::vec3 offset);
+        void StopAll();
+
+        //Opens a track for streaming. Only the file header is read now, a background thread decodes it a little
+        //ahead of the mixer into a ring of music_buffer_seconds, so memory doesn't grow with the track's length.
+        //Anything miniaudio decodes works: WAV, FLAC, MP3 and OGG Vorbis
+        AudioMusicId OpenMusic(std::string const& file_path, AudioMusicParams const& params = {});
+        //Fades in over fade_seconds, from where it was paused. Fading one in while another fades out crossfades
+        void PlayMusic(AudioMusicId music, float fade_seconds = 0.0f);
+        void StopMusic(AudioMusicId music, float fade_seconds = 0.0f);
+
+        AudioMixer::Stats GetStats() const;
+        uint32_t SampleRate() const { return settings.sample_rate; }
+        size_t ClipBytes() const { return clip_bytes; }
+        //Decoded music buffered across all streams, plus what the decoders hold
+        size_t MusicBytes() const { return music_bytes; }
+        //Commands lost because the mixer fell that far behind
+        uint64_t DroppedCommands() const { return dropped_commands; }
+
+    private:
+        void Submit(AudioCommand const& command);
+
+        AudioSettings settings;
+        std::unique_ptr<AudioMixer> mixer;
+
+        struct Device;
+        std::unique_ptr<Device> device;
+
+        std::vector<std::unique_ptr<AudioClip>> clips;
+        std::unordered_map<std::string, AudioClipId> clips_by_path;
+        size_t clip_bytes = 0;
+
+        void StreamMusic();
+
+        //The streaming thread walks these, the lock only keeps OpenMusic from adding one under it. The mixer never
+        //takes it, it only sees streams through commands
+        std::vector<std::unique_ptr<AudioStream>> streams;
+        std::mutex streams_mutex;
+        std::thread streamer;
+        std::atomic<bool> streaming{false};
+        size_t music_bytes = 0;
+
+        uint32_t next_voice_id = 1;
+        uint64_t dropped_commands = 0;
+    };
+}
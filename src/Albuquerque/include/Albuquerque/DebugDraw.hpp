@@ -0,0 +1,107 @@
+#pragma once
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+
+#include <Albuquerque/UniformRing.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Immediate mode debug drawing. Add shapes any time during the frame, then Render once inside a render pass.
+    //Every shape is an instance of a small unit mesh (segment, box, sphere) with its own transform, so a thousand
+    //colliders are a thousand 80 byte instances instead of tens of thousands of tessellated line vertices.
+    //Everything is written into a persistently mapped ring buffer once per frame and drawn with a single
+    //multi draw indirect call. GL thread only.
+    class DebugDraw
+    {
+    public:
+        //Depth testing against the scene is off by default so colliders show through walls
+        explicit DebugDraw(bool depth_test = false);
+        ~DebugDraw();
+
+        DebugDraw(DebugDraw const&) = delete;
+        DebugDraw& operator=(DebugDraw const&) = delete;
+
+        void Line(glm::vec3 start, glm::vec3 end, glm::vec3 color);
+        void Box(glm::vec3 center, glm::vec3 half_extents, glm::vec3 color);
+        //Unit cube from -1 to 1 put through transform, for oriented boxes
+        void Box(glm::mat4 const& transform, glm::vec3 color);
+        void Sphere(glm::vec3 center, float radius, glm::vec3 color);
+        //The frustum a camera with this view projection matrix sees
+        void Frustum(glm::mat4 const& view_proj, glm::vec3 color);
+
+        //Uploads and draws everything added since the last call, then clears it. Has to be called inside a Fwog
+        //render pass. view_uniforms gets bound to uniform binding 0 and must start with the viewProj matrix,
+        //which every app's global uniform buffer already does.
+        void Render(Fwog::Buffer const& view_uniforms);
+        //Same but with the view uniforms streamed through the frame's UniformRing
+        void Render(UniformSlice const& view_uniforms);
+
+        //Throws away everything added this frame without drawing it
+        void Clear();
+
+        size_t InstanceCount() const;
+
+    private:
+        enum Shape : uint32_t
+        {
+            shape_line,
+            shape_box,
+            shape_sphere,
+            shape_count
+        };
+
+        //Matches DebugInstance in debug_draw.vert.glsl
+        struct Instance
+        {
+            glm::mat4 transform;
+            glm::vec4 color;
+        };
+
+        //Same layout as glMultiDrawArraysIndirect expects
+        struct DrawCommand
+        {
+            uint32_t vertex_count;
+            uint32_t instance_count;
+            uint32_t first_vertex;
+            uint32_t first_instance;
+        };
+
+        static constexpr uint32_t frames_in_flight = 3;
+        //Covers every GL implementation's uniform and storage buffer offset alignment
+        static constexpr size_t segment_alignment = 256;
+
+        void CreateRing(size_t instance_capacity);
+        //Blocks until the GPU is done reading the segment so it can be written again
+        void WaitForSegment(uint32_t segment);
+        void WaitForAllSegments();
+        void RenderWithView(Fwog::Buffer const& view_uniforms, uint64_t view_offset, uint64_t view_size);
+
+        //Filled during the frame, capacity is kept between frames so steady state adding never allocates
+        std::array<std::vector<Instance>, shape_count> instances;
+
+        std::array<uint32_t, shape_count> mesh_first_vertex{};
+        std::array<uint32_t, shape_count> mesh_vertex_count{};
+
+        std::optional<Fwog::GraphicsPipeline> pipeline;
+        std::optional<Fwog::Buffer> mesh_buffer;
+
+        //frames_in_flight segments of [draw commands][instances]. The GPU can still be reading the previous
+        //segments while this frame writes the next, fences say when one is free again
+        std::optional<Fwog::Buffer> ring_buffer;
+        std::byte* ring_memory = nullptr;
+        size_t segment_instance_capacity = 0;
+        size_t segment_stride = 0;
+        uint32_t current_segment = 0;
+        std::array<void*, frames_in_flight> segment_fences{};
+    };
+}
@@ -0,0 +1,411 @@
+#pragma once
+#include <Albuquerque/JobSystem.hpp>
+
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Archetype ECS. Every unique set of components gets an archetype, and an archetype stores its entities in
+    //16KB chunks with one tightly packed array per component (SoA). Systems walk whole arrays instead of hopping
+    //between objects, which is most of the point.
+    //Components get moved between chunks with memcpy so they have to be trivially copyable.
+
+    struct Entity
+    {
+        static constexpr uint32_t invalid_index = 0xFFFFFFFF;
+
+        uint32_t index = invalid_index;
+        //Bumped every time the index gets reused so stale handles can be detected
+        uint32_t generation = 0;
+
+        bool IsValid() const { return index != invalid_index; }
+        bool operator==(Entity const&) const = default;
+    };
+
+    using ComponentId = uint32_t;
+    constexpr uint32_t max_component_types = 64;
+    using ComponentMask = std::bitset<max_component_types>;
+
+    struct ComponentInfo
+    {
+        uint32_t size = 0;
+        uint32_t alignment = 0;
+    };
+
+    namespace ECSDetail
+    {
+        ComponentId RegisterComponent(uint32_t size, uint32_t alignment);
+        ComponentInfo const& GetComponentInfo(ComponentId id);
+    }
+
+    //Ids are handed out the first time a type is used, so they can differ between runs. Don't save them
+    template <typename T>
+    ComponentId GetComponentId()
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Components are moved between chunks with memcpy");
+        static ComponentId id = ECSDetail::RegisterComponent(sizeof(T), alignof(T));
+        return id;
+    }
+
+    template <typename... Ts>
+    ComponentMask MakeComponentMask()
+    {
+        ComponentMask mask;
+        (mask.set(GetComponentId<Ts>()), ...);
+        return mask;
+    }
+
+    struct Chunk
+    {
+        static constexpr size_t size = 16 * 1024;
+
+        alignas(64) std::byte data[size];
+        uint32_t count = 0;
+    };
+
+    class Archetype
+    {
+    public:
+        explicit Archetype(ComponentMask mask);
+
+        bool HasComponent(ComponentId id) const { return mask.test(id); }
+
+        Entity* Entities(Chunk& chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+        void* Column(Chunk& chunk, ComponentId id) const { return chunk.data + column_offsets[id]; }
+
+        template <typename T>
+        T* Column(Chunk& chunk) const { return reinterpret_cast<T*>(Column(chunk, GetComponentId<T>())); }
+
+        size_t EntityCount() const;
+
+        ComponentMask mask;
+        std::vector<ComponentId> components;
+        uint32_t chunk_capacity = 0;
+
+        //All chunks are full except the last one
+        std::vector<std::unique_ptr<Chunk>> chunks;
+
+    private:
+        friend class World;
+
+        //Where each component's array starts inside a chunk
+        std::array<uint32_t, max_component_types> column_offsets{};
+
+        //Cached neighbours so adding or removing a component doesn't have to look the archetype up again
+        std::array<Archetype*, max_component_types> add_edges{};
+        std::array<Archetype*, max_component_types> remove_edges{};
+    };
+
+    class World
+    {
+    public:
+        World();
+        ~World();
+
+        World(World const&) = delete;
+        World& operator=(World const&) = delete;
+
+        Entity Create();
+
+        //Creates the entity straight in its final archetype instead of moving it once per component
+        template <typename... Ts>
+        Entity Create(Ts const&... components);
+
+        void Destroy(Entity entity);
+        bool IsAlive(Entity entity) const;
+
+        //Adding a component the entity already has just overwrites the value
+        template <typename T>
+        void Add(Entity entity, T const& component = {});
+
+        template <typename T>
+        void Remove(Entity entity);
+
+        template <typename T>
+        bool Has(Entity entity) const;
+
+        //nullptr if the entity doesn't have it. Only valid until the next structural change
+        template <typename T>
+        T* Get(Entity entity);
+
+        //Type erased versions, the command buffers use these
+        void AddRaw(Entity entity, ComponentId id, void const* data);
+        void RemoveRaw(Entity entity, ComponentId id);
+
+        size_t EntityCount() const { return alive_count; }
+
+        //Archetypes are never deleted and only ever appended, queries rely on that for their cache
+        std::vector<std::unique_ptr<Archetype>> const& Archetypes() const { return archetypes; }
+
+    private:
+        struct EntityRecord
+        {
+            Archetype* archetype = nullptr;
+            uint32_t chunk_index = 0;
+            uint32_t row = 0;
+            uint32_t generation = 0;
+        };
+
+        Entity AllocateEntity();
+        Archetype* GetOrCreateArchetype(ComponentMask mask);
+        Archetype* GetAddTarget(Archetype* archetype, ComponentId id);
+        Archetype* GetRemoveTarget(Archetype* archetype, ComponentId id);
+
+        //Appends a row for the entity and points its record at it
+        void AllocateRow(Archetype* archetype, Entity entity);
+        //Swap removes the row, moving the very last entity of the archetype into the hole
+        void FreeRow(Archetype* archetype, uint32_t chunk_index, uint32_t row);
+        //Moves the entity and every component both archetypes share
+        void MoveEntity(Entity entity, Archetype* destination);
+
+        std::vector<EntityRecord> records;
+        std::vector<uint32_t> free_indices;
+        size_t alive_count = 0;
+
+        std::vector<std::unique_ptr<Archetype>> archetypes;
+        std::unordered_map<ComponentMask, Archetype*> archetype_lookup;
+        Archetype* empty_archetype = nullptr;
+    };
+
+    //Structural changes (create, destroy, add, remove) move entities between chunks, so they can't happen while a
+    //query is iterating. Record them here instead and play them back afterwards.
+    //Not thread safe, parallel systems should use one buffer per job thread (see JobSystem::CurrentThreadIndex).
+    class CommandBuffer
+    {
+    public:
+        //Adds that follow with an invalid entity (Entity{}) go onto the most recently created entity
+        void Create();
+        void Destroy(Entity entity);
+
+        template <typename T>
+        void Add(Entity entity, T const& component);
+
+        template <typename T>
+        void Remove(Entity entity);
+
+        //Applies everything in the order it was recorded, then clears. Commands on dead entities are skipped
+        void Playback(World& world);
+
+        bool IsEmpty() const { return commands.empty(); }
+        void Clear();
+
+    private:
+        enum class CommandType : uint8_t
+        {
+            Create,
+            Destroy,
+            Add,
+            Remove
+        };
+
+        struct Command
+        {
+            CommandType type;
+            ComponentId component;
+            Entity entity;
+            uint32_t payload_offset;
+        };
+
+        std::vector<Command> commands;
+        std::vector<std::byte> payload;
+    };
+
+    //Caches which archetypes match, and only looks at archetypes created since the last use to update it
+    template <typename... Ts>
+    class Query
+    {
+    public:
+        explicit Query(World& world, ComponentMask excluded = {})
+            : world(&world), required(MakeComponentMask<Ts...>()), excluded(excluded)
+        {
+        }
+
+        //f(Entity, Ts&...)
+        template <typename F>
+        void ForEach(F&& f);
+
+        //f(uint32_t count, Entity const* entities, Ts*... columns). For loops the compiler can vectorize
+        template <typename F>
+        void ForEachChunk(F&& f);
+
+        //Same as ForEach with one job per chunk on the shared job pool. No structural changes in f, use a
+        //CommandBuffer per thread
+        template <typename F>
+        void ParallelForEach(char const* name, F&& f);
+
+        size_t Count();
+
+        std::vector<Archetype*> const& MatchingArchetypes()
+        {
+            Refresh();
+            return matching;
+        }
+
+    private:
+        void Refresh();
+
+        World* world;
+        ComponentMask required;
+        ComponentMask excluded;
+
+        std::vector<Archetype*> matching;
+        size_t archetypes_seen = 0;
+
+        std::vector<std::pair<Archetype*, Chunk*>> parallel_chunks;
+    };
+
+    template <typename... Ts>
+    Entity World::Create(Ts const&... components)
+    {
+        Entity entity = AllocateEntity();
+        Archetype* archetype = GetOrCreateArchetype(MakeComponentMask<Ts...>());
+        AllocateRow(archetype, entity);
+
+        EntityRecord& record = records[entity.index];
+        Chunk& chunk = *archetype->chunks[record.chunk_index];
+        ((archetype->Column<Ts>(chunk)[record.row] = components), ...);
+        return entity;
+    }
+
+    template <typename T>
+    void World::Add(Entity entity, T const& component)
+    {
+        AddRaw(entity, GetComponentId<T>(), &component);
+    }
+
+    template <typename T>
+    void World::Remove(Entity entity)
+    {
+        RemoveRaw(entity, GetComponentId<T>());
+    }
+
+    template <typename T>
+    bool World::Has(Entity entity) const
+    {
+        return IsAlive(entity) && records[entity.index].archetype->HasComponent(GetComponentId<T>());
+    }
+
+    template <typename T>
+    T* World::Get(Entity entity)
+    {
+        if (!IsAlive(entity))
+            return nullptr;
+
+        EntityRecord const& record = records[entity.index];
+        if (!record.archetype->HasComponent(GetComponentId<T>()))
+            return nullptr;
+
+        return &record.archetype->Column<T>(*record.archetype->chunks[record.chunk_index])[record.row];
+    }
+
+    template <typename T>
+    void CommandBuffer::Add(Entity entity, T const& component)
+    {
+        uint32_t offset = static_cast<uint32_t>(payload.size());
+        payload.resize(payload.size() + sizeof(T));
+        std::memcpy(payload.data() + offset, &component, sizeof(T));
+
+        commands.push_back({CommandType::Add, GetComponentId<T>(), entity, offset});
+    }
+
+    template <typename T>
+    void CommandBuffer::Remove(Entity entity)
+    {
+        commands.push_back({CommandType::Remove, GetComponentId<T>(), entity, 0});
+    }
+
+    template <typename... Ts>
+    void Query<Ts...>::Refresh()
+    {
+        auto const& all_archetypes = world->Archetypes();
+        for (; archetypes_seen < all_archetypes.size(); ++archetypes_seen)
+        {
+            Archetype* archetype = all_archetypes[archetypes_seen].get();
+            if ((archetype->mask & required) == required && (archetype->mask & excluded).none())
+            {
+                matching.push_back(archetype);
+            }
+        }
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::ForEachChunk(F&& f)
+    {
+        Refresh();
+        for (Archetype* archetype : matching)
+        {
+            for (auto& chunk : archetype->chunks)
+            {
+                f(chunk->count, archetype->Entities(*chunk), archetype->template Column<Ts>(*chunk)...);
+            }
+        }
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::ForEach(F&& f)
+    {
+        ForEachChunk([&f](uint32_t count, Entity const* entities, Ts*... columns)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                f(entities[i], columns[i]...);
+            }
+        });
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::ParallelForEach(char const* name, F&& f)
+    {
+        Refresh();
+
+        parallel_chunks.clear();
+        for (Archetype* archetype : matching)
+        {
+            for (auto& chunk : archetype->chunks)
+            {
+                parallel_chunks.emplace_back(archetype, chunk.get());
+            }
+        }
+
+        JobSystem::Instance().ParallelFor(name, parallel_chunks.size(), 1, [&](size_t first, size_t last)
+        {
+            for (size_t c = first; c < last; ++c)
+            {
+                auto [archetype, chunk] = parallel_chunks[c];
+                Entity const* entities = archetype->Entities(*chunk);
+                std::tuple<Ts*...> columns{archetype->template Column<Ts>(*chunk)...};
+
+                for (uint32_t i = 0; i < chunk->count; ++i)
+                {
+                    f(entities[i], std::get<Ts*>(columns)[i]...);
+                }
+            }
+        });
+    }
+
+    template <typename... Ts>
+    size_t Query<Ts...>::Count()
+    {
+        Refresh();
+        size_t count = 0;
+        for (Archetype* archetype : matching)
+        {
+            count += archetype->EntityCount();
+        }
+        return count;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <optional>
+
+namespace Albuquerque
+{
+    //Keeps the float coordinates everything is simulated and rendered in close to zero. The real position of a
+    //thing is Origin() + its local position, with the origin in doubles, which is exact to well under a
+    //millimeter anywhere on a planet sized map. Once the focus (the player, the camera) gets rebase_distance away
+    //from the origin horizontally the origin jumps to the snap point under it, and everyone holding local
+    //positions subtracts the returned shift. That is one pass over the active objects, nothing else changes.
+    //Up stays absolute so heights keep meaning the same thing, nothing here flies high enough for it to matter.
+    class FloatingOrigin
+    {
+    public:
+        //snap keeps the shifts whole numbers so subtracting them is exact
+        explicit FloatingOrigin(float rebase_distance = 2048.0f, double snap = 1024.0);
+
+        //Call once per simulation step. Returns the shift to subtract from every local position when it rebased
+        std::optional<glm::vec3> Update(glm::vec3 local_focus);
+
+        //Back to a fixed origin, e.g. when a level is loaded in world coordinates
+        void Reset(glm::dvec3 origin = glm::dvec3(0.0));
+
+        glm::vec3 ToLocal(glm::dvec3 const& world) const { return glm::vec3(world - origin); }
+        glm::dvec3 ToWorld(glm::vec3 const& local) const { return origin + glm::dvec3(local); }
+
+        glm::dvec3 const& Origin() const { return origin; }
+        float RebaseDistance() const { return rebase_distance; }
+        uint64_t RebaseCount() const { return rebase_count; }
+
+    private:
+        glm::dvec3 origin{0.0};
+        float rebase_distance;
+        double snap;
+        uint64_t rebase_count = 0;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Albuquerque
+{
+    //RGBA8, first row is the top of the image (already flipped from GL)
+    struct CapturedImage
+    {
+        int32_t width = 0;
+        int32_t height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    struct ImageCompareResult
+    {
+        bool size_matches = false;
+        uint32_t failed_pixels = 0;
+        float failed_pixel_fraction = 1.0f;
+        float mean_difference = 1.0f;
+        float max_difference = 1.0f;
+        bool passed = false;
+    };
+
+    //Reads back the default framebuffer's back buffer. Call before swapping
+    CapturedImage CaptureBackBuffer(int32_t width, int32_t height);
+
+    bool WritePng(std::string const& file_path, CapturedImage const& image);
+    bool LoadPng(std::string const& file_path, CapturedImage& image);
+
+    //Per pixel 'redmean' weighted colour distance normalized to [0, 1]. A pixel only fails if no pixel in the 3x3
+    //neighbourhood of the golden is within tolerance, so a one pixel shift in rasterization does not fail the image.
+    ImageCompareResult CompareImages(CapturedImage const& image, CapturedImage const& golden, float pixel_tolerance, float max_failed_pixel_fraction);
+
+    //Failed pixels in red over a darkened copy of the image, for looking at what went wrong
+    CapturedImage MakeDifferenceImage(CapturedImage const& image, CapturedImage const& golden, float pixel_tolerance);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <chrono>
+
+namespace Albuquerque
+{
+    //Accumulator for running the simulation at a fixed rate no matter the framerate.
+    //Steps are always exactly StepDt() long so the same inputs give the same result, which is what makes replays
+    //and headless benchmarks of the physics possible.
+    class FixedTimestep
+    {
+    public:
+        FixedTimestep(double tick_rate_hz = 60.0, uint32_t max_steps_per_frame = 8);
+
+        void SetTickRate(double tick_rate_hz);
+        void SetMaxStepsPerFrame(uint32_t max_steps);
+
+        //Adds the frame time and returns how many fixed steps to run this frame. If more than the max steps are owed
+        //the extra time is dropped (the simulation slows down) instead of spiralling into longer and longer frames
+        uint32_t Advance(double frame_dt);
+
+        //How far between the previous and current simulation state the frame is, in [0, 1). For interpolating
+        double Alpha() const { return accumulator / step_dt; }
+
+        double StepDt() const { return step_dt; }
+        double TickRate() const { return 1.0 / step_dt; }
+        uint32_t MaxStepsPerFrame() const { return max_steps_per_frame; }
+
+        uint64_t TickCount() const { return tick_count; }
+        //Total simulation time thrown away because of the step clamp. Non zero means the machine can't keep up
+        double DroppedTime() const { return dropped_time; }
+
+        void Reset();
+
+    private:
+        double step_dt;
+        uint32_t max_steps_per_frame;
+
+        double accumulator = 0.0;
+        uint64_t tick_count = 0;
+        double dropped_time = 0.0;
+    };
+
+    //Caps the framerate. Sleeping alone overshoots by however coarse the OS scheduler is (often 1-2ms on Windows),
+    //so it sleeps until close to the deadline and then spins the rest of the way.
+    class FramePacer
+    {
+        using clock_t = std::chrono::steady_clock;
+    public:
+        //0 means uncapped
+        void SetTargetFps(double fps);
+        double TargetFps() const { return target_fps; }
+
+        //How close to the deadline sleeping stops and spinning takes over
+        void SetSpinThreshold(double milliseconds);
+
+        //Blocks until the next frame should start. Call once per frame after presenting
+        void WaitForNextFrame();
+
+        //How late the last frame started compared to its deadline
+        double LastOvershootMs() const { return last_overshoot_ms; }
+
+    private:
+        double target_fps = 0.0;
+        clock_t::duration spin_threshold = std::chrono::microseconds(1500);
+
+        clock_t::time_point next_frame_deadline{};
+        bool has_deadline = false;
+        double last_overshoot_ms = 0.0;
+    };
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <Fwog/Buffer.h>
+#include <Fwog/Pipeline.h>
+
+#include <Albuquerque/UniformRing.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Matches CullObject in gpu_cull.comp.glsl (std430)
+    struct GpuCullObject
+    {
+        glm::vec3 center{0.0f};
+        float radius = 0.0f;
+        glm::vec3 half_extents{0.0f};
+        uint32_t mesh_index = 0;
+        //What ends up in the instance index buffer, so the vertex shader can find the object's uniforms
+        uint32_t object_index = 0;
+        uint32_t flags = 0;
+        uint32_t padding[2] = {};
+    };
+    static_assert(sizeof(GpuCullObject) == 48);
+
+    //Skipped by the cull pass without being removed, e.g. a collectable that got picked up
+    inline constexpr uint32_t gpu_cull_hidden = 1u << 0;
+
+    //Same layout as glMultiDrawElementsIndirect expects
+    struct DrawElementsIndirectCommand
+    {
+        uint32_t index_count;
+        uint32_t instance_count;
+        uint32_t first_index;
+        int32_t base_vertex;
+        uint32_t base_instance;
+    };
+    static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+    //The part of the bound index buffer one mesh uses
+    struct GpuCullMesh
+    {
+        uint32_t index_count = 0;
+        uint32_t first_index = 0;
+        int32_t base_vertex = 0;
+    };
+
+    //The CPU half of the culling, kept free of GL so it can be tested on its own
+    namespace GpuCulling
+    {
+        GpuCullObject PackAABB(glm::vec3 center, glm::vec3 half_extents, uint32_t mesh_index, uint32_t object_index, uint32_t flags = 0);
+        GpuCullObject PackSphere(glm::vec3 center, float radius, uint32_t mesh_index, uint32_t object_index, uint32_t flags = 0);
+
+        //One command per mesh with instance_count zeroed for the cull pass to count up. base_instance is where the
+        //mesh's visible indices start, every mesh gets room for all the objects that use it
+        std::vector<DrawElementsIndirectCommand> BuildCommandLayout(std::span<GpuCullMesh const> meshes, std::span<GpuCullObject const> objects);
+        //Same, from how many objects each mesh has, so keeping it up to date costs the mesh count and not the object count
+        std::vector<DrawElementsIndirectCommand> BuildCommandLayout(std::span<GpuCullMesh const> meshes, std::span<uint32_t const> objects_per_mesh);
+
+        //Left, right, bottom, top, near, far. Normalized and pointing inwards, for OpenGL's -1 to 1 depth
+        std::array<glm::vec4, 6> ExtractFrustumPlanes(glm::mat4 const& view_proj);
+
+        //Same test as the shader, sphere first then the box against every plane
+        bool IsVisible(std::array<glm::vec4, 6> const& planes, GpuCullObject const& object);
+    }
+
+    class HiZPyramid;
+
+    //Frustum culls a list of objects on the GPU and draws the survivors with one glMultiDrawElementsIndirectCount.
+    //A compute pass tests every object and appends its object_index to its mesh's range of the instance index
+    //buffer, a second one compacts the meshes that have anything visible into the indirect commands. The vertex
+    //shader then reads instance_indices[gl_BaseInstance + gl_InstanceID] to find the object it is drawing.
+    //The counters are reset by the passes themselves so nothing is uploaded per frame except the frustum.
+    //Given a Hi-Z pyramid of last frame's depth, whatever survives the frustum is also tested for occlusion.
+    //GL thread only.
+    class GpuCuller
+    {
+    public:
+        explicit GpuCuller(std::vector<GpuCullMesh> meshes);
+
+        //How many objects the cull pass let through, read back a few frames late so nothing waits on the GPU
+        struct Stats
+        {
+            uint32_t visible = 0;
+            uint32_t frustum_culled = 0;
+            uint32_t occlusion_culled = 0;
+        };
+
+        GpuCuller(GpuCuller const&) = delete;
+        GpuCuller& operator=(GpuCuller const&) = delete;
+        ~GpuCuller();
+
+        //Replaces every object, and rebuilds the buffers if there are more than before
+        void SetObjects(std::span<GpuCullObject const> new_objects);
+        //Patches one object in place. index is the position in the list given to SetObjects or returned by AddObject
+        void UpdateObject(uint32_t index, GpuCullObject const& object);
+        void SetHidden(uint32_t index, bool hidden);
+        //Appends one object and returns its index. The buffers double when they run out, so adding objects one at a
+        //time only copies everything now and then, otherwise it's one object and the per mesh commands
+        uint32_t AddObject(GpuCullObject const& object);
+        //Moves the last object into index, the same swap remove the world store does, so the two stay in step
+        void RemoveObject(uint32_t index);
+
+        //Compute passes, so outside of any render pass and before Draw. Without a valid hiz only the frustum is tested
+        void Cull(glm::mat4 const& view_proj, UniformRing& frame_uniforms, HiZPyramid const* hiz = nullptr);
+
+        //Inside a render pass with the pipeline, vertex and index buffers and the object storage buffer already
+        //bound. The visible indices go to storage binding instance_index_binding
+        void Draw(uint32_t instance_index_binding = 2) const;
+
+        uint32_t ObjectCount() const { return static_cast<uint32_t>(objects.size()); }
+        uint32_t MeshCount() const { return static_cast<uint32_t>(meshes.size()); }
+        Stats const& LastStats() const { return last_stats; }
+
+    private:
+        //Matches CullUniforms in the shaders (std140)
+        struct CullUniforms
+        {
+            std::array<glm::vec4, 6> planes;
+            glm::mat4 hiz_view_proj;
+            glm::vec2 hiz_size;
+            uint32_t hiz_mip_count;
+            uint32_t hiz_enabled;
+            uint32_t object_count;
+            uint32_t mesh_count;
+            uint32_t padding[2];
+        };
+        static_assert(sizeof(CullUniforms) == 192);
+
+        //Slots of the stats readback ring, one per frame in flight
+        static constexpr uint32_t stats_slots = 3;
+        //Generous, storage buffer offsets have to be aligned to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+        static constexpr size_t stats_slot_size = 256;
+
+        void CreateBuffers();
+        void UploadCommands();
+        //Waits for the slot's last cull to finish, keeps what it counted and zeroes it for this one
+        void ReadStats(uint32_t slot);
+
+        std::vector<GpuCullMesh> meshes;
+        std::vector<GpuCullObject> objects;
+        std::vector<uint32_t> objects_per_mesh;
+        size_t object_capacity = 0;
+
+        std::optional<Fwog::ComputePipeline> cull_pipeline;
+        std::optional<Fwog::ComputePipeline> compact_pipeline;
+
+        std::optional<Fwog::Buffer> object_buffer;
+        //Per mesh, instance_count is what the cull pass counts
+        std::optional<Fwog::Buffer> command_buffer;
+        //Only the meshes with something visible, what the draw reads
+        std::optional<Fwog::Buffer> draw_buffer;
+        std::optional<Fwog::Buffer> draw_count_buffer;
+        std::optional<Fwog::Buffer> instance_index_buffer;
+
+        std::optional<Fwog::Buffer> stats_buffer;
+        uint32_t* stats_mapped = nullptr;
+        std::array<void*, stats_slots> stats_fences{};
+        uint64_t cull_index = 0;
+        Stats last_stats;
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <Fwog/Buffer.h>
+#include <Fwog/Texture.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+
+namespace Albuquerque
+{
+    //What the id shaders write: the kind of object in the top 8 bits and its index below. 0 is nothing
+    inline constexpr uint32_t pick_index_bits = 24;
+    inline constexpr uint32_t pick_index_mask = (1u << pick_index_bits) - 1;
+
+    inline constexpr uint32_t PickKind(uint32_t id) { return id >> pick_index_bits; }
+    inline constexpr uint32_t PickIndex(uint32_t id) { return id & pick_index_mask; }
+
+    //The CPU half of the picking, kept free of GL so it can be tested on its own
+    namespace GpuPicking
+    {
+        //Like gluPickMatrix: maps the region_size pixel square centred on cursor onto the whole of clip space.
+        //Multiplied onto a view projection, a region_size target sees exactly those pixels of the full view.
+        //cursor is in window pixels from the top left, like GLFW gives it
+        glm::mat4 PickMatrix(glm::vec2 cursor, glm::vec2 viewport_size, uint32_t region_size);
+
+        //The id closest to the middle of a region_size square of ids (rows bottom up, like GL reads them), 0 if
+        //there's nothing. Looking past the middle pixel makes thin things like the checkpoint rings easy to hit
+        uint32_t ResolveRegion(std::span<uint32_t const> ids, uint32_t region_size);
+    }
+
+    //Finds what's under the cursor by drawing ids instead of colours, so what gets picked is exactly what got
+    //drawn, rings and all. Only the pixels around the cursor are drawn, through a pick matrix onto a tiny R32UI
+    //target, and they come back through a mapped buffer behind a fence. Poll picks them up a frame or so later,
+    //so picking never waits on the GPU and costs the same however many objects there are.
+    //GL thread only
+    class GpuPicker
+    {
+    public:
+        struct Result
+        {
+            //0 if the cursor was over nothing
+            uint32_t id = 0;
+            glm::vec2 cursor{0.0f};
+        };
+
+        explicit GpuPicker(uint32_t region_size = 9);
+        ~GpuPicker();
+
+        GpuPicker(GpuPicker const&) = delete;
+        GpuPicker& operator=(GpuPicker const&) = delete;
+
+        //Picks at cursor on the next Render. Replaces a request that hasn't been drawn yet
+        void Request(glm::vec2 cursor);
+        bool HasRequest() const { return has_request; }
+
+        //Draws the ids for the pending request, if there is one and a readback slot is free, and starts reading
+        //them back. Outside of any render pass. draw runs inside the pick pass and gets the view projection to use
+        void Render(glm::mat4 const& view_proj, glm::vec2 viewport_size, std::function<void(glm::mat4 const&)> const& draw);
+
+        //Never waits. True with the oldest readback that has landed
+        bool Poll(Result& result);
+
+        uint32_t RegionSize() const { return region_size; }
+        Fwog::Texture const& IdTexture() const { return id_texture.value(); }
+
+    private:
+        static constexpr uint32_t readback_slots = 3;
+
+        struct Readback
+        {
+            void* fence = nullptr;
+            glm::vec2 cursor{0.0f};
+        };
+
+        uint32_t region_size;
+        std::optional<Fwog::Texture> id_texture;
+        std::optional<Fwog::Texture> depth_texture;
+
+        std::optional<Fwog::Buffer> readback_buffer;
+        uint32_t const* readback_mapped = nullptr;
+        std::array<Readback, readback_slots> readbacks{};
+        //Readbacks started and polled so far, the slot is the count modulo readback_slots
+        uint64_t started = 0;
+        uint64_t polled = 0;
+
+        bool has_request = false;
+        glm::vec2 requested_cursor{0.0f};
+    };
+}
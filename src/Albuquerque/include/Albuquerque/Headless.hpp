@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Settings for running an app without a visible window. The window still exists (invisible) so the GL context
+    //works the same, on CI that means Mesa/llvmpipe under a virtual display.
+    struct HeadlessSettings
+    {
+        bool enabled = false;
+
+        uint32_t frame_count = 120;
+        double fixed_dt = 1.0 / 60.0;
+
+        //Every n-th frame (and the last one) is dumped to png. 0 only dumps the last frame
+        uint32_t capture_every = 30;
+        std::string capture_directory = "headless_output";
+
+        //Empty means nothing gets compared. With update_goldens the captures are written here instead
+        std::string golden_directory;
+        bool update_goldens = false;
+
+        //Per pixel perceptual difference in [0, 1] that still counts as the same pixel
+        float pixel_tolerance = 0.02f;
+        //How many pixels are allowed to be over the tolerance before the image fails
+        float max_failed_pixel_fraction = 0.001f;
+
+        std::string report_path = "headless_output/report.json";
+
+        //0 disables the check. Otherwise the run fails if the p95 cpu frame time goes over it
+        double frame_budget_ms = 0.0;
+
+        //Every frame's profiler zones get written here when it is set, .csv or .json by the extension
+        std::string profile_path;
+    };
+
+    struct HeadlessCaptureResult
+    {
+        uint32_t frame_index = 0;
+        std::string file_path;
+        std::string golden_path;
+
+        bool compared = false;
+        bool passed = true;
+        float failed_pixel_fraction = 0.0f;
+        float mean_difference = 0.0f;
+        float max_difference = 0.0f;
+    };
+
+    struct HeadlessReport
+    {
+        std::vector<double> frame_cpu_ms;
+        std::vector<HeadlessCaptureResult> captures;
+
+        double mean_ms = 0.0;
+        double p50_ms = 0.0;
+        double p95_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+
+        bool timing_passed = true;
+        bool images_passed = true;
+
+        bool Passed() const { return timing_passed && images_passed; }
+    };
+
+    //Picks out --headless and the options that go with it. Anything it does not know about is ignored so
+    //apps can still have their own arguments. Returns false if a known option has a bad value.
+    //--headless --frames <n> --dt <seconds> --capture-every <n> --capture-dir <path> --golden-dir <path>
+    //--update-goldens --tolerance <0-1> --max-failed-fraction <0-1> --report <path> --frame-budget-ms <ms>
+    bool ParseHeadlessArguments(int argc, char* argv[], HeadlessSettings& settings);
+
+    //Fills in the summary statistics and the timing pass/fail from frame_cpu_ms
+    void FinalizeHeadlessReport(HeadlessReport& report, HeadlessSettings const& settings);
+
+    bool WriteHeadlessReport(std::string const& file_path, HeadlessReport const& report, HeadlessSettings const& settings);
+}
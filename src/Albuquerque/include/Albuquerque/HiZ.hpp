@@ -0,0 +1,117 @@
+#pragma once
+#include <Fwog/Texture.h>
+#include <Fwog/Pipeline.h>
+
+#include <Albuquerque/GpuCulling.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Hierarchical Z occlusion. Every mip of the pyramid holds the farthest depth of the texels under it, so if
+    //the nearest point of an object's screen rectangle is behind the farthest depth of the one or two texels
+    //covering it, the object is hidden. The GPU version lives in gpu_cull.comp.glsl, these are the same steps
+    //on the CPU so the software occlusion buffer and the tests agree with it.
+    namespace HiZ
+    {
+        //Screen rectangle in 0 to 1 uv and nearest depth in 0 to 1 of a box seen through view_proj
+        struct ScreenBounds
+        {
+            glm::vec2 uv_min{0.0f};
+            glm::vec2 uv_max{0.0f};
+            float nearest_depth = 0.0f;
+            //Some corner is behind the camera, nothing can be said about it so it is never occluded
+            bool crosses_near_plane = false;
+        };
+
+        ScreenBounds ProjectBox(glm::mat4 const& view_proj, glm::vec3 center, glm::vec3 half_extents);
+
+        uint32_t MipCount(uint32_t width, uint32_t height);
+
+        //Smallest mip where the rectangle is at most a texel across, so only 2x2 (3x3 with rounding) texels need
+        //to be read
+        uint32_t SelectMip(ScreenBounds const& bounds, uint32_t width, uint32_t height, uint32_t mip_count);
+
+        //Halves a level keeping the farthest depth. Odd sizes fold the last row or column into the texel before
+        //so nothing is dropped
+        void Downsample(std::vector<float> const& source, uint32_t source_width, uint32_t source_height,
+            std::vector<float>& destination, uint32_t destination_width, uint32_t destination_height);
+    }
+
+    //GPU depth pyramid built from last frame's depth buffer with compute passes. R32F, same size as the depth
+    //texture at mip 0. GL thread only.
+    class HiZPyramid
+    {
+    public:
+        HiZPyramid();
+
+        HiZPyramid(HiZPyramid const&) = delete;
+        HiZPyramid& operator=(HiZPyramid const&) = delete;
+
+        //After the scene has been drawn. view_proj is what it was drawn with, next frame's culling tests against it
+        void Build(Fwog::Texture const& depth, glm::mat4 const& view_proj);
+
+        //Forget the last depth, e.g. after the camera jumped
+        void Invalidate() { valid = false; }
+
+        bool IsValid() const { return valid; }
+        Fwog::Texture const& Texture() const { return pyramid.value(); }
+        glm::mat4 const& ViewProj() const { return view_proj; }
+        uint32_t Width() const { return width; }
+        uint32_t Height() const { return height; }
+        uint32_t MipCount() const { return mip_count; }
+        //Only ever read with texelFetch, Fwog just wants a sampler to bind a texture
+        Fwog::Sampler const& NearestSampler() const { return nearest_sampler.value(); }
+
+    private:
+        std::optional<Fwog::ComputePipeline> copy_pipeline;
+        std::optional<Fwog::ComputePipeline> downsample_pipeline;
+        std::optional<Fwog::Sampler> nearest_sampler;
+
+        std::optional<Fwog::Texture> pyramid;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mip_count = 0;
+
+        glm::mat4 view_proj{1.0f};
+        bool valid = false;
+    };
+
+    //Small depth buffer the CPU rasterizes occluder boxes into, then tests objects against like the GPU pyramid.
+    //For headless runs and tests where nobody wants to depend on what the GPU did last frame.
+    class SoftwareOcclusion
+    {
+    public:
+        explicit SoftwareOcclusion(uint32_t width = 256, uint32_t height = 128);
+
+        //Clears the depth to the far plane
+        void Begin(glm::mat4 const& view_proj);
+        void AddOccluder(glm::vec3 center, glm::vec3 half_extents);
+        //Builds the pyramid, has to be called before IsOccluded
+        void Finish();
+
+        bool IsOccluded(glm::vec3 center, glm::vec3 half_extents) const;
+        bool IsOccluded(GpuCullObject const& object) const { return IsOccluded(object.center, object.half_extents); }
+
+        uint32_t Width() const { return width; }
+        uint32_t Height() const { return height; }
+        //Depth at mip 0, for debugging
+        float DepthAt(uint32_t x, uint32_t y) const { return levels[0][y * width + x]; }
+
+    private:
+        void RasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c);
+
+        uint32_t width;
+        uint32_t height;
+        glm::mat4 view_proj{1.0f};
+
+        std::vector<std::vector<float>> levels;
+        std::vector<glm::uvec2> level_sizes;
+    };
+}
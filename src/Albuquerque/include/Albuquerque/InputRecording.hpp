@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Every key and mouse button the app can ask about, plus the cursor. Application samples it once per frame
+    //after polling events, so every fixed tick of a frame sees the same input, and IsKeyPressed and friends read
+    //from it instead of GLFW. That is what lets a recording stand in for the real devices.
+    struct InputState
+    {
+        //GLFW_KEY_LAST + 1 and GLFW_MOUSE_BUTTON_LAST + 1, kept as numbers so this doesn't need GLFW
+        static constexpr int32_t key_count = 349;
+        static constexpr int32_t mouse_button_count = 8;
+
+        std::array<uint64_t, (key_count + 63) / 64> keys{};
+        uint8_t mouse_buttons = 0;
+        double mouse_x = 0.0;
+        double mouse_y = 0.0;
+
+        bool Key(int32_t key) const;
+        void SetKey(int32_t key, bool down);
+        bool MouseButton(int32_t button) const;
+        void SetMouseButton(int32_t button, bool down);
+
+        bool operator==(InputState const&) const = default;
+    };
+
+    //A frame of a recording: how long it was, how many fixed ticks it ran and the input all of them saw.
+    //Feeding the same dts through FixedTimestep gives the same tick counts, so a replay runs the exact same
+    //simulation no matter how fast the machine is
+    struct InputFrame
+    {
+        double dt = 0.0;
+        uint32_t steps = 0;
+        InputState state;
+    };
+
+    //Appends frames to a binary file. The state is only written on frames where it changed, most frames are
+    //10 bytes. Nothing is buffered beyond what stdio does, so a crash still leaves everything up to it
+    class InputRecorder
+    {
+    public:
+        InputRecorder() = default;
+        ~InputRecorder();
+
+        InputRecorder(InputRecorder const&) = delete;
+        InputRecorder& operator=(InputRecorder const&) = delete;
+
+        //tick_rate is checked on replay, a different rate would give different tick counts
+        bool Open(std::string const& file_path, double tick_rate);
+        void WriteFrame(InputFrame const& frame);
+        void Close();
+
+        bool IsOpen() const { return file != nullptr; }
+        uint32_t FrameCount() const { return frame_count; }
+
+    private:
+        std::FILE* file = nullptr;
+        uint32_t frame_count = 0;
+        InputState previous_state;
+    };
+
+    //Reads a whole recording up front and hands the frames out in order
+    class InputReplay
+    {
+    public:
+        bool Open(std::string const& file_path);
+
+        //False once every frame was handed out
+        bool NextFrame(InputFrame& frame);
+
+        bool Finished() const { return next_frame >= frames.size(); }
+        double TickRate() const { return tick_rate; }
+        size_t FrameCount() const { return frames.size(); }
+        size_t FramesPlayed() const { return next_frame; }
+
+    private:
+        std::vector<InputFrame> frames;
+        size_t next_frame = 0;
+        double tick_rate = 0.0;
+    };
+
+    //Set from the command line, see ParseInputArguments
+    struct InputSettings
+    {
+        //--record <file>: writes everything this run does to the file
+        std::string record_path;
+        //--replay <file>: plays the file back at its own pace instead of reading the devices
+        std::string replay_path;
+        //--benchmark <file>: replays the file as fast as possible, closes at the end of it and writes the timing
+        //report, which has every frame's profiler zones in it
+        bool benchmark = false;
+        std::string benchmark_report_path = "benchmark_output/benchmark.json";
+    };
+
+    bool ParseInputArguments(int argc, char* argv[], InputSettings& settings);
+}
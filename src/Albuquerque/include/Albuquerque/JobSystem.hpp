@@ -0,0 +1,202 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace Albuquerque
+{
+    //Counts how many jobs attached to it are still running. JobSystem::Wait on it until it hits zero
+    class JobCounter
+    {
+    public:
+        bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+        uint32_t Pending() const { return pending.load(std::memory_order_acquire); }
+
+    private:
+        friend class JobSystem;
+        std::atomic<uint32_t> pending{0};
+    };
+
+    //The lambda lives inside the job itself so spawning never allocates. Anything captured has to fit in storage,
+    //capture by reference or pointer for anything big
+    struct Job
+    {
+        static constexpr size_t storage_size = 64;
+
+        void (*function)(void* storage) = nullptr;
+        void (*destroy)(void* storage) = nullptr;
+        alignas(16) std::byte storage[storage_size];
+
+        char const* name = nullptr;
+        JobCounter* counter = nullptr;
+        JobCounter const* dependency = nullptr;
+
+        //Set while queued or running so the ring allocator never hands out a job that is still in use
+        std::atomic<bool> in_use{false};
+    };
+
+    //Chase-Lev work stealing deque. The owning thread pushes and pops the bottom (LIFO, good for cache),
+    //any other thread steals from the top. Fixed size, Push fails when full and the caller runs the job itself
+    class WorkStealingDeque
+    {
+    public:
+        static constexpr int64_t capacity = 4096;
+
+        bool Push(Job* job);
+        Job* Pop();
+        Job* Steal();
+
+        bool IsEmpty() const { return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr int64_t mask = capacity - 1;
+        static_assert((capacity & mask) == 0, "Deque capacity has to be a power of two");
+
+        //Own cache lines so the owner and the thieves don't fight over them
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        alignas(64) std::array<std::atomic<Job*>, capacity> buffer{};
+    };
+
+    //Work stealing job pool shared by everything in the process. Every worker thread (and the main thread, which
+    //is worker 0) has its own deque. Waiting on a counter runs other jobs instead of blocking, so the main thread
+    //helps out and nested waits inside jobs can't deadlock the pool.
+    class JobSystem
+    {
+    public:
+        //The first call creates the pool and makes the calling thread worker 0. Application does this in its
+        //constructor so it's always the main thread
+        static JobSystem& Instance();
+
+        ~JobSystem();
+
+        JobSystem(JobSystem const&) = delete;
+        JobSystem& operator=(JobSystem const&) = delete;
+
+        //Queues f() on the calling thread's deque. The counter (optional) is incremented now and decremented when
+        //f finishes. The dependency (optional) has to reach zero before f runs.
+        //Threads that aren't part of the pool (like the render thread) just run f right away.
+        template <typename F>
+        void Run(char const* name, F&& f, JobCounter* counter = nullptr, JobCounter const* dependency = nullptr);
+
+        //Runs other jobs until the counter reaches zero
+        void Wait(JobCounter const& counter);
+
+        //Splits [0, count) into ranges of grain_size and calls f(first, last) on each, then waits for all of
+        //them. A grain size of 0 picks one that gives every thread a few ranges to balance with
+        template <typename F>
+        void ParallelFor(char const* name, size_t count, size_t grain_size, F&& f);
+
+        //Workers plus the main thread
+        uint32_t ThreadCount() const { return static_cast<uint32_t>(workers.size()); }
+
+        //Index of the calling thread in the pool, -1 if it isn't part of it
+        static int32_t CurrentThreadIndex();
+
+        uint64_t JobsExecuted() const { return jobs_executed.load(std::memory_order_relaxed); }
+        uint64_t JobsStolen() const { return jobs_stolen.load(std::memory_order_relaxed); }
+
+    private:
+        JobSystem(uint32_t worker_thread_count);
+
+        static constexpr size_t job_pool_size = 4096;
+
+        struct Worker
+        {
+            WorkStealingDeque deque;
+            std::unique_ptr<std::array<Job, job_pool_size>> job_pool = std::make_unique<std::array<Job, job_pool_size>>();
+            size_t job_pool_cursor = 0;
+            std::thread thread;
+        };
+
+        //Returns nullptr if the next pool slot is still busy, the caller runs the job inline then
+        Job* AllocateJob(Worker& worker);
+        void Submit(Worker& worker, Job* job);
+
+        Job* FindJob(uint32_t thread_index);
+        void Execute(Job* job);
+        void WorkerMain(uint32_t thread_index);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        std::atomic<uint32_t> queued_jobs{0};
+        std::atomic<bool> stopping{false};
+        std::atomic<uint32_t> sleeping_workers{0};
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_condition;
+
+        std::atomic<uint64_t> jobs_executed{0};
+        std::atomic<uint64_t> jobs_stolen{0};
+    };
+
+    template <typename F>
+    void JobSystem::Run(char const* name, F&& f, JobCounter* counter, JobCounter const* dependency)
+    {
+        using Functor = std::decay_t<F>;
+        static_assert(sizeof(Functor) <= Job::storage_size, "Job capture is too big, capture by reference instead");
+        static_assert(alignof(Functor) <= 16, "Job capture is over aligned");
+
+        int32_t thread_index = CurrentThreadIndex();
+        Job* job = thread_index >= 0 ? AllocateJob(*workers[thread_index]) : nullptr;
+
+        if (job == nullptr)
+        {
+            if (dependency)
+                Wait(*dependency);
+
+            f();
+            return;
+        }
+
+        new (job->storage) Functor(std::forward<F>(f));
+        job->function = [](void* storage) { (*static_cast<Functor*>(storage))(); };
+        job->destroy = [](void* storage) { static_cast<Functor*>(storage)->~Functor(); };
+        job->name = name;
+        job->counter = counter;
+        job->dependency = dependency;
+
+        if (counter)
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        Submit(*workers[thread_index], job);
+    }
+
+    template <typename F>
+    void JobSystem::ParallelFor(char const* name, size_t count, size_t grain_size, F&& f)
+    {
+        if (count == 0)
+            return;
+
+        if (grain_size == 0)
+        {
+            size_t target_ranges = static_cast<size_t>(ThreadCount()) * 4;
+            grain_size = (count + target_ranges - 1) / target_ranges;
+        }
+
+        //Not worth the overhead, or nobody to share with
+        if (count <= grain_size || CurrentThreadIndex() < 0)
+        {
+            f(size_t(0), count);
+            return;
+        }
+
+        JobCounter counter;
+        auto* function = &f;
+        for (size_t first = 0; first < count; first += grain_size)
+        {
+            size_t last = first + grain_size < count ? first + grain_size : count;
+            Run(name, [function, first, last]() { (*function)(first, last); }, &counter);
+        }
+
+        Wait(counter);
+    }
+}
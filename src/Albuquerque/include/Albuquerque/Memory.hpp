@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace Albuquerque
+{
+    struct AllocationStats
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;
+    };
+
+    //Counts every heap allocation in the process. Only does anything when the library is built with
+    //ALBUQUERQUE_TRACK_ALLOCATIONS (on by default), which replaces the global operator new/delete.
+    namespace MemoryTracking
+    {
+        bool IsEnabled();
+
+        //Everything since the program started
+        AllocationStats Totals();
+
+        //What was allocated since the previous call. Application calls this once at the start of every frame
+        AllocationStats EndFrame();
+    }
+
+    //Bump allocator for temporaries that only live for one frame. Application resets its frame_arena at the start
+    //of every frame, so nothing allocated from it may be kept past the end of the frame.
+    //Deallocating does nothing, everything goes at once on Reset. If a frame needs more than the capacity the rest
+    //comes from the upstream resource, and the next Reset grows the arena so steady state frames never do that.
+    //Containers opt in through std::pmr: std::pmr::vector<int> values(&frame_arena);
+    //Not thread safe.
+    class FrameArena : public std::pmr::memory_resource
+    {
+    public:
+        explicit FrameArena(size_t capacity = 4 * 1024 * 1024, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~FrameArena() override;
+
+        FrameArena(FrameArena const&) = delete;
+        FrameArena& operator=(FrameArena const&) = delete;
+
+        void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T* Allocate(size_t count) { return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T))); }
+
+        void Reset();
+
+        size_t Used() const { return used + overflow_bytes; }
+        size_t Capacity() const { return capacity; }
+        //Most used in a single frame so far
+        size_t HighWater() const { return high_water; }
+        //How much the current frame had to get from upstream
+        size_t OverflowBytes() const { return overflow_bytes; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+    private:
+        struct OverflowBlock
+        {
+            void* memory;
+            size_t bytes;
+            size_t alignment;
+        };
+
+        std::pmr::memory_resource* upstream;
+        std::byte* buffer = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+        size_t high_water = 0;
+
+        size_t overflow_bytes = 0;
+        std::vector<OverflowBlock> overflow_blocks;
+    };
+
+    //Fixed size blocks handed out from a free list. Memory comes from the upstream in pages and is only given back
+    //when the pool is destroyed, so after warming up allocating and freeing never touches the heap.
+    //As a pmr resource it serves anything that fits in a block and passes bigger requests upstream.
+    //Not thread safe.
+    class PoolAllocator : public std::pmr::memory_resource
+    {
+    public:
+        PoolAllocator(size_t block_size, size_t blocks_per_page = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+        ~PoolAllocator() override;
+
+        PoolAllocator(PoolAllocator const&) = delete;
+        PoolAllocator& operator=(PoolAllocator const&) = delete;
+
+        void* Allocate();
+        void Free(void* block);
+
+        size_t BlockSize() const { return block_size; }
+        size_t BlocksInUse() const { return blocks_in_use; }
+        size_t PageCount() const { return pages.size(); }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+    private:
+        static constexpr size_t block_alignment = alignof(std::max_align_t);
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        void AddPage();
+
+        std::pmr::memory_resource* upstream;
+        size_t block_size;
+        size_t blocks_per_page;
+
+        FreeBlock* free_list = nullptr;
+        std::vector<void*> pages;
+        size_t blocks_in_use = 0;
+    };
+}
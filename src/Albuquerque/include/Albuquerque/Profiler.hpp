@@ -0,0 +1,192 @@
+#pragma once
+#include <tracy/Tracy.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Albuquerque
+{
+    //Frame times and named CPU/GPU zones kept in the app itself, so they can be looked at without Tracy attached
+    //and written out to compare runs. Application owns one and marks the frames around the GL work, anything can
+    //add zones through the ALBUQUERQUE_PROFILE_* macros, which do nothing while no profiler exists (tests).
+    //GPU zones are timestamp query pairs from a pool per frame in flight, read back frames_in_flight frames later
+    //only if the GPU is done with them, so nothing ever waits on the GPU. CPU zones can come from any thread and
+    //land in whichever frame is open when they finish.
+    class Profiler
+    {
+    public:
+        struct Percentiles
+        {
+            double p50 = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+            double max = 0.0;
+        };
+
+        struct FrameRecord
+        {
+            uint64_t frame = 0;
+            //Start of this frame to the start of the next one, so it includes waiting on vsync or the pacer
+            double frame_ms = 0.0;
+            //Between BeginFrame and EndFrame
+            double cpu_ms = 0.0;
+            //Negative until the queries come back, and stays that way if they were dropped
+            double gpu_ms = -1.0;
+            //By zone id, summed if a zone ran more than once. GPU zones are 0 until they come back
+            std::vector<float> zone_ms;
+        };
+
+        explicit Profiler(uint32_t history_size = 512, uint32_t gpu_frames_in_flight = 4);
+        ~Profiler();
+
+        Profiler(Profiler const&) = delete;
+        Profiler& operator=(Profiler const&) = delete;
+
+        //The one the macros report to, nullptr if there is none
+        static Profiler* Active();
+
+        //Ids are shared by every profiler and never change, the macros keep them in a static
+        static uint32_t RegisterZone(char const* name, bool gpu);
+        static uint32_t ZoneCount();
+
+        //GL thread, around everything the frame submits
+        void BeginFrame();
+        void EndFrame();
+
+        //Any thread
+        void AddCpuSample(uint32_t zone, double ms);
+
+        //GL thread, between BeginFrame and EndFrame. Can nest
+        void BeginGpuZone(uint32_t zone);
+        void EndGpuZone();
+
+        //Reads back every frame whose queries are done, even the recent ones. For the end of a run after a glFinish
+        void ResolvePendingGpuFrames();
+
+        //Over the frames in the history window
+        Percentiles FrameTimePercentiles() const;
+
+        //Keeps every frame from now on instead of just the history window, for exporting
+        void StartRecording();
+        void StopRecording();
+        bool IsRecording() const { return recording; }
+        size_t RecordedFrames() const;
+
+        //The recording if there is one, otherwise the history window. The GPU columns of the last few frames are
+        //still missing, stop a few frames before exporting to get them
+        bool ExportCsv(std::string const& file_path) const;
+        bool ExportJson(std::string const& file_path) const;
+
+        //Percentiles, the frame time graph and histogram, the zone table and the record/export buttons
+        void RenderUI();
+
+        uint64_t DroppedGpuFrames() const { return dropped_gpu_frames.load(); }
+
+    private:
+        using clock_t = std::chrono::steady_clock;
+
+        struct GpuFrame
+        {
+            uint64_t frame = 0;
+            bool pending = false;
+            //Two timestamps per zone
+            std::vector<uint32_t> queries;
+            std::vector<uint32_t> zones;
+            uint32_t used_zones = 0;
+        };
+
+        void ResolveGpuFrame(GpuFrame& gpu_frame);
+        //Runs update on the frame's history and recording entries, if they are still around. Needs the lock
+        template <typename Function>
+        void UpdateFrame(uint64_t frame, Function&& update);
+        //The recording, or the history window oldest first if nothing was recorded
+        std::vector<FrameRecord> ExportedFrames() const;
+
+        mutable std::mutex mutex;
+
+        std::vector<FrameRecord> history;
+        std::vector<FrameRecord> recorded;
+        uint64_t recording_first_frame = 0;
+        bool recording = false;
+
+        uint64_t frame_index = 0;
+        bool frame_open = false;
+        clock_t::time_point frame_start{};
+        std::vector<float> open_zone_ms;
+
+        std::vector<GpuFrame> gpu_frames;
+        std::vector<uint32_t> open_gpu_zones;
+        uint32_t frame_gpu_zone = 0;
+        //Written on the GL thread, read by the UI which is on the main thread in pipelined mode
+        std::atomic<uint64_t> dropped_gpu_frames = 0;
+
+        uint32_t export_count = 0;
+        std::vector<float> ui_frame_ms;
+        std::vector<double> ui_zone_total;
+        std::vector<float> ui_zone_max;
+        std::vector<float> ui_zone_last;
+    };
+
+    class CpuProfileScope
+    {
+    public:
+        explicit CpuProfileScope(uint32_t zone)
+            : zone(zone), start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~CpuProfileScope()
+        {
+            if (Profiler* profiler = Profiler::Active())
+                profiler->AddCpuSample(zone, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        CpuProfileScope(CpuProfileScope const&) = delete;
+        CpuProfileScope& operator=(CpuProfileScope const&) = delete;
+
+    private:
+        uint32_t zone;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    class GpuProfileScope
+    {
+    public:
+        explicit GpuProfileScope(uint32_t zone)
+            : profiler(Profiler::Active())
+        {
+            if (profiler)
+                profiler->BeginGpuZone(zone);
+        }
+
+        ~GpuProfileScope()
+        {
+            if (profiler)
+                profiler->EndGpuZone();
+        }
+
+        GpuProfileScope(GpuProfileScope const&) = delete;
+        GpuProfileScope& operator=(GpuProfileScope const&) = delete;
+
+    private:
+        Profiler* profiler;
+    };
+}
+
+#define ALBUQUERQUE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ALBUQUERQUE_PROFILE_CONCAT(a, b) ALBUQUERQUE_PROFILE_CONCAT_IMPL(a, b)
+
+//Tracy zone plus a profiler zone for the rest of the scope. name has to be a string literal
+#define ALBUQUERQUE_PROFILE_CPU(name) \
+    ZoneScopedN(name); \
+    static uint32_t const ALBUQUERQUE_PROFILE_CONCAT(profile_cpu_zone_, __LINE__) = ::Albuquerque::Profiler::RegisterZone(name, false); \
+    ::Albuquerque::CpuProfileScope ALBUQUERQUE_PROFILE_CONCAT(profile_cpu_scope_, __LINE__)(ALBUQUERQUE_PROFILE_CONCAT(profile_cpu_zone_, __LINE__))
+
+//GPU time of the GL commands submitted in the rest of the scope. GL thread only
+#define ALBUQUERQUE_PROFILE_GPU(name) \
+    static uint32_t const ALBUQUERQUE_PROFILE_CONCAT(profile_gpu_zone_, __LINE__) = ::Albuquerque::Profiler::RegisterZone(name, true); \
+    ::Albuquerque::GpuProfileScope ALBUQUERQUE_PROFILE_CONCAT(profile_gpu_scope_, __LINE__)(ALBUQUERQUE_PROFILE_CONCAT(profile_gpu_zone_, __LINE__))
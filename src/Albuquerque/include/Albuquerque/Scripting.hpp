@@ -0,0 +1,168 @@
+#pragma once
+#include <Albuquerque/Memory.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+struct lua_Debug;
+
+namespace Albuquerque
+{
+    //Where the Lua state gets its memory from, handed to Lua as its lua_Alloc. Blocks up to 512 bytes (strings,
+    //closures, small tables, call frames) come from pools by size class, so once a few ticks have warmed them up
+    //scripts churning through those never reach the heap. Anything bigger goes straight to the heap.
+    //Counts everything, and refuses to go over the memory limit, which Lua turns into a "not enough memory" error
+    //for the script that asked. Not thread safe, like the Lua state using it
+    class ScriptAllocator
+    {
+    public:
+        struct Stats
+        {
+            //Every allocation Lua asked for, including growing or shrinking a block into a new one
+            uint64_t allocations = 0;
+            uint64_t frees = 0;
+            //Of allocations, the ones that had to go to the heap
+            uint64_t heap_allocations = 0;
+            size_t bytes_in_use = 0;
+            size_t high_water = 0;
+            //Allocations refused by the memory limit
+            uint64_t refused = 0;
+        };
+
+        explicit ScriptAllocator(size_t memory_limit = std::numeric_limits<size_t>::max());
+        ~ScriptAllocator();
+
+        ScriptAllocator(ScriptAllocator const&) = delete;
+        ScriptAllocator& operator=(ScriptAllocator const&) = delete;
+
+        //Matches lua_Alloc, user_data is the allocator
+        static void* LuaAlloc(void* user_data, void* pointer, size_t old_size, size_t new_size);
+
+        Stats const& GetStats() const { return stats; }
+
+    private:
+        static constexpr size_t smallest_class = 16;
+        static constexpr size_t size_class_count = 6;
+
+        static size_t SizeClass(size_t bytes);
+
+        void* Allocate(size_t bytes);
+        void Free(void* pointer, size_t bytes);
+
+        size_t memory_limit;
+        std::array<std::unique_ptr<PoolAllocator>, size_class_count> pools;
+        Stats stats;
+    };
+
+    //What a script sees of an array bound with ScriptRuntime::BindArray
+    struct ScriptArrayView;
+
+    using ScriptId = uint32_t;
+    inline constexpr ScriptId invalid_script = std::numeric_limits<uint32_t>::max();
+
+    struct ScriptSettings
+    {
+        //Lua VM instructions one script may run in one tick before it gets stopped for that tick
+        uint32_t instruction_budget = 200000;
+        //Ticks in a row a script may go over budget or error before it's disabled for good
+        uint32_t strikes_to_disable = 3;
+        //For the whole state, every script together
+        size_t memory_limit = 64 * 1024 * 1024;
+    };
+
+    //Lua scripts driving a lot of objects at once, like track elements or AI racers.
+    //Each script owns a range of objects and defines update(first, last, dt), called once per tick for the whole
+    //range instead of once per object. The object data itself never gets copied into Lua: BindArray hands the
+    //scripts views straight onto C++ arrays, so position_x[i] reads and writes the C++ float in place and a script
+    //that only works through the views allocates nothing. View indices are the C++ ones, from 0.
+    //Every script runs in its own sandbox: its globals are its own, it only gets the safe parts of the standard
+    //library (no io, os, load, require or debug), and it can only run instruction_budget instructions per tick.
+    //All scripts share one Lua state, only touch it from one thread
+    class ScriptRuntime
+    {
+    public:
+        struct ScriptInfo
+        {
+            std::string name;
+            uint32_t first = 0;
+            uint32_t count = 0;
+            uint32_t strikes = 0;
+            bool disabled = false;
+            uint64_t budget_overruns = 0;
+            uint64_t errors = 0;
+            std::string last_error;
+        };
+
+        struct Stats
+        {
+            double last_tick_ms = 0.0;
+            uint32_t scripts_run = 0;
+            uint32_t disabled_scripts = 0;
+            uint64_t budget_overruns = 0;
+            uint64_t errors = 0;
+            //What the last tick asked the allocator for
+            uint64_t tick_allocations = 0;
+            uint64_t tick_heap_allocations = 0;
+            ScriptAllocator::Stats memory;
+        };
+
+        ScriptRuntime();
+        ~ScriptRuntime();
+
+        ScriptRuntime(ScriptRuntime const&) = delete;
+        ScriptRuntime& operator=(ScriptRuntime const&) = delete;
+
+        bool Initialize(ScriptSettings const& settings = {});
+        void Shutdown();
+        bool IsInitialized() const { return state != nullptr; }
+
+        //Every script sees it as a global called name. Call again whenever the array moves or changes size, it only
+        //updates the view. The array has to stay alive until then
+        void BindArray(std::string const& name, float* data, size_t count);
+        void BindArray(std::string const& name, std::vector<float>& values) { BindArray(name, values.data(), values.size()); }
+
+        //Runs the chunk once in a new sandbox, it has to leave an update function behind
+        ScriptId Load(std::string const& name, std::string_view source);
+        ScriptId LoadFile(std::string const& file_path);
+        void SetRange(ScriptId script, uint32_t first, uint32_t count);
+        //Gives a disabled script another go
+        void Enable(ScriptId script);
+
+        //One update call per enabled script
+        void Tick(double dt);
+
+        ScriptInfo const& GetScript(ScriptId script) const { return scripts[script]; }
+        uint32_t ScriptCount() const { return static_cast<uint32_t>(scripts.size()); }
+        Stats GetStats() const;
+
+    private:
+        static void BudgetHook(lua_State* L, lua_Debug* debug);
+        //Pushes a new sandbox table onto the stack
+        void NewSandbox();
+        void Strike(ScriptInfo& script, std::string error);
+
+        ScriptSettings settings;
+        std::unique_ptr<ScriptAllocator> allocator;
+        lua_State* state = nullptr;
+        //Registry reference to the table every sandbox falls back to for the views
+        int shared_ref = 0;
+
+        //Owned by Lua as userdata, kept alive by the shared table
+        std::unordered_map<std::string, ScriptArrayView*> views;
+
+        std::vector<ScriptInfo> scripts;
+        //Registry references to each script's update function
+        std::vector<int> update_refs;
+
+        bool over_budget = false;
+        Stats stats;
+    };
+}
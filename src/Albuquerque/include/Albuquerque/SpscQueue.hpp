@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace Albuquerque
+{
+    //Single producer, single consumer bounded ring. Neither side ever locks or allocates, so the consumer can be
+    //a real-time thread like the audio callback. Capacity is rounded up to a power of two.
+    template <typename T>
+    class SpscQueue
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        explicit SpscQueue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+
+            slots = std::make_unique<T[]>(size);
+            mask = size - 1;
+        }
+
+        SpscQueue(SpscQueue const&) = delete;
+        SpscQueue& operator=(SpscQueue const&) = delete;
+
+        //Producer side. False when full, the value is not queued
+        bool Push(T const& value)
+        {
+            size_t tail = tail_index.load(std::memory_order_relaxed);
+            if (tail - cached_head >= Capacity())
+            {
+                cached_head = head_index.load(std::memory_order_acquire);
+                if (tail - cached_head >= Capacity())
+                    return false;
+            }
+
+            slots[tail & mask] = value;
+            tail_index.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //Consumer side. False when empty
+        bool Pop(T& value)
+        {
+            size_t head = head_index.load(std::memory_order_relaxed);
+            if (head == cached_tail)
+            {
+                cached_tail = tail_index.load(std::memory_order_acquire);
+                if (head == cached_tail)
+                    return false;
+            }
+
+            value = slots[head & mask];
+            head_index.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        //Producer side. Pushes as many as fit, returns how many did
+        size_t Push(T const* values, size_t count)
+        {
+            size_t tail = tail_index.load(std::memory_order_relaxed);
+            if (Capacity() - (tail - cached_head) < count)
+                cached_head = head_index.load(std::memory_order_acquire);
+
+            count = std::min(count, Capacity() - (tail - cached_head));
+            for (size_t i = 0; i < count; ++i)
+                slots[(tail + i) & mask] = values[i];
+            tail_index.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        //Consumer side. Pops up to count, returns how many it got
+        size_t Pop(T* values, size_t count)
+        {
+            size_t head = head_index.load(std::memory_order_relaxed);
+            if (cached_tail - head < count)
+                cached_tail = tail_index.load(std::memory_order_acquire);
+
+            count = std::min(count, cached_tail - head);
+            for (size_t i = 0; i < count; ++i)
+                values[i] = slots[(head + i) & mask];
+            head_index.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        //Producer side. At least this many values fit right now
+        size_t FreeSpace()
+        {
+            cached_head = head_index.load(std::memory_order_acquire);
+            return Capacity() - (tail_index.load(std::memory_order_relaxed) - cached_head);
+        }
+
+        size_t Capacity() const { return mask + 1; }
+
+    private:
+        std::unique_ptr<T[]> slots;
+        size_t mask = 0;
+
+        //Each side's index and its copy of the other side's get their own cache line so they don't false share
+        alignas(64) std::atomic<size_t> tail_index{0};
+        size_t cached_head = 0;
+        alignas(64) std::atomic<size_t> head_index{0};
+        size_t cached_tail = 0;
+    };
+}
@@ -0,0 +1,223 @@
+#pragma once
+#include <Fwog/Buffer.h>
+
+#include <Albuquerque/JobSystem.hpp>
+#include <Albuquerque/UniformRing.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Albuquerque
+{
+    //What each patch gets at its uniform binding. Same as the {mat4 model; vec4 color;} block the scene vertex
+    //shaders read there, so the whole block is bound and not just the matrix
+    struct TerrainPatchUniforms
+    {
+        glm::mat4 model{1.0f};
+        glm::vec4 color{1.0f};
+    };
+
+    //Same layout as Primitives::Vertex so the textured pipelines can draw it
+    struct TerrainVertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+    static_assert(sizeof(TerrainVertex) == 32);
+
+    struct TerrainNoiseSettings
+    {
+        uint32_t seed = 1337;
+        //Of the first octave, in cycles per meter
+        float frequency = 1.0f / 3000.0f;
+        uint32_t octaves = 6;
+        float lacunarity = 2.0f;
+        float gain = 0.5f;
+        //Highest the terrain gets
+        float amplitude = 800.0f;
+        //Flat at 0 inside this radius around the origin, then rises over blend_distance. Keeps the level itself on
+        //the ground it was made for
+        float flat_radius = 6000.0f;
+        float blend_distance = 4000.0f;
+    };
+
+    //Heightfield as a pure function of the position, so any thread can ask for any point and tiles always agree
+    //on their shared edges
+    namespace TerrainNoise
+    {
+        //fBm value noise, 0 to amplitude
+        float Height(TerrainNoiseSettings const& settings, double x, double z);
+        //Central differences over step meters
+        glm::vec3 Normal(TerrainNoiseSettings const& settings, double x, double z, double step);
+    }
+
+    //A quadtree node, which is also the tile cache entry that holds its mesh. A node covers
+    //leaf_size * 2^lod meters per side and its corner is at (x, z) times that
+    struct TerrainTileKey
+    {
+        int32_t lod = 0;
+        int32_t x = 0;
+        int32_t z = 0;
+
+        bool operator==(TerrainTileKey const&) const = default;
+    };
+
+    struct TerrainTileKeyHash
+    {
+        size_t operator()(TerrainTileKey const& key) const
+        {
+            size_t hash = std::hash<int32_t>{}(key.lod);
+            hash ^= std::hash<int32_t>{}(key.x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<int32_t>{}(key.z) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    //Edges of a patch that meet a coarser neighbour
+    inline constexpr uint32_t terrain_edge_neg_x = 1u << 0;
+    inline constexpr uint32_t terrain_edge_pos_x = 1u << 1;
+    inline constexpr uint32_t terrain_edge_neg_z = 1u << 2;
+    inline constexpr uint32_t terrain_edge_pos_z = 1u << 3;
+    inline constexpr uint32_t terrain_stitch_variants = 16;
+
+    struct TerrainSettings
+    {
+        //Size of the finest nodes in meters
+        float leaf_size = 250.0f;
+        //Roots are leaf_size * 2^(lod_count - 1) meters across
+        uint32_t lod_count = 6;
+        //Roots kept around the camera's root in every direction, so (2r+1)^2 of them
+        uint32_t root_radius = 1;
+        //A node splits while the camera is closer than this many times its size
+        float split_distance = 2.0f;
+        //Quads per patch side, has to be even for the stitching
+        uint32_t patch_quads = 32;
+        //Meters per repeat of the ground texture
+        float uv_period = 4000.0f;
+
+        //Tile meshes on the GPU plus the ones being built. Least recently drawn tiles go first when it is full
+        size_t memory_budget_bytes = 64 * 1024 * 1024;
+        uint32_t max_builds_in_flight = 16;
+        //Buffer creation is on the GL thread so it is spread over frames
+        uint32_t max_uploads_per_frame = 8;
+
+        TerrainNoiseSettings noise;
+    };
+
+    //The CPU side of a patch, kept free of GL so it can be tested on its own
+    namespace TerrainMesh
+    {
+        //Vertices of a node relative to its corner, heights are absolute
+        void BuildVertices(TerrainSettings const& settings, TerrainTileKey key, std::vector<TerrainVertex>& vertices);
+
+        //Two triangles per quad. On every edge in stitch_mask the odd vertices are folded onto the even one before
+        //them, which leaves that edge with exactly the vertices of the coarser neighbour so there is no crack
+        std::vector<uint32_t> BuildIndices(uint32_t patch_quads, uint32_t stitch_mask);
+
+        //Corner of a node in world space
+        glm::dvec2 NodeOrigin(TerrainSettings const& settings, TerrainTileKey key);
+        double NodeSize(TerrainSettings const& settings, int32_t lod);
+    }
+
+    //Unbounded heightfield terrain. Every frame a quadtree is walked from the roots around the camera, splitting
+    //nodes that are close, so the number of patches (and vertices) drawn stays about the same wherever the camera
+    //is. Each node's mesh is a tile built on the job system and cached under a fixed memory budget. A node only
+    //splits once all four children are ready, until then it draws itself, so streaming never leaves holes.
+    //GL thread only, the builds are the only thing on the workers.
+    class Terrain
+    {
+    public:
+        struct DrawNode
+        {
+            TerrainTileKey key;
+            uint32_t stitch_mask = 0;
+        };
+
+        struct Stats
+        {
+            uint32_t resident_tiles = 0;
+            uint32_t builds_in_flight = 0;
+            size_t resident_bytes = 0;
+            uint32_t drawn_nodes = 0;
+            uint64_t drawn_vertices = 0;
+            uint64_t tiles_built = 0;
+            uint64_t tiles_evicted = 0;
+            //Requests turned down because everything in the budget was in use
+            uint64_t budget_overruns = 0;
+        };
+
+        explicit Terrain(TerrainSettings settings = {});
+        ~Terrain();
+
+        Terrain(Terrain const&) = delete;
+        Terrain& operator=(Terrain const&) = delete;
+
+        //Uploads finished tiles, picks this frame's nodes and queues builds for what is missing. In world space
+        void Update(glm::dvec3 const& camera_position);
+
+        //Inside a render pass with a pipeline taking TerrainVertex bound. Every patch gets TerrainPatchUniforms at
+        //uniform binding model_binding, its model relative to render_origin so it stays small wherever the patch is
+        void Draw(UniformRing& frame_uniforms, glm::dvec3 const& render_origin = glm::dvec3(0.0), uint32_t model_binding = 1) const;
+
+        float HeightAt(double x, double z) const;
+
+        std::span<DrawNode const> DrawNodes() const { return draw_nodes; }
+        Stats const& GetStats() const { return stats; }
+        TerrainSettings const& Settings() const { return settings; }
+
+    private:
+        struct Tile
+        {
+            std::optional<Fwog::Buffer> vertex_buffer;
+            uint64_t last_used_frame = 0;
+        };
+
+        //Filled on a worker, picked up by Update once done is set
+        struct TileBuild
+        {
+            TerrainTileKey key;
+            std::vector<TerrainVertex> vertices;
+            std::atomic<bool> done{false};
+        };
+
+        void FinishBuilds();
+        void Select(TerrainTileKey key, glm::dvec3 const& camera_position);
+        //Marks the tile as used this frame, false if it isn't resident
+        bool Touch(TerrainTileKey key);
+        void RequestTile(TerrainTileKey key);
+        bool EvictLeastRecentlyUsed();
+        uint32_t StitchMask(TerrainTileKey key) const;
+
+        size_t TileBytes() const;
+        uint32_t IndexCount() const;
+
+        TerrainSettings settings;
+
+        //All the stitch variants back to back, variant i starts at i * IndexCount()
+        std::optional<Fwog::Buffer> index_buffer;
+
+        std::unordered_map<TerrainTileKey, Tile, TerrainTileKeyHash> tiles;
+        std::vector<std::unique_ptr<TileBuild>> builds;
+        JobCounter build_counter;
+
+        std::vector<DrawNode> draw_nodes;
+        std::unordered_set<TerrainTileKey, TerrainTileKeyHash> drawn_keys;
+
+        uint64_t frame_index = 0;
+        Stats stats;
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Albuquerque
+{
+    //Single producer, single consumer triple buffer for handing whole frame snapshots between threads.
+    //The producer always has a slot to write into and the consumer always has a complete slot to read from, neither
+    //ever waits on the other. If the producer publishes twice before the consumer acquires, the older one is skipped.
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        //Producer side. The slot is only ever touched by the producer until Publish
+        T& WriteSlot() { return slots[write_index]; }
+
+        void Publish()
+        {
+            uint8_t previous = shared.exchange(static_cast<uint8_t>(write_index | new_data_bit), std::memory_order_acq_rel);
+            write_index = previous & index_mask;
+        }
+
+        //Consumer side. Swaps in the newest published slot, returns false (and keeps the old slot) if nothing new
+        bool Acquire()
+        {
+            if ((shared.load(std::memory_order_relaxed) & new_data_bit) == 0)
+                return false;
+
+            uint8_t previous = shared.exchange(read_index, std::memory_order_acq_rel);
+            read_index = previous & index_mask;
+            return true;
+        }
+
+        T const& ReadSlot() const { return slots[read_index]; }
+
+        bool HasNewData() const { return (shared.load(std::memory_order_relaxed) & new_data_bit) != 0; }
+
+    private:
+        static constexpr uint8_t index_mask = 0x3;
+        static constexpr uint8_t new_data_bit = 0x4;
+
+        std::array<T, 3> slots{};
+        uint8_t write_index = 0;
+        uint8_t read_index = 1;
+        std::atomic<uint8_t> shared{2};
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <Fwog/Buffer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Albuquerque
+{
+    //A piece of this frame's uniform ring. Only valid until the end of the frame it was allocated in
+    struct UniformSlice
+    {
+        Fwog::Buffer const* buffer = nullptr;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+
+        bool IsValid() const { return buffer != nullptr; }
+    };
+
+    //Streams per-frame uniform and storage data through one persistently mapped buffer instead of an UpdateData
+    //per object. The buffer is split into one segment per frame in flight, a fence at the end of every frame says
+    //when the GPU is done with it, and allocating within a frame is just bumping an offset.
+    //Application owns one and calls BeginFrame and EndFrame around the GL work of every frame, apps get it
+    //through FrameUniforms(). GL thread only.
+    class UniformRing
+    {
+    public:
+        struct Stats
+        {
+            //Fences checked before reusing a segment, and how many of those the GPU was still busy with
+            uint64_t fence_waits = 0;
+            uint64_t stalls = 0;
+            double stall_ms = 0.0;
+            double last_stall_ms = 0.0;
+
+            //Times a frame didn't fit and the ring had to be recreated bigger
+            uint64_t grows = 0;
+            size_t last_frame_bytes = 0;
+        };
+
+        explicit UniformRing(size_t bytes_per_frame = 256 * 1024, uint32_t frames_in_flight = 3);
+        ~UniformRing();
+
+        UniformRing(UniformRing const&) = delete;
+        UniformRing& operator=(UniformRing const&) = delete;
+
+        //Waits until the GPU is done with the segment this frame is going to write
+        void BeginFrame();
+        //Fences everything submitted this frame
+        void EndFrame();
+
+        //Aligned for both uniform and storage buffer binding. data points at the mapped memory to write into
+        UniformSlice Allocate(size_t size, void** data);
+
+        template <typename T>
+        UniformSlice Push(T const& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            void* data;
+            UniformSlice slice = Allocate(sizeof(T), &data);
+            std::memcpy(data, &value, sizeof(T));
+            return slice;
+        }
+
+        template <typename T>
+        UniformSlice Push(std::span<T const> values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            void* data;
+            UniformSlice slice = Allocate(values.size_bytes(), &data);
+            std::memcpy(data, values.data(), values.size_bytes());
+            return slice;
+        }
+
+        static void BindUniform(uint32_t index, UniformSlice const& slice);
+        static void BindStorage(uint32_t index, UniformSlice const& slice);
+
+        Stats const& GetStats() const { return stats; }
+        size_t BytesPerFrame() const { return bytes_per_frame; }
+        uint32_t FramesInFlight() const { return frames_in_flight; }
+        size_t Alignment() const { return alignment; }
+
+    private:
+        void CreateBuffer(size_t new_bytes_per_frame);
+
+        size_t bytes_per_frame;
+        uint32_t frames_in_flight;
+        size_t alignment = 256;
+
+        std::unique_ptr<Fwog::Buffer> buffer;
+        std::byte* mapped = nullptr;
+
+        uint64_t frame_index = 0;
+        size_t frame_offset = 0;
+
+        //One per frame in flight, indexed by frame_index % frames_in_flight
+        std::vector<void*> frame_fences;
+
+        //Buffers replaced by a grow stay alive until the GPU can't be reading them anymore
+        struct RetiredBuffer
+        {
+            std::unique_ptr<Fwog::Buffer> buffer;
+            uint64_t last_frame;
+        };
+        std::vector<RetiredBuffer> retired_buffers;
+
+        Stats stats;
+    };
+}
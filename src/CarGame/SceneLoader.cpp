@@ -2,11 +2,7 @@
 #include <iostream>
 #include <bit>
 #include <numeric>
-#include <execution>
-#include <iostream>
-#include <bit>
-#include <numeric>
-#include <execution>
+#include <atomic>
 #include <stack>
 #include <tuple>
 #include <optional>
@@ -17,6 +13,7 @@
 #include <glm/gtx/transform.hpp>
 
 #include "CarGame/SceneLoader.h"
+#include <Albuquerque/JobSystem.hpp>
 
 #include FWOG_OPENGL_HEADER
 //#include <glm/gtx/string_cast.hpp>
@@ -146,13 +143,21 @@ namespace Utility
 
     bool LoadImageDataParallel(std::vector<RawImageData>& rawImageData, std::vector<tinygltf::Image>& images, tinygltf::LoadImageDataOption options)
     {
-      return std::all_of(std::execution::par, rawImageData.begin(), rawImageData.end(), [&](RawImageData& rawImage) mutable
+      //One image per job, decoding sizes vary too much for bigger ranges to balance well
+      std::atomic<bool> all_succeeded = true;
+      Albuquerque::JobSystem::Instance().ParallelFor("Decode glTF Image", rawImageData.size(), 1, [&](size_t first, size_t last)
         {
-          auto& [image_idx, err, warn, req_width, req_height, bytes, size] = rawImage;
-          bool success = tinygltf::LoadImageData(&images[image_idx], image_idx, err, warn, req_width, req_height, bytes, size, &options);
-          delete[] bytes;
-          return success;
+          for (size_t i = first; i < last; ++i)
+          {
+            auto& [image_idx, err, warn, req_width, req_height, bytes, size] = rawImageData[i];
+            bool success = tinygltf::LoadImageData(&images[image_idx], image_idx, err, warn, req_width, req_height, bytes, size, &options);
+            delete[] bytes;
+            if (!success)
+              all_succeeded = false;
+          }
         });
+
+      return all_succeeded;
     }
 
     glm::mat4 NodeToMat4(const tinygltf::Node& node)
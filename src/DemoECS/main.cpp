@@ -2,10 +2,16 @@
 
 #include <iostream>
 #include <array>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 #include <glm/vec3.hpp>
 #include "header.hpp"
 
+#include <Albuquerque/ECS.hpp>
+
 //Just trying to learn and understand how demongod's ECS thing works...
 //https://old.reddit.com/r/cpp_questions/comments/r4rll0/comment/hmp300u/
 
@@ -31,12 +37,13 @@ namespace Data
 void AddComponent(Entity e, Tag tag)
 {
 	spdlog::debug("Add component to entity {0:d};", e);
-	Data::tags[e] += tag;
+	//Has to be a bitwise or, adding the same tag twice with += carries into the next bit
+	Data::tags[e] |= tag;
 }
 
 void RemoveComponent(Entity e, Tag tag)
 {
-	Data::tags[e] -= tag;
+	Data::tags[e] &= ~tag;
 }
 
 
@@ -70,8 +77,186 @@ void test1()
 	assert(!hasPosition(e));
 }
 
+//Adding twice used to corrupt the mask
+void test2()
+{
+	spdlog::info("test2()\n");
+
+	Entity e = 2;
+	AddComponent(e, CompareTags::Position);
+	AddComponent(e, CompareTags::Position);
+	assert(Data::tags[e] == CompareTags::Position);
+
+	RemoveComponent(e, CompareTags::Position);
+	RemoveComponent(e, CompareTags::Position);
+	assert(Data::tags[e] == 0);
+}
+
+//The real ECS in Albuquerque from here on
+struct Transform
+{
+	glm::vec3 position;
+	glm::vec3 rotation;
+	glm::vec3 scale;
+};
+
+struct Velocity
+{
+	glm::vec3 linear;
+};
+
+struct Health
+{
+	float value;
+};
+
+void test3()
+{
+	spdlog::info("test3()\n");
+
+	Albuquerque::World world;
+
+	Albuquerque::Entity a = world.Create(Transform{}, Velocity{glm::vec3(1.0f, 0.0f, 0.0f)});
+	Albuquerque::Entity b = world.Create();
+	world.Add(b, Transform{});
+	world.Add(b, Health{100.0f});
+	world.Add(b, Health{50.0f});
+
+	assert(world.Has<Velocity>(a) && !world.Has<Health>(a));
+	assert(world.Get<Health>(b)->value == 50.0f);
+
+	Albuquerque::Query<Transform, Velocity> moving(world);
+	assert(moving.Count() == 1);
+
+	world.Add(b, Velocity{glm::vec3(0.0f, 1.0f, 0.0f)});
+	assert(moving.Count() == 2);
+
+	moving.ForEach([](Albuquerque::Entity, Transform& transform, Velocity& velocity)
+		{
+			transform.position += velocity.linear;
+		});
+	assert(world.Get<Transform>(a)->position.x == 1.0f);
+	assert(world.Get<Transform>(b)->position.y == 1.0f);
+	assert(world.Get<Health>(b)->value == 50.0f);
+
+	world.Remove<Velocity>(a);
+	assert(moving.Count() == 1);
+
+	//Structural changes during iteration go through a command buffer
+	Albuquerque::CommandBuffer commands;
+	moving.ForEach([&](Albuquerque::Entity entity, Transform&, Velocity&)
+		{
+			commands.Destroy(entity);
+		});
+	commands.Create();
+	commands.Add(Albuquerque::Entity{}, Health{1.0f});
+	commands.Playback(world);
+
+	assert(!world.IsAlive(b));
+	assert(world.EntityCount() == 2);
+
+	//The freed slot gets reused with a new generation, the old handle has to stay dead
+	Albuquerque::Entity d = world.Create(Health{2.0f});
+	world.Destroy(d);
+	Albuquerque::Entity c = world.Create();
+	assert(c.index == d.index && c.generation != d.generation);
+	assert(!world.IsAlive(d) && world.Get<Health>(d) == nullptr);
+}
+
+//Iterates a million Transform+Velocity entities both as an ECS and as the AoS vector of objects the games use
+//today (like buildingObjectList). The AoS object carries the cold data real objects have, which is what drags
+//it down: every entity update pulls whole cache lines of data the loop never reads.
+void benchmark()
+{
+	spdlog::info("benchmark()\n");
+
+	constexpr size_t entity_count = 1000000;
+	constexpr int iterations = 10;
+	constexpr float dt = 1.0f / 60.0f;
+
+	struct GameObject
+	{
+		Transform transform;
+		Velocity velocity;
+		float model[16];
+		uint32_t mesh_index;
+		uint32_t material_index;
+		char name[32];
+	};
+
+	auto time_ms = [](auto&& function)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; ++i)
+		{
+			function();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+	};
+
+	auto report = [&](char const* name, double ms, size_t bytes_per_entity)
+	{
+		//Without hardware counters the lines pulled in per entity is the best stand in for cache misses
+		double cache_lines_per_entity = static_cast<double>(bytes_per_entity) / 64.0;
+		spdlog::info("{}: {:.3f} ms, {:.1f} M entities/s, {:.2f} cache lines per entity", name, ms,
+			static_cast<double>(entity_count) / (ms * 1000.0), cache_lines_per_entity);
+	};
+
+	std::vector<GameObject> objects(entity_count);
+	for (size_t i = 0; i < entity_count; ++i)
+	{
+		objects[i].velocity.linear = glm::vec3(1.0f, 2.0f, 3.0f);
+	}
+
+	double aos_ms = time_ms([&]()
+		{
+			for (GameObject& object : objects)
+			{
+				object.transform.position += object.velocity.linear * dt;
+			}
+		});
+	report("AoS", aos_ms, sizeof(GameObject));
+
+	Albuquerque::World world;
+	for (size_t i = 0; i < entity_count; ++i)
+	{
+		world.Create(Transform{}, Velocity{glm::vec3(1.0f, 2.0f, 3.0f)});
+	}
+
+	Albuquerque::Query<Transform, Velocity> query(world);
+
+	double ecs_ms = time_ms([&]()
+		{
+			query.ForEachChunk([](uint32_t count, Albuquerque::Entity const*, Transform* transforms, Velocity* velocities)
+				{
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						transforms[i].position += velocities[i].linear * dt;
+					}
+				});
+		});
+	report("ECS", ecs_ms, sizeof(Transform) + sizeof(Velocity));
+
+	double parallel_ms = time_ms([&]()
+		{
+			query.ParallelForEach("Integrate Velocity", [](Albuquerque::Entity, Transform& transform, Velocity& velocity)
+				{
+					transform.position += velocity.linear * dt;
+				});
+		});
+	report("ECS Parallel", parallel_ms, sizeof(Transform) + sizeof(Velocity));
+
+	spdlog::info("ECS speedup over AoS: {:.2f}x single threaded, {:.2f}x on {} threads", aos_ms / ecs_ms,
+		aos_ms / parallel_ms, Albuquerque::JobSystem::Instance().ThreadCount());
+}
+
 int main()
 {
 	spdlog::info("Hello World!\n");
+	Albuquerque::JobSystem::Instance();
+
 	test1();
+	test2();
+	test3();
+	benchmark();
 }
\ No newline at end of file
@@ -1,9 +1,25 @@
-
 #include <MilwaukeeApplication.hpp>
 
+#include <string_view>
+
 int main(int argc, char* argv[])
 {
+    Albuquerque::HeadlessSettings headless_settings;
+    if (!Albuquerque::ParseHeadlessArguments(argc, argv, headless_settings))
+    {
+        return 1;
+    }
+
+    //The canvas is traced on the main thread while the render thread uploads and presents the previous one
+    bool pipelined = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--pipelined")
+            pipelined = true;
+    }
+
     Milwaukee::MilwaukeeApplication application;
-    application.Run();
-    return 0;
-}
\ No newline at end of file
+    application.SetHeadless(headless_settings);
+    application.SetPipelinedRendering(pipelined);
+    return application.Run();
+}
@@ -6,6 +6,7 @@
 #include <stb_image.h>
 
 #include <MilwaukeeApplication.hpp>
+#include <Albuquerque/JobSystem.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -25,9 +26,11 @@
 #include <iterator>
 #include <fstream>
 #include <vector>
+#include <memory_resource>
 #include <queue>
 #include <set>
 #include <iostream>
+#include <limits>
 
 namespace Milwaukee
 {
@@ -287,6 +290,16 @@ bool MilwaukeeApplication::Load()
     size_t canvas_origin_y = draw_framebuffer_height / 2 - canvas_height / 2;
 
     draw_canvas = std::make_unique<Canvas>(canvas_width, canvas_height, canvas_origin_x, canvas_origin_y);
+
+    sphere_batch.reserve(64);
+
+    progressive_spheres = {
+        {glm::vec3(0.0f, -1.0f, 3.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1.0f},
+        {glm::vec3(-2.0f, 0.0f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f), 1.0f},
+        {glm::vec3(2.0f, 0.0f, 4.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1.0f},
+    };
+    sphere_accumulator.Resize(draw_canvas->width, draw_canvas->height);
+    sphere_accumulator.LoadJitterTexture("./data/textures/bluenoise256.png");
     
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     currently_binded_fbo = 0;
@@ -301,6 +314,31 @@ void MilwaukeeApplication::Update( double dt)
     {
         Close();
     }
+
+    //Pipelined mode traces here on the main thread while the render thread is still presenting the previous canvas
+    if (IsPipelined())
+    {
+        UpdatePauseToggle();
+
+        if (!is_rendering_paused)
+        {
+            TraceSpheres(dt);
+            elapsed_time_seconds += dt;
+        }
+    }
+}
+
+void MilwaukeeApplication::UpdateScriptedCamera(uint32_t frame_index, double time)
+{
+    //Headless runs use the progressive renderer with no time budget so every frame converges fully and the
+    //output only depends on the camera, not on how fast the machine is
+    render_spheres_delay = true;
+    use_progressive_accumulation = true;
+    progressive_budget_ms = std::numeric_limits<float>::max();
+    sphere_accumulator.max_passes = 4;
+
+    float t = static_cast<float>(time);
+    progressive_camera_position = glm::vec3(0.75f * sin(t * 0.5f), 0.25f * sin(t), -0.5f + 0.5f * cos(t * 0.5f));
 }
 
 void MilwaukeeApplication::ClearFBO(uint32_t fbo, glm::vec4 color)
@@ -474,6 +512,29 @@ void MilwaukeeApplication::RenderScene([[maybe_unused]] double dt)
 
     //RenderSpheresDelay(dt);
 
+    //On the render thread only the finished canvas gets uploaded, the tracing already happened in Update
+    if (IsPipelined())
+    {
+        PresentCanvasSnapshot();
+        return;
+    }
+
+    UpdatePauseToggle();
+
+    if (is_rendering_paused)
+        return;
+
+    if (render_spheres_delay)
+        RenderSpheresDelay(dt);
+    else
+        RenderSpheresRealTime(dt);
+
+    elapsed_time_seconds += dt;
+}
+
+
+void MilwaukeeApplication::UpdatePauseToggle()
+{
     static bool was_accent_pressed = false;
     if (IsKeyPressed(GLFW_KEY_GRAVE_ACCENT) && !was_accent_pressed)
     {
@@ -484,38 +545,161 @@ void MilwaukeeApplication::RenderScene([[maybe_unused]] double dt)
     {
         was_accent_pressed = false;
     }
-        
+}
 
+void MilwaukeeApplication::TraceSpheres(double dt)
+{
+    //The non progressive delay mode draws straight into the FBO so it can't run off the render thread
+    if (render_spheres_delay && use_progressive_accumulation)
+        TraceSpheresProgressive(dt);
+    else
+        TraceSpheresRealTime(dt);
+}
 
-    if (is_rendering_paused)
-        return;
+void MilwaukeeApplication::PublishFrameSnapshot()
+{
+    ZoneScopedC(tracy::Color::Yellow);
 
-    RenderSpheresRealTime(dt);
+    CanvasSnapshot& snapshot = canvas_snapshots.WriteSlot();
+    snapshot.width = draw_canvas->width;
+    snapshot.height = draw_canvas->height;
+    snapshot.origin_x = draw_canvas->origin_x;
+    snapshot.origin_y = draw_canvas->origin_y;
 
-    elapsed_time_seconds += dt;
+    //Same size every frame so after the first few frames this is just a memcpy into the existing storage
+    snapshot.pixels = draw_canvas->canvas_color_buffer;
+
+    canvas_snapshots.Publish();
 }
 
+void MilwaukeeApplication::PresentCanvasSnapshot()
+{
+    canvas_snapshots.Acquire();
+    CanvasSnapshot const& snapshot = canvas_snapshots.ReadSlot();
+
+    ClearFBO(screen_draw_fbo, clear_screen_color_default_fbo);
+    ClearFBO(draw_framebuffer.get()->fbo_id, clear_screen_color);
+
+    if (!snapshot.pixels.empty())
+    {
+        glTextureSubImage2D(draw_framebuffer->tex_id, 0, snapshot.origin_x, snapshot.origin_y, snapshot.width, snapshot.height, GL_RGBA, GL_FLOAT, snapshot.pixels.data());
+    }
+
+    DrawPixelsToScreen();
+}
 
 void MilwaukeeApplication::BuildSceneOneCommands()
 {
+    renderCommandBuffer.Clear();
+
     auto DrawLineCommand = [&](glm::i32vec2 start, glm::i32vec2 end, glm::vec4 color)
     {
-        std::function<void()> func = 
-            std::bind(&MilwaukeeApplication::DrawLineBresenham, this, start, end, color, true);
-        return func;
+        renderCommandBuffer.Push(LineCommand{start, end, color, true});
     };
 
 
     static constexpr int32_t square_size = 300;
 
     //A white square example centered around the origin
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(-1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, -1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(1 * square_size, 1 * square_size), glm::ivec2(-1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(-1 * square_size, 1 * square_size), glm::ivec2(-1 * square_size, -1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
+    DrawLineCommand(glm::ivec2(-1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, -1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    DrawLineCommand(glm::ivec2(1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    DrawLineCommand(glm::ivec2(1 * square_size, 1 * square_size), glm::ivec2(-1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    DrawLineCommand(glm::ivec2(-1 * square_size, 1 * square_size), glm::ivec2(-1 * square_size, -1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+
+    DrawLineCommand(glm::ivec2(-1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    DrawLineCommand(glm::ivec2(1 * square_size, -1 * square_size), glm::ivec2(-1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(-1 * square_size, -1 * square_size), glm::ivec2(1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
-    renderCommandQueue.push(DrawLineCommand(glm::ivec2(1 * square_size, -1 * square_size), glm::ivec2(-1 * square_size, 1 * square_size), glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
+    renderCommandBuffer.Sort();
+}
+
+void MilwaukeeApplication::ExecuteRenderCommands(RenderCommandBuffer const& commands)
+{
+    ZoneScopedC(tracy::Color::Yellow);
+
+    sphere_batch.clear();
+
+    struct Executor
+    {
+        MilwaukeeApplication& app;
+
+        void operator()(LineCommand const& cmd)
+        {
+            app.DrawLineBresenham(cmd.start, cmd.end, cmd.color, cmd.center_origin);
+        }
+
+        void operator()(PixelCommand const& cmd)
+        {
+            app.DrawPixel(cmd.position.x, cmd.position.y, cmd.color, cmd.offset.x, cmd.offset.y);
+        }
+
+        void operator()(SquareCommand const& cmd)
+        {
+            app.DrawFilledSquare(cmd.center, cmd.color, cmd.length, cmd.center_origin);
+        }
+
+        void operator()(SphereCommand const& cmd)
+        {
+            app.sphere_batch.push_back(cmd);
+        }
+    };
+
+    commands.Visit(Executor{*this});
+
+    if (!sphere_batch.empty())
+    {
+        DrawSphereBatch(sphere_batch);
+    }
+}
+
+void MilwaukeeApplication::DrawSphereBatch(std::vector<SphereCommand> const& spheres)
+{
+    //Same setup as RenderSceneThree but every sphere in the batch is tested for a pixel before moving onto the next pixel
+    static constexpr float distance_to_viewport = 1.0f;
+    static constexpr float t_min = distance_to_viewport;
+    static constexpr float inf = std::numeric_limits<float>::max();
+
+    int32_t canvas_width = draw_canvas->width;
+    int32_t canvas_height = draw_canvas->height;
+
+    Light directional_light;
+
+    for (int32_t y = -canvas_height / 2; y < canvas_height / 2; y += 1)
+    {
+        for (int32_t x = -canvas_width / 2; x < canvas_width / 2; x += 1)
+        {
+            glm::vec3 ray(static_cast<float>(x) / static_cast<float>(canvas_width), static_cast<float>(y) / static_cast<float>(canvas_height), distance_to_viewport);
+
+            float closest_t = inf;
+            SphereCommand const* closest_sphere = nullptr;
+
+            float a = glm::dot(ray, ray);
+            for (auto const& sphere : spheres)
+            {
+                glm::vec3 CO = -sphere.center;
+                float b = 2.0f * glm::dot(CO, ray);
+                float c = glm::dot(CO, CO) - sphere.radius * sphere.radius;
+                float discrim = b * b - 4.0f * a * c;
+                if (discrim < 0.0f)
+                    continue;
+
+                float t = (-b - sqrt(discrim)) / (2.0f * a);
+                if (t > t_min && t < closest_t)
+                {
+                    closest_t = t;
+                    closest_sphere = &sphere;
+                }
+            }
+
+            if (closest_sphere == nullptr)
+                continue;
+
+            glm::vec3 normal = glm::normalize(closest_t * ray - closest_sphere->center);
+            float intensity = 0.2f + directional_light.intensity * std::max(glm::dot(normal, directional_light.direction), 0.0f);
+            draw_canvas->DrawPixel(x, y, glm::vec4(closest_sphere->color * intensity, 1.0f));
+        }
+    }
+
+    draw_canvas->DrawCanvasToFBO(*draw_framebuffer);
 }
 
 
@@ -527,11 +711,7 @@ void MilwaukeeApplication::RenderSceneOne()
     {
         ClearFBO(draw_framebuffer.get()->fbo_id, draw_framebuffer.get()->clear_color);
 
-        while (!renderCommandQueue.empty())
-        {
-            renderCommandQueue.front()();
-            renderCommandQueue.pop();
-        }
+        ExecuteRenderCommands(renderCommandBuffer);
 
         is_screen_dirty = false;
         //DrawCanvasToFBO();
@@ -780,6 +960,11 @@ void MilwaukeeApplication::RenderSceneThree()
 
 void MilwaukeeApplication::RenderSpheresDelay(double dt)
 {
+    if (use_progressive_accumulation)
+    {
+        RenderSpheresProgressive(dt);
+        return;
+    }
 
     static glm::vec4 default_draw_color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
@@ -931,16 +1116,160 @@ void MilwaukeeApplication::RenderSpheresDelay(double dt)
 }
 
 
+namespace
+{
+    //FNV-1a over the raw bytes. Only used to notice the scene changed, collisions just mean a missed reset
+    uint64_t HashBytes(void const* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        auto bytes = static_cast<unsigned char const*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}
+
+void MilwaukeeApplication::RenderSpheresProgressive(double dt)
+{
+    ClearFBO(screen_draw_fbo, clear_screen_color_default_fbo);
+
+    TraceSpheresProgressive(dt);
+
+    draw_canvas->DrawCanvasToFBO(*draw_framebuffer);
+    DrawPixelsToScreen();
+}
+
+void MilwaukeeApplication::TraceSpheresProgressive(double dt)
+{
+    ZoneScopedC(tracy::Color::Green);
+
+    static constexpr glm::vec4 background_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    static constexpr float distance_to_viewport = 1.0f;
+    static constexpr float t_min = distance_to_viewport;
+    static constexpr float inf = std::numeric_limits<float>::max();
+    static constexpr float specular_power = 50.0f;
+
+    //Same controls as the real time version. Camera on G/J Y/H T/U and the green sphere on WASD
+    float move = static_cast<float>(dt);
+    glm::vec3& green_sphere_center = progressive_spheres[1].center;
+
+    if (IsKeyPressed(GLFW_KEY_D))
+        green_sphere_center.x += move;
+    else if (IsKeyPressed(GLFW_KEY_A))
+        green_sphere_center.x -= move;
+
+    if (IsKeyPressed(GLFW_KEY_W))
+        green_sphere_center.y += move;
+    else if (IsKeyPressed(GLFW_KEY_S))
+        green_sphere_center.y -= move;
+
+    if (IsKeyPressed(GLFW_KEY_G))
+        progressive_camera_position.x -= move;
+    else if (IsKeyPressed(GLFW_KEY_J))
+        progressive_camera_position.x += move;
+
+    if (IsKeyPressed(GLFW_KEY_Y))
+        progressive_camera_position.z += move;
+    else if (IsKeyPressed(GLFW_KEY_H))
+        progressive_camera_position.z -= move;
+
+    if (IsKeyPressed(GLFW_KEY_T))
+        progressive_camera_position.y += move;
+    else if (IsKeyPressed(GLFW_KEY_U))
+        progressive_camera_position.y -= move;
+
+    uint64_t scene_hash = HashBytes(&progressive_camera_position, sizeof(progressive_camera_position));
+    scene_hash = HashBytes(progressive_spheres.data(), progressive_spheres.size() * sizeof(ProgressiveSphere), scene_hash);
+
+    if (sphere_accumulator.ResetIfChanged(scene_hash))
+    {
+        draw_canvas->ClearCanvas(background_color);
+    }
+
+    float canvas_width = static_cast<float>(draw_canvas->width);
+    float canvas_height = static_cast<float>(draw_canvas->height);
+    glm::vec3 origin = progressive_camera_position;
+    Light directional_light;
+
+    auto trace_sample = [&](glm::vec2 canvas_position)
+    {
+        glm::vec3 ray(canvas_position.x / canvas_width, canvas_position.y / canvas_height, distance_to_viewport);
+
+        float a = glm::dot(ray, ray);
+        float closest_t = inf;
+        ProgressiveSphere const* closest_sphere = nullptr;
+
+        for (auto const& sphere : progressive_spheres)
+        {
+            glm::vec3 CO = origin - sphere.center;
+            float b = 2.0f * glm::dot(CO, ray);
+            float c = glm::dot(CO, CO) - sphere.radius * sphere.radius;
+            float discrim = b * b - 4.0f * a * c;
+            if (discrim < 0.0f)
+                continue;
+
+            float sqrt_discrim = sqrt(discrim);
+            float t_near = (-b - sqrt_discrim) / (2.0f * a);
+            float t_far = (-b + sqrt_discrim) / (2.0f * a);
+            float t = t_near > t_min ? t_near : t_far;
+
+            if (t > t_min && t < closest_t)
+            {
+                closest_t = t;
+                closest_sphere = &sphere;
+            }
+        }
+
+        if (closest_sphere == nullptr)
+            return glm::vec3(background_color);
+
+        glm::vec3 P = origin + closest_t * ray;
+        glm::vec3 normal = glm::normalize(P - closest_sphere->center);
+        glm::vec3 view = glm::normalize(ray);
+
+        float intensity = 0.0f;
+        float n_dot_l = glm::dot(normal, directional_light.direction);
+        if (n_dot_l > 0.0f)
+        {
+            intensity += directional_light.intensity * n_dot_l;
+        }
+
+        glm::vec3 reflect_ray = (2.0f * n_dot_l * normal) - directional_light.direction;
+        float reflect_ray_dot_v = glm::dot(reflect_ray, view);
+        if (reflect_ray_dot_v > 0.0f)
+        {
+            intensity += directional_light.intensity * powf(reflect_ray_dot_v / glm::length(reflect_ray), specular_power);
+        }
+
+        return closest_sphere->color * intensity;
+    };
+
+    sphere_accumulator.Accumulate(trace_sample, progressive_budget_ms);
+    sphere_accumulator.Resolve(*draw_canvas);
+}
+
+
 void MilwaukeeApplication::RenderSpheresRealTime(double dt)
+{
+    ClearFBO(screen_draw_fbo, clear_screen_color_default_fbo);
+    ClearFBO(draw_framebuffer.get()->fbo_id, clear_screen_color);
+
+    TraceSpheresRealTime(dt);
+
+    draw_canvas->DrawCanvasToFBO(*draw_framebuffer);
+    DrawPixelsToScreen();
+}
+
+void MilwaukeeApplication::TraceSpheresRealTime(double dt)
 {
     ZoneScopedC(tracy::Color::Green);
 
 
     static glm::vec4 default_draw_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
-    ClearFBO(screen_draw_fbo, clear_screen_color_default_fbo);
     draw_canvas->ClearCanvas(default_draw_color);
-    ClearFBO(draw_framebuffer.get()->fbo_id, clear_screen_color);
 
     //static bool is_first_frame = true;
     //if (is_first_frame)
@@ -1105,7 +1434,7 @@ void MilwaukeeApplication::RenderSpheresRealTime(double dt)
     Sphere sphere_red{red_sphere_center, glm::vec3(1.0f, 0.0f, 0.0f), 1.0f};
     Sphere sphere_blue{blue_sphere_center, glm::vec3(0.0f, 0.0f, 1.0f), 1.0f};
 
-    auto TraceRay = [&](glm::vec3 origin, glm::vec3 ray, std::vector<Sphere>const& sphere_list)
+    auto TraceRay = [&](glm::vec3 origin, glm::vec3 ray, std::pmr::vector<Sphere>const& sphere_list)
     {
         float closest_t = inf;
         glm::vec4 draw_color = default_draw_color; //Background color
@@ -1149,7 +1478,8 @@ void MilwaukeeApplication::RenderSpheresRealTime(double dt)
     };
 
     glm::vec3 origin = cameraPos;
-    std::vector<Sphere> spheres{sphere_red, sphere_green, sphere_blue};
+    //Rebuilt every frame so it comes from the frame arena instead of the heap
+    std::pmr::vector<Sphere> spheres({sphere_red, sphere_green, sphere_blue}, &frame_arena);
 
     int curr_x = -canvas_width / 2;
     int curr_y = -canvas_height / 2;
@@ -1165,18 +1495,21 @@ void MilwaukeeApplication::RenderSpheresRealTime(double dt)
     if (elapsed_draw_time > time_between_draw)
     {
         elapsed_draw_time = 0.0f;
-        for (int32_t x = -canvas_width / 2; x < canvas_width / 2; x += 1)
+
+        //Every column only writes its own pixels so they can be traced on the job pool without any locking
+        int32_t half_width = canvas_width / 2;
+        Albuquerque::JobSystem::Instance().ParallelFor("Trace Columns", static_cast<size_t>(half_width * 2), 16, [&](size_t first, size_t last)
         {
-            for (int32_t y = -canvas_height / 2; y < canvas_height / 2; y += 1)
+            for (int32_t x = static_cast<int32_t>(first) - half_width; x < static_cast<int32_t>(last) - half_width; x += 1)
             {
-                glm::vec3 ray = convert_canvas_to_viewport(x, y);
-                draw_canvas->DrawPixel(x, y, TraceRay(origin, ray, spheres));
+                for (int32_t y = -canvas_height / 2; y < canvas_height / 2; y += 1)
+                {
+                    glm::vec3 ray = convert_canvas_to_viewport(x, y);
+                    draw_canvas->DrawPixel(x, y, TraceRay(origin, ray, spheres));
+                }
             }
-        }
+        });
     }
-
-    draw_canvas->DrawCanvasToFBO(*draw_framebuffer);
-    DrawPixelsToScreen();
 }
 
 
@@ -1192,6 +1525,32 @@ void MilwaukeeApplication::RenderUI([[maybe_unused]] double dt)
         ImGui::End();
     }
 
+    RenderMemoryStatsUI();
+
+    ImGui::Begin("Progressive Accumulation");
+    {
+        ImGui::Checkbox("Render Spheres Delay", &render_spheres_delay);
+        ImGui::Checkbox("Use Progressive Accumulation", &use_progressive_accumulation);
+        ImGui::SliderFloat("Frame Budget (ms)", &progressive_budget_ms, 0.5f, 33.0f);
+
+        int samples_per_pass = static_cast<int>(sphere_accumulator.samples_per_pass);
+        if (ImGui::SliderInt("Samples Per Pixel Per Pass", &samples_per_pass, 1, 16))
+            sphere_accumulator.samples_per_pass = static_cast<uint32_t>(samples_per_pass);
+
+        int max_passes = static_cast<int>(sphere_accumulator.max_passes);
+        if (ImGui::SliderInt("Max Passes", &max_passes, 1, 1024))
+            sphere_accumulator.max_passes = static_cast<uint32_t>(max_passes);
+
+        ImGui::Text("Passes: %u Samples per pixel: %u", sphere_accumulator.CompletedPasses(), sphere_accumulator.SamplesPerPixel());
+        ImGui::Text("Current row: %d Last accumulate: %.3f ms", sphere_accumulator.CurrentRow(), sphere_accumulator.LastAccumulateMs());
+        ImGui::TextUnformatted(sphere_accumulator.IsConverged() ? "Converged" : "Accumulating");
+
+        if (ImGui::Button("Reset Accumulation"))
+            sphere_accumulator.Reset();
+
+        ImGui::End();
+    }
+
     ImGui::Begin("Canvas Settings");
     {
         ImGui::Text("Screen Resolution (Width, Height): %d %d", windowWidth, windowHeight);
@@ -1227,6 +1586,9 @@ void MilwaukeeApplication::RenderUI([[maybe_unused]] double dt)
 
 
 
+        //These touch GL objects directly which the main thread can't do when the render thread owns the context
+        ImGui::BeginDisabled(IsPipelined());
+
         static float resize_percentage = 1.0f;
         static float resize_percentage_canvas = 1.0f;
         ImGui::DragFloat("Resize Percentage FBO of Window: ", &resize_percentage);
@@ -1254,6 +1616,7 @@ void MilwaukeeApplication::RenderUI([[maybe_unused]] double dt)
 
             draw_canvas->Resize(canvas_width, canvas_height);
             draw_canvas->SetOrigin(canvas_origin_x, canvas_origin_y);
+            sphere_accumulator.Resize(canvas_width, canvas_height);
 
             static glm::vec4 default_draw_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
             draw_canvas->ClearCanvas(default_draw_color);
@@ -1292,6 +1655,8 @@ void MilwaukeeApplication::RenderUI([[maybe_unused]] double dt)
             ClearFBO(draw_framebuffer.get()->fbo_id, clear_screen_color);
         }
 
+        ImGui::EndDisabled();
+
 
 
         ImGui::End();
@@ -0,0 +1,125 @@
+#include <ProgressiveAccumulator.hpp>
+#include <MilwaukeeApplication.hpp>
+
+#include <stb_image.h>
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+#include <string>
+
+namespace Milwaukee
+{
+
+void ProgressiveAccumulator::Resize(int32_t set_width, int32_t set_height)
+{
+    width = set_width;
+    height = set_height;
+
+    accumulation_buffer.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    row_sample_count.resize(static_cast<size_t>(height));
+    Reset();
+}
+
+bool ProgressiveAccumulator::LoadJitterTexture(std::string_view file_path)
+{
+    int32_t texture_width = 0;
+    int32_t texture_height = 0;
+    int32_t channels = 0;
+
+    std::string path(file_path);
+    unsigned char* pixels = stbi_load(path.c_str(), &texture_width, &texture_height, &channels, 1);
+    if (pixels == nullptr)
+    {
+        spdlog::warn("ProgressiveAccumulator: Could not load jitter texture {}, falling back to R2 jitter", path);
+        return false;
+    }
+
+    //Only square tiling textures make sense here, the bluenoise ones all are
+    if (texture_width != texture_height)
+    {
+        spdlog::warn("ProgressiveAccumulator: Jitter texture {} is not square", path);
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    jitter_texture_size = texture_width;
+    jitter_texture.resize(static_cast<size_t>(texture_width) * static_cast<size_t>(texture_height));
+    for (size_t i = 0; i < jitter_texture.size(); ++i)
+    {
+        jitter_texture[i] = static_cast<float>(pixels[i]) / 256.0f;
+    }
+
+    stbi_image_free(pixels);
+    return true;
+}
+
+void ProgressiveAccumulator::Reset()
+{
+    std::fill(accumulation_buffer.begin(), accumulation_buffer.end(), glm::vec3(0.0f));
+    std::fill(row_sample_count.begin(), row_sample_count.end(), 0u);
+    row_cursor = 0;
+    completed_passes = 0;
+}
+
+bool ProgressiveAccumulator::ResetIfChanged(uint64_t scene_hash)
+{
+    if (scene_hash == last_scene_hash)
+        return false;
+
+    last_scene_hash = scene_hash;
+    Reset();
+    return true;
+}
+
+void ProgressiveAccumulator::Resolve(Canvas& canvas) const
+{
+    for (int32_t y = 0; y < height; y += 1)
+    {
+        uint32_t sample_count = row_sample_count[y];
+        if (sample_count == 0)
+            continue;
+
+        float inverse_count = 1.0f / static_cast<float>(sample_count);
+        glm::vec3 const* row = accumulation_buffer.data() + static_cast<size_t>(y) * static_cast<size_t>(width);
+
+        for (int32_t x = 0; x < width; x += 1)
+        {
+            canvas.DrawPixel(x - width / 2, y - height / 2, glm::vec4(row[x] * inverse_count, 1.0f));
+        }
+    }
+}
+
+glm::vec2 ProgressiveAccumulator::Jitter(int32_t x, int32_t y, uint32_t sample_index) const
+{
+    //R2 sequence offset per sample, so each sample of a pixel lands somewhere new
+    static constexpr float g = 1.32471795724474602596f;
+    static constexpr float a1 = 1.0f / g;
+    static constexpr float a2 = 1.0f / (g * g);
+
+    glm::vec2 r2(
+        std::fmod(0.5f + a1 * static_cast<float>(sample_index), 1.0f),
+        std::fmod(0.5f + a2 * static_cast<float>(sample_index), 1.0f));
+
+    if (jitter_texture_size == 0)
+    {
+        return r2 - 0.5f;
+    }
+
+    //Single channel texture, so the y jitter reads from half a tile away to not be correlated with x
+    int32_t half_size = jitter_texture_size / 2;
+    int32_t tx = x % jitter_texture_size;
+    int32_t ty = y % jitter_texture_size;
+    int32_t tx2 = (x + half_size) % jitter_texture_size;
+    int32_t ty2 = (y + half_size) % jitter_texture_size;
+
+    glm::vec2 noise(
+        jitter_texture[static_cast<size_t>(ty) * jitter_texture_size + tx],
+        jitter_texture[static_cast<size_t>(ty2) * jitter_texture_size + tx2]);
+
+    //Cranley-Patterson rotation of the blue noise by the sequence keeps the blue noise distribution across the image
+    glm::vec2 jitter = noise + r2;
+    jitter -= glm::floor(jitter);
+    return jitter - 0.5f;
+}
+
+}
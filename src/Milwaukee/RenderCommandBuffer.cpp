@@ -0,0 +1,63 @@
+#include <RenderCommandBuffer.hpp>
+
+namespace Milwaukee
+{
+
+RenderCommandBuffer::RenderCommandBuffer(size_t reserve_bytes, size_t reserve_commands)
+{
+    bytes.resize(AlignUp(reserve_bytes));
+    entries.reserve(reserve_commands);
+}
+
+size_t RenderCommandBuffer::Allocate(size_t size)
+{
+    size_t offset = used_bytes;
+    size_t new_used = AlignUp(used_bytes + size);
+
+    if (new_used > bytes.size())
+    {
+        //Doubling so the amount of reallocations is logarithmic in the size of the biggest frame
+        bytes.resize(std::max(new_used, bytes.size() * 2));
+    }
+
+    used_bytes = new_used;
+    return offset;
+}
+
+void RenderCommandBuffer::Sort()
+{
+    if (is_sorted)
+        return;
+
+    std::stable_sort(entries.begin(), entries.end(), [](Entry const& lhs, Entry const& rhs)
+    {
+        return lhs.sort_key < rhs.sort_key;
+    });
+
+    is_sorted = true;
+}
+
+void RenderCommandBuffer::Append(RenderCommandBuffer const& other)
+{
+    if (other.Empty())
+        return;
+
+    size_t base = Allocate(other.used_bytes);
+    std::memcpy(bytes.data() + base, other.bytes.data(), other.used_bytes);
+
+    for (auto const& entry : other.entries)
+    {
+        entries.push_back({entry.sort_key, static_cast<uint32_t>(base + entry.offset)});
+    }
+
+    is_sorted = false;
+}
+
+void RenderCommandBuffer::Clear()
+{
+    used_bytes = 0;
+    entries.clear();
+    is_sorted = true;
+}
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <Albuquerque/Application.hpp>
+#include <RenderCommandBuffer.hpp>
+#include <ProgressiveAccumulator.hpp>
+#include <Albuquerque/TripleBuffer.hpp>
 
 
 #include <glm/mat4x4.hpp>
@@ -11,8 +14,6 @@
 #include <string_view>
 #include <vector>
 #include <memory>
-#include <queue>
-#include <functional>
 #include <chrono>
 
 
@@ -150,6 +151,8 @@ protected:
     void RenderScene(double dt) override;
     void RenderUI(double dt) override;
     void Update(double dt) override;
+    void UpdateScriptedCamera(uint32_t frame_index, double time) override;
+    void PublishFrameSnapshot() override;
 
 private:
 
@@ -171,6 +174,10 @@ private:
 
     void DrawPixel();
 
+    //Replays a recorded buffer. Does not consume it so the same buffer can be executed every frame
+    void ExecuteRenderCommands(RenderCommandBuffer const& commands);
+    void DrawSphereBatch(std::vector<SphereCommand> const& spheres);
+
     //Some 'scenes' which are just collection of function calls
     void BuildSceneOneCommands();
     void RenderSceneOne();
@@ -182,9 +189,21 @@ private:
     void RenderSceneThree();
 
     void RenderSpheresDelay(double dt);
+    //Accumulates jittered samples over frames instead of redrawing. Used by RenderSpheresDelay when enabled
+    void RenderSpheresProgressive(double dt);
 
     void RenderSpheresRealTime(double dt);
 
+    //CPU only halves of the sphere renderers, they only write into the canvas. Pipelined mode runs these in Update
+    void TraceSpheresRealTime(double dt);
+    void TraceSpheresProgressive(double dt);
+    void TraceSpheres(double dt);
+
+    void UpdatePauseToggle();
+
+    //Render thread side of pipelined mode
+    void PresentCanvasSnapshot();
+
     void BrushControlCallback(double xoffset, double yoffset);
 
     bool MakeShader(std::string_view vertexShaderFilePath, std::string_view fragmentShaderFilePath);
@@ -193,7 +212,10 @@ private:
 
     uint32_t _shaderProgram;
 
-    std::queue<std::function<void()>> renderCommandQueue;
+    RenderCommandBuffer renderCommandBuffer;
+
+    //Spheres get gathered here while replaying so they can be traced in one go. Reserved once so replaying does not allocate.
+    std::vector<SphereCommand> sphere_batch;
 
     //for the default framebuffer
     glm::vec4 clear_screen_color_default_fbo{0.4f, 0.4f, 0.4f, 1.0f};
@@ -214,6 +236,33 @@ private:
     std::unique_ptr<DrawFrameBuffer> draw_framebuffer;
     std::unique_ptr<Canvas> draw_canvas;
     double elapsed_time_seconds = 0.0f;
+
+    //Progressive sphere scene. Kept as members instead of statics so a change can be detected and reset the accumulation
+    struct ProgressiveSphere
+    {
+        glm::vec3 center;
+        glm::vec3 color;
+        float radius;
+    };
+
+    bool render_spheres_delay = false;
+    bool use_progressive_accumulation = true;
+    float progressive_budget_ms = 8.0f;
+    glm::vec3 progressive_camera_position{0.0f, 0.0f, 0.0f};
+    std::vector<ProgressiveSphere> progressive_spheres;
+    ProgressiveAccumulator sphere_accumulator;
+
+    //What the render thread needs from the canvas in pipelined mode
+    struct CanvasSnapshot
+    {
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t origin_x = 0;
+        int32_t origin_y = 0;
+        std::vector<glm::vec4> pixels;
+    };
+
+    Albuquerque::TripleBuffer<CanvasSnapshot> canvas_snapshots;
 };
 
 
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <glm/vec2.hpp>
+#include <glm/common.hpp>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+namespace Milwaukee
+{
+
+class Canvas;
+
+//Progressive renderer for static scenes. Instead of redrawing the canvas from scratch, every pass adds more jittered
+//samples per pixel into a float accumulation buffer and the canvas shows the running average.
+//Work is done row by row and stops when the frame budget runs out, the next frame continues from the same row.
+class ProgressiveAccumulator
+{
+public:
+    void Resize(int32_t set_width, int32_t set_height);
+
+    //Blue noise gives the sub-pixel offsets. Without it the jitter falls back to the R2 sequence only
+    bool LoadJitterTexture(std::string_view file_path);
+
+    //Throws away every sample. Call when the camera or scene changes
+    void Reset();
+
+    //Resets only if the hash is different to the one from the last call. Returns true if it did reset
+    bool ResetIfChanged(uint64_t scene_hash);
+
+    //trace_sample(glm::vec2 canvas_position) -> glm::vec3. Position is centre origin like Canvas::DrawPixel
+    //with the jitter already added. Returns the number of rows traced this call.
+    template <typename TraceFunc>
+    int32_t Accumulate(TraceFunc&& trace_sample, double budget_ms);
+
+    //Writes the averaged colour of every pixel that has at least one sample into the canvas
+    void Resolve(Canvas& canvas) const;
+
+    bool IsConverged() const { return completed_passes >= max_passes; }
+    uint32_t CompletedPasses() const { return completed_passes; }
+    //Lowest sample count of any pixel, the rows after the cursor are one pass behind
+    uint32_t SamplesPerPixel() const { return row_sample_count.empty() ? 0 : row_sample_count.back(); }
+    int32_t CurrentRow() const { return row_cursor; }
+    double LastAccumulateMs() const { return last_accumulate_ms; }
+
+    //Changing these mid accumulation is fine, they only apply to passes that have not started yet
+    uint32_t samples_per_pass = 1;
+    uint32_t max_passes = 64;
+
+private:
+    glm::vec2 Jitter(int32_t x, int32_t y, uint32_t sample_index) const;
+
+    int32_t width = 0;
+    int32_t height = 0;
+
+    //Sum of all samples. Divided by the per row sample count when resolving
+    std::vector<glm::vec3> accumulation_buffer;
+    std::vector<uint32_t> row_sample_count;
+
+    std::vector<float> jitter_texture;
+    int32_t jitter_texture_size = 0;
+
+    int32_t row_cursor = 0;
+    uint32_t completed_passes = 0;
+    uint32_t current_pass_samples = 1;
+
+    uint64_t last_scene_hash = 0;
+    double last_accumulate_ms = 0.0;
+};
+
+template <typename TraceFunc>
+int32_t ProgressiveAccumulator::Accumulate(TraceFunc&& trace_sample, double budget_ms)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    auto start = clock_t::now();
+
+    auto elapsed_ms = [&]()
+    {
+        return std::chrono::duration<double, std::milli>(clock_t::now() - start).count();
+    };
+
+    int32_t rows_traced = 0;
+
+    //Always finish at least one row so a tiny budget still makes progress
+    while (width > 0 && !IsConverged() && (rows_traced == 0 || elapsed_ms() < budget_ms))
+    {
+        //Sample count is only picked up at the start of a pass so every row in a pass gets the same amount
+        if (row_cursor == 0)
+        {
+            current_pass_samples = std::max(samples_per_pass, 1u);
+        }
+
+        int32_t y = row_cursor;
+        glm::vec3* row = accumulation_buffer.data() + static_cast<size_t>(y) * static_cast<size_t>(width);
+        uint32_t first_sample = row_sample_count[y];
+
+        for (int32_t x = 0; x < width; x += 1)
+        {
+            for (uint32_t s = 0; s < current_pass_samples; s += 1)
+            {
+                glm::vec2 canvas_position = glm::vec2(x - width / 2, y - height / 2) + Jitter(x, y, first_sample + s);
+                row[x] += trace_sample(canvas_position);
+            }
+        }
+
+        row_sample_count[y] += current_pass_samples;
+        rows_traced += 1;
+        row_cursor += 1;
+
+        if (row_cursor == height)
+        {
+            row_cursor = 0;
+            completed_passes += 1;
+        }
+    }
+
+    last_accumulate_ms = elapsed_ms();
+    return rows_traced;
+}
+
+}
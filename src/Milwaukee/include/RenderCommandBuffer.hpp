@@ -0,0 +1,180 @@
+#pragma once
+
+#include <glm/vec4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec2.hpp>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+namespace Milwaukee
+{
+
+//Replaces the old std::queue<std::function<void()>>. Every command is a POD struct written
+//into one linear byte stream so recording is just a memcpy and replaying does not allocate.
+
+enum class RenderCommandType : uint8_t
+{
+    Line,
+    Pixel,
+    Square,
+    Sphere
+};
+
+struct LineCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::Line;
+
+    glm::i32vec2 start;
+    glm::i32vec2 end;
+    glm::vec4 color;
+    bool center_origin = true;
+};
+
+struct PixelCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::Pixel;
+
+    glm::i32vec2 position;
+    glm::vec4 color;
+    glm::i32vec2 offset{0, 0};
+};
+
+struct SquareCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::Square;
+
+    glm::i32vec2 center;
+    glm::vec4 color;
+    int32_t length = 30;
+    bool center_origin = false;
+};
+
+//Spheres are not drawn one by one. The executor gathers all of them (they end up next to each other after sorting)
+//and traces them in one pass over the canvas
+struct SphereCommand
+{
+    static constexpr RenderCommandType type = RenderCommandType::Sphere;
+
+    glm::vec3 center;
+    float radius;
+    glm::vec3 color;
+};
+
+struct RenderCommandHeader
+{
+    RenderCommandType type;
+    uint32_t sort_key;
+};
+
+class RenderCommandBuffer
+{
+public:
+    //Everything is aligned to this so the payload can be read back in place
+    static constexpr size_t command_alignment = 16;
+
+    RenderCommandBuffer(size_t reserve_bytes = 4096, size_t reserve_commands = 256);
+
+    //Layer is the most significant part so things like 'background first' can be expressed. Commands of the same type
+    //are then grouped together which is what lets the executor batch them.
+    static constexpr uint32_t MakeSortKey(uint8_t layer, RenderCommandType type, uint16_t order = 0)
+    {
+        return (static_cast<uint32_t>(layer) << 24) | (static_cast<uint32_t>(type) << 16) | order;
+    }
+
+    template <typename T>
+    void Push(T const& command, uint32_t sort_key)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Render commands must be POD so they can be memcpy'd");
+
+        RenderCommandHeader header{T::type, sort_key};
+
+        size_t header_offset = Allocate(PayloadOffset() + sizeof(T));
+        std::memcpy(bytes.data() + header_offset, &header, sizeof(header));
+        std::memcpy(bytes.data() + header_offset + PayloadOffset(), &command, sizeof(T));
+
+        entries.push_back({sort_key, static_cast<uint32_t>(header_offset)});
+        is_sorted = false;
+    }
+
+    template <typename T>
+    void Push(T const& command)
+    {
+        Push(command, MakeSortKey(0, T::type));
+    }
+
+    //Stable so commands with the same key keep the order they were recorded in
+    void Sort();
+
+    //Per-thread buffers get merged into one before executing. Offsets are rebased onto this buffer.
+    void Append(RenderCommandBuffer const& other);
+
+    //Keeps the capacity. After the first frame recording the same commands again does not allocate.
+    void Clear();
+
+    size_t Size() const { return entries.size(); }
+    size_t ByteSize() const { return used_bytes; }
+    size_t ByteCapacity() const { return bytes.size(); }
+    bool Empty() const { return entries.empty(); }
+
+    //Replays in the current order (record order, or key order after Sort()). Can be called any number of times.
+    template <typename Visitor>
+    void Visit(Visitor&& visitor) const
+    {
+        for (auto const& entry : entries)
+        {
+            std::byte const* header_ptr = bytes.data() + entry.offset;
+            std::byte const* payload_ptr = header_ptr + PayloadOffset();
+
+            RenderCommandHeader header;
+            std::memcpy(&header, header_ptr, sizeof(header));
+
+            switch (header.type)
+            {
+            case RenderCommandType::Line:
+                visitor(*reinterpret_cast<LineCommand const*>(payload_ptr));
+                break;
+            case RenderCommandType::Pixel:
+                visitor(*reinterpret_cast<PixelCommand const*>(payload_ptr));
+                break;
+            case RenderCommandType::Square:
+                visitor(*reinterpret_cast<SquareCommand const*>(payload_ptr));
+                break;
+            case RenderCommandType::Sphere:
+                visitor(*reinterpret_cast<SphereCommand const*>(payload_ptr));
+                break;
+            }
+        }
+    }
+
+private:
+    static constexpr size_t AlignUp(size_t value)
+    {
+        return (value + command_alignment - 1) & ~(command_alignment - 1);
+    }
+
+    static constexpr size_t PayloadOffset()
+    {
+        return AlignUp(sizeof(RenderCommandHeader));
+    }
+
+    //Bump allocates from the byte stream, growing it geometrically if it runs out
+    size_t Allocate(size_t size);
+
+    struct Entry
+    {
+        uint32_t sort_key;
+        uint32_t offset;
+    };
+
+    std::vector<std::byte> bytes;
+    std::vector<Entry> entries;
+    size_t used_bytes = 0;
+    bool is_sorted = true;
+};
+
+}
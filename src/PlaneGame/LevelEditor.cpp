@@ -0,0 +1,175 @@
+#include "LevelEditor.h"
+
+#include <utility>
+
+namespace PlaneGame {
+
+WorldHandle LevelEditor::Add(glm::vec3 center, glm::vec3 half_extents) {
+  auto object = static_cast<EditorObjectId>(object_handles.size());
+  object_handles.emplace_back();
+  PlaceObject(object, center, half_extents);
+
+  Record(EditRecord{EditType::add, object, glm::vec3(0.0f), center,
+                    half_extents});
+  return object_handles[object];
+}
+
+bool LevelEditor::Move(WorldHandle handle, glm::vec3 center, bool merge) {
+  if (!buildings.slots.Contains(handle)) return false;
+
+  EditorObjectId object = ObjectOf(handle);
+  uint32_t dense = buildings.slots.DenseIndex(handle);
+  glm::vec3 from = buildings.Center(dense);
+  glm::vec3 half_extents = buildings.HalfExtents(dense);
+  MoveObject(object, center);
+
+  // Only onto the newest edit, anything undone past it would be lost
+  // otherwise
+  if (merge && cursor > 0 && cursor == history.size()) {
+    EditRecord& last = history.back();
+    if (last.type == EditType::move && last.object == object) {
+      last.to = center;
+      return true;
+    }
+  }
+
+  Record(EditRecord{EditType::move, object, from, center, half_extents});
+  return true;
+}
+
+bool LevelEditor::Remove(WorldHandle handle) {
+  if (!buildings.slots.Contains(handle)) return false;
+
+  EditorObjectId object = ObjectOf(handle);
+  uint32_t dense = buildings.slots.DenseIndex(handle);
+  glm::vec3 center = buildings.Center(dense);
+  glm::vec3 half_extents = buildings.HalfExtents(dense);
+  EraseObject(object);
+
+  Record(EditRecord{EditType::remove, object, center, glm::vec3(0.0f),
+                    half_extents});
+  return true;
+}
+
+bool LevelEditor::Undo() {
+  if (!CanUndo()) return false;
+  cursor -= 1;
+  Apply(history[cursor], false);
+  return true;
+}
+
+bool LevelEditor::Redo() {
+  if (!CanRedo()) return false;
+  Apply(history[cursor], true);
+  cursor += 1;
+  return true;
+}
+
+EditorObjectId LevelEditor::ObjectOf(WorldHandle handle) {
+  if (handle.index < slot_objects.size()) {
+    EditorObjectId object = slot_objects[handle.index];
+    if (object != invalid_editor_object && object_handles[object] == handle) {
+      return object;
+    }
+  } else {
+    slot_objects.resize(handle.index + 1, invalid_editor_object);
+  }
+
+  auto object = static_cast<EditorObjectId>(object_handles.size());
+  object_handles.push_back(handle);
+  slot_objects[handle.index] = object;
+  return object;
+}
+
+WorldHandle LevelEditor::HandleOf(EditorObjectId object) const {
+  if (object >= object_handles.size()) return {};
+  return object_handles[object];
+}
+
+void LevelEditor::TakeChanges(std::vector<WorldChange>& out) {
+  out.clear();
+  std::swap(out, changes);
+}
+
+void LevelEditor::Clear() {
+  history.clear();
+  cursor = 0;
+  object_handles.clear();
+  slot_objects.clear();
+  changes.clear();
+}
+
+void LevelEditor::Translate(glm::vec3 offset) {
+  for (EditRecord& record : history) {
+    record.from += offset;
+    record.to += offset;
+  }
+  for (WorldChange& change : changes) {
+    change.center += offset;
+  }
+}
+
+void LevelEditor::Record(EditRecord const& record) {
+  history.resize(cursor);
+  history.push_back(record);
+  cursor += 1;
+}
+
+void LevelEditor::Apply(EditRecord const& record, bool forward) {
+  switch (record.type) {
+    case EditType::add:
+      if (forward) {
+        PlaceObject(record.object, record.to, record.half_extents);
+      } else {
+        EraseObject(record.object);
+      }
+      break;
+    case EditType::move:
+      MoveObject(record.object, forward ? record.to : record.from);
+      break;
+    case EditType::remove:
+      if (forward) {
+        EraseObject(record.object);
+      } else {
+        PlaceObject(record.object, record.from, record.half_extents);
+      }
+      break;
+  }
+}
+
+void LevelEditor::PlaceObject(EditorObjectId object, glm::vec3 center,
+                              glm::vec3 half_extents) {
+  WorldHandle handle = buildings.Add(center, half_extents);
+  object_handles[object] = handle;
+  if (handle.index >= slot_objects.size()) {
+    slot_objects.resize(handle.index + 1, invalid_editor_object);
+  }
+  slot_objects[handle.index] = object;
+
+  changes.push_back(WorldChange{WorldChange::added, handle,
+                                buildings.Size() - 1, center, half_extents});
+}
+
+void LevelEditor::MoveObject(EditorObjectId object, glm::vec3 center) {
+  WorldHandle handle = object_handles[object];
+  buildings.Move(handle, center);
+
+  uint32_t dense = buildings.slots.DenseIndex(handle);
+  changes.push_back(WorldChange{WorldChange::moved, handle, dense, center,
+                                buildings.HalfExtents(dense)});
+}
+
+void LevelEditor::EraseObject(EditorObjectId object) {
+  WorldHandle handle = object_handles[object];
+  uint32_t dense = buildings.slots.DenseIndex(handle);
+  glm::vec3 center = buildings.Center(dense);
+  glm::vec3 half_extents = buildings.HalfExtents(dense);
+  buildings.Remove(handle);
+
+  slot_objects[handle.index] = invalid_editor_object;
+  object_handles[object] = {};
+  changes.push_back(WorldChange{WorldChange::removed, handle, dense, center,
+                                half_extents});
+}
+
+}  // namespace PlaneGame
@@ -11,9 +11,22 @@ int main(int argc, char* argv[])
         PlaneGame::Tests::RunTests();
     }
 
+    Albuquerque::HeadlessSettings headless_settings;
+    if (!Albuquerque::ParseHeadlessArguments(argc, argv, headless_settings))
+    {
+        return 1;
+    }
+
+    Albuquerque::InputSettings input_settings;
+    if (!Albuquerque::ParseInputArguments(argc, argv, input_settings))
+    {
+        return 1;
+    }
+
     PlaneGame::ProjectApplication application;
-    application.Run();
-    return 0;
+    application.SetHeadless(headless_settings);
+    application.SetInput(input_settings);
+    return application.Run();
 }
 
 
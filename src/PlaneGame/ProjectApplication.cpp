@@ -6,12 +6,6 @@
 #include <Fwog/Rendering.h>
 #include <Fwog/Shader.h>
 
-//This must be included before GLFW or else you'd get https://stackoverflow.com/questions/3927810/how-to-prevent-macro-redefinition
-//https://web.archive.org/web/20230630052623/https://stackoverflow.com/questions/3927810/how-to-prevent-macro-redefinition
-
-#define MINIAUDIO_IMPLEMENTATION
-#include "miniaudio.h"
-
 //https://stackoverflow.com/questions/44345811/glad-h-giving-error-that-opengl-header-is-included
 #define GLFW_INCLUDE_NONE
 #include <glad/glad.h>
@@ -22,12 +16,14 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdarg>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/mat4x4.hpp>
 #include <iostream>
@@ -73,6 +69,10 @@ static constexpr char frag_line_shader_path[] =
 static constexpr char vert_indexed_shader_path[] =
     "data/shaders/draw_indexed.vert.glsl";
 static constexpr char frag_color_shader_path[] = "data/shaders/color.frag.glsl";
+static constexpr char frag_pick_id_shader_path[] =
+    "data/shaders/pick_id.frag.glsl";
+static constexpr char frag_pick_occluder_shader_path[] =
+    "data/shaders/pick_occluder.frag.glsl";
 static constexpr char frag_phong_shader_path[] =
     "data/shaders/phongFog.frag.glsl";
 
@@ -105,6 +105,14 @@ std::string ProjectApplication::LoadFile(std::string_view path) {
           std::istreambuf_iterator<char>()};
 }
 
+// Music ships compressed where it can, the first of these that exists is used
+static std::string FindMusicFile(std::string const& base_path) {
+  for (char const* extension : {".ogg", ".flac", ".mp3", ".wav"}) {
+    if (fs::exists(base_path + extension)) return base_path + extension;
+  }
+  return base_path + ".wav";
+}
+
 static Fwog::GraphicsPipeline CreatePipeline() {
   // Specify our two vertex attributes: position and color.
   // Positions are 3x float, so we will use R32G32B32_FLOAT like we would in
@@ -192,7 +200,8 @@ static Fwog::GraphicsPipeline CreatePipelineLines() {
   }};
 }
 
-static Fwog::GraphicsPipeline CreatePipelineTextured() {
+static Fwog::GraphicsPipeline CreatePipelineTextured(
+    char const* fragment_shader_path = frag_texture_shader_path) {
   // Specify our two vertex attributes: position and color.
   // Positions are 3x float, so we will use R32G32B32_FLOAT like we would in
   // Vulkan.
@@ -229,7 +238,7 @@ static Fwog::GraphicsPipeline CreatePipelineTextured() {
                    ProjectApplication::LoadFile(vert_shader_path));
   auto fragmentShader =
       Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER,
-                   ProjectApplication::LoadFile(frag_texture_shader_path));
+                   ProjectApplication::LoadFile(fragment_shader_path));
 
   return Fwog::GraphicsPipeline{{
       .vertexShader = &vertexShader,
@@ -242,9 +251,11 @@ static Fwog::GraphicsPipeline CreatePipelineTextured() {
   }};
 }
 
-static Fwog::GraphicsPipeline CreatePipelineColoredIndex() {
+static Fwog::GraphicsPipeline CreatePipelineColoredIndex(
+    char const* fragment_shader_path = frag_phong_shader_path) {
   // To be honest since this is the same as the others I might as well just pass
-  // in the shader paths instead
+  // in the shader paths instead. Started with the fragment shader, the pick
+  // pass only needs a different one of those
 
   static constexpr auto sceneInputBindingDescs = std::array{
       Fwog::VertexInputBindingDescription{
@@ -279,7 +290,7 @@ static Fwog::GraphicsPipeline CreatePipelineColoredIndex() {
                    ProjectApplication::LoadFile(vert_indexed_shader_path));
   auto fragmentShader =
       Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER,
-                   ProjectApplication::LoadFile(frag_phong_shader_path));
+                   ProjectApplication::LoadFile(fragment_shader_path));
 
   return Fwog::GraphicsPipeline{{
       .vertexShader = &vertexShader,
@@ -294,33 +305,6 @@ static Fwog::GraphicsPipeline CreatePipelineColoredIndex() {
 
 
 
-void DrawCall::SetBuffers(Fwog::Buffer const& vertex_buffer, Fwog::Buffer const& index_buffer)
-{
-    this->vertex_buffer = &vertex_buffer;
-    this->index_buffer = &index_buffer;
-}
-
-void DrawCall::SetModelTransformation(glm::mat4 const& model)
-{
-    uniform.model = model;
-    object_buffer.UpdateData(uniform, 0);
-}
-
-void DrawCall::SetColor(glm::vec4 color)
-{
-    uniform.color = color;
-    object_buffer.UpdateData(uniform, 0);
-}
-
-void DrawCall::Draw(uint64_t stride,uint32_t index_buffer_index, uint32_t object_buffer_index) const
-{
-    Fwog::Cmd::BindUniformBuffer(object_buffer_index, object_buffer);
-    Fwog::Cmd::BindVertexBuffer(index_buffer_index, *vertex_buffer, 0, stride);
-    Fwog::Cmd::BindIndexBuffer(*index_buffer, Fwog::IndexType::UNSIGNED_INT);
-    Fwog::Cmd::DrawIndexed(static_cast<uint32_t>(index_buffer->Size()) / sizeof(uint32_t) ,1, 0, 0, 0);
-}
-
-
 Fwog::GraphicsPipeline ProjectApplication::CreatePipelineSkybox() {
   static constexpr auto sceneInputBindingDescs =
       std::array{Fwog::VertexInputBindingDescription{
@@ -352,131 +336,12 @@ Fwog::GraphicsPipeline ProjectApplication::CreatePipelineSkybox() {
   }};
 }
 
-void ProjectApplication::AddDebugDrawLine(glm::vec3 ptA, glm::vec3 ptB,
-                                          glm::vec3 color) {
-  std::array<glm::vec3, 2> linePos{ptA, ptB};
-  std::array<glm::vec3, 2> colorPos{color, color};
-  vertex_buffer_draw_lines.value().UpdateData(
-      linePos, sizeof(glm::vec3) * curr_num_draw_points);
-  vertex_buffer_draw_colors.value().UpdateData(
-      colorPos, sizeof(glm::vec3) * curr_num_draw_points);
-
-  curr_num_draw_points += 2;
-}
-
-void ProjectApplication::ClearLines() { curr_num_draw_points = 0; }
-
-void ProjectApplication::DrawLineAABB(Collision::AABB const& aabb,
-                                      glm::vec3 boxColor) {
-  // It is ok to recalculate face points from the extents despite performance
-  // cost because this draw function is optional
-
-  // back : negative z-axis
-  // forward : positive z-axis
-  glm::vec3 backface_down_left = glm::vec3(aabb.center.x - aabb.halfExtents.x,
-                                           aabb.center.y - aabb.halfExtents.y,
-                                           aabb.center.z - aabb.halfExtents.z);
-  glm::vec3 backface_down_right = glm::vec3(aabb.center.x + aabb.halfExtents.x,
-                                            aabb.center.y - aabb.halfExtents.y,
-                                            aabb.center.z - aabb.halfExtents.z);
-  glm::vec3 backface_up_left = glm::vec3(aabb.center.x - aabb.halfExtents.x,
-                                         aabb.center.y + aabb.halfExtents.y,
-                                         aabb.center.z - aabb.halfExtents.z);
-  glm::vec3 backface_up_right = glm::vec3(aabb.center.x + aabb.halfExtents.x,
-                                          aabb.center.y + aabb.halfExtents.y,
-                                          aabb.center.z - aabb.halfExtents.z);
-
-  glm::vec3 frontface_down_left = glm::vec3(aabb.center.x - aabb.halfExtents.x,
-                                            aabb.center.y - aabb.halfExtents.y,
-                                            aabb.center.z + aabb.halfExtents.z);
-  glm::vec3 frontface_down_right = glm::vec3(
-      aabb.center.x + aabb.halfExtents.x, aabb.center.y - aabb.halfExtents.y,
-      aabb.center.z + aabb.halfExtents.z);
-  glm::vec3 frontface_up_left = glm::vec3(aabb.center.x - aabb.halfExtents.x,
-                                          aabb.center.y + aabb.halfExtents.y,
-                                          aabb.center.z + aabb.halfExtents.z);
-  glm::vec3 frontface_up_right = glm::vec3(aabb.center.x + aabb.halfExtents.x,
-                                           aabb.center.y + aabb.halfExtents.y,
-                                           aabb.center.z + aabb.halfExtents.z);
-
-  // Back face
-  AddDebugDrawLine(backface_down_left, backface_down_right, boxColor);
-  AddDebugDrawLine(backface_down_left, backface_up_left, boxColor);
-  AddDebugDrawLine(backface_up_left, backface_up_right, boxColor);
-  AddDebugDrawLine(backface_up_right, backface_down_right, boxColor);
-
-  // Front Face
-  AddDebugDrawLine(frontface_down_left, frontface_down_right, boxColor);
-  AddDebugDrawLine(frontface_down_left, frontface_up_left, boxColor);
-  AddDebugDrawLine(frontface_up_left, frontface_up_right, boxColor);
-  AddDebugDrawLine(frontface_up_right, frontface_down_right, boxColor);
-
-  // Left Face
-  AddDebugDrawLine(backface_down_left, frontface_down_left, boxColor);
-  AddDebugDrawLine(backface_up_left, frontface_up_left, boxColor);
-
-  // Right Face
-  AddDebugDrawLine(backface_down_right, frontface_down_right, boxColor);
-  AddDebugDrawLine(backface_up_right, frontface_up_right, boxColor);
-}
-
-void ProjectApplication::DrawLineSphere(Collision::Sphere const& sphere,
-                                        glm::vec3 sphereColor) {
-  // http://www.songho.ca/opengl/gl_sphere.html
-
-  constexpr uint32_t num_stacks = 16;
-  constexpr uint32_t num_slices = 16;
-
-  static glm::vec3 temp_horizontal{0.f};
-  static glm::vec3 temp_vert{0.f};
-  static glm::vec3 normal{0.f};
-
-  glm::vec3 position_horizontal = sphere.center;
-  glm::vec3 position_vert = sphere.center;
-  glm::vec3 local_origin = sphere.center;
-
-  float radius = sphere.radius;
-
-  for (uint32_t curr_stack{0}; curr_stack <= num_stacks; ++curr_stack) {
-    float theta = static_cast<float>(curr_stack * PI / num_stacks);
-    float sin_theta = sin(theta);
-    float cos_theta = cos(theta);
-
-    for (uint32_t curr_slice{0}; curr_slice <= num_slices; ++curr_slice) {
-      float phi = static_cast<float>(curr_slice * 2 * PI / num_slices);
-      float sin_phi = sin(phi);
-      float cos_phi = cos(phi);
-
-      normal.x = cos_phi * sin_theta;
-      normal.y = cos_theta;
-      normal.z = sin_phi * sin_theta;
-
-      temp_horizontal = position_horizontal;
-      temp_vert = position_vert;
-
-      position_horizontal.x = radius * normal.x;
-      position_horizontal.y = radius * normal.y;
-      position_horizontal.z = radius * normal.z;
-
-      position_horizontal = local_origin + position_horizontal;
-
-      position_vert.y = radius * normal.x;
-      position_vert.x = radius * normal.y;
-      position_vert.z = radius * normal.z;
-
-      position_vert = local_origin + position_vert;
-
-      AddDebugDrawLine(position_horizontal, temp_horizontal, sphereColor);
-      AddDebugDrawLine(position_vert, temp_vert, sphereColor);
-    }
-  }
-}
-
 void ProjectApplication::AfterCreatedUiContext() {}
 
 void ProjectApplication::BeforeDestroyUiContext() {}
 
 void ProjectApplication::LoadCheckpoints() {
+  ALBUQUERQUE_PROFILE_CPU("Load Checkpoints");
   std::vector<glm::mat4> list =
       Utility::LoadTransformsFromFile("data/levels/checkpoint_layout.gltf");
 
@@ -498,20 +363,18 @@ void ProjectApplication::AddCheckpoint(glm::vec3 position, glm::mat4 transform,
   // The Fwog buffers don't have copy constructors so we using emplace to avoid
   // copy construction
 
-  // checkpointList.emplace_back();
-  // checkpointObject& checkpoint = checkpointList.back();
-  checkpointObject checkpoint;
+  WorldHandle handle = world_store.checkpoints.Add(
+      glm::vec3(transform[3].x, transform[3].y, transform[3].z),
+      checkpointObject::base_radius * scale.x);
 
-  checkpoint.center = glm::vec3(transform[3].x, transform[3].y, transform[3].z);
-  checkpoint.scale = scale;
-  if (checkpointList.empty()) {
-    checkpoint.activated = true;
-    checkpoint.color = checkpointObject::activated_color_linear;
+  if (handle.index >= checkpoint_render_state.size()) {
+    checkpoint_render_state.resize(handle.index + 1);
   }
+  checkpointObject& checkpoint = checkpoint_render_state[handle.index];
 
-  checkpoint.collider.center =
-      glm::vec3(transform[3].x, transform[3].y, transform[3].z);
-  checkpoint.collider.radius = checkpointObject::base_radius * scale.x;
+  checkpoint.color = checkpoint_route.empty()
+                         ? checkpointObject::activated_color_linear
+                         : checkpointObject::non_activated_color_linear;
 
   checkpoint.model = transform;
 
@@ -521,15 +384,14 @@ void ProjectApplication::AddCheckpoint(glm::vec3 position, glm::mat4 transform,
   // glm::rotate(checkpoint.rotation_model_matrix, glm::radians(yaw_degrees),
   // worldUp);
 
-  ObjectUniforms uniform;
-  uniform.model = transform;
-  uniform.color = glm::vec4(checkpoint.color, 1.0f);
-
-  checkpoint.object_buffer = Fwog::TypedBuffer<ObjectUniforms>(
-      Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-  checkpoint.object_buffer.value().UpdateData(uniform, 0);
+  checkpoint_route.push_back(handle);
+}
 
-  checkpointList.push_back(std::move(checkpoint));
+Collision::Sphere ProjectApplication::CheckpointCollider(
+    size_t route_index) const {
+  SphereColliders const& checkpoints = world_store.checkpoints;
+  uint32_t i = checkpoints.slots.DenseIndex(checkpoint_route[route_index]);
+  return Collision::Sphere{checkpoints.Center(i), checkpoints.radius[i]};
 }
 
 void ProjectApplication::CreateSkybox() {
@@ -664,16 +526,12 @@ void ProjectApplication::LoadGroundPlane() {
   groundAlbedo.value().GenMipmaps();
   stbi_image_free(textureData);
 
-  glm::mat4 modelPlane = glm::mat4(1.0f);
-  modelPlane = glm::scale(modelPlane, planeScale);
-  ObjectUniforms planeUniform;
-  planeUniform.model = modelPlane;
-  objectBufferPlane = Fwog::TypedBuffer<ObjectUniforms>(
-      Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-  objectBufferPlane.value().UpdateData(planeUniform, 0);
-
-  vertex_buffer_plane.emplace(Primitives::plane_vertices);
-  index_buffer_plane.emplace(Primitives::plane_indices);
+  // The old ground was 3x3 planes of 4000 around the origin, so that stays
+  // flat and the texture keeps the same scale
+  Albuquerque::TerrainSettings terrain_settings;
+  terrain_settings.uv_period = 4000.0f;
+  terrain_settings.noise.flat_radius = 6000.0f;
+  terrain.emplace(terrain_settings);
 }
 
 void ProjectApplication::LoadBuffers() {
@@ -694,19 +552,7 @@ void ProjectApplication::LoadBuffers() {
     vertex_buffer_color_line = Fwog::TypedBuffer<glm::vec3>(axisColors);
   }
 
-  // Create collision line buffer
-  {
-    // Doesn't matter what the default initalization is since we only draw the
-    // valid points
-    std::array<glm::vec3, max_num_draw_points> linePts{};
-
-    vertex_buffer_draw_lines = Fwog::TypedBuffer<glm::vec3>(
-        max_num_draw_points, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    vertex_buffer_draw_colors = Fwog::TypedBuffer<glm::vec3>(
-        max_num_draw_points, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    vertex_buffer_draw_lines.value().UpdateData(linePts, 0);
-    vertex_buffer_draw_colors.value().UpdateData(linePts, 0);
-  }
+  debug_draw.emplace();
 
   // Camera Settings
   {
@@ -721,12 +567,7 @@ void ProjectApplication::LoadBuffers() {
     globalStruct.viewProj = viewProj;
     globalStruct.eyePos = camPos;
 
-    globalUniformsBuffer = Fwog::TypedBuffer<GlobalUniforms>(
-        Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    globalUniformsBuffer_skybox = Fwog::TypedBuffer<GlobalUniforms>(
-        Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    globalUniformsBuffer.value().UpdateData(globalStruct, 0);
-    globalUniformsBuffer_skybox.value().UpdateData(globalStruct, 0);
+    globalStruct_skybox = globalStruct;
   }
 
   // Creating ground plane
@@ -749,23 +590,17 @@ void ProjectApplication::LoadBuffers() {
     aircraft_sphere_collider.center = aircraftPos;
 
     aircraftUniform.color = aircraftColor;
-    objectBufferaircraft = Fwog::TypedBuffer<ObjectUniforms>(
-        Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    object_buffer_propeller = Fwog::TypedBuffer<ObjectUniforms>(
-        Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    objectBufferaircraft.value().UpdateData(aircraftUniform, 0);
+    aircraft_uniforms = aircraftUniform;
 
     aircraftUniform.color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
 
-    object_buffer_propeller.value().UpdateData(aircraftUniform, 0);
+    propeller_uniforms = aircraftUniform;
   }
 
   // Load the actual scene vertices here
   Utility::LoadModelFromFile(scene_collectable,
                              "data/assets/collectableSphere.glb",
                              glm::mat4{1.0f}, true);
-  collectableObjectBuffers = Fwog::TypedBuffer<ObjectUniforms>(
-      max_num_collectables, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
 
   building_vertex_buffer.emplace(Primitives::cube_vertices);
   building_index_buffer.emplace(Primitives::cube_indices);
@@ -776,83 +611,44 @@ void ProjectApplication::LoadBuffers() {
 
   // checkpoint_vertex_buffer.emplace(scene_checkpoint_ring.meshes[0].vertexBuffer);
   // checkpoint_index_buffer.emplace(scene_checkpoint_ring.meshes[0].indexBuffer);
-}
 
-void ProjectApplication::CreateGroundChunks() {
-  // Makes the chunks surrounding relative to a center
-  constexpr glm::vec3 center_position{0.0f, 0.0f, 0.0f};
-  constexpr glm::vec3 center_chunk_scale{planeScale};
-
-  // length of the world unit vectors (can also be dot product) allows not
-  // having to worry about what direction is forward/front
-  glm::vec3 forward_chunk_offset{
-      center_position.x, center_position.y,
-      center_position.z + glm::length(worldForward) * center_chunk_scale.z};
-  glm::vec3 back_chunk_offset{
-      center_position.x, center_position.y,
-      center_position.z - glm::length(worldForward) * center_chunk_scale.z};
-  glm::vec3 right_chunk_offset{
-      center_position.x + glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y, center_position.z};
-  glm::vec3 left_chunk_offset{
-      center_position.x - glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y, center_position.z};
-
-  glm::vec3 forward_right_chunk_offset{
-      center_position.x + glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y,
-      center_position.z + glm::length(worldForward) * center_chunk_scale.z};
-  glm::vec3 forward_left_chunk_offset{
-      center_position.x - glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y,
-      center_position.z + glm::length(worldForward) * center_chunk_scale.z};
-
-  glm::vec3 back_right_chunk_offset{
-      center_position.x + glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y,
-      center_position.z - glm::length(worldForward) * center_chunk_scale.z};
-  glm::vec3 back_left_chunk_offset{
-      center_position.x - glm::length(worldRight) * center_chunk_scale.x,
-      center_position.y,
-      center_position.z - glm::length(worldForward) * center_chunk_scale.z};
-
-  // I heard rumors of these things called 'constructors'...
-  // Not as clumsy or random as a lambda; an elegant weapon for a more civilized
-  // age...
-  auto create_chunk = [&](glm::vec3 chunk_center) {
-    grond_chunk_list.emplace_back();
-    ground_chunk& chunk = grond_chunk_list.back();
-    chunk.ground_center = chunk_center;
-    glm::mat4 model(1.0f);
-    model = glm::translate(model, chunk_center);
-    model = glm::scale(model, planeScale);
-    chunk.ground_uniform.model = model;
-    chunk.object_buffer = Fwog::TypedBuffer<ObjectUniforms>(
-        Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    chunk.object_buffer.value().UpdateData(chunk.ground_uniform, 0);
+  // One mesh each since they all have their own vertex and index buffers
+  auto index_count = [](Fwog::Buffer const& index_buffer) {
+    return static_cast<uint32_t>(index_buffer.Size() / sizeof(uint32_t));
   };
-
-  create_chunk(forward_chunk_offset);
-  create_chunk(back_chunk_offset);
-  create_chunk(right_chunk_offset);
-  create_chunk(left_chunk_offset);
-  create_chunk(forward_right_chunk_offset);
-  create_chunk(forward_left_chunk_offset);
-  create_chunk(back_right_chunk_offset);
-  create_chunk(back_left_chunk_offset);
+  building_culler.emplace(std::vector<Albuquerque::GpuCullMesh>{
+      {.index_count = index_count(building_index_buffer.value())}});
+  collectable_culler.emplace(std::vector<Albuquerque::GpuCullMesh>{
+      {.index_count = index_count(scene_collectable.meshes[0].indexBuffer)}});
+  checkpoint_culler.emplace(std::vector<Albuquerque::GpuCullMesh>{
+      {.index_count = index_count(scene_checkpoint_ring.meshes[0].indexBuffer)}});
+
+  scene_color = Fwog::CreateTexture2D({windowWidth, windowHeight},
+                                      Fwog::Format::R8G8B8A8_SRGB,
+                                      "Scene Color");
+  scene_depth = Fwog::CreateTexture2D({windowWidth, windowHeight},
+                                      Fwog::Format::D32_FLOAT, "Scene Depth");
+  hiz_pyramid.emplace();
+  mouse_picker.emplace();
 }
 
 void ProjectApplication::AddCollectable(glm::vec3 position, glm::vec3 scale,
                                         glm::vec3 color) {
   ObjectUniforms collectableUniform;
   collectableUniform.model = glm::mat4(1.0f);
-  collectableUniform.model = glm::translate(collectableUniform.model, position);
+  collectableUniform.model = glm::translate(collectableUniform.model,
+                                            position - object_space_offset);
   collectableUniform.model = glm::scale(collectableUniform.model, scale);
   collectableUniform.color = glm::vec4(color, 1.0f);
 
-  collectableObjectBuffers.value().UpdateData(
-      collectableUniform, sizeof(collectableUniform) * collectableList.size());
-  collectableList.emplace_back(position, scale, false);
+  // Uploaded with the culling objects, AddCollectable can run off the GL
+  // thread
+  WorldHandle handle = world_store.collectables.Add(position, scale.x);
+  if (handle.index >= collectable_uniforms.size()) {
+    collectable_uniforms.resize(handle.index + 1);
+  }
+  collectable_uniforms[handle.index] = collectableUniform;
+  cull_objects_dirty = true;
 }
 
 void ProjectApplication::LoadCollectables() {
@@ -874,54 +670,355 @@ void ProjectApplication::LoadCollectables() {
 }
 
 void ProjectApplication::LoadBuildings() {
+  ALBUQUERQUE_PROFILE_CPU("Load Buildings");
   // Do Not export rotations or this will not work as intended. Only scale and
   // translation! This is meant to be AABBs
   std::vector<glm::mat4> transformList = Utility::LoadTransformsFromFile(
       "data/levels/building_collider_layout.gltf");
 
   for (auto const& transform : transformList) {
-    buildingObject object;
-
     // Just the starting building idea
     glm::mat4 model(1.0f);
     model = transform;
 
-    object.building_center =
+    glm::vec3 building_center =
         glm::vec3(transform[3].x, transform[3].y, transform[3].z);
-    object.building_scale =
+    glm::vec3 building_scale =
         glm::vec3(transform[0].x, transform[1].y, transform[2].z);
 
-    object.building_collider.center = object.building_center;
-    object.building_collider.halfExtents = object.building_scale * 0.5f;
+    WorldHandle handle =
+        world_store.buildings.Add(building_center, building_scale * 0.5f);
 
-    object.drawcall.SetModelTransformation(model);
-    object.drawcall.SetColor(glm::vec4{default_building_color, 1.0f});
-    object.drawcall.SetBuffers(building_vertex_buffer.value(), building_index_buffer.value());
+    if (handle.index >= building_uniforms.size()) {
+      building_uniforms.resize(handle.index + 1);
+    }
+    model[3] -= glm::vec4(object_space_offset, 0.0f);
+    building_uniforms[handle.index] =
+        ObjectUniforms{model, glm::vec4{default_building_color, 1.0f}};
+  }
 
-    buildingObjectList.push_back(std::move(object));
+  cull_objects_dirty = true;
+}
+
+void ProjectApplication::UpdateCullObjects() {
+  ALBUQUERQUE_PROFILE_CPU("Update Cull Objects");
+  using Albuquerque::GpuCulling::PackAABB;
+  using Albuquerque::GpuCulling::PackSphere;
+
+  ApplyEditorChanges();
+
+  if (cull_objects_dirty) {
+    cull_objects_dirty = false;
+
+    // Everything gets uploaded anyway, so this is where the offset the
+    // rebases left behind goes back into the uniforms
+    if (object_space_offset != glm::vec3(0.0f)) {
+      glm::vec4 translation(object_space_offset, 0.0f);
+      for (ObjectUniforms& uniforms : building_uniforms) {
+        uniforms.model[3] += translation;
+      }
+      for (ObjectUniforms& uniforms : collectable_uniforms) {
+        uniforms.model[3] += translation;
+      }
+      object_space_offset = glm::vec3(0.0f);
+    }
+
+    size_t building_count = std::max<size_t>(building_uniforms.size(), 1);
+    if (!building_object_buffer || building_object_buffer->Size() <
+                                       building_count * sizeof(ObjectUniforms)) {
+      building_object_buffer = Fwog::TypedBuffer<ObjectUniforms>(
+          building_count, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+    }
+    if (!building_uniforms.empty()) {
+      building_object_buffer->UpdateData(
+          std::span<ObjectUniforms const>(building_uniforms));
+    }
+
+    // Doubled when it runs out, so a level adding collectables one by one
+    // only reallocates now and then
+    size_t collectable_count = std::max<size_t>(collectable_uniforms.size(), 1);
+    size_t collectable_capacity =
+        collectableObjectBuffers
+            ? collectableObjectBuffers->Size() / sizeof(ObjectUniforms)
+            : 0;
+    if (collectable_capacity < collectable_count) {
+      collectableObjectBuffers = Fwog::TypedBuffer<ObjectUniforms>(
+          std::max(collectable_count, collectable_capacity * 2),
+          Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+    }
+    if (!collectable_uniforms.empty()) {
+      collectableObjectBuffers->UpdateData(
+          std::span<ObjectUniforms const>(collectable_uniforms));
+    }
+
+    AABBColliders const& buildings = world_store.buildings;
+    // Everything starts out unhidden again, the software pass redoes it
+    building_occluded.assign(buildings.Size(), 0);
+    cull_objects.clear();
+    for (uint32_t i = 0; i < buildings.Size(); ++i) {
+      cull_objects.push_back(PackAABB(buildings.Center(i),
+                                      buildings.HalfExtents(i), 0,
+                                      buildings.slots.Handle(i).index));
+    }
+    building_culler->SetObjects(cull_objects);
+
+    SphereColliders const& collectables = world_store.collectables;
+    collectable_occluded.assign(collectables.Size(), 0);
+    cull_objects.clear();
+    for (uint32_t i = 0; i < collectables.Size(); ++i) {
+      cull_objects.push_back(PackSphere(collectables.Center(i),
+                                        collectables.radius[i], 0,
+                                        collectables.slots.Handle(i).index));
+    }
+    collectable_culler->SetObjects(cull_objects);
   }
+
+  // Only a handful of checkpoints and which ones are left changes as they
+  // are flown through, so they are just redone every frame
+  cull_objects.clear();
+  checkpoint_uniforms.clear();
+  for (size_t i = 0; i < checkpoint_route.size(); ++i) {
+    checkpointObject const& checkpoint =
+        checkpoint_render_state[checkpoint_route[i].index];
+    // Drawn and culled with the buildings, so in their space too
+    glm::mat4 model = checkpoint.model;
+    model[3] -= glm::vec4(object_space_offset, 0.0f);
+    checkpoint_uniforms.push_back(
+        ObjectUniforms{model, glm::vec4(checkpoint.color, 1.0f)});
+
+    Collision::Sphere collider = CheckpointCollider(i);
+    bool passed = all_checkpoints_collected || i < curr_active_checkpoint;
+    cull_objects.push_back(
+        PackSphere(collider.center - object_space_offset, collider.radius, 0,
+                   static_cast<uint32_t>(i),
+                   passed ? Albuquerque::gpu_cull_hidden : 0));
+  }
+  checkpoint_culler->SetObjects(cull_objects);
 }
 
-void ProjectApplication::SetBackgroundMusic(ma_sound& bgm)
+void ProjectApplication::ApplyEditorChanges() {
+  ALBUQUERQUE_PROFILE_CPU("Apply Editor Changes");
+  using Albuquerque::GpuCulling::PackAABB;
+
+  level_editor.TakeChanges(editor_changes);
+
+  for (WorldChange const& change : editor_changes) {
+    uint32_t slot = change.handle.index;
+
+    if (change.type != WorldChange::removed) {
+      if (slot >= building_uniforms.size()) {
+        building_uniforms.resize(slot + 1);
+      }
+      glm::mat4 model =
+          glm::translate(glm::mat4(1.0f), change.center - object_space_offset);
+      model = glm::scale(model, change.half_extents * 2.0f);
+      glm::vec3 color = change.handle == editor_selected
+                            ? selected_building_color
+                            : default_building_color;
+      building_uniforms[slot] = ObjectUniforms{model, glm::vec4(color, 1.0f)};
+    }
+
+    // The full refill picks up the uniforms from above
+    if (cull_objects_dirty) continue;
+
+    switch (change.type) {
+      case WorldChange::added: {
+        size_t capacity =
+            building_object_buffer->Size() / sizeof(ObjectUniforms);
+        if (slot >= capacity) {
+          // Doubling, so adding buildings one by one only copies them all
+          // every now and then
+          building_object_buffer = Fwog::TypedBuffer<ObjectUniforms>(
+              std::max(building_uniforms.size(), capacity * 2),
+              Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
+          building_object_buffer->UpdateData(
+              std::span<ObjectUniforms const>(building_uniforms));
+        } else {
+          building_object_buffer->UpdateData(building_uniforms[slot], slot);
+        }
+
+        building_culler->AddObject(PackAABB(change.center - object_space_offset,
+                                            change.half_extents, 0, slot));
+        building_occluded.push_back(0);
+        break;
+      }
+      case WorldChange::moved: {
+        building_object_buffer->UpdateData(building_uniforms[slot], slot);
+        uint32_t flags = building_occluded[change.dense_index]
+                             ? Albuquerque::gpu_cull_hidden
+                             : 0;
+        building_culler->UpdateObject(
+            change.dense_index,
+            PackAABB(change.center - object_space_offset, change.half_extents,
+                     0, slot, flags));
+        break;
+      }
+      case WorldChange::removed: {
+        // Nothing points at the slot anymore so its uniforms can stay. Same
+        // swap remove as the world store, so dense indices keep matching
+        building_culler->RemoveObject(change.dense_index);
+        building_occluded[change.dense_index] = building_occluded.back();
+        building_occluded.pop_back();
+        break;
+      }
+    }
+  }
+}
+
+glm::mat4 ProjectApplication::ObjectViewProj(
+    glm::mat4 const& view_proj) const {
+  return glm::translate(view_proj, object_space_offset);
+}
+
+void ProjectApplication::RebaseOrigin(glm::vec3 shift) {
+  ALBUQUERQUE_PROFILE_CPU("Rebase Origin");
+  auto start = std::chrono::steady_clock::now();
+
+  aircraftPos -= shift;
+  aircraftPos_previous -= shift;
+  aircraft_box_collider.center -= shift;
+  aircraft_sphere_collider.center -= shift;
+
+  gameplayCamera.position -= shift;
+  gameplayCamera.target -= shift;
+  editorCamera.position -= shift;
+  editorCamera.target -= shift;
+
+  world_store.Translate(-shift);
+  level_editor.Translate(-shift);
+  audio.Translate(-shift);
+
+  glm::vec4 translation(shift, 0.0f);
+  for (checkpointObject& checkpoint : checkpoint_render_state) {
+    checkpoint.model[3] -= translation;
+  }
+
+  // The object buffers and culling objects stay where they are and get drawn
+  // through a view projection moved by the offset instead, so nothing is
+  // uploaded. Only once they've drifted far enough from the origin to lose
+  // precision do they get refilled, which puts the offset back in
+  object_space_offset -= shift;
+  if (glm::length(object_space_offset) >
+      max_object_space_offset_rebases * floating_origin.RebaseDistance()) {
+    cull_objects_dirty = true;
+  }
+  // Last frame's depth is from before the jump
+  hiz_pyramid->Invalidate();
+
+  last_rebase_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+}
+
+void ProjectApplication::UpdateSoftwareOcclusion() {
+  ALBUQUERQUE_PROFILE_CPU("Software Occlusion");
+  using Albuquerque::GpuCulling::IsVisible;
+  using Albuquerque::GpuCulling::PackAABB;
+  using Albuquerque::GpuCulling::PackSphere;
+
+  auto const planes =
+      Albuquerque::GpuCulling::ExtractFrustumPlanes(globalStruct.viewProj);
+  AABBColliders const& buildings = world_store.buildings;
+  SphereColliders const& collectables = world_store.collectables;
+
+  software_occlusion.Begin(globalStruct.viewProj);
+  for (uint32_t i = 0; i < buildings.Size(); ++i) {
+    if (IsVisible(planes, PackAABB(buildings.Center(i),
+                                   buildings.HalfExtents(i), 0, i))) {
+      software_occlusion.AddOccluder(buildings.Center(i),
+                                     buildings.HalfExtents(i));
+    }
+  }
+  software_occlusion.Finish();
+
+  // Same counts the cull shader keeps, so the stats window reads the same
+  auto classify = [&](Albuquerque::GpuCullObject const& object,
+                      Albuquerque::GpuCuller::Stats& stats) {
+    if (!IsVisible(planes, object)) {
+      stats.frustum_culled += 1;
+      return false;
+    }
+    if (software_occlusion.IsOccluded(object)) {
+      stats.occlusion_culled += 1;
+      return true;
+    }
+    stats.visible += 1;
+    return false;
+  };
+
+  building_software_stats = {};
+  for (uint32_t i = 0; i < buildings.Size(); ++i) {
+    bool occluded = classify(
+        PackAABB(buildings.Center(i), buildings.HalfExtents(i), 0, i),
+        building_software_stats);
+    if (occluded != static_cast<bool>(building_occluded[i])) {
+      building_occluded[i] = occluded;
+      building_culler->SetHidden(i, occluded);
+    }
+  }
+
+  collectable_software_stats = {};
+  for (uint32_t i = 0; i < collectables.Size(); ++i) {
+    bool occluded = classify(
+        PackSphere(collectables.Center(i), collectables.radius[i], 0, i),
+        collectable_software_stats);
+    if (occluded != static_cast<bool>(collectable_occluded[i])) {
+      collectable_occluded[i] = occluded;
+      collectable_culler->SetHidden(i, occluded);
+    }
+  }
+}
+
+void ProjectApplication::StartEngineSound() {
+  if (plane_flying_voice.IsValid()) return;
+
+  Albuquerque::AudioPlayParams engine;
+  engine.gain = 0.4f;
+  engine.priority = 200;
+  engine.loop = true;
+  engine.spatial = true;
+  engine.position = aircraftPos;
+  // The camera trails 25 units behind, keep it at full volume from there
+  engine.min_distance = 40.0f;
+  plane_flying_voice = audio.Play(plane_flying_sfx, engine);
+}
+
+void ProjectApplication::StopEngineSound() {
+  audio.Stop(plane_flying_voice);
+  plane_flying_voice = {};
+}
+
+void ProjectApplication::PlayPickupSound(glm::vec3 position) {
+  // Each pickup gets its own voice, grabbing a few at once no longer cuts the
+  // earlier ones off
+  Albuquerque::AudioPlayParams pickup;
+  pickup.gain = 0.75f;
+  pickup.spatial = true;
+  pickup.position = position;
+  pickup.min_distance = 40.0f;
+  audio.Play(pickup_sfx, pickup);
+}
+
+void ProjectApplication::SetBackgroundMusic(Albuquerque::AudioMusicId music)
 {
-    //I hate that this is a global lets fix it in the refactor
-    if (curr_background_music_ptr != nullptr)
+    // Crossfades, the old track pauses where it is once it's faded out
+    if (current_music != music || is_background_music_muted)
     {
-        ma_sound_stop(curr_background_music_ptr);
+        audio.StopMusic(current_music, music_fade_seconds);
     }
 
-    curr_background_music_ptr = &bgm;
+    current_music = music;
     if (!is_background_music_muted) {
-        ma_sound_start(curr_background_music_ptr);
+        audio.PlayMusic(current_music, music_fade_seconds);
     }
 }
 
 void ProjectApplication::MuteBackgroundMusicToggle(bool set_muted) {
   is_background_music_muted = set_muted;
   if (curr_game_state == game_states::level_editor)
-    SetBackgroundMusic(level_editor_music_ma);
+    SetBackgroundMusic(level_editor_music);
   else {
-    SetBackgroundMusic(background_music_ma);
+    SetBackgroundMusic(background_music);
   }
 }
 
@@ -944,58 +1041,45 @@ bool ProjectApplication::Load() {
         aircraft_min_speed = std::stof(buffer);
     }
 
-    //iniitalize miniaudio
-    ma_result ma_res;
-    ma_res = ma_engine_init(NULL, &miniAudioEngine);
-    if (ma_res != MA_SUCCESS) {
-        return -1;
+    fixed_timestep.SetTickRate(physics_tick_rate);
+    fixed_timestep.SetMaxStepsPerFrame(physics_max_steps_per_frame);
+    if (configInstance.GetDataString("PhysicsTickRate", buffer))
+    {
+        fixed_timestep.SetTickRate(std::stod(buffer));
     }
 
-    //ma_engine_play_sound(&miniAudioEngine, "data/sounds/start.wav", NULL);
-
   // Initialize SoLoud (automatic back-end selection)
 
 
-  ma_res = ma_sound_init_from_file(&miniAudioEngine, "data/sounds/start.wav", 0, NULL, NULL, &plane_crash_sfx_ma);
-  if (ma_res != MA_SUCCESS) {
-      return ma_res;
+  // Headless runs still mix, on the null backend, so they cost the same
+  Albuquerque::AudioSettings audio_settings;
+  audio_settings.null_backend = IsHeadless();
+  if (!audio.Initialize(audio_settings)) {
+      return false;
   }
-  ma_sound_set_volume(&plane_crash_sfx_ma, 0.75);
-
-  
-  ma_res = ma_sound_init_from_file(&miniAudioEngine, "data/sounds/planeflying.wav", 0, NULL, NULL, &plane_flying_sfx_ma);
-  if (ma_res != MA_SUCCESS) {
-      return ma_res;
-  }
-  ma_sound_set_volume(&plane_flying_sfx_ma, 0.40);
-  ma_sound_set_looping(&plane_flying_sfx_ma, true);
-  ma_sound_start(&plane_flying_sfx_ma);
-
-  //res = plane_flying_sfx.load("data/sounds/planeFlying.wav");
-  //plane_speedup_sfx.load("data/sounds/planeFlying.wav");
 
-  ma_res = ma_sound_init_from_file(&miniAudioEngine, "data/sounds/backgroundMusic.wav", 0, NULL, NULL, &background_music_ma);
-  if (ma_res != MA_SUCCESS) {
-      return ma_res;
-  }
-  ma_sound_set_volume(&background_music_ma, 0.30);
-
-  //background_music.load("data/sounds/backgroundMusic.wav");
-  //background_music.setVolume(0.30);
-
-  ma_res = ma_sound_init_from_file(&miniAudioEngine, "data/sounds/levelEditorMusic.wav", 0, NULL, NULL, &level_editor_music_ma);
-  if (ma_res != MA_SUCCESS) {
-      return ma_res;
-  }
-  ma_sound_set_volume(&level_editor_music_ma, 0.70);
-
-  
-  ma_res = ma_sound_init_from_file(&miniAudioEngine, "data/sounds/collectablePlaceholderSound.wav", 0, NULL, NULL, &plane_collectable_pickup_sfx_ma);
-  if (ma_res != MA_SUCCESS) {
-      return ma_res;
-  }
-
-  ma_sound_set_volume(&plane_crash_sfx_ma, 0.75);
+  // A missing clip only means that sound doesn't play, Play skips invalid
+  // clips, so the game (and headless runs) still start without it
+  auto load_sfx = [&](char const* file_path) {
+    Albuquerque::AudioClipId clip = audio.LoadClip(file_path);
+    if (clip == Albuquerque::invalid_audio_clip) {
+      spdlog::warn("Couldn't load sound {}, playing without it", file_path);
+    }
+    return clip;
+  };
+  plane_crash_sfx = load_sfx("data/sounds/start.wav");
+  plane_flying_sfx = load_sfx("data/sounds/planeflying.wav");
+  pickup_sfx = load_sfx("data/sounds/collectablePlaceholderSound.wav");
+
+  // Streamed, only the headers are read here. A missing track just means no
+  // music
+  Albuquerque::AudioMusicParams music_params;
+  music_params.gain = 0.30f;
+  background_music = audio.OpenMusic(
+      FindMusicFile("data/sounds/backgroundMusic"), music_params);
+  music_params.gain = 0.70f;
+  level_editor_music = audio.OpenMusic(
+      FindMusicFile("data/sounds/levelEditorMusic"), music_params);
 
   //Initalized camera
 
@@ -1007,9 +1091,11 @@ bool ProjectApplication::Load() {
   pipeline_lines = CreatePipelineLines();
   pipeline_textured = CreatePipelineTextured();
   pipeline_colored_indexed = CreatePipelineColoredIndex();
+  pipeline_pick_ids = CreatePipelineColoredIndex(frag_pick_id_shader_path);
+  pipeline_pick_terrain = CreatePipelineTextured(frag_pick_occluder_shader_path);
 
+  use_software_occlusion = IsHeadless();
   LoadBuffers();
-  CreateGroundChunks();
   CreateSkybox();
 
   // LoadCollectables();
@@ -1018,7 +1104,7 @@ bool ProjectApplication::Load() {
   // Play sfx
 
 
-  SetBackgroundMusic(background_music_ma);
+  SetBackgroundMusic(background_music);
 
   // soloud.play(background_music);
 
@@ -1034,19 +1120,29 @@ bool ProjectApplication::Load() {
 }
 
 void ProjectApplication::ResetLevel() {
-  collectableList.clear();
-  buildingObjectList.clear();
-  checkpointList.clear();
+  // The camera jumps back to the start, last frame's depth means nothing there
+  hiz_pyramid->Invalidate();
+  world_store.Clear();
+  level_editor.Clear();
+  editor_selected = {};
+  collectable_uniforms.clear();
+  checkpoint_route.clear();
 
   StartLevel();
 }
 
 void ProjectApplication::StartLevel() {
 
-  //When a sound is stopped, it is not rewound to the start -> https://miniaud.io/docs/manual/index.html
-  ma_sound_seek_to_pcm_frame(&plane_crash_sfx_ma, 0);
-  ma_sound_stop(&plane_crash_sfx_ma);
-  ma_sound_start(&plane_flying_sfx_ma);
+  audio.StopAll();
+  plane_flying_voice = {};
+  StartEngineSound();
+
+  // The level files are in world coordinates, anything left over gets moved
+  // back there before they are loaded
+  if (floating_origin.Origin() != glm::dvec3(0.0)) {
+    RebaseOrigin(floating_origin.ToLocal(glm::dvec3(0.0)));
+    floating_origin.Reset();
+  }
 
   LoadBuildings();
 
@@ -1061,6 +1157,10 @@ void ProjectApplication::StartLevel() {
   aircraft_body =
       PhysicsBody{aircraft_starting_speed, aircraft_starting_direction_vector};
 
+  // Nothing to interpolate from after a teleport
+  aircraftPos_previous = aircraftPos;
+  aircraft_rotation_previous = aircraft_body.rotMatrix;
+
   ObjectUniforms aircraftUniform;
   aircraftUniform.model = glm::mat4(1.0f);
   aircraftUniform.model = glm::translate(aircraftUniform.model, aircraftPos);
@@ -1073,7 +1173,7 @@ void ProjectApplication::StartLevel() {
   aircraft_sphere_collider.center = aircraftPos;
 
   aircraftUniform.color = aircraftColor;
-  objectBufferaircraft.value().UpdateData(aircraftUniform, 0);
+  aircraft_uniforms = aircraftUniform;
 
   SetMouseCursorDisabled(true);
   current_player_level_time = 0.0f;
@@ -1161,8 +1261,19 @@ void ProjectApplication::UpdateEditorCamera(double dt) {
                                                       editor_camera_speed_scale;
     }
 
-    if (IsMouseKeyPressed(GLFW_MOUSE_BUTTON_1)) {
-      MouseRaycast(editorCamera);
+    // Clicks on the editor windows shouldn't select what's behind them, and
+    // neither should a replay's. The pick lands in RenderMousePick a frame or
+    // so later
+    static bool wasMousePressed_Pick = false;
+    if (!wasMousePressed_Pick && IsMouseKeyPressed(GLFW_MOUSE_BUTTON_1) &&
+        !ImGui::GetIO().WantCaptureMouse && !IsReplaying()) {
+      wasMousePressed_Pick = true;
+      double mouse_x, mouse_y;
+      GetMousePosition(mouse_x, mouse_y);
+      mouse_picker->Request(glm::vec2(mouse_x, mouse_y));
+    } else if (wasMousePressed_Pick &&
+               IsMouseKeyReleased(GLFW_MOUSE_BUTTON_1)) {
+      wasMousePressed_Pick = false;
     }
 
     // To Do: Make this cneter of the screen
@@ -1235,6 +1346,29 @@ void ProjectApplication::UpdateEditorCamera(double dt) {
   }
 }
 
+void ProjectApplication::UpdateScriptedCamera(uint32_t frame_index,
+                                              double time) {
+  // Headless runs fly the editor camera in a circle around the level instead
+  // of the aircraft, so there is no physics or input involved in what ends up
+  // on screen. Setting both states skips the editor transition in Update which
+  // would copy over the gameplay camera.
+  curr_game_state = game_states::level_editor;
+  prev_game_state = game_states::level_editor;
+
+  static constexpr float orbit_radius = 150.0f;
+  static constexpr float orbit_height = 60.0f;
+  static constexpr float orbit_speed = 0.25f;
+
+  float angle = static_cast<float>(time) * orbit_speed;
+  editorCamera.position = glm::vec3(orbit_radius * cos(angle), orbit_height,
+                                    orbit_radius * sin(angle));
+  editorCamera.target = glm::vec3(0.0f, 0.0f, 0.0f);
+  editorCamera.forward =
+      glm::normalize(editorCamera.target - editorCamera.position);
+  editorCamera.right = glm::normalize(glm::cross(editorCamera.forward, worldUp));
+  editorCamera.up = glm::cross(editorCamera.right, editorCamera.forward);
+}
+
 float ProjectApplication::lerp(float start, float end, float t) {
   return start + (end - start) * t;
 }
@@ -1254,8 +1388,11 @@ void ProjectApplication::Update(double dt) {
   // Change of state
   if (prev_game_state != curr_game_state) {
     if (curr_game_state == game_states::game_over) {
-      ma_sound_start(&plane_crash_sfx_ma);
-      ma_sound_stop(&plane_flying_sfx_ma);
+      Albuquerque::AudioPlayParams crash;
+      crash.gain = 0.75f;
+      crash.priority = 255;
+      audio.Play(plane_crash_sfx, crash);
+      StopEngineSound();
 
       render_plane = false;
     } else if (curr_game_state == game_states::playing) {
@@ -1263,8 +1400,8 @@ void ProjectApplication::Update(double dt) {
         ResetLevel();
       }
     } else if (curr_game_state == game_states::level_editor) {
-      ma_sound_stop(&plane_flying_sfx_ma);
-      SetBackgroundMusic(level_editor_music_ma);
+      StopEngineSound();
+      SetBackgroundMusic(level_editor_music);
 
       editorCamera = gameplayCamera;
 
@@ -1321,12 +1458,16 @@ void ProjectApplication::Update(double dt) {
 
   if (curr_game_state == game_states::level_editor) {
     UpdateEditorCamera(dt);
+    UpdateLevelEditorInput();
 
     // Camera logic stuff
     ZoneScopedC(tracy::Color::Blue);
 
     glm::mat4 view = glm::lookAt(editorCamera.position, editorCamera.target,
                                  editorCamera.up);
+    audio.SetListener(editorCamera.position,
+                      editorCamera.target - editorCamera.position,
+                      editorCamera.up);
     glm::mat4 proj =
         glm::perspective((base_fov_radians), 1.6f, nearPlane, farPlane);
     glm::mat4 viewProj = proj * view;
@@ -1334,19 +1475,17 @@ void ProjectApplication::Update(double dt) {
     globalStruct.viewProj = viewProj;
     globalStruct.eyePos = editorCamera.position;
 
-    globalUniformsBuffer.value().UpdateData(globalStruct, 0);
-
     glm::mat4 view_rot_only = glm::mat4(glm::mat3(view));
-    globalStruct.viewProj = proj * view_rot_only;
-    globalUniformsBuffer_skybox.value().UpdateData(globalStruct, 0);
+    globalStruct_skybox = globalStruct;
+    globalStruct_skybox.viewProj = proj * view_rot_only;
 
     static bool wasKeyPressed_Gameplay = false;
     if (!wasKeyPressed_Editor && IsKeyPressed(GLFW_KEY_2)) {
       wasKeyPressed_Editor = true;
       curr_game_state = game_states::playing;
-      SetBackgroundMusic(background_music_ma);
+      SetBackgroundMusic(background_music);
 
-      ma_sound_start(&plane_flying_sfx_ma);
+      StartEngineSound();
 
 
       SetMouseCursorDisabled(true);
@@ -1356,13 +1495,121 @@ void ProjectApplication::Update(double dt) {
   }
 
   if (curr_game_state == game_states::playing) {
+    // Physics and collision are in FixedUpdate. This only places the aircraft
+    // between the last two fixed states so it moves smoothly at any framerate
+    float alpha = GetInterpolationAlpha();
+    glm::vec3 render_position =
+        glm::mix(aircraftPos_previous, aircraftPos, alpha);
+    glm::mat4 render_rotation = glm::mat4_cast(
+        glm::slerp(glm::quat_cast(aircraft_rotation_previous),
+                   glm::quat_cast(aircraft_body.rotMatrix), alpha));
+
+    glm::vec3 render_forward =
+        glm::vec3(render_rotation * glm::vec4(worldForward, 1.0f));
+    glm::vec3 render_up = glm::vec3(render_rotation * glm::vec4(worldUp, 1.0f));
+
+    float zoom_speed_level =
+        min_zoom_level_scale +
+        (max_zoom_level_scale - min_zoom_level_scale) *
+            (aircraft_body.current_speed / aircraft_max_speed);
+
+    if (IsKeyPressed(GLFW_KEY_SPACE)) {
+      zoom_speed_level = 1.02f;
+    }
+
+    audio.SetGain(plane_flying_voice,
+                  aircraft_body.current_speed / aircraft_max_speed);
+    audio.SetPosition(plane_flying_voice, render_position);
+
+    if (draw_player_colliders) {
+      debug_draw->Sphere(aircraft_sphere_collider.center,
+                         aircraft_sphere_collider.radius,
+                         glm::vec3(1.0f, 0.0, 0.0f));
+    }
+
+    if (draw_collectable_colliders) {
+      SphereColliders const& collectables = world_store.collectables;
+      for (uint32_t i = 0; i < collectables.Size(); ++i) {
+        debug_draw->Sphere(collectables.Center(i), collectables.radius[i],
+                           glm::vec3(1.0f, 0.0, 0.0f));
+      }
+    }
+
+    if (draw_building_colliders) {
+      AABBColliders const& buildings = world_store.buildings;
+      for (uint32_t i = 0; i < buildings.Size(); ++i) {
+        debug_draw->Box(buildings.Center(i), buildings.HalfExtents(i),
+                        glm::vec3(0.0f, 1.0f, 0.0f));
+      }
+    }
+
+    {
+      // aircraft uniform buffer changes
+      ZoneScopedC(tracy::Color::Orange);
+      glm::mat4 model(1.0f);
+      glm::mat4 propModel(1.0f);
+
+      model = glm::translate(model, render_position);
+      propModel = glm::translate(propModel, render_position);
+      propModel = glm::rotate(
+          propModel, glm::radians(aircraft_body.propeller_angle_degrees),
+          render_forward);
+
+      propModel *= render_rotation;
+      model *= render_rotation;
+
+      aircraft_uniforms =
+          ObjectUniforms(model, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+      propeller_uniforms =
+          ObjectUniforms(propModel, glm::vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    }
+
+    {
+      // Camera logic stuff
+      ZoneScopedC(tracy::Color::Blue);
+
+      gameplayCamera.position =
+          (render_position - render_forward * 25.0f) + render_up * 10.0f;
+      gameplayCamera.target = render_position + (render_up * 10.0f);
+      gameplayCamera.up = render_up;
+
+      glm::mat4 view = glm::lookAt(gameplayCamera.position,
+                                   gameplayCamera.target, gameplayCamera.up);
+      glm::mat4 view_rot_only = glm::mat4(glm::mat3(view));
+
+      // we dont actually have to recalculate this every frame yet but we
+      // might wanna adjust fov i guess
+      glm::mat4 proj = glm::perspective((base_fov_radians)*zoom_speed_level,
+                                        1.6f, nearPlane, farPlane);
+      glm::mat4 viewProj = proj * view;
+
+      globalStruct.viewProj = viewProj;
+      globalStruct.eyePos = gameplayCamera.position;
+
+      audio.SetListener(gameplayCamera.position,
+                        gameplayCamera.target - gameplayCamera.position,
+                        gameplayCamera.up);
+
+      globalStruct_skybox = globalStruct;
+      globalStruct_skybox.viewProj = proj * view_rot_only;
+    }
+  }
+}
+
+// Runs at the fixed tick rate so the flight and the collision checks do not
+// depend on the framerate
+void ProjectApplication::FixedUpdate(double dt) {
+  if (curr_game_state == game_states::playing) {
+    if (std::optional<glm::vec3> shift = floating_origin.Update(aircraftPos)) {
+      RebaseOrigin(*shift);
+    }
+
+    aircraftPos_previous = aircraftPos;
+    aircraft_rotation_previous = aircraft_body.rotMatrix;
+
     {
       // aircraft Inputs
       float dt_float = static_cast<float>(dt);
-      float zoom_speed_level =
-          min_zoom_level_scale +
-          (max_zoom_level_scale - min_zoom_level_scale) *
-              (aircraft_body.current_speed / aircraft_max_speed);
 
       aircraft_current_speed_scale = 1.0f;
       {
@@ -1398,14 +1645,8 @@ void ProjectApplication::Update(double dt) {
             aircraft_body.rotMatrix * glm::vec4(aircraft_body.up_vector, 1.0f));
 
 
-        ma_sound_set_volume(&plane_flying_sfx_ma, 1 * (aircraft_body.current_speed / aircraft_max_speed));
-       /* soloud.setVolume(
-            plane_flying_sfx_handle,
-            1.0 * (aircraft_body.current_speed / aircraft_max_speed));*/
-
         if (IsKeyPressed(GLFW_KEY_SPACE)) {
           aircraft_current_speed_scale = aircraft_speedup_scale;
-          zoom_speed_level = 1.02f;
 
           //soloud.setVolume(plane_flying_sfx_handle, 0.80);
         }
@@ -1502,120 +1743,70 @@ void ProjectApplication::Update(double dt) {
                        aircraft_current_speed_scale * dt_float;
 
         Collision::SyncSphere(aircraft_sphere_collider, aircraftPos);
-
-        if (draw_player_colliders) {
-          DrawLineSphere(aircraft_sphere_collider, glm::vec3(1.0f, 0.0, 0.0f));
-        }
-      }
-
-      {
-        // aircraft uniform buffer changes
-        ZoneScopedC(tracy::Color::Orange);
-        glm::mat4 model(1.0f);
-        glm::mat4 propModel(1.0f);
-
-        model = glm::translate(model, aircraftPos);
-        propModel = glm::translate(propModel, aircraftPos);
-        propModel = glm::rotate(
-            propModel, glm::radians(aircraft_body.propeller_angle_degrees),
-            aircraft_body.forward_vector);
-
-        propModel *= aircraft_body.rotMatrix;
-        model *= aircraft_body.rotMatrix;
-
-        ObjectUniforms a(model, glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
-        objectBufferaircraft.value().UpdateData(a, 0);
-
-        a.model = propModel;
-        a.color = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
-
-        object_buffer_propeller.value().UpdateData(a, 0);
-      }
-
-      {
-        // Camera logic stuff
-        ZoneScopedC(tracy::Color::Blue);
-
-        gameplayCamera.position =
-            (aircraftPos - aircraft_body.forward_vector * 25.0f) +
-            aircraft_body.up_vector * 10.0f;
-        gameplayCamera.target = aircraftPos + (aircraft_body.up_vector * 10.0f);
-        gameplayCamera.up = aircraft_body.up_vector;
-
-        glm::mat4 view = glm::lookAt(gameplayCamera.position,
-                                     gameplayCamera.target, gameplayCamera.up);
-        glm::mat4 view_rot_only = glm::mat4(glm::mat3(view));
-
-        // we dont actually have to recalculate this every frame yet but we
-        // might wanna adjust fov i guess
-        glm::mat4 proj = glm::perspective((base_fov_radians)*zoom_speed_level,
-                                          1.6f, nearPlane, farPlane);
-        glm::mat4 viewProj = proj * view;
-
-        globalStruct.viewProj = proj * view_rot_only;
-        globalUniformsBuffer_skybox.value().UpdateData(globalStruct, 0);
-
-        globalStruct.viewProj = viewProj;
-        globalStruct.eyePos = gameplayCamera.position;
-
-        globalUniformsBuffer.value().UpdateData(globalStruct, 0);
       }
     }
 
     if (!all_checkpoints_collected) current_player_level_time += dt;
 
-    // Collision Checks with collectable
-    for (size_t i = 0; i < collectableList.size(); ++i) {
-      auto& collectable = collectableList[i];
-
-      if (collectable.isCollected) {
-        continue;
-      }
-
-      if (draw_collectable_colliders) {
-        DrawLineSphere(collectable.collider, glm::vec3(1.0f, 0.0, 0.0f));
-      }
+    ALBUQUERQUE_PROFILE_CPU("Collision");
+
+    // Everything is swept along this tick's move so at boost speed the
+    // aircraft can't skip through something between two ticks
+    glm::vec3 sweep_start = aircraftPos_previous;
+    glm::vec3 sweep_end = aircraftPos;
+    float aircraft_radius = aircraft_sphere_collider.radius;
+
+    // Buildings first, nothing past the crash gets collected
+    float time_of_impact;
+    if (world_store.buildings.Sweep(sweep_start, sweep_end, aircraft_radius,
+                                    &time_of_impact) >= 0) {
+      sweep_end = glm::mix(sweep_start, sweep_end, time_of_impact);
+      aircraftPos = sweep_end;
+      Collision::SyncSphere(aircraft_sphere_collider, aircraftPos);
+      curr_game_state = game_states::game_over;
+    }
 
-      if (Collision::sphereCollisionCheck(aircraft_sphere_collider,
-                                          collectable.collider)) {
-        
-        ma_sound_seek_to_pcm_frame(&plane_collectable_pickup_sfx_ma, 0);
-        ma_sound_start(&plane_collectable_pickup_sfx_ma);
-        collectable.isCollected = true;
-
-        // Because we use instancing. Decided to simply change the scale to set
-        // it to not render. Maybe there is a better way?
-        ObjectUniforms temp;
-        temp.model = glm::scale(temp.model, glm::vec3(0.0f, 0.0f, 0.0f));
-        collectableObjectBuffers.value().UpdateData(temp,
-                                                 sizeof(ObjectUniforms) * i);
+    // Collision Checks with collectable. Collected ones are removed from the
+    // store, so the sweep only goes through the ones left and this only
+    // loops again if two were picked up in the same tick
+    SphereColliders& collectables = world_store.collectables;
+    int32_t i;
+    while ((i = collectables.Sweep(sweep_start, sweep_end, aircraft_radius)) >=
+           0) {
+      PlayPickupSound(collectables.Center(i));
+      collectables.Remove(collectables.slots.Handle(i));
+
+      // Same swap remove as the store so the dense indices keep matching,
+      // and only the live ones are culled and drawn. Its uniforms can stay,
+      // nothing points at the slot anymore. A pending rebuild redoes all of
+      // this from the store anyway
+      if (!cull_objects_dirty) {
+        collectable_culler->RemoveObject(i);
+        collectable_occluded[i] = collectable_occluded.back();
+        collectable_occluded.pop_back();
       }
     }
 
-    // Collision check with checkpoint (only need to check the next active one!)
-    if (!all_checkpoints_collected && !checkpointList.empty() &&
-        Collision::sphereCollisionCheck(
-            checkpointList[curr_active_checkpoint].collider,
-            aircraft_sphere_collider)) {
-      checkpointList[curr_active_checkpoint].color =
-          checkpointObject::non_activated_color_linear;
-      checkpointList[curr_active_checkpoint].activated = false;
-
-      ma_sound_seek_to_pcm_frame(&plane_collectable_pickup_sfx_ma, 0);
-      ma_sound_start(&plane_collectable_pickup_sfx_ma);
-
-      if (curr_active_checkpoint + 1 != checkpointList.size()) {
+    // Collision check with checkpoint (only need to check the next active
+    // one!). Grown by the aircraft's radius it's the path of its centre
+    // against the ring, and a fast tick can go through more than one
+    auto passes_checkpoint = [&]() {
+      Collision::Sphere checkpoint = CheckpointCollider(curr_active_checkpoint);
+      checkpoint.radius += aircraft_radius;
+      return Collision::SegmentSphereCheck(sweep_start, sweep_end, checkpoint);
+    };
+    while (!all_checkpoints_collected && !checkpoint_route.empty() &&
+           passes_checkpoint()) {
+      checkpoint_render_state[checkpoint_route[curr_active_checkpoint].index]
+          .color = checkpointObject::non_activated_color_linear;
+
+      PlayPickupSound(CheckpointCollider(curr_active_checkpoint).center);
+
+      if (curr_active_checkpoint + 1 != checkpoint_route.size()) {
         curr_active_checkpoint += 1;
-        checkpointList[curr_active_checkpoint].color =
-            checkpointObject::activated_color_linear;
-
-        ObjectUniforms uniform;
-        uniform.model = checkpointList[curr_active_checkpoint].model;
-        uniform.color =
-            glm::vec4(checkpointList[curr_active_checkpoint].color, 1.0f);
-        checkpointList[curr_active_checkpoint].object_buffer.value().UpdateData(
-            uniform, 0);
-        // checkpointList[curr_active_checkpoint].activated = true;
+        checkpointObject& next_checkpoint =
+            checkpoint_render_state[checkpoint_route[curr_active_checkpoint].index];
+        next_checkpoint.color = checkpointObject::activated_color_linear;
       } else {
         all_checkpoints_collected = true;
         std::cout
@@ -1637,124 +1828,265 @@ void ProjectApplication::Update(double dt) {
       }
     }
 
-    // Collision checks with buildings
-    for (auto const& building : buildingObjectList) {
-      if (Collision::SphereAABBCollisionCheck(aircraft_sphere_collider,
-                                              building.building_collider)) {
-        curr_game_state = game_states::game_over;
-        break;
-      }
-    }
-
     // Check if crashed with the ground
-    if (aircraftPos.y < 0.0f) {
+    glm::dvec3 aircraft_world = floating_origin.ToWorld(aircraftPos);
+    if (aircraftPos.y < terrain->HeightAt(aircraft_world.x, aircraft_world.z)) {
       curr_game_state = game_states::game_over;
     }
   }
 }
 
-void ProjectApplication::MouseRaycast(camera const& cam) {
-  ZoneScopedC(tracy::Color::Purple2);
-
-  glm::mat4 proj = glm::perspective((PI / 2.0f), 1.6f, nearPlane, farPlane);
-  glm::mat4 view = glm::lookAt(cam.position, cam.target, cam.up);
-  // https://antongerdelan.net/opengl/raycasting.html
-
-  // Viewport Coordinate
-  static double mouseX = windowWidth / 2;
-  static double mouseY = windowHeight / 2;
-  GetMousePosition(mouseX, mouseY);
-
-  // NDC Coordinate
-  float x = (2.0f * mouseX) / windowWidth - 1.0f;
-  float y = 1.0f - (2.0f * mouseY) / windowHeight;
-  float z = 1.0f;
-  glm::vec3 ray_nds = glm::vec3(x, y, z);
-
-  // Homogenous Clip Coordinates
-  glm::vec4 ray_clip = glm::vec4(ray_nds.x, ray_nds.y, -1.0, 1.0);
-
-  // View Space Coordinates
-  glm::vec4 ray_eye = inverse(proj) * ray_clip;
-
-  ray_eye = glm::vec4(ray_eye.x, ray_eye.y, -1.0, 0.0);
-
-  // World Coordinates
-  glm::vec4 ray_wor = (inverse(view) * ray_eye);
-  glm::vec3 ray_world_vec3 = glm::vec3(ray_wor.x, ray_wor.y, ray_wor.z);
-  ray_world_vec3 = glm::normalize(ray_world_vec3);
-
-  constexpr float debug_mouse_click_length = 5000.0f;
-
-  // std::vector<buildingObject*> accepted_colliders;
-
-  // for (auto& buillding : buildingObjectList)
-  //{
-  //	//To Do: Rewrite the raycast logic (it should check every collider it
-  //passes for every step so it can do early rejections) 	if
-  //(Collision::RaycastCheck(cam.position, ray_world_vec3,
-  //buillding.building_collider))
-  //	{
-  //		accepted_colliders.push_back(&buillding);
-  //		break;
-  //	}
-  // }
-
-  // if (accepted_colliders.empty())
-  //	return;
-
-  // std::sort<buildingObject*>(accepted_colliders.front(),
-  // accepted_colliders.back(), [&](auto const& lhs, auto const& rhs)
-  //{
-  //		glm::vec3 lhs_vec = (lhs.building_center - cam.position);
-  //		glm::vec3 rhs_vec = (rhs.building_center - cam.position);
-  //		float dist_lhs = glm::dot(lhs_vec, lhs_vec);
-  //		float dist_rhs = glm::dot(rhs_vec, rhs_vec);
-  //		return dist_lhs < dist_rhs;
-  // });
-
-  buildingObject* building_hit =
-      RaycastCheck(cam.position, ray_world_vec3, buildingObjectList);
-  if (building_hit == nullptr) return;
-
-
-  building_hit->drawcall.SetColor(glm::vec4(0.0f, 1.0f, 0.0f, 0));
-
-  // Yea we should create a function for this
-  // 
-  // 
-  //ObjectUniforms temp;
-  //glm::mat4 model(1.0f);
-  //model = glm::translate(model, building_hit->building_center);
-  //model = glm::scale(model, building_hit->building_scale);
-  //temp.color = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
-  //temp.model = model;
-  //building_hit->object_buffer.value().UpdateData(temp, 0);
-
-  // AddDebugDrawLine(cam.position, cam.position + ray_world_vec3 *
-  // debug_mouse_click_length, glm::vec3(0.0f, 0.0f, 1.0f));
+void ProjectApplication::SelectBuilding(WorldHandle handle) {
+  if (handle == editor_selected) return;
+
+  // One the editor added this frame has no uniforms yet,
+  // ApplyEditorChanges colours it
+  auto set_color = [&](WorldHandle building, glm::vec3 color) {
+    if (!world_store.buildings.slots.Contains(building) ||
+        building.index >= building_uniforms.size() ||
+        building.index >=
+            building_object_buffer->Size() / sizeof(ObjectUniforms))
+      return;
+    building_uniforms[building.index].color = glm::vec4(color, 1.0f);
+    building_object_buffer->UpdateData(building_uniforms[building.index],
+                                       building.index);
+  };
+  set_color(editor_selected, default_building_color);
+  editor_selected = handle;
+  set_color(editor_selected, selected_building_color);
 }
 
-void ProjectApplication::RenderScene(double dt) {
-  // RenderMousePick();
+void ProjectApplication::DrawCulledObjects(
+    Albuquerque::UniformRing& frame_uniforms, bool pick_ids) {
+  auto bind_pick_kind = [&](pick_kinds kind) {
+    if (pick_ids) {
+      Albuquerque::UniformRing::BindUniform(
+          3, frame_uniforms.Push(
+                 PickUniforms{.kind = static_cast<uint32_t>(kind)}));
+    }
+  };
 
+  bind_pick_kind(pick_kinds::building);
+  Fwog::Cmd::BindStorageBuffer(1, building_object_buffer.value());
+  Fwog::Cmd::BindVertexBuffer(0, building_vertex_buffer.value(), 0,
+                              sizeof(Utility::Vertex));
+  Fwog::Cmd::BindIndexBuffer(building_index_buffer.value(),
+                             Fwog::IndexType::UNSIGNED_INT);
+  building_culler->Draw();
+
+  bind_pick_kind(pick_kinds::collectable);
+  Fwog::Cmd::BindStorageBuffer(1, collectableObjectBuffers.value());
+  Fwog::Cmd::BindVertexBuffer(0, scene_collectable.meshes[0].vertexBuffer, 0,
+                              sizeof(Utility::Vertex));
+  Fwog::Cmd::BindIndexBuffer(scene_collectable.meshes[0].indexBuffer,
+                             Fwog::IndexType::UNSIGNED_INT);
+  collectable_culler->Draw();
+
+  if (!checkpoint_uniforms.empty()) {
+    bind_pick_kind(pick_kinds::checkpoint);
+    Albuquerque::UniformRing::BindStorage(
+        1, frame_uniforms.Push(
+               std::span<ObjectUniforms const>(checkpoint_uniforms)));
+    Fwog::Cmd::BindVertexBuffer(0, scene_checkpoint_ring.meshes[0].vertexBuffer,
+                                0, sizeof(Primitives::Vertex));
+    Fwog::Cmd::BindIndexBuffer(scene_checkpoint_ring.meshes[0].indexBuffer,
+                               Fwog::IndexType::UNSIGNED_INT);
+    checkpoint_culler->Draw();
+  }
+}
+
+void ProjectApplication::RenderMousePick() {
+  Albuquerque::GpuPicker::Result pick;
+  while (mouse_picker->Poll(pick)) {
+    editor_picked_id = pick.id;
+    auto kind = static_cast<pick_kinds>(Albuquerque::PickKind(pick.id));
+    if (kind == pick_kinds::building) {
+      // Could have been removed since, then it's an empty slot
+      SelectBuilding(world_store.buildings.slots.SlotHandle(
+          Albuquerque::PickIndex(pick.id)));
+    }
+  }
+
+  if (!mouse_picker->HasRequest()) return;
+
+  Albuquerque::UniformRing& frame_uniforms = FrameUniforms();
+  mouse_picker->Render(
+      globalStruct.viewProj,
+      glm::vec2(static_cast<float>(windowWidth),
+                static_cast<float>(windowHeight)),
+      [&](glm::mat4 const& pick_view_proj) {
+        Albuquerque::UniformSlice pick_globals = frame_uniforms.Push(
+            GlobalUniforms{pick_view_proj, globalStruct.eyePos});
+
+        // Can't be picked but hides whatever is behind it
+        Fwog::Cmd::BindGraphicsPipeline(pipeline_pick_terrain.value());
+        Albuquerque::UniformRing::BindUniform(0, pick_globals);
+        terrain->Draw(frame_uniforms, floating_origin.Origin());
+
+        Fwog::Cmd::BindGraphicsPipeline(pipeline_pick_ids.value());
+        Albuquerque::UniformRing::BindUniform(
+            0, frame_uniforms.Push(GlobalUniforms{
+                   ObjectViewProj(pick_view_proj),
+                   globalStruct.eyePos - object_space_offset}));
+        DrawCulledObjects(frame_uniforms, true);
+      });
+}
+
+void ProjectApplication::UpdateLevelEditorInput() {
+  // Typing into an editor field (Ctrl+click on a drag) needs Delete and
+  // Ctrl+Z for itself. A replay's keys weren't meant for the editor either,
+  // and the UI focus they'd depend on isn't part of the recording
+  if (ImGui::GetIO().WantCaptureKeyboard || IsReplaying()) return;
+
+  bool control = IsKeyPressed(GLFW_KEY_LEFT_CONTROL) ||
+                 IsKeyPressed(GLFW_KEY_RIGHT_CONTROL);
+
+  static bool wasKeyPressed_Undo = false;
+  if (!wasKeyPressed_Undo && control && IsKeyPressed(GLFW_KEY_Z)) {
+    wasKeyPressed_Undo = true;
+    level_editor.Undo();
+    editor_merge_move = false;
+  } else if (wasKeyPressed_Undo && IsKeyRelease(GLFW_KEY_Z)) {
+    wasKeyPressed_Undo = false;
+  }
+
+  static bool wasKeyPressed_Redo = false;
+  if (!wasKeyPressed_Redo && control && IsKeyPressed(GLFW_KEY_Y)) {
+    wasKeyPressed_Redo = true;
+    level_editor.Redo();
+    editor_merge_move = false;
+  } else if (wasKeyPressed_Redo && IsKeyRelease(GLFW_KEY_Y)) {
+    wasKeyPressed_Redo = false;
+  }
+
+  static bool wasKeyPressed_Delete = false;
+  if (!wasKeyPressed_Delete && IsKeyPressed(GLFW_KEY_DELETE)) {
+    wasKeyPressed_Delete = true;
+    if (level_editor.Remove(editor_selected)) editor_selected = {};
+  } else if (wasKeyPressed_Delete && IsKeyRelease(GLFW_KEY_DELETE)) {
+    wasKeyPressed_Delete = false;
+  }
+}
+
+void ProjectApplication::RenderLevelEditorUI() {
+  ImGui::Begin("Level Editor");
+  {
+    ImGui::Text("Click a building to select it. Ctrl+Z/Ctrl+Y to undo/redo");
+    ImGui::Text("Buildings: %u in %u grid cells",
+                world_store.buildings.Size(),
+                world_store.buildings.grid.CellCount());
+    ImGui::Text("History: %zu edits, %zu undone, %.1f KiB",
+                level_editor.HistorySize(),
+                level_editor.HistorySize() - level_editor.Cursor(),
+                level_editor.HistoryBytes() / 1024.0);
+    switch (static_cast<pick_kinds>(Albuquerque::PickKind(editor_picked_id))) {
+      case pick_kinds::building:
+        ImGui::Text("Picked: building %u",
+                    Albuquerque::PickIndex(editor_picked_id));
+        break;
+      case pick_kinds::collectable:
+        ImGui::Text("Picked: collectable %u",
+                    Albuquerque::PickIndex(editor_picked_id));
+        break;
+      case pick_kinds::checkpoint:
+        ImGui::Text("Picked: checkpoint %u",
+                    Albuquerque::PickIndex(editor_picked_id));
+        break;
+      default:
+        ImGui::Text("Picked: nothing");
+        break;
+    }
+
+    ImGui::BeginDisabled(!level_editor.CanUndo());
+    if (ImGui::Button("Undo")) level_editor.Undo();
+    ImGui::EndDisabled();
+    ImGui::SameLine();
+    ImGui::BeginDisabled(!level_editor.CanRedo());
+    if (ImGui::Button("Redo")) level_editor.Redo();
+    ImGui::EndDisabled();
+
+    ImGui::Separator();
+    ImGui::DragFloat3("New Building Half Size",
+                      &editor_new_building_half_extents.x, 1.0f, 1.0f,
+                      1000.0f);
+    if (ImGui::Button("Add Building In Front")) {
+      constexpr float add_distance = 200.0f;
+      glm::vec3 forward =
+          glm::normalize(editorCamera.target - editorCamera.position);
+      editor_selected = level_editor.Add(
+          editorCamera.position + forward * add_distance,
+          editor_new_building_half_extents);
+    }
+
+    AABBColliders const& buildings = world_store.buildings;
+    if (buildings.slots.Contains(editor_selected)) {
+      ImGui::Separator();
+      glm::vec3 center =
+          buildings.Center(buildings.slots.DenseIndex(editor_selected));
+      bool changed = ImGui::DragFloat3("Selected Position", &center.x, 1.0f);
+      if (ImGui::IsItemActivated()) editor_merge_move = false;
+      if (changed) {
+        level_editor.Move(editor_selected, center, editor_merge_move);
+        editor_merge_move = true;
+      }
+      if (ImGui::Button("Delete Building (Del)")) {
+        level_editor.Remove(editor_selected);
+        editor_selected = {};
+      }
+    }
+
+    ImGui::End();
+  }
+}
+
+void ProjectApplication::RenderScene(double dt) {
   ZoneScopedC(tracy::Color::Red);
 
-  Fwog::RenderToSwapchain(Fwog::SwapchainRenderInfo{
-      .viewport =
-          Fwog::Viewport{.drawRect{.offset = {0, 0},
-                                   .extent = {windowWidth, windowHeight}},
-                         .minDepth = 0.0f,
-                         .maxDepth = 1.0f},
-      .colorLoadOp = Fwog::AttachmentLoadOp::CLEAR,
-      .clearColorValue = {skyColorFoggy.r, skyColorFoggy.g, skyColorFoggy.b,
-                          1.0f},
-      .depthLoadOp = Fwog::AttachmentLoadOp::CLEAR,
-      .clearDepthValue = 1.0f},
+  // Everything that changes per frame goes through the ring instead of an
+  // UpdateData per buffer, which could stall on a buffer the GPU still reads
+  Albuquerque::UniformRing& frame_uniforms = FrameUniforms();
+  global_uniforms_slice = frame_uniforms.Push(globalStruct);
+  global_uniforms_skybox_slice = frame_uniforms.Push(globalStruct_skybox);
+
+  terrain->Update(floating_origin.ToWorld(globalStruct.eyePos));
+
+  // Culling is a compute pass so it has to happen before the render pass.
+  // Occlusion is tested against the pyramid of last frame's depth, unless
+  // the CPU already did it
+  UpdateCullObjects();
+  if (use_software_occlusion) {
+    UpdateSoftwareOcclusion();
+  }
+  Albuquerque::HiZPyramid const* hiz =
+      use_software_occlusion ? nullptr : &hiz_pyramid.value();
+  // After UpdateCullObjects, which can fold the offset back in
+  glm::mat4 object_view_proj = ObjectViewProj(globalStruct.viewProj);
+  object_globals_slice = frame_uniforms.Push(GlobalUniforms{
+      object_view_proj, globalStruct.eyePos - object_space_offset});
+  building_culler->Cull(object_view_proj, frame_uniforms, hiz);
+  collectable_culler->Cull(object_view_proj, frame_uniforms, hiz);
+  checkpoint_culler->Cull(object_view_proj, frame_uniforms, hiz);
+
+  Fwog::RenderAttachment color_attachment{
+      .texture = &scene_color.value(),
+      .clearValue = Fwog::ClearColorValue{skyColorFoggy.r, skyColorFoggy.g,
+                                          skyColorFoggy.b, 1.0f},
+      .loadOp = Fwog::AttachmentLoadOp::CLEAR};
+  Fwog::RenderAttachment depth_attachment{
+      .texture = &scene_depth.value(),
+      .clearValue = Fwog::ClearDepthStencilValue{.depth = 1.0f},
+      .loadOp = Fwog::AttachmentLoadOp::CLEAR};
+
+  Fwog::Render(Fwog::RenderInfo{
+      .name = "Scene",
+      .colorAttachments = {&color_attachment, 1},
+      .depthAttachment = &depth_attachment},
   [&]
   {
+      ALBUQUERQUE_PROFILE_CPU("Scene Pass");
+      ALBUQUERQUE_PROFILE_GPU("Scene Pass");
 
-      // Drawing a ground plane
+      // Drawing the terrain
       {
           Fwog::SamplerState ss;
           ss.minFilter = Fwog::Filter::LINEAR;
@@ -1766,86 +2098,24 @@ void ProjectApplication::RenderScene(double dt) {
           auto nearestSampler = Fwog::Sampler(ss);
 
           Fwog::Cmd::BindGraphicsPipeline(pipeline_textured.value());
-          Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
-          Fwog::Cmd::BindUniformBuffer(1, objectBufferPlane.value());
+          Albuquerque::UniformRing::BindUniform(0, global_uniforms_slice);
           Fwog::Cmd::BindSampledImage(0, groundAlbedo.value(), nearestSampler);
-          Fwog::Cmd::BindVertexBuffer(0, vertex_buffer_plane.value(), 0,
-              sizeof(Primitives::Vertex));
-          Fwog::Cmd::BindIndexBuffer(index_buffer_plane.value(),
-              Fwog::IndexType::UNSIGNED_INT);
-          Fwog::Cmd::DrawIndexed(
-              static_cast<uint32_t>(Primitives::plane_indices.size()), 1, 0, 0, 0);
-
-          // Drawing the other ground planes
-          for (auto const& ground : grond_chunk_list) {
-              Fwog::Cmd::BindUniformBuffer(1, ground.object_buffer.value());
-              Fwog::Cmd::BindSampledImage(0, groundAlbedo.value(), nearestSampler);
-              Fwog::Cmd::BindVertexBuffer(0, vertex_buffer_plane.value(), 0,
-                  sizeof(Primitives::Vertex));
-              Fwog::Cmd::BindIndexBuffer(index_buffer_plane.value(),
-                  Fwog::IndexType::UNSIGNED_INT);
-              Fwog::Cmd::DrawIndexed(
-                  static_cast<uint32_t>(Primitives::plane_indices.size()), 1, 0, 0, 0);
-          }
+          terrain->Draw(frame_uniforms, floating_origin.Origin());
       }
 
-      // Drawing buildings
+      // Drawing buildings, collectables and checkpoints. Only what the
+      // culling pass kept gets drawn
       {
-          static constexpr uint64_t stride = sizeof(Utility::Vertex);
-          for (auto const& building : buildingObjectList) {
-              Fwog::Cmd::BindGraphicsPipeline(pipeline_flat.value());
-              Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
-              building.drawcall.Draw(stride);
-          }
-      }
-
-      // Drawing the collectables
-      {
-          if (!collectableList.empty()) {
-              Fwog::Cmd::BindGraphicsPipeline(pipeline_colored_indexed.value());
-              Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
-              Fwog::Cmd::BindStorageBuffer(1, collectableObjectBuffers.value());
-              Fwog::Cmd::BindVertexBuffer(0, scene_collectable.meshes[0].vertexBuffer,
-                  0, sizeof(Utility::Vertex));
-              Fwog::Cmd::BindIndexBuffer(scene_collectable.meshes[0].indexBuffer,
-                  Fwog::IndexType::UNSIGNED_INT);
-              Fwog::Cmd::DrawIndexed(
-                  static_cast<uint32_t>(
-                      scene_collectable.meshes[0].indexBuffer.Size()) /
-                  sizeof(uint32_t),
-                  collectableList.size(), 0, 0, 0);
-          }
-      }
-
-      // Drawing checkpoints
-      {
-          // Assumptions: All checkpoints are allocated in collection sequence
-          // linearly.
-          if (!all_checkpoints_collected) {
-              for (size_t i = curr_active_checkpoint; i < checkpointList.size(); ++i) {
-                  Fwog::Cmd::BindGraphicsPipeline(pipeline_flat.value());
-                  Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
-                  Fwog::Cmd::BindUniformBuffer(1,
-                      checkpointList[i].object_buffer.value());
-                  Fwog::Cmd::BindVertexBuffer(
-                      0, scene_checkpoint_ring.meshes[0].vertexBuffer, 0,
-                      sizeof(Primitives::Vertex));
-                  Fwog::Cmd::BindIndexBuffer(scene_checkpoint_ring.meshes[0].indexBuffer,
-                      Fwog::IndexType::UNSIGNED_INT);
-                  Fwog::Cmd::DrawIndexed(
-                      static_cast<uint32_t>(
-                          scene_checkpoint_ring.meshes[0].indexBuffer.Size()) /
-                      sizeof(uint32_t),
-                      1, 0, 0, 0);
-              }
-          }
+          Fwog::Cmd::BindGraphicsPipeline(pipeline_colored_indexed.value());
+          Albuquerque::UniformRing::BindUniform(0, object_globals_slice);
+          DrawCulledObjects(frame_uniforms, false);
       }
 
       // Drawing a aircraft
       if (render_plane) {
           Fwog::Cmd::BindGraphicsPipeline(pipeline_flat.value());
-          Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
-          Fwog::Cmd::BindUniformBuffer(1, objectBufferaircraft.value());
+          Albuquerque::UniformRing::BindUniform(0, global_uniforms_slice);
+          Albuquerque::UniformRing::BindUniform(1, frame_uniforms.Push(aircraft_uniforms));
           Fwog::Cmd::BindVertexBuffer(0, scene_aircraft.meshes[1].vertexBuffer, 0,
               sizeof(Utility::Vertex));
           Fwog::Cmd::BindIndexBuffer(scene_aircraft.meshes[1].indexBuffer,
@@ -1855,7 +2125,7 @@ void ProjectApplication::RenderScene(double dt) {
               sizeof(uint32_t),
               1, 0, 0, 0);
 
-          Fwog::Cmd::BindUniformBuffer(1, object_buffer_propeller.value());
+          Albuquerque::UniformRing::BindUniform(1, frame_uniforms.Push(propeller_uniforms));
           Fwog::Cmd::BindVertexBuffer(0, scene_aircraft.meshes[0].vertexBuffer, 0,
               sizeof(Utility::Vertex));
           Fwog::Cmd::BindIndexBuffer(scene_aircraft.meshes[0].indexBuffer,
@@ -1869,7 +2139,7 @@ void ProjectApplication::RenderScene(double dt) {
       // Drawing axis lines
       {
           Fwog::Cmd::BindGraphicsPipeline(pipeline_lines.value());
-          Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer.value());
+          Albuquerque::UniformRing::BindUniform(0, global_uniforms_slice);
           if (renderAxis) {
               Fwog::Cmd::BindVertexBuffer(0, vertex_buffer_pos_line.value(), 0,
                   3 * sizeof(float));
@@ -1878,19 +2148,8 @@ void ProjectApplication::RenderScene(double dt) {
               Fwog::Cmd::Draw(num_points_world_axis, 1, 0, 0);
           }
 
-          // Drawing collision lines
-          if (curr_num_draw_points != 0 &&
-              curr_num_draw_points < max_num_draw_points) {
-              Fwog::Cmd::BindVertexBuffer(0, vertex_buffer_draw_lines.value(), 0,
-                  3 * sizeof(float));
-              Fwog::Cmd::BindVertexBuffer(1, vertex_buffer_draw_colors.value(), 0,
-                  3 * sizeof(float));
-              Fwog::Cmd::Draw(curr_num_draw_points, 1, 0, 0);
-
-              // Allows DrawLine to be called every frame without creating buffers.
-              // Should make new buffer  if want presistent lines ofc
-              ClearLines();
-          }
+          // Drawing collision shapes, all of them in one upload and draw
+          debug_draw->Render(global_uniforms_slice);
       }
 
       // Drawing skybox last depth buffer
@@ -1905,7 +2164,7 @@ void ProjectApplication::RenderScene(double dt) {
           auto nearestSampler = Fwog::Sampler(ss);
 
           Fwog::Cmd::BindGraphicsPipeline(pipeline_skybox.value());
-          Fwog::Cmd::BindUniformBuffer(0, globalUniformsBuffer_skybox.value());
+          Albuquerque::UniformRing::BindUniform(0, global_uniforms_skybox_slice);
           Fwog::Cmd::BindSampledImage(0, skybox_texture.value(), nearestSampler);
           Fwog::Cmd::BindVertexBuffer(0, vertex_buffer_skybox.value(), 0,
               3 * sizeof(float));
@@ -1914,18 +2173,97 @@ void ProjectApplication::RenderScene(double dt) {
   }
   );
   //Fwog::EndRendering();
+
+  // Same culled lists as the scene, so it only draws what's on screen
+  RenderMousePick();
+
+  // The color target is already sRGB encoded, so the blit must not encode it
+  // a second time
+  glDisable(GL_FRAMEBUFFER_SRGB);
+  Fwog::BlitTextureToSwapchain(scene_color.value(), {}, {},
+                               scene_color->Extent(),
+                               {windowWidth, windowHeight},
+                               Fwog::Filter::NEAREST);
+
+  if (!use_software_occlusion) {
+    hiz_pyramid->Build(scene_depth.value(), globalStruct.viewProj);
+  }
 }
 
 void ProjectApplication::RenderUI(double dt) {
   // This is needed or else there's a crash
   glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
 
+  RenderProfilerUI();
+
   ImGui::Begin("Performance");
   {
     ImGui::Text("Framerate: %.0f Hertz", 1 / dt);
+    ImGui::Text("Physics: %.0f Hertz, %llu ticks, %.3f s dropped",
+                fixed_timestep.TickRate(),
+                static_cast<unsigned long long>(fixed_timestep.TickCount()),
+                fixed_timestep.DroppedTime());
+
+    if (ImGui::SliderFloat("FPS Cap (0 = off)", &fps_cap, 0.0f, 240.0f)) {
+      frame_pacer.SetTargetFps(fps_cap);
+    }
+
+    ImGui::Separator();
+    if (ImGui::Checkbox("Software Occlusion", &use_software_occlusion)) {
+      // Unhides whatever the software pass hid, and last frame's pyramid is
+      // stale either way
+      cull_objects_dirty = true;
+      hiz_pyramid->Invalidate();
+    }
+
+    auto cull_stats_row = [](char const* name,
+                             Albuquerque::GpuCuller::Stats const& stats) {
+      ImGui::Text("%s: %u visible, %u frustum culled, %u occluded", name,
+                  stats.visible, stats.frustum_culled, stats.occlusion_culled);
+    };
+    // The GPU counts arrive a few frames late
+    cull_stats_row("Buildings", use_software_occlusion
+                                    ? building_software_stats
+                                    : building_culler->LastStats());
+    cull_stats_row("Collectables", use_software_occlusion
+                                       ? collectable_software_stats
+                                       : collectable_culler->LastStats());
+    cull_stats_row("Checkpoints", checkpoint_culler->LastStats());
+
+    ImGui::Separator();
+    Albuquerque::Terrain::Stats const& terrain_stats = terrain->GetStats();
+    ImGui::Text("Terrain: %u patches, %llu vertices", terrain_stats.drawn_nodes,
+                static_cast<unsigned long long>(terrain_stats.drawn_vertices));
+    ImGui::Text("Terrain tiles: %u resident, %u building, %.1f MiB",
+                terrain_stats.resident_tiles, terrain_stats.builds_in_flight,
+                terrain_stats.resident_bytes / (1024.0 * 1024.0));
+    ImGui::Text("Terrain tiles: %llu built, %llu evicted, %llu over budget",
+                static_cast<unsigned long long>(terrain_stats.tiles_built),
+                static_cast<unsigned long long>(terrain_stats.tiles_evicted),
+                static_cast<unsigned long long>(terrain_stats.budget_overruns));
+
+    glm::dvec3 const& origin = floating_origin.Origin();
+    ImGui::Text("Origin: %.0f, %.0f, %llu rebases, last %.3f ms", origin.x,
+                origin.z,
+                static_cast<unsigned long long>(floating_origin.RebaseCount()),
+                last_rebase_ms);
+
+    Albuquerque::AudioMixer::Stats audio_stats = audio.GetStats();
+    ImGui::Text("Audio: %u/%u voices, %llu stolen, %llu rejected",
+                audio_stats.active_voices, audio_stats.max_voices,
+                static_cast<unsigned long long>(audio_stats.stolen_voices),
+                static_cast<unsigned long long>(audio_stats.rejected_voices));
+    ImGui::Text("Audio mixer: %.3f%% of a core per 100 voices, %.1f MiB of clips",
+                audio_stats.CpuPercentPer100Voices(audio.SampleRate()),
+                audio.ClipBytes() / (1024.0 * 1024.0));
+    ImGui::Text("Music: %u streaming, %.0f KiB buffered, %llu underruns",
+                audio_stats.active_music, audio.MusicBytes() / 1024.0,
+                static_cast<unsigned long long>(audio_stats.music_underruns));
     ImGui::End();
   }
 
+  RenderMemoryStatsUI();
+
   ImGui::Begin("How To Play");
   {
     ImGui::Text("Use the arrow keys to pitch and roll!");
@@ -1944,15 +2282,23 @@ void ProjectApplication::RenderUI(double dt) {
       is_background_music_muted = set_background_music;
       MuteBackgroundMusicToggle(is_background_music_muted);
     }
+
+    ImGui::Checkbox("Draw Player Collider", &draw_player_colliders);
+    ImGui::Checkbox("Draw Collectable Colliders", &draw_collectable_colliders);
+    ImGui::Checkbox("Draw Building Colliders", &draw_building_colliders);
     ImGui::End();
   }
 
+  if (curr_game_state == game_states::level_editor) {
+    RenderLevelEditorUI();
+  }
+
   ImGui::Begin("Gameplay");
   {
     ImGui::Text("Checkpoint: %d/%d",
                 curr_active_checkpoint +
                     static_cast<uint32_t>(all_checkpoints_collected),
-                checkpointList.size());
+                checkpoint_route.size());
     ImGui::Text("Current Time: %f", current_player_level_time);
     if (all_checkpoints_collected) {
       ImGui::Text("Level Completed");
@@ -1965,8 +2311,6 @@ void ProjectApplication::RenderUI(double dt) {
   }
 }
 
-ProjectApplication::~ProjectApplication() {
-  ma_engine_uninit(&miniAudioEngine);
-}
+ProjectApplication::~ProjectApplication() {}
 
 }  // namespace PlaneGame
@@ -4,6 +4,26 @@
 //spdlog handles the logging for it more efficently by default so we ok
 #include <iostream>
 #include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <Albuquerque/Audio.hpp>
+#include <Albuquerque/JobSystem.hpp>
+#include <Albuquerque/GpuCulling.hpp>
+#include <Albuquerque/GpuPicking.hpp>
+#include <Albuquerque/FloatingOrigin.hpp>
+#include <Albuquerque/HiZ.hpp>
+#include <Albuquerque/InputRecording.hpp>
+#include <Albuquerque/Scripting.hpp>
+#include <Albuquerque/Terrain.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 namespace PlaneGame
 {
@@ -44,9 +64,1468 @@ namespace PlaneGame
 
 
 
+	void WorldStoreTester::TestHandles()
+	{
+		std::cout << "WorldStore TestHandles()\n";
+
+		AABBColliders buildings;
+		WorldHandle first = buildings.Add(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(1.0f));
+		WorldHandle second = buildings.Add(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(1.0f));
+		WorldHandle third = buildings.Add(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+
+		assert(buildings.Raycast(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1000.0f) == 0);
+
+		//The last building moves into the removed one's place, its handle has to follow it
+		buildings.Remove(first);
+		assert(!buildings.slots.Contains(first));
+		assert(buildings.slots.DenseIndex(third) == 0);
+		assert(buildings.Center(buildings.slots.DenseIndex(second)).z == 20.0f);
+		assert(buildings.Raycast(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1000.0f) == static_cast<int32_t>(buildings.slots.DenseIndex(second)));
+
+		//Slot gets reused but the old handle must not see the new building
+		WorldHandle reused = buildings.Add(glm::vec3(0.0f), glm::vec3(1.0f));
+		assert(reused.index == first.index && reused.generation != first.generation);
+		assert(!buildings.slots.Contains(first));
+
+		SphereColliders collectables;
+		collectables.Add(glm::vec3(0.0f), 1.0f);
+		collectables.Add(glm::vec3(10.0f, 0.0f, 0.0f), 1.0f);
+		assert(collectables.FirstOverlap(glm::vec3(1.5f, 0.0f, 0.0f), 1.0f) == 0);
+		collectables.flags[0] |= world_flag_collected;
+		assert(collectables.FirstOverlap(glm::vec3(1.5f, 0.0f, 0.0f), 1.0f, world_flag_collected) == -1);
+
+		std::cout << "WorldStore TestHandles() Done\n";
+	}
+
+	void WorldStoreTester::TestCollect()
+	{
+		std::cout << "WorldStore TestCollect()\n";
+
+		//A row of collectables along the flight path and a few off to the side, past the 4096 the old buffer had
+		SphereColliders collectables;
+		constexpr uint32_t count = 5000;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			float side = (i % 3 == 0) ? 100.0f : 0.0f;
+			collectables.Add(glm::vec3(side, 0.0f, 10.0f * i), 2.0f);
+		}
+
+		//What the culler keeps, the slot of each dense object, swap removed by the same index
+		std::vector<uint32_t> culled_slots;
+		for (uint32_t i = 0; i < collectables.Size(); ++i)
+			culled_slots.push_back(collectables.slots.Handle(i).index);
+
+		//Picked up like the game does it, in ticks along the row
+		uint32_t collected = 0;
+		for (float z = 0.0f; z < 10.0f * count; z += 250.0f)
+		{
+			int32_t i;
+			while ((i = collectables.Sweep(glm::vec3(0.0f, 0.0f, z), glm::vec3(0.0f, 0.0f, z + 250.0f), 1.0f)) >= 0)
+			{
+				collectables.Remove(collectables.slots.Handle(i));
+				culled_slots[i] = culled_slots.back();
+				culled_slots.pop_back();
+				collected += 1;
+			}
+		}
+
+		//Every one on the path went once, the rest are still there and still line up with the culler
+		assert(collected == count - (count + 2) / 3);
+		assert(collectables.Size() == (count + 2) / 3 && culled_slots.size() == collectables.Size());
+		for (uint32_t i = 0; i < collectables.Size(); ++i)
+		{
+			assert(culled_slots[i] == collectables.slots.Handle(i).index);
+			assert(collectables.center_x[i] == 100.0f);
+		}
+
+		std::cout << "WorldStore TestCollect() Done\n";
+	}
+
+	void WorldStoreTester::TestGridRaycast()
+	{
+		std::cout << "WorldStore TestGridRaycast()\n";
+
+		std::mt19937 random(77);
+		auto uniform = [&random](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+		auto random_box = [&]() { return glm::vec3(uniform(5.0f, 40.0f), uniform(5.0f, 80.0f), uniform(5.0f, 40.0f)); };
+		auto random_center = [&]() { return glm::vec3(uniform(-1500.0f, 1500.0f), uniform(0.0f, 100.0f), uniform(-1500.0f, 1500.0f)); };
+
+		AABBColliders buildings;
+		std::vector<WorldHandle> handles;
+		for (int i = 0; i < 3000; ++i)
+			handles.push_back(buildings.Add(random_center(), random_box()));
+		//Too big for the grid, goes in the oversized list
+		handles.push_back(buildings.Add(glm::vec3(0.0f, -50.0f, 0.0f), glm::vec3(5000.0f, 1.0f, 5000.0f)));
+
+		auto brute_force = [&](glm::vec3 origin, glm::vec3 direction, float max_distance)
+		{
+			float closest = max_distance;
+			bool hit = false;
+			for (uint32_t i = 0; i < buildings.Size(); ++i)
+			{
+				glm::vec3 low = (buildings.Center(i) - buildings.HalfExtents(i) - origin) / direction;
+				glm::vec3 high = (buildings.Center(i) + buildings.HalfExtents(i) - origin) / direction;
+				glm::vec3 near = glm::min(low, high);
+				glm::vec3 far = glm::max(low, high);
+				float t_near = std::max({near.x, near.y, near.z, 0.0f});
+				float t_far = std::min({far.x, far.y, far.z});
+				if (t_near <= t_far && t_near < closest)
+				{
+					closest = t_near;
+					hit = true;
+				}
+			}
+			return hit ? closest : -1.0f;
+		};
+
+		uint32_t hits = 0;
+		for (int round = 0; round < 2000; ++round)
+		{
+			//Edits in between so the cells have to keep up
+			WorldHandle& edited = handles[random() % handles.size()];
+			switch (round % 3)
+			{
+			case 0:
+				buildings.Move(edited, random_center());
+				break;
+			case 1:
+				buildings.Remove(edited);
+				edited = buildings.Add(random_center(), random_box());
+				break;
+			default:
+				//Now and then a rebase, the grid has to keep finding everything without being rebuilt
+				if (round % 100 == 2)
+					buildings.Translate(glm::vec3(uniform(-300.0f, 300.0f), uniform(-10.0f, 10.0f), uniform(-300.0f, 300.0f)));
+				break;
+			}
+
+			glm::vec3 origin(uniform(-2000.0f, 2000.0f), uniform(0.0f, 300.0f), uniform(-2000.0f, 2000.0f));
+			glm::vec3 direction(uniform(-1.0f, 1.0f), uniform(-0.5f, 0.2f), uniform(-1.0f, 1.0f));
+			//Some straight down and some along an axis, where the walk never steps on one of the axes
+			if (round % 7 == 0)
+				direction = glm::vec3(0.0f, -1.0f, 0.0f);
+			else if (round % 11 == 0)
+				direction.z = 0.0f;
+			direction = glm::normalize(direction);
+
+			float expected = brute_force(origin, direction, 5000.0f);
+			float distance = -1.0f;
+			int32_t hit = buildings.Raycast(origin, direction, 5000.0f, &distance);
+			//Equal distances can be either box, only the distance has to match
+			assert((hit >= 0) == (expected >= 0.0f));
+			assert(hit < 0 || std::abs(distance - expected) <= 1e-3f * std::max(1.0f, expected));
+			hits += hit >= 0;
+		}
+		assert(hits > 0);
+
+		std::cout << "WorldStore TestGridRaycast() Done, " << hits << " hits in " << buildings.grid.CellCount() << " cells\n";
+	}
+
+	void CollisionTester::TestSweepProperties()
+	{
+		std::cout << "Collision TestSweepProperties()\n";
+
+		std::mt19937 random(1234);
+		auto uniform = [&random](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+		auto random_point = [&](float extent) { return glm::vec3(uniform(-extent, extent), uniform(-extent, extent), uniform(-extent, extent)); };
+
+		auto box_distance = [](glm::vec3 point, glm::vec3 center, glm::vec3 half_extents)
+		{
+			glm::vec3 outside = glm::max(glm::abs(point - center) - half_extents, glm::vec3(0.0f));
+			return glm::length(outside);
+		};
+
+		constexpr uint32_t samples = 256;
+		constexpr float tolerance = 1e-3f;
+		uint32_t hits = 0;
+
+		for (uint32_t trial = 0; trial < 2000; ++trial)
+		{
+			//Moves from barely anything up to far longer than the shapes, like a boosted tick
+			//Half of them roughly aimed at the shape so plenty hit
+			float radius = uniform(0.5f, 6.0f);
+			bool against_box = trial % 2 == 0;
+			glm::vec3 center = random_point(20.0f);
+			glm::vec3 start = random_point(60.0f);
+			glm::vec3 direction = trial % 4 < 2 ? center + random_point(15.0f) - start : random_point(1.0f);
+			glm::vec3 end = start + direction * (uniform(0.0f, 150.0f) / std::max(glm::length(direction), 1e-3f));
+			glm::vec3 half_extents(uniform(0.5f, 15.0f), uniform(0.5f, 15.0f), uniform(0.5f, 15.0f));
+			float other_radius = uniform(0.5f, 15.0f);
+
+			auto distance = [&](float t)
+			{
+				glm::vec3 point = glm::mix(start, end, t);
+				return against_box ? box_distance(point, center, half_extents) : glm::length(point - center) - other_radius;
+			};
+			auto sweep = [&](glm::vec3 from, glm::vec3 to, float& t)
+			{
+				return against_box ? SweepSphereAABB(from, to, radius, center, half_extents, t)
+					: SweepSphereSphere(from, to, radius, center, other_radius, t);
+			};
+
+			float time_of_impact = 0.0f;
+			bool hit = sweep(start, end, time_of_impact);
+			hits += hit;
+
+			//Nothing the discrete test sees is missed or found late
+			for (uint32_t i = 0; i <= samples; ++i)
+			{
+				float t = float(i) / samples;
+				if (distance(t) < radius)
+				{
+					assert(hit && time_of_impact <= t + tolerance);
+					break;
+				}
+			}
+
+			if (hit)
+			{
+				//Touching at the contact and clear of it before
+				float length = glm::length(end - start);
+				assert(time_of_impact >= 0.0f && time_of_impact <= 1.0f);
+				assert(std::abs(distance(time_of_impact) - radius) <= tolerance * (1.0f + length) || time_of_impact == 0.0f);
+				for (uint32_t i = 0; i < samples && time_of_impact > 0.0f; ++i)
+				{
+					float t = time_of_impact * float(i) / samples;
+					assert(distance(t) >= radius - tolerance * (1.0f + length));
+				}
+			}
+
+			//Ticks of any rate along the same path find the same contact
+			uint32_t steps = 1 + random() % 16;
+			bool stepped_hit = false;
+			float stepped_time = 0.0f;
+			for (uint32_t step = 0; step < steps && !stepped_hit; ++step)
+			{
+				glm::vec3 from = glm::mix(start, end, float(step) / steps);
+				glm::vec3 to = glm::mix(start, end, float(step + 1) / steps);
+				float t;
+				if (sweep(from, to, t))
+				{
+					stepped_hit = true;
+					stepped_time = (step + t) / steps;
+				}
+			}
+			assert(stepped_hit == hit);
+			assert(!hit || std::abs(stepped_time - time_of_impact) <= tolerance);
+		}
+
+		//Enough of the trials hit for the above to mean something
+		assert(hits > 200);
+
+		//The stores pick the earliest contact, not the first in memory
+		AABBColliders boxes;
+		boxes.Add(glm::vec3(0.0f, 0.0f, 100.0f), glm::vec3(5.0f));
+		boxes.Add(glm::vec3(0.0f, 0.0f, 50.0f), glm::vec3(5.0f));
+		float time_of_impact = 0.0f;
+		assert(boxes.Sweep(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 200.0f), 1.0f, &time_of_impact) == 1);
+		assert(std::abs(time_of_impact - 44.0f / 200.0f) < 1e-5f);
+		assert(boxes.Sweep(glm::vec3(20.0f, 0.0f, 0.0f), glm::vec3(20.0f, 0.0f, 200.0f), 1.0f) == -1);
+
+		SphereColliders spheres;
+		spheres.Add(glm::vec3(0.0f, 0.0f, 100.0f), 5.0f);
+		spheres.Add(glm::vec3(0.0f, 0.0f, 50.0f), 5.0f, world_flag_collected);
+		assert(spheres.Sweep(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 200.0f), 1.0f, world_flag_collected, &time_of_impact) == 0);
+		assert(std::abs(time_of_impact - 94.0f / 200.0f) < 1e-5f);
+
+		std::cout << "Collision TestSweepProperties() Done\n";
+	}
+
+	void GpuCullingTester::TestCommandLayout()
+	{
+		std::cout << "GpuCulling TestCommandLayout()\n";
+
+		using namespace Albuquerque;
+
+		std::vector<GpuCullMesh> meshes = {
+			{.index_count = 36, .first_index = 0, .base_vertex = 0},
+			{.index_count = 120, .first_index = 36, .base_vertex = 24},
+			{.index_count = 6, .first_index = 156, .base_vertex = 80},
+		};
+
+		//Two objects for mesh 1, one for mesh 0, none for mesh 2
+		std::vector<GpuCullObject> objects = {
+			GpuCulling::PackSphere(glm::vec3(0.0f), 1.0f, 1, 10),
+			GpuCulling::PackAABB(glm::vec3(0.0f), glm::vec3(1.0f), 0, 11),
+			GpuCulling::PackSphere(glm::vec3(0.0f), 1.0f, 1, 12),
+		};
+
+		auto commands = GpuCulling::BuildCommandLayout(meshes, objects);
+		assert(commands.size() == meshes.size());
+		for (size_t i = 0; i < commands.size(); ++i)
+		{
+			assert(commands[i].index_count == meshes[i].index_count);
+			assert(commands[i].first_index == meshes[i].first_index);
+			assert(commands[i].base_vertex == meshes[i].base_vertex);
+			assert(commands[i].instance_count == 0);
+		}
+
+		//Every mesh starts where the previous one's objects end
+		assert(commands[0].base_instance == 0);
+		assert(commands[1].base_instance == 1);
+		assert(commands[2].base_instance == 3);
+
+		//The shader reads these as std430 structs
+		assert(offsetof(GpuCullObject, radius) == 12);
+		assert(offsetof(GpuCullObject, half_extents) == 16);
+		assert(offsetof(GpuCullObject, mesh_index) == 28);
+		assert(offsetof(GpuCullObject, object_index) == 32);
+		assert(offsetof(GpuCullObject, flags) == 36);
+		assert(offsetof(DrawElementsIndirectCommand, base_instance) == 16);
+
+		//A box is culled by the sphere around it too, so that has to contain the corners
+		GpuCullObject box = GpuCulling::PackAABB(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(1.0f, 2.0f, 2.0f), 0, 0);
+		assert(std::abs(box.radius - 3.0f) < 1e-5f);
+
+		std::cout << "GpuCulling TestCommandLayout() Done\n";
+	}
+
+	void GpuCullingTester::TestFrustum()
+	{
+		std::cout << "GpuCulling TestFrustum()\n";
+
+		using namespace Albuquerque;
+
+		//Looking down -z from the origin, 90 degrees so the side planes are at 45 degrees
+		glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		auto planes = GpuCulling::ExtractFrustumPlanes(proj * view);
+
+		for (glm::vec4 const& plane : planes)
+		{
+			assert(std::abs(glm::length(glm::vec3(plane)) - 1.0f) < 1e-4f);
+		}
+
+		auto visible = [&](GpuCullObject const& object) { return GpuCulling::IsVisible(planes, object); };
+
+		assert(visible(GpuCulling::PackSphere(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f, 0, 0)));
+		assert(!visible(GpuCulling::PackSphere(glm::vec3(0.0f, 0.0f, 10.0f), 1.0f, 0, 0)));
+		assert(!visible(GpuCulling::PackSphere(glm::vec3(0.0f, 0.0f, -200.0f), 1.0f, 0, 0)));
+		assert(!visible(GpuCulling::PackSphere(glm::vec3(30.0f, 0.0f, -10.0f), 1.0f, 0, 0)));
+
+		//Center outside the left plane but the sphere still pokes in
+		assert(visible(GpuCulling::PackSphere(glm::vec3(-11.0f, 0.0f, -10.0f), 2.0f, 0, 0)));
+
+		//Long thin box with its center outside the left plane that still reaches into the view
+		assert(visible(GpuCulling::PackAABB(glm::vec3(-20.0f, 0.0f, -10.0f), glm::vec3(15.0f, 0.5f, 0.5f), 0, 0)));
+
+		//Long thin box below the view whose bounding sphere reaches in but the box itself doesn't
+		assert(!visible(GpuCulling::PackAABB(glm::vec3(0.0f, -15.0f, -5.0f), glm::vec3(10.0f, 0.5f, 0.5f), 0, 0)));
+
+		assert(!visible(GpuCulling::PackSphere(glm::vec3(0.0f, 0.0f, -10.0f), 1.0f, 0, 0, gpu_cull_hidden)));
+
+		std::cout << "GpuCulling TestFrustum() Done\n";
+	}
+
+	void OcclusionTester::TestDownsample()
+	{
+		std::cout << "Occlusion TestDownsample()\n";
+
+		using namespace Albuquerque;
+
+		std::vector<float> destination;
+		std::vector<float> even = {
+			0.1f, 0.2f, 0.5f, 0.3f,
+			0.4f, 0.3f, 0.2f, 0.9f,
+		};
+		HiZ::Downsample(even, 4, 2, destination, 2, 1);
+		assert(destination.size() == 2);
+		assert(destination[0] == 0.4f);
+		assert(destination[1] == 0.9f);
+
+		//3x3 into 1x1 has to look at the last row and column too
+		std::vector<float> odd = {
+			0.1f, 0.1f, 0.1f,
+			0.1f, 0.1f, 0.1f,
+			0.1f, 0.1f, 0.7f,
+		};
+		HiZ::Downsample(odd, 3, 3, destination, 1, 1);
+		assert(destination.size() == 1);
+		assert(destination[0] == 0.7f);
+
+		assert(HiZ::MipCount(256, 128) == 9);
+		assert(HiZ::MipCount(1600, 900) == 11);
+
+		std::cout << "Occlusion TestDownsample() Done\n";
+	}
+
+	void OcclusionTester::TestSoftwareOcclusion()
+	{
+		std::cout << "Occlusion TestSoftwareOcclusion()\n";
+
+		using namespace Albuquerque;
+
+		//Same aspect as the default occlusion buffer, looking down -z from the origin
+		glm::mat4 proj = glm::perspective(glm::radians(90.0f), 2.0f, 1.0f, 100.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		SoftwareOcclusion occlusion;
+		occlusion.Begin(proj * view);
+		occlusion.AddOccluder(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(5.0f, 5.0f, 0.5f));
+		occlusion.Finish();
+
+		//The wall is in the middle of the screen, the sky around it stays at the far plane
+		assert(occlusion.DepthAt(occlusion.Width() / 2, occlusion.Height() / 2) < 1.0f);
+		assert(occlusion.DepthAt(0, 0) == 1.0f);
+
+		assert(occlusion.IsOccluded(glm::vec3(0.0f, 0.0f, -30.0f), glm::vec3(1.0f)));
+		assert(!occlusion.IsOccluded(glm::vec3(20.0f, 0.0f, -30.0f), glm::vec3(1.0f)));
+		assert(!occlusion.IsOccluded(glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(1.0f)));
+
+		//Straddling the camera, never occluded
+		assert(!occlusion.IsOccluded(glm::vec3(0.0f), glm::vec3(2.0f)));
+
+		//The wall doesn't hide itself
+		assert(!occlusion.IsOccluded(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(5.0f, 5.0f, 0.5f)));
+
+		std::cout << "Occlusion TestSoftwareOcclusion() Done\n";
+	}
+
+	void TerrainTester::TestStitching()
+	{
+		std::cout << "Terrain TestStitching()\n";
+
+		using namespace Albuquerque;
+
+		constexpr uint32_t quads = 8;
+		constexpr uint32_t side = quads + 1;
+
+		std::vector<uint32_t> plain = TerrainMesh::BuildIndices(quads, 0);
+		assert(plain.size() == quads * quads * 6);
+
+		for (uint32_t mask = 1; mask < terrain_stitch_variants; ++mask)
+		{
+			std::vector<uint32_t> stitched = TerrainMesh::BuildIndices(quads, mask);
+
+			//Same count so every variant can be drawn with the same call
+			assert(stitched.size() == plain.size());
+
+			for (uint32_t index : stitched)
+			{
+				uint32_t i = index % side;
+				uint32_t j = index / side;
+				assert(!((mask & terrain_edge_neg_x) && i == 0 && (j & 1)));
+				assert(!((mask & terrain_edge_pos_x) && i == quads && (j & 1)));
+				assert(!((mask & terrain_edge_neg_z) && j == 0 && (i & 1)));
+				assert(!((mask & terrain_edge_pos_z) && j == quads && (i & 1)));
+			}
+		}
+
+		std::cout << "Terrain TestStitching() Done\n";
+	}
+
+	void TerrainTester::TestSharedEdges()
+	{
+		std::cout << "Terrain TestSharedEdges()\n";
+
+		using namespace Albuquerque;
+
+		//Far from the origin so it isn't all flat
+		TerrainSettings settings;
+		settings.patch_quads = 8;
+		settings.noise.flat_radius = 0.0f;
+		settings.noise.blend_distance = 1.0f;
+		constexpr uint32_t side = 9;
+
+		TerrainTileKey coarse{1, -3, 5};
+		TerrainTileKey fine{0, -6, 10};
+		TerrainTileKey fine_neighbour{0, -7, 10};
+
+		std::vector<TerrainVertex> coarse_vertices;
+		std::vector<TerrainVertex> fine_vertices;
+		std::vector<TerrainVertex> neighbour_vertices;
+		TerrainMesh::BuildVertices(settings, coarse, coarse_vertices);
+		TerrainMesh::BuildVertices(settings, fine, fine_vertices);
+		TerrainMesh::BuildVertices(settings, fine_neighbour, neighbour_vertices);
+
+		//The fine patch is the coarse one's -x, -z quarter, so its even vertices on the -x edge are the coarse
+		//patch's first few on that edge
+		for (uint32_t j = 0; j < side; j += 2)
+		{
+			assert(fine_vertices[j * side].position.y == coarse_vertices[(j / 2) * side].position.y);
+		}
+
+		//Same lod neighbours share every vertex on the edge between them
+		for (uint32_t j = 0; j < side; ++j)
+		{
+			assert(fine_vertices[j * side].position.y == neighbour_vertices[j * side + side - 1].position.y);
+		}
+
+		//Nothing is flat out here
+		bool any_height = false;
+		for (TerrainVertex const& vertex : coarse_vertices)
+		{
+			any_height |= vertex.position.y > 0.0f;
+		}
+		assert(any_height);
+
+		std::cout << "Terrain TestSharedEdges() Done\n";
+	}
+
+	void FloatingOriginTester::TestRebase()
+	{
+		std::cout << "FloatingOrigin TestRebase()\n";
+
+		Albuquerque::FloatingOrigin origin(2048.0f, 1024.0);
+
+		//Inside the distance nothing moves
+		assert(!origin.Update(glm::vec3(2000.0f, 500.0f, -2000.0f)));
+		assert(origin.RebaseCount() == 0);
+
+		glm::vec3 local(5000.3f, 120.5f, -2100.25f);
+		glm::dvec3 world = origin.ToWorld(local);
+
+		SphereColliders spheres;
+		spheres.Add(local, 1.0f);
+
+		std::optional<glm::vec3> shift = origin.Update(local);
+		assert(shift);
+		assert(origin.RebaseCount() == 1);
+		assert(shift->y == 0.0f);
+		assert(std::fmod(shift->x, 1024.0f) == 0.0f && std::fmod(shift->z, 1024.0f) == 0.0f);
+
+		//Whole number shifts are exact so moving everything by them loses nothing
+		local -= *shift;
+		spheres.Translate(-*shift);
+		assert(origin.ToWorld(local) == world);
+		assert(spheres.Center(0) == local);
+
+		//And the focus ends up back near the middle
+		assert(std::abs(local.x) <= 512.0f && std::abs(local.z) <= 512.0f);
+		assert(!origin.Update(local));
+
+		std::cout << "FloatingOrigin TestRebase() Done\n";
+	}
+
+	void InputRecordingTester::TestRoundTrip()
+	{
+		std::cout << "InputRecording TestRoundTrip()\n";
+
+		using namespace Albuquerque;
+
+		std::string file_path = (std::filesystem::temp_directory_path() / "planegame_input_test.bin").string();
+
+		//Some frames change the state and some don't, odd dts so any rounding would show
+		std::vector<InputFrame> frames;
+		InputState state;
+		for (uint32_t i = 0; i < 200; ++i)
+		{
+			if (i % 7 == 0)
+			{
+				state.SetKey(87 + (i % 3), (i / 7) % 2 == 0);
+				state.SetMouseButton(1, i % 14 == 0);
+				state.mouse_x = i * 1.25;
+				state.mouse_y = 900.0 - i * 0.5;
+			}
+			frames.push_back(InputFrame{ 1.0 / (50.0 + i % 13), i % 3, state });
+		}
+		state.SetKey(InputState::key_count - 1, true);
+		assert(state.Key(InputState::key_count - 1));
+		assert(!state.Key(InputState::key_count));
+
+		{
+			InputRecorder recorder;
+			bool opened = recorder.Open(file_path, 60.0);
+			assert(opened);
+			for (InputFrame const& frame : frames)
+			{
+				recorder.WriteFrame(frame);
+			}
+		}
+
+		//Unchanged frames are only the dt, the steps and the flags
+		size_t full_size = frames.size() * (sizeof(double) + 2 + sizeof(InputState));
+		assert(std::filesystem::file_size(file_path) < full_size / 2);
+
+		InputReplay replay;
+		bool opened = replay.Open(file_path);
+		assert(opened);
+		assert(replay.TickRate() == 60.0);
+		assert(replay.FrameCount() == frames.size());
+
+		InputFrame frame;
+		for (InputFrame const& expected : frames)
+		{
+			bool got_frame = replay.NextFrame(frame);
+			assert(got_frame);
+			assert(frame.dt == expected.dt);
+			assert(frame.steps == expected.steps);
+			assert(frame.state == expected.state);
+		}
+		assert(replay.Finished() && !replay.NextFrame(frame));
+
+		std::filesystem::remove(file_path);
+		std::cout << "InputRecording TestRoundTrip() Done\n";
+	}
+
+	void AudioTester::TestMixer()
+	{
+		std::cout << "Audio TestMixer()\n";
+
+		using namespace Albuquerque;
+
+		//Half scale mono, 10 ms at 48k
+		AudioClip clip;
+		clip.samples.assign(480, 16384);
+		clip.frame_count = 480;
+
+		auto play = [&clip](AudioMixer& mixer, uint32_t id, AudioPlayParams const& params)
+		{
+			AudioCommand command;
+			command.type = AudioCommand::Type::play;
+			command.voice_id = id;
+			command.clip = &clip;
+			command.params = params;
+			bool queued = mixer.Submit(command);
+			assert(queued);
+		};
+
+		auto close_to = [](float a, float b) { return std::abs(a - b) < 1e-3f; };
+		std::vector<float> output(256 * 2);
+
+		//One shot plays to the end of the clip and frees its voice
+		{
+			AudioMixer mixer(48000, 4, 16);
+			play(mixer, 1, {});
+			mixer.Mix(output.data(), 256);
+			assert(close_to(output[0], 0.5f) && close_to(output[1], 0.5f));
+			assert(mixer.GetStats().active_voices == 1);
+
+			mixer.Mix(output.data(), 256);
+			assert(close_to(output[(479 - 256) * 2], 0.5f));
+			assert(output[(480 - 256) * 2] == 0.0f);
+			mixer.Mix(output.data(), 256);
+			assert(mixer.GetStats().active_voices == 0);
+		}
+
+		//Twice the pitch is done in half the frames
+		{
+			AudioMixer mixer(48000, 4, 16);
+			AudioPlayParams params;
+			params.pitch = 2.0f;
+			play(mixer, 1, params);
+			mixer.Mix(output.data(), 256);
+			assert(close_to(output[239 * 2], 0.5f));
+			assert(output[240 * 2] == 0.0f);
+		}
+
+		//Lower priorities never steal, equal and higher ones do
+		{
+			AudioMixer mixer(48000, 4, 16);
+			AudioPlayParams params;
+			params.priority = 100;
+			params.loop = true;
+			for (uint32_t id = 1; id <= 4; ++id)
+				play(mixer, id, params);
+
+			params.priority = 50;
+			play(mixer, 5, params);
+			params.priority = 100;
+			play(mixer, 6, params);
+			params.priority = 200;
+			play(mixer, 7, params);
+			mixer.Mix(output.data(), 256);
+
+			AudioMixer::Stats stats = mixer.GetStats();
+			assert(stats.active_voices == 4);
+			assert(stats.rejected_voices == 1);
+			assert(stats.stolen_voices == 2);
+		}
+
+		//Spatial voice to the right of the listener is only in the right channel, with 1/distance past min_distance,
+		//and moving everything together changes nothing
+		{
+			AudioMixer mixer(48000, 4, 16);
+			AudioPlayParams params;
+			params.spatial = true;
+			params.position = glm::vec3(20.0f, 0.0f, 0.0f);
+			params.min_distance = 10.0f;
+			params.max_distance = 100.0f;
+			params.loop = true;
+			play(mixer, 1, params);
+			mixer.Mix(output.data(), 256);
+			assert(close_to(output[0], 0.0f) && close_to(output[1], 0.25f));
+
+			AudioCommand translate;
+			translate.type = AudioCommand::Type::translate;
+			translate.forward = glm::vec3(5000.0f, 0.0f, 0.0f);
+			mixer.Submit(translate);
+			mixer.Mix(output.data(), 256);
+			assert(close_to(output[511], 0.25f));
+
+			//Past max_distance it ramps down to silence over one block
+			AudioCommand move;
+			move.type = AudioCommand::Type::set_position;
+			move.voice_id = 1;
+			move.params.position = glm::vec3(5200.0f, 0.0f, 0.0f);
+			mixer.Submit(move);
+			mixer.Mix(output.data(), 256);
+			mixer.Mix(output.data(), 256);
+			assert(output[1] == 0.0f && output[511] == 0.0f);
+		}
+
+		std::cout << "Audio TestMixer() Done\n";
+	}
+
+	void AudioTester::TestNullBackend()
+	{
+		std::cout << "Audio TestNullBackend()\n";
+
+		Albuquerque::AudioSettings settings;
+		settings.null_backend = true;
+		Albuquerque::AudioSystem audio;
+		bool initialized = audio.Initialize(settings);
+		assert(initialized);
+
+		//50 ms stereo clip
+		std::vector<int16_t> samples(2 * 2400, 1000);
+		Albuquerque::AudioClipId clip = audio.AddClip(samples, 2);
+		assert(clip != Albuquerque::invalid_audio_clip);
+		assert(audio.ClipBytes() == samples.size() * sizeof(int16_t));
+
+		for (int i = 0; i < 8; ++i)
+		{
+			Albuquerque::AudioVoice voice = audio.Play(clip);
+			assert(voice.IsValid());
+		}
+
+		//The null backend pulls in real time, give it a good while past the clip's length
+		auto start = std::chrono::steady_clock::now();
+		Albuquerque::AudioMixer::Stats stats = audio.GetStats();
+		while ((stats.mixed_voice_frames < 8 * 2400 || stats.active_voices != 0) &&
+			std::chrono::steady_clock::now() - start < std::chrono::seconds(2))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			stats = audio.GetStats();
+		}
+
+		assert(stats.mixed_voice_frames >= 8 * 2400);
+		assert(stats.active_voices == 0);
+		assert(audio.DroppedCommands() == 0);
+
+		std::cout << "Audio TestNullBackend() Done\n";
+	}
+
+	void AudioTester::TestMusicStream()
+	{
+		std::cout << "Audio TestMusicStream()\n";
+
+		//0.3 s of 48k stereo 16 bit, as the most basic WAV there is
+		std::string file_path = (std::filesystem::temp_directory_path() / "planegame_music_test.wav").string();
+		uint32_t const frame_count = 14400;
+		{
+			std::ofstream file(file_path, std::ios::binary);
+			auto write = [&file](auto value) { file.write(reinterpret_cast<char const*>(&value), sizeof(value)); };
+			uint32_t data_bytes = frame_count * 2 * sizeof(int16_t);
+			file.write("RIFF", 4);
+			write(uint32_t(36 + data_bytes));
+			file.write("WAVEfmt ", 8);
+			write(uint32_t(16));
+			write(uint16_t(1));
+			write(uint16_t(2));
+			write(uint32_t(48000));
+			write(uint32_t(48000 * 2 * sizeof(int16_t)));
+			write(uint16_t(2 * sizeof(int16_t)));
+			write(uint16_t(16));
+			file.write("data", 4);
+			write(data_bytes);
+			for (uint32_t i = 0; i < frame_count * 2; ++i)
+			{
+				write(int16_t(i % 2000));
+			}
+		}
+
+		Albuquerque::AudioSettings settings;
+		settings.null_backend = true;
+		settings.music_buffer_seconds = 0.05f;
+		Albuquerque::AudioSystem audio;
+		bool initialized = audio.Initialize(settings);
+		assert(initialized);
+
+		Albuquerque::AudioMusicParams params;
+		params.loop = false;
+		Albuquerque::AudioMusicId music = audio.OpenMusic(file_path, params);
+		assert(music != Albuquerque::invalid_audio_music);
+		assert(audio.MusicBytes() < std::filesystem::file_size(file_path));
+
+		audio.PlayMusic(music, 0.05f);
+		auto start = std::chrono::steady_clock::now();
+		auto wait_for = [&](auto done)
+		{
+			Albuquerque::AudioMixer::Stats stats = audio.GetStats();
+			while (!done(stats) && std::chrono::steady_clock::now() - start < std::chrono::seconds(3))
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				stats = audio.GetStats();
+			}
+			return stats;
+		};
+
+		//Nothing is playing before the mixer picks up the command, so it has to start before it can end
+		Albuquerque::AudioMixer::Stats stats = wait_for([](auto const& stats) { return stats.active_music == 1; });
+		assert(stats.active_music == 1);
+		stats = wait_for([](auto const& stats) { return stats.active_music == 0; });
+
+		//Played the whole file out and let its slot go
+		assert(stats.active_music == 0);
+		assert(stats.music_frames >= frame_count);
+		std::cout << "  " << audio.MusicBytes() / 1024 << " KiB buffered, " << stats.music_underruns << " underruns\n";
+
+		audio.Shutdown();
+		std::filesystem::remove(file_path);
+		std::cout << "Audio TestMusicStream() Done\n";
+	}
+
+	void ScriptingTester::TestSandbox()
+	{
+		std::cout << "Scripting TestSandbox()\n";
+
+		using namespace Albuquerque;
+
+		ScriptRuntime scripts;
+		scripts.Initialize({.instruction_budget = 10000, .strikes_to_disable = 2});
+
+		std::vector<float> height(8, 0.0f);
+		scripts.BindArray("height", height);
+
+		ScriptId rise = scripts.Load("rise", R"(
+			function update(first, last, dt)
+				for i = first, last do
+					height[i] = height[i] + dt
+				end
+			end)");
+		scripts.SetRange(rise, 0, 4);
+
+		ScriptId runaway = scripts.Load("runaway", "function update() while true do end end");
+		scripts.SetRange(runaway, 0, 1);
+
+		//Neither of these exist in a sandbox
+		ScriptId escape = scripts.Load("escape", "function update() os.exit(1) end");
+		scripts.SetRange(escape, 0, 1);
+		ScriptId probe = scripts.Load("probe", R"(
+			function update()
+				assert(load == nil and require == nil and io == nil and debug == nil)
+				assert(getmetatable == nil and setmetatable == nil and collectgarbage == nil and print == nil)
+			end)");
+		scripts.SetRange(probe, 0, 1);
+
+		ScriptId out_of_range = scripts.Load("out_of_range", "function update() height[#height] = 1 end");
+		scripts.SetRange(out_of_range, 0, 1);
+
+		//Globals and library changes stay in their own sandbox
+		ScriptId vandal = scripts.Load("vandal", "secret = 1 math.floor = nil function update() end");
+		scripts.SetRange(vandal, 0, 1);
+		ScriptId reader = scripts.Load("reader", R"(
+			function update(first, last)
+				assert(secret == nil)
+				height[last] = math.floor(2.5)
+			end)");
+		scripts.SetRange(reader, 7, 1);
+
+		assert(scripts.Load("no_update", "local x = 1") == invalid_script);
+		assert(scripts.Load("syntax", "function update(") == invalid_script);
+		assert(scripts.Load("slow_load", "while true do end") == invalid_script);
+
+		scripts.Tick(0.5);
+		for (size_t i = 0; i < height.size(); ++i)
+		{
+			float const expected = i < 4 ? 0.5f : (i == 7 ? 2.0f : 0.0f);
+			assert(height[i] == expected);
+		}
+
+		ScriptRuntime::Stats stats = scripts.GetStats();
+		assert(stats.budget_overruns == 1 && stats.errors == 2);
+		assert(scripts.GetScript(runaway).budget_overruns == 1 && !scripts.GetScript(runaway).disabled);
+		assert(scripts.GetScript(escape).errors == 1);
+		assert(scripts.GetScript(out_of_range).last_error.find("out of range") != std::string::npos);
+		assert(scripts.GetScript(reader).errors == 0 && scripts.GetScript(vandal).errors == 0 && scripts.GetScript(probe).errors == 0);
+
+		//Second bad tick in a row disables them, the good ones carry on
+		scripts.Tick(0.5);
+		assert(scripts.GetScript(runaway).disabled && scripts.GetScript(escape).disabled && scripts.GetScript(out_of_range).disabled);
+		assert(!scripts.GetScript(rise).disabled && height[0] == 1.0f);
+		stats = scripts.GetStats();
+		assert(stats.disabled_scripts == 3);
+
+		scripts.Tick(0.5);
+		assert(scripts.GetStats().scripts_run == scripts.ScriptCount() - 3);
+
+		//Once warmed up, a tick that only does math through the views doesn't allocate
+		assert(scripts.GetStats().tick_allocations == 0);
+
+		scripts.Enable(runaway);
+		scripts.Tick(0.5);
+		assert(scripts.GetScript(runaway).budget_overruns == 3);
+
+		//Rebinding moves the view without reloading anything
+		std::vector<float> bigger(16, 10.0f);
+		scripts.BindArray("height", bigger);
+		scripts.Tick(1.0);
+		assert(bigger[0] == 11.0f && bigger[15] == 10.0f && height[0] == 2.0f);
+
+		std::cout << "Scripting TestSandbox() Done\n";
+	}
+
+	void ScriptingTester::TestMemoryLimit()
+	{
+		std::cout << "Scripting TestMemoryLimit()\n";
+
+		using namespace Albuquerque;
+
+		ScriptRuntime scripts;
+		scripts.Initialize({.instruction_budget = 100000000, .memory_limit = 1024 * 1024});
+
+		ScriptId hoarder = scripts.Load("hoarder", R"(
+			hoard = {}
+			function update()
+				for i = 1, 10000000 do
+					hoard[#hoard + 1] = "some text " .. i
+				end
+			end)");
+		scripts.SetRange(hoarder, 0, 1);
+		scripts.Tick(0.0);
+
+		ScriptRuntime::Stats stats = scripts.GetStats();
+		assert(scripts.GetScript(hoarder).errors == 1);
+		assert(scripts.GetScript(hoarder).last_error.find("memory") != std::string::npos);
+		assert(stats.memory.refused > 0 && stats.memory.high_water <= 1024 * 1024);
+
+		std::cout << "Scripting TestMemoryLimit() Done\n";
+	}
+
+	void LevelEditorTester::TestUndoRedo()
+	{
+		std::cout << "LevelEditor TestUndoRedo()\n";
+
+		std::mt19937 random(5);
+		auto uniform = [&random](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+		auto random_center = [&]() { return glm::vec3(uniform(-500.0f, 500.0f), 0.0f, uniform(-500.0f, 500.0f)); };
+
+		AABBColliders buildings;
+		for (int i = 0; i < 200; ++i)
+			buildings.Add(random_center(), glm::vec3(10.0f));
+
+		//Level contents in dense order, what undoing everything has to bring back. Handles may change, the
+		//boxes may not
+		auto snapshot = [&]()
+		{
+			std::vector<std::pair<glm::vec3, glm::vec3>> boxes;
+			for (uint32_t i = 0; i < buildings.Size(); ++i)
+				boxes.emplace_back(buildings.Center(i), buildings.HalfExtents(i));
+			std::sort(boxes.begin(), boxes.end(), [](auto const& a, auto const& b)
+			{
+				return std::tie(a.first.x, a.first.z, a.second.x) < std::tie(b.first.x, b.first.z, b.second.x);
+			});
+			return boxes;
+		};
+		auto same = [](auto const& a, auto const& b)
+		{
+			if (a.size() != b.size())
+				return false;
+			for (size_t i = 0; i < a.size(); ++i)
+			{
+				if (a[i].first != b[i].first || a[i].second != b[i].second)
+					return false;
+			}
+			return true;
+		};
+
+		//Stands in for the culler and the uniforms, replaying the changes has to keep it matching the store
+		std::vector<WorldHandle> mirror = buildings.slots.Handles();
+		std::vector<glm::vec3> mirror_centers;
+		for (uint32_t i = 0; i < buildings.Size(); ++i)
+			mirror_centers.push_back(buildings.Center(i));
+		std::vector<WorldChange> changes;
+		auto replay = [&](LevelEditor& editor)
+		{
+			editor.TakeChanges(changes);
+			for (WorldChange const& change : changes)
+			{
+				switch (change.type)
+				{
+				case WorldChange::added:
+					assert(change.dense_index == mirror.size());
+					mirror.push_back(change.handle);
+					mirror_centers.push_back(change.center);
+					break;
+				case WorldChange::moved:
+					assert(mirror[change.dense_index] == change.handle);
+					mirror_centers[change.dense_index] = change.center;
+					break;
+				case WorldChange::removed:
+					assert(mirror[change.dense_index] == change.handle);
+					mirror[change.dense_index] = mirror.back();
+					mirror.pop_back();
+					mirror_centers[change.dense_index] = mirror_centers.back();
+					mirror_centers.pop_back();
+					break;
+				}
+			}
+			assert(mirror == buildings.slots.Handles());
+			for (uint32_t i = 0; i < buildings.Size(); ++i)
+				assert(mirror_centers[i] == buildings.Center(i));
+		};
+
+		auto before = snapshot();
+		LevelEditor editor(buildings);
+		constexpr int edit_count = 300;
+		for (int i = 0; i < edit_count; ++i)
+		{
+			WorldHandle picked = buildings.slots.Handle(random() % buildings.Size());
+			switch (i % 4)
+			{
+			case 0:
+				editor.Add(random_center(), glm::vec3(uniform(5.0f, 20.0f)));
+				break;
+			case 1:
+				editor.Remove(picked);
+				break;
+			default:
+				editor.Move(picked, random_center());
+				break;
+			}
+			if (i % 10 == 0)
+				replay(editor);
+		}
+		replay(editor);
+		assert(editor.HistorySize() == edit_count && editor.Cursor() == edit_count);
+		auto after = snapshot();
+
+		while (editor.Undo()) {}
+		replay(editor);
+		assert(same(snapshot(), before));
+
+		while (editor.Redo()) {}
+		replay(editor);
+		assert(same(snapshot(), after));
+
+		//A new edit after undoing drops what could have been redone
+		editor.Undo();
+		editor.Undo();
+		editor.Move(buildings.slots.Handle(0), glm::vec3(0.0f));
+		assert(!editor.CanRedo() && editor.HistorySize() == edit_count - 1);
+
+		//A drag merges into one edit, undone in one go
+		WorldHandle dragged = buildings.slots.Handle(1);
+		glm::vec3 start = buildings.Center(1);
+		for (int i = 1; i <= 10; ++i)
+			editor.Move(dragged, start + glm::vec3(float(i), 0.0f, 0.0f), i > 1);
+		assert(editor.HistorySize() == edit_count);
+		editor.Undo();
+		assert(buildings.Center(buildings.slots.DenseIndex(dragged)) == start);
+		replay(editor);
+
+		//Stale handles do nothing
+		WorldHandle removed = buildings.slots.Handle(2);
+		editor.Remove(removed);
+		assert(!editor.Move(removed, glm::vec3(0.0f)) && !editor.Remove(removed));
+		replay(editor);
+
+		std::cout << "LevelEditor TestUndoRedo() Done, " << editor.HistoryBytes() << " bytes of history\n";
+	}
+
+	void JobSystemBenchmark::SpawnOverhead()
+	{
+		std::cout << "JobSystem SpawnOverhead()\n";
+
+		auto& job_system = Albuquerque::JobSystem::Instance();
+		constexpr uint32_t job_count = 100000;
+		std::atomic<uint32_t> ran = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		Albuquerque::JobCounter counter;
+		for (uint32_t i = 0; i < job_count; ++i)
+		{
+			job_system.Run("Empty Job", [&ran]() { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		job_system.Wait(counter);
+
+		double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+		assert(ran == job_count);
+		std::cout << "  " << job_count << " jobs on " << job_system.ThreadCount() << " threads, "
+			<< elapsed_ns / job_count << " ns per job\n";
+	}
+
+	void JobSystemBenchmark::ScalingEfficiency()
+	{
+		std::cout << "JobSystem ScalingEfficiency()\n";
+
+		auto& job_system = Albuquerque::JobSystem::Instance();
+
+		//Enough maths per element that the loop is compute bound rather than memory bound
+		std::vector<float> values(1 << 20);
+		auto work = [&values](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; ++i)
+			{
+				float x = static_cast<float>(i);
+				for (int k = 0; k < 32; ++k)
+				{
+					x = std::sqrt(x * x + 1.0f);
+				}
+				values[i] = x;
+			}
+		};
+
+		auto time_ms = [](auto&& function)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		double serial_ms = time_ms([&]() { work(0, values.size()); });
+		float serial_check = values.back();
+
+		for (size_t grain_size : { size_t(256), size_t(4096), size_t(65536) })
+		{
+			double parallel_ms = time_ms([&]() { job_system.ParallelFor("Scaling Benchmark", values.size(), grain_size, work); });
+			assert(values.back() == serial_check);
+
+			double speedup = serial_ms / parallel_ms;
+			std::cout << "  grain " << grain_size << ": serial " << serial_ms << " ms, parallel " << parallel_ms
+				<< " ms, speedup " << speedup << "x, efficiency " << 100.0 * speedup / job_system.ThreadCount() << "%\n";
+		}
+	}
+
+	void CollisionBenchmark::SweepCost()
+	{
+		std::cout << "Collision SweepCost()\n";
+
+		//About what a big level has, spread over the same few km
+		std::mt19937 random(42);
+		auto uniform = [&random](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+
+		AABBColliders buildings;
+		for (int i = 0; i < 2000; ++i)
+		{
+			buildings.Add(glm::vec3(uniform(-2000.0f, 2000.0f), uniform(0.0f, 100.0f), uniform(-2000.0f, 2000.0f)),
+				glm::vec3(uniform(5.0f, 30.0f), uniform(10.0f, 100.0f), uniform(5.0f, 30.0f)));
+		}
+
+		//Boosted ticks at 60 Hz are about 150 units long
+		constexpr uint32_t query_count = 20000;
+		std::vector<glm::vec3> starts(query_count);
+		std::vector<glm::vec3> ends(query_count);
+		for (uint32_t i = 0; i < query_count; ++i)
+		{
+			starts[i] = glm::vec3(uniform(-2000.0f, 2000.0f), uniform(0.0f, 200.0f), uniform(-2000.0f, 2000.0f));
+			ends[i] = starts[i] + glm::vec3(uniform(-1.0f, 1.0f), uniform(-0.2f, 0.2f), uniform(-1.0f, 1.0f)) * 150.0f;
+		}
+
+		auto time_ns = [](auto&& function)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		uint32_t swept_hits = 0;
+		uint32_t discrete_hits = 0;
+		double sweep_ns = time_ns([&]()
+		{
+			for (uint32_t i = 0; i < query_count; ++i)
+				swept_hits += buildings.Sweep(starts[i], ends[i], 2.0f) >= 0;
+		});
+		double overlap_ns = time_ns([&]()
+		{
+			for (uint32_t i = 0; i < query_count; ++i)
+				discrete_hits += buildings.FirstOverlap(ends[i], 2.0f) >= 0;
+		});
+
+		//Every end overlap is on the swept path too
+		assert(swept_hits >= discrete_hits);
+		std::cout << "  " << buildings.Size() << " boxes: sweep " << sweep_ns / query_count << " ns, discrete "
+			<< overlap_ns / query_count << " ns per tick, " << swept_hits << " swept hits vs " << discrete_hits << " discrete\n";
+	}
+
+	void AudioBenchmark::MixerCost()
+	{
+		std::cout << "Audio MixerCost()\n";
+
+		using namespace Albuquerque;
+
+		//One second of noise so nothing gets cached away
+		AudioClip clip;
+		clip.samples.resize(48000);
+		uint32_t seed = 1;
+		for (int16_t& sample : clip.samples)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			sample = static_cast<int16_t>(seed >> 16);
+		}
+		clip.frame_count = 48000;
+
+		constexpr uint32_t voice_count = 100;
+		AudioMixer mixer(48000, 128, 256);
+		for (uint32_t i = 0; i < voice_count; ++i)
+		{
+			AudioCommand command;
+			command.type = AudioCommand::Type::play;
+			command.voice_id = i + 1;
+			command.clip = &clip;
+			command.params.gain = 0.01f;
+			command.params.pitch = 0.8f + 0.4f * i / voice_count;
+			command.params.loop = true;
+			command.params.spatial = true;
+			command.params.position = glm::vec3(std::cos(float(i)), 0.0f, std::sin(float(i))) * (5.0f + i);
+			mixer.Submit(command);
+		}
+
+		//10 seconds of audio in 10 ms blocks
+		constexpr uint32_t block_frames = 480;
+		constexpr uint32_t block_count = 1000;
+		std::vector<float> output(block_frames * 2);
+		for (uint32_t i = 0; i < block_count; ++i)
+		{
+			mixer.Mix(output.data(), block_frames);
+		}
+
+		AudioMixer::Stats stats = mixer.GetStats();
+		assert(stats.active_voices == voice_count);
+		std::cout << "  " << voice_count << " voices, " << stats.mix_seconds * 1e6 / block_count << " us per "
+			<< block_frames << " frame block, " << stats.CpuPercentPer100Voices(mixer.SampleRate()) << "% of a core per 100 voices\n";
+	}
+
+	void ScriptingBenchmark::ObjectUpdate()
+	{
+		std::cout << "Scripting ObjectUpdate()\n";
+
+		using namespace Albuquerque;
+
+		constexpr uint32_t object_count = 10000;
+		constexpr uint32_t kinds = 4;
+
+		std::vector<float> position_x(object_count);
+		std::vector<float> position_y(object_count);
+		std::vector<float> rotation_y(object_count, 0.0f);
+		std::vector<float> phase(object_count);
+		for (uint32_t i = 0; i < object_count; ++i)
+		{
+			position_x[i] = float(i % 100) * 10.0f;
+			position_y[i] = 5.0f;
+			phase[i] = float(i) * 0.1f;
+		}
+
+		//Spinning pickups, bobbing rings, sliding gates and pulsing lights
+		char const* const sources[kinds] = {
+			R"(function update(first, last, dt)
+				for i = first, last do rotation_y[i] = (rotation_y[i] + 90 * dt) % 360 end
+			end)",
+			R"(local time = 0
+			function update(first, last, dt)
+				time = time + dt
+				local sin = math.sin
+				for i = first, last do position_y[i] = 5 + sin(time + phase[i]) * 2 end
+			end)",
+			R"(function update(first, last, dt)
+				for i = first, last do
+					local x = position_x[i] + 20 * dt
+					if x > 1000 then x = x - 1000 end
+					position_x[i] = x
+				end
+			end)",
+			R"(local time = 0
+			function update(first, last, dt)
+				time = time + dt
+				for i = first, last do phase[i] = (phase[i] + dt) % 6.2831853 end
+			end)",
+		};
+
+		//The same spinners written the way a binding without views forces it: a table per object in and out
+		char const* const per_object_tables = R"(
+			local function spin(object, dt)
+				object.rotation_y = (object.rotation_y + 90 * dt) % 360
+				return object
+			end
+			function update(first, last, dt)
+				for i = first, last do
+					local object = {x = position_x[i], y = position_y[i], rotation_y = rotation_y[i]}
+					rotation_y[i] = spin(object, dt).rotation_y
+				end
+			end)";
+
+		auto run = [&](char const* label, std::vector<char const*> const& script_sources)
+		{
+			ScriptRuntime scripts;
+			scripts.Initialize();
+			scripts.BindArray("position_x", position_x);
+			scripts.BindArray("position_y", position_y);
+			scripts.BindArray("rotation_y", rotation_y);
+			scripts.BindArray("phase", phase);
+
+			uint32_t const range = object_count / uint32_t(script_sources.size());
+			for (uint32_t i = 0; i < script_sources.size(); ++i)
+			{
+				ScriptId id = scripts.Load(label + std::to_string(i), script_sources[i]);
+				scripts.SetRange(id, i * range, range);
+			}
+
+			constexpr double dt = 1.0 / 60.0;
+			for (int i = 0; i < 10; ++i)
+			{
+				scripts.Tick(dt);
+			}
+
+			constexpr int tick_count = 300;
+			uint64_t allocations = 0;
+			uint64_t heap_allocations = 0;
+			double total_ms = 0.0;
+			for (int i = 0; i < tick_count; ++i)
+			{
+				scripts.Tick(dt);
+				ScriptRuntime::Stats stats = scripts.GetStats();
+				assert(stats.errors == 0 && stats.budget_overruns == 0);
+				allocations += stats.tick_allocations;
+				heap_allocations += stats.tick_heap_allocations;
+				total_ms += stats.last_tick_ms;
+			}
+
+			ScriptRuntime::Stats stats = scripts.GetStats();
+			std::cout << "  " << label << ": " << total_ms / tick_count << " ms per tick for " << object_count << " objects ("
+				<< total_ms / tick_count * 1e6 / object_count << " ns each), " << double(allocations) / tick_count
+				<< " allocations and " << double(heap_allocations) / tick_count << " heap allocations per tick, "
+				<< stats.memory.high_water / 1024 << " KiB high water\n";
+		};
+
+		run("Array views", std::vector<char const*>(std::begin(sources), std::end(sources)));
+		run("Table per object", std::vector<char const*>(kinds, per_object_tables));
+	}
+
+	void GpuPickingTester::TestPickRegion()
+	{
+		std::cout << "GpuPicking TestPickRegion()\n";
+
+		using namespace Albuquerque;
+		constexpr uint32_t region = 9;
+		glm::vec2 viewport(1600.0f, 900.0f);
+		glm::vec2 cursor(400.0f, 300.0f);
+		glm::mat4 pick = GpuPicking::PickMatrix(cursor, viewport, region);
+
+		//Window pixels (y down) to clip space through a plain full screen view
+		auto to_clip = [&](glm::vec2 pixel)
+		{
+			return glm::vec4(2.0f * pixel.x / viewport.x - 1.0f, 1.0f - 2.0f * pixel.y / viewport.y, 0.5f, 1.0f);
+		};
+		auto nearly = [](float a, float b) { return std::abs(a - b) < 1e-3f; };
+
+		glm::vec4 middle = pick * to_clip(cursor);
+		assert(nearly(middle.x, 0.0f) && nearly(middle.y, 0.0f) && nearly(middle.z, 0.5f));
+
+		float half = region * 0.5f;
+		glm::vec4 bottom_left = pick * to_clip(cursor + glm::vec2(-half, half));
+		glm::vec4 top_right = pick * to_clip(cursor + glm::vec2(half, -half));
+		assert(nearly(bottom_left.x, -1.0f) && nearly(bottom_left.y, -1.0f));
+		assert(nearly(top_right.x, 1.0f) && nearly(top_right.y, 1.0f));
+
+		//w carries through, so it works the same after a perspective projection
+		glm::vec4 scaled = pick * (to_clip(cursor) * 4.0f);
+		assert(nearly(scaled.x / scaled.w, 0.0f) && nearly(scaled.y / scaled.w, 0.0f));
+
+		std::vector<uint32_t> ids(region * region, 0);
+		assert(GpuPicking::ResolveRegion(ids, region) == 0);
+
+		//A corner and something one off the middle, the nearer one wins
+		ids[0] = 7;
+		assert(GpuPicking::ResolveRegion(ids, region) == 7);
+		ids[4 * region + 5] = (2u << pick_index_bits) | 12345;
+		uint32_t picked = GpuPicking::ResolveRegion(ids, region);
+		assert(PickKind(picked) == 2 && PickIndex(picked) == 12345);
+
+		//Right under the cursor beats everything
+		ids[4 * region + 4] = 3;
+		assert(GpuPicking::ResolveRegion(ids, region) == 3);
+	}
+
+	void LevelEditorBenchmark::EditCost()
+	{
+		std::cout << "LevelEditor EditCost()\n";
+
+		std::mt19937 random(9);
+		auto uniform = [&random](float low, float high) { return std::uniform_real_distribution<float>(low, high)(random); };
+		auto random_center = [&]() { return glm::vec3(uniform(-20000.0f, 20000.0f), uniform(0.0f, 100.0f), uniform(-20000.0f, 20000.0f)); };
+
+		auto time_ns = [](auto&& function)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		for (uint32_t building_count : {10000u, 100000u})
+		{
+			AABBColliders buildings;
+			for (uint32_t i = 0; i < building_count; ++i)
+				buildings.Add(random_center(), glm::vec3(uniform(5.0f, 30.0f), uniform(10.0f, 100.0f), uniform(5.0f, 30.0f)));
+
+			LevelEditor editor(buildings);
+			std::vector<WorldChange> changes;
+			constexpr uint32_t edit_count = 10000;
+			double edit_ns = time_ns([&]()
+			{
+				for (uint32_t i = 0; i < edit_count; ++i)
+				{
+					WorldHandle picked = buildings.slots.Handle(random() % buildings.Size());
+					switch (i % 5)
+					{
+					case 0: editor.Add(random_center(), glm::vec3(10.0f)); break;
+					case 1: editor.Remove(picked); break;
+					case 2: editor.Undo(); break;
+					default: editor.Move(picked, random_center()); break;
+					}
+					//What the renderer does with them every frame
+					editor.TakeChanges(changes);
+				}
+			});
+
+			constexpr uint32_t ray_count = 10000;
+			uint32_t ray_hits = 0;
+			double ray_ns = time_ns([&]()
+			{
+				for (uint32_t i = 0; i < ray_count; ++i)
+				{
+					glm::vec3 origin = random_center() + glm::vec3(0.0f, 200.0f, 0.0f);
+					glm::vec3 direction = glm::normalize(glm::vec3(uniform(-1.0f, 1.0f), -0.3f, uniform(-1.0f, 1.0f)));
+					ray_hits += buildings.Raycast(origin, direction, 5000.0f) >= 0;
+				}
+			});
+
+			std::cout << "  " << buildings.Size() << " buildings: " << edit_ns / edit_count << " ns per edit, "
+				<< ray_ns / ray_count << " ns per raycast (" << ray_hits << " hits), " << editor.HistoryBytes() / 1024
+				<< " KiB of history, " << buildings.grid.CellCount() << " cells\n";
+		}
+	}
+
 	void Tests::RunTests()
 	{
 		PlaneGame::ConfigReaderTester::TestOne();
+		PlaneGame::WorldStoreTester::TestHandles();
+		PlaneGame::WorldStoreTester::TestGridRaycast();
+		PlaneGame::WorldStoreTester::TestCollect();
+		PlaneGame::CollisionTester::TestSweepProperties();
+		PlaneGame::GpuCullingTester::TestCommandLayout();
+		PlaneGame::GpuCullingTester::TestFrustum();
+		PlaneGame::OcclusionTester::TestDownsample();
+		PlaneGame::OcclusionTester::TestSoftwareOcclusion();
+		PlaneGame::TerrainTester::TestStitching();
+		PlaneGame::TerrainTester::TestSharedEdges();
+		PlaneGame::FloatingOriginTester::TestRebase();
+		PlaneGame::InputRecordingTester::TestRoundTrip();
+		PlaneGame::AudioTester::TestMixer();
+		PlaneGame::AudioTester::TestNullBackend();
+		PlaneGame::AudioTester::TestMusicStream();
+		PlaneGame::ScriptingTester::TestSandbox();
+		PlaneGame::ScriptingTester::TestMemoryLimit();
+		PlaneGame::LevelEditorTester::TestUndoRedo();
+		PlaneGame::GpuPickingTester::TestPickRegion();
+		PlaneGame::JobSystemBenchmark::SpawnOverhead();
+		PlaneGame::JobSystemBenchmark::ScalingEfficiency();
+		PlaneGame::CollisionBenchmark::SweepCost();
+		PlaneGame::AudioBenchmark::MixerCost();
+		PlaneGame::ScriptingBenchmark::ObjectUpdate();
+		PlaneGame::LevelEditorBenchmark::EditCost();
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,545 @@
+#include "WorldStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+namespace PlaneGame {
+
+namespace {
+// Overlap tests run a block at a time without branching so the inner loop
+// vectorizes, then the block is scanned for the first hit
+constexpr uint32_t collision_block_size = 16;
+
+template <typename T>
+void SwapRemove(std::vector<T>& values, uint32_t removed, uint32_t last) {
+  values[removed] = values[last];
+  values.pop_back();
+}
+
+// One axis at a time so it is a plain loop over a float array
+void TranslateAxis(std::vector<float>& values, float offset) {
+  for (float& value : values) {
+    value += offset;
+  }
+}
+
+// Bounds of everything a sphere touches moving from start to end
+struct SweepBounds {
+  glm::vec3 min;
+  glm::vec3 max;
+
+  SweepBounds(glm::vec3 start, glm::vec3 end, float radius) {
+    min = glm::vec3(std::min(start.x, end.x), std::min(start.y, end.y),
+                    std::min(start.z, end.z)) -
+          radius;
+    max = glm::vec3(std::max(start.x, end.x), std::max(start.y, end.y),
+                    std::max(start.z, end.z)) +
+          radius;
+  }
+};
+}  // namespace
+
+bool SweepSphereSphere(glm::vec3 start, glm::vec3 end, float radius,
+                       glm::vec3 center, float other_radius,
+                       float& time_of_impact) {
+  glm::vec3 motion = end - start;
+  glm::vec3 offset = start - center;
+  float combined_radius = radius + other_radius;
+
+  // |offset + t * motion|^2 = combined_radius^2
+  float c = glm::dot(offset, offset) - combined_radius * combined_radius;
+  if (c <= 0.0f) {
+    time_of_impact = 0.0f;
+    return true;
+  }
+
+  float a = glm::dot(motion, motion);
+  float b = glm::dot(offset, motion);
+  // Not moving, or moving away
+  if (a == 0.0f || b >= 0.0f) return false;
+
+  float discriminant = b * b - a * c;
+  if (discriminant < 0.0f) return false;
+
+  float t = (-b - std::sqrt(discriminant)) / a;
+  if (t > 1.0f) return false;
+
+  time_of_impact = t;
+  return true;
+}
+
+bool SweepSphereAABB(glm::vec3 start, glm::vec3 end, float radius,
+                     glm::vec3 center, glm::vec3 half_extents,
+                     float& time_of_impact) {
+  glm::vec3 motion = end - start;
+  glm::vec3 box_min = center - half_extents;
+  glm::vec3 box_max = center + half_extents;
+
+  // Where the centre crosses a plane of the box. In between, every axis is
+  // either below, inside or above the box the whole time
+  float times[8];
+  uint32_t time_count = 0;
+  times[time_count++] = 0.0f;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (motion[axis] == 0.0f) continue;
+    for (float plane : {box_min[axis], box_max[axis]}) {
+      float t = (plane - start[axis]) / motion[axis];
+      if (t > 0.0f && t < 1.0f) times[time_count++] = t;
+    }
+  }
+  times[time_count++] = 1.0f;
+  std::sort(times, times + time_count);
+
+  float radius_squared = radius * radius;
+  for (uint32_t piece = 0; piece + 1 < time_count; ++piece) {
+    float t0 = times[piece];
+    float t1 = times[piece + 1];
+    float middle = 0.5f * (t0 + t1);
+
+    // Squared distance over the piece is the sum of the outside axes'
+    // (offset + t * rate)^2, as a * t^2 + b * t + c
+    float a = 0.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+      float position = start[axis] + middle * motion[axis];
+      float offset, rate;
+      if (position < box_min[axis]) {
+        offset = box_min[axis] - start[axis];
+        rate = -motion[axis];
+      } else if (position > box_max[axis]) {
+        offset = start[axis] - box_max[axis];
+        rate = motion[axis];
+      } else {
+        continue;
+      }
+      a += rate * rate;
+      b += 2.0f * offset * rate;
+      c += offset * offset;
+    }
+    c -= radius_squared;
+
+    if (a * t0 * t0 + b * t0 + c <= 0.0f) {
+      time_of_impact = t0;
+      return true;
+    }
+
+    // Distance only falls on this piece if the smaller root is inside it
+    float discriminant = b * b - 4.0f * a * c;
+    if (a == 0.0f || discriminant < 0.0f) continue;
+
+    float t = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if (t >= t0 && t <= t1) {
+      time_of_impact = t;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+WorldHandle SlotMap::Insert() {
+  uint32_t slot_index;
+  if (!free_slots.empty()) {
+    slot_index = free_slots.back();
+    free_slots.pop_back();
+  } else {
+    slot_index = static_cast<uint32_t>(slots.size());
+    slots.emplace_back();
+  }
+
+  Slot& slot = slots[slot_index];
+  slot.dense_index = static_cast<uint32_t>(dense_handles.size());
+  slot.occupied = true;
+
+  WorldHandle handle{slot_index, slot.generation};
+  dense_handles.push_back(handle);
+  return handle;
+}
+
+bool SlotMap::Remove(WorldHandle handle, uint32_t& removed_dense,
+                     uint32_t& last_dense) {
+  if (!Contains(handle)) return false;
+
+  Slot& slot = slots[handle.index];
+  removed_dense = slot.dense_index;
+  last_dense = static_cast<uint32_t>(dense_handles.size() - 1);
+
+  // The last object takes the removed one's place
+  WorldHandle moved = dense_handles[last_dense];
+  dense_handles[removed_dense] = moved;
+  slots[moved.index].dense_index = removed_dense;
+  dense_handles.pop_back();
+
+  slot.occupied = false;
+  slot.generation += 1;
+  free_slots.push_back(handle.index);
+  return true;
+}
+
+bool SlotMap::Contains(WorldHandle handle) const {
+  return handle.index < slots.size() && slots[handle.index].occupied &&
+         slots[handle.index].generation == handle.generation;
+}
+
+uint32_t SlotMap::DenseIndex(WorldHandle handle) const {
+  return slots[handle.index].dense_index;
+}
+
+void SlotMap::Clear() {
+  free_slots.clear();
+  // Reversed so the slots get reused in the same order as before
+  for (uint32_t i = static_cast<uint32_t>(slots.size()); i-- > 0;) {
+    if (slots[i].occupied) {
+      slots[i].occupied = false;
+      slots[i].generation += 1;
+    }
+    free_slots.push_back(i);
+  }
+  dense_handles.clear();
+}
+
+int32_t SpatialGrid::Cell(float position, double origin) const {
+  return static_cast<int32_t>(std::floor((double(position) - origin) / cell_size));
+}
+
+SpatialGrid::CellRange SpatialGrid::Range(glm::vec3 min, glm::vec3 max) const {
+  return {Cell(min.x, origin_x), Cell(min.z, origin_z), Cell(max.x, origin_x),
+          Cell(max.z, origin_z)};
+}
+
+void SpatialGrid::Erase(std::vector<uint32_t>& ids, uint32_t id) {
+  auto found = std::find(ids.begin(), ids.end(), id);
+  if (found == ids.end()) return;
+  *found = ids.back();
+  ids.pop_back();
+}
+
+void SpatialGrid::Insert(uint32_t id, glm::vec3 min, glm::vec3 max) {
+  CellRange range = Range(min, max);
+  if (id >= ranges.size()) ranges.resize(id + 1);
+  ranges[id] = range;
+  if (range.Count() > max_cells_per_box) {
+    oversized.push_back(id);
+    return;
+  }
+
+  for (int32_t x = range.min_x; x <= range.max_x; ++x) {
+    for (int32_t z = range.min_z; z <= range.max_z; ++z) {
+      cells[Key(x, z)].push_back(id);
+    }
+  }
+
+  if (bounds.min_x > bounds.max_x) {
+    bounds = range;
+  } else {
+    bounds.min_x = std::min(bounds.min_x, range.min_x);
+    bounds.min_z = std::min(bounds.min_z, range.min_z);
+    bounds.max_x = std::max(bounds.max_x, range.max_x);
+    bounds.max_z = std::max(bounds.max_z, range.max_z);
+  }
+}
+
+void SpatialGrid::Remove(uint32_t id) {
+  CellRange range = ranges[id];
+  if (range.Count() > max_cells_per_box) {
+    Erase(oversized, id);
+    return;
+  }
+
+  for (int32_t x = range.min_x; x <= range.max_x; ++x) {
+    for (int32_t z = range.min_z; z <= range.max_z; ++z) {
+      auto found = cells.find(Key(x, z));
+      if (found == cells.end()) continue;
+      Erase(found->second, id);
+      // Empty cells go, bounds stay as they are since shrinking them would
+      // mean looking at every cell
+      if (found->second.empty()) cells.erase(found);
+    }
+  }
+}
+
+void SpatialGrid::Move(uint32_t id, glm::vec3 new_min, glm::vec3 new_max) {
+  if (ranges[id] == Range(new_min, new_max)) return;
+  Remove(id);
+  Insert(id, new_min, new_max);
+}
+
+void SpatialGrid::Clear() {
+  cells.clear();
+  oversized.clear();
+  ranges.clear();
+  bounds = {0, 0, -1, -1};
+  origin_x = 0.0;
+  origin_z = 0.0;
+}
+
+void SpatialGrid::Translate(glm::vec3 offset) {
+  origin_x += offset.x;
+  origin_z += offset.z;
+}
+
+WorldHandle SphereColliders::Add(glm::vec3 center, float sphere_radius,
+                                 uint32_t sphere_flags) {
+  center_x.push_back(center.x);
+  center_y.push_back(center.y);
+  center_z.push_back(center.z);
+  radius.push_back(sphere_radius);
+  flags.push_back(sphere_flags);
+  return slots.Insert();
+}
+
+void SphereColliders::Remove(WorldHandle handle) {
+  uint32_t removed, last;
+  if (!slots.Remove(handle, removed, last)) return;
+
+  SwapRemove(center_x, removed, last);
+  SwapRemove(center_y, removed, last);
+  SwapRemove(center_z, removed, last);
+  SwapRemove(radius, removed, last);
+  SwapRemove(flags, removed, last);
+}
+
+void SphereColliders::Clear() {
+  slots.Clear();
+  center_x.clear();
+  center_y.clear();
+  center_z.clear();
+  radius.clear();
+  flags.clear();
+}
+
+void SphereColliders::Translate(glm::vec3 offset) {
+  TranslateAxis(center_x, offset.x);
+  TranslateAxis(center_y, offset.y);
+  TranslateAxis(center_z, offset.z);
+}
+
+int32_t SphereColliders::FirstOverlap(glm::vec3 center, float query_radius,
+                                      uint32_t skip_flags) const {
+  uint32_t count = Size();
+  for (uint32_t start = 0; start < count; start += collision_block_size) {
+    uint32_t end = std::min(start + collision_block_size, count);
+
+    bool hit[collision_block_size];
+    for (uint32_t i = start; i < end; ++i) {
+      float dx = center_x[i] - center.x;
+      float dy = center_y[i] - center.y;
+      float dz = center_z[i] - center.z;
+      float r = radius[i] + query_radius;
+      hit[i - start] =
+          (dx * dx + dy * dy + dz * dz < r * r) & ((flags[i] & skip_flags) == 0);
+    }
+
+    for (uint32_t i = start; i < end; ++i) {
+      if (hit[i - start]) return static_cast<int32_t>(i);
+    }
+  }
+
+  return -1;
+}
+
+int32_t SphereColliders::Sweep(glm::vec3 start, glm::vec3 end,
+                               float sweep_radius, uint32_t skip_flags,
+                               float* time_of_impact) const {
+  SweepBounds bounds(start, end, sweep_radius);
+
+  int32_t first = -1;
+  float first_time = 2.0f;
+
+  uint32_t count = Size();
+  for (uint32_t block = 0; block < count; block += collision_block_size) {
+    uint32_t block_end = std::min(block + collision_block_size, count);
+
+    bool candidate[collision_block_size];
+    for (uint32_t i = block; i < block_end; ++i) {
+      float r = radius[i];
+      candidate[i - block] =
+          (center_x[i] + r >= bounds.min.x) & (center_x[i] - r <= bounds.max.x) &
+          (center_y[i] + r >= bounds.min.y) & (center_y[i] - r <= bounds.max.y) &
+          (center_z[i] + r >= bounds.min.z) & (center_z[i] - r <= bounds.max.z) &
+          ((flags[i] & skip_flags) == 0);
+    }
+
+    for (uint32_t i = block; i < block_end; ++i) {
+      float t;
+      if (candidate[i - block] &&
+          SweepSphereSphere(start, end, sweep_radius, Center(i), radius[i], t) &&
+          t < first_time) {
+        first = static_cast<int32_t>(i);
+        first_time = t;
+      }
+    }
+  }
+
+  if (time_of_impact != nullptr && first >= 0) *time_of_impact = first_time;
+  return first;
+}
+
+WorldHandle AABBColliders::Add(glm::vec3 center, glm::vec3 half_extents,
+                               uint32_t box_flags) {
+  center_x.push_back(center.x);
+  center_y.push_back(center.y);
+  center_z.push_back(center.z);
+  extent_x.push_back(half_extents.x);
+  extent_y.push_back(half_extents.y);
+  extent_z.push_back(half_extents.z);
+  flags.push_back(box_flags);
+
+  WorldHandle handle = slots.Insert();
+  grid.Insert(handle.index, center - half_extents, center + half_extents);
+  return handle;
+}
+
+void AABBColliders::Remove(WorldHandle handle) {
+  if (!slots.Contains(handle)) return;
+  uint32_t dense = slots.DenseIndex(handle);
+  grid.Remove(handle.index);
+
+  uint32_t removed, last;
+  slots.Remove(handle, removed, last);
+
+  SwapRemove(center_x, removed, last);
+  SwapRemove(center_y, removed, last);
+  SwapRemove(center_z, removed, last);
+  SwapRemove(extent_x, removed, last);
+  SwapRemove(extent_y, removed, last);
+  SwapRemove(extent_z, removed, last);
+  SwapRemove(flags, removed, last);
+}
+
+bool AABBColliders::Move(WorldHandle handle, glm::vec3 center) {
+  if (!slots.Contains(handle)) return false;
+  uint32_t dense = slots.DenseIndex(handle);
+  glm::vec3 half_extents = HalfExtents(dense);
+
+  center_x[dense] = center.x;
+  center_y[dense] = center.y;
+  center_z[dense] = center.z;
+  grid.Move(handle.index, center - half_extents, center + half_extents);
+  return true;
+}
+
+void AABBColliders::Clear() {
+  slots.Clear();
+  grid.Clear();
+  center_x.clear();
+  center_y.clear();
+  center_z.clear();
+  extent_x.clear();
+  extent_y.clear();
+  extent_z.clear();
+  flags.clear();
+}
+
+void AABBColliders::Translate(glm::vec3 offset) {
+  TranslateAxis(center_x, offset.x);
+  TranslateAxis(center_y, offset.y);
+  TranslateAxis(center_z, offset.z);
+
+  // The boxes keep their cells, only the grid's origin moves
+  grid.Translate(offset);
+}
+
+int32_t AABBColliders::FirstOverlap(glm::vec3 center, float radius) const {
+  uint32_t count = Size();
+  float radius_squared = radius * radius;
+
+  for (uint32_t start = 0; start < count; start += collision_block_size) {
+    uint32_t end = std::min(start + collision_block_size, count);
+
+    // Distance from the sphere centre to the box, per axis it is how far
+    // outside the slab the centre is (0 when inside)
+    bool hit[collision_block_size];
+    for (uint32_t i = start; i < end; ++i) {
+      float dx = std::max(std::abs(center.x - center_x[i]) - extent_x[i], 0.0f);
+      float dy = std::max(std::abs(center.y - center_y[i]) - extent_y[i], 0.0f);
+      float dz = std::max(std::abs(center.z - center_z[i]) - extent_z[i], 0.0f);
+      hit[i - start] = dx * dx + dy * dy + dz * dz < radius_squared;
+    }
+
+    for (uint32_t i = start; i < end; ++i) {
+      if (hit[i - start]) return static_cast<int32_t>(i);
+    }
+  }
+
+  return -1;
+}
+
+int32_t AABBColliders::Sweep(glm::vec3 start, glm::vec3 end, float radius,
+                             float* time_of_impact) const {
+  SweepBounds bounds(start, end, radius);
+
+  int32_t first = -1;
+  float first_time = 2.0f;
+
+  uint32_t count = Size();
+  for (uint32_t block = 0; block < count; block += collision_block_size) {
+    uint32_t block_end = std::min(block + collision_block_size, count);
+
+    bool candidate[collision_block_size];
+    for (uint32_t i = block; i < block_end; ++i) {
+      candidate[i - block] = (center_x[i] + extent_x[i] >= bounds.min.x) &
+                             (center_x[i] - extent_x[i] <= bounds.max.x) &
+                             (center_y[i] + extent_y[i] >= bounds.min.y) &
+                             (center_y[i] - extent_y[i] <= bounds.max.y) &
+                             (center_z[i] + extent_z[i] >= bounds.min.z) &
+                             (center_z[i] - extent_z[i] <= bounds.max.z);
+    }
+
+    for (uint32_t i = block; i < block_end; ++i) {
+      float t;
+      if (candidate[i - block] &&
+          SweepSphereAABB(start, end, radius, Center(i), HalfExtents(i), t) &&
+          t < first_time) {
+        first = static_cast<int32_t>(i);
+        first_time = t;
+      }
+    }
+  }
+
+  if (time_of_impact != nullptr && first >= 0) *time_of_impact = first_time;
+  return first;
+}
+
+int32_t AABBColliders::Raycast(glm::vec3 origin, glm::vec3 direction,
+                               float max_distance, float* hit_distance) const {
+  // Slab test. Dividing by a zero direction gives inf which the min/max
+  // handle correctly
+  glm::vec3 inverse_direction = 1.0f / direction;
+
+  int32_t closest = -1;
+  float closest_t = max_distance;
+
+  grid.WalkRay(origin, direction, max_distance,
+               [&](std::vector<uint32_t> const& ids, float exit) {
+    for (uint32_t slot : ids) {
+      uint32_t i = slots.SlotDenseIndex(slot);
+      float t1x = (center_x[i] - extent_x[i] - origin.x) * inverse_direction.x;
+      float t2x = (center_x[i] + extent_x[i] - origin.x) * inverse_direction.x;
+      float t1y = (center_y[i] - extent_y[i] - origin.y) * inverse_direction.y;
+      float t2y = (center_y[i] + extent_y[i] - origin.y) * inverse_direction.y;
+      float t1z = (center_z[i] - extent_z[i] - origin.z) * inverse_direction.z;
+      float t2z = (center_z[i] + extent_z[i] - origin.z) * inverse_direction.z;
+
+      float t_near = std::max({std::min(t1x, t2x), std::min(t1y, t2y),
+                               std::min(t1z, t2z), 0.0f});
+      float t_far = std::min({std::max(t1x, t2x), std::max(t1y, t2y),
+                              std::max(t1z, t2z)});
+
+      if (t_near <= t_far && t_near < closest_t) {
+        closest_t = t_near;
+        closest = static_cast<int32_t>(i);
+      }
+    }
+
+    // Every box reaching into a later cell is hit past this one's exit
+    return closest < 0 || closest_t > exit;
+  });
+
+  if (hit_distance != nullptr && closest >= 0) *hit_distance = closest_t;
+  return closest;
+}
+
+}  // namespace PlaneGame
@@ -0,0 +1,114 @@
+// Undo and redo for the level editor. Every edit is kept as one small delta
+// (what it did to which object, and where from and to) instead of a snapshot,
+// so the history stays tiny even in a level with 100k buildings. Doing or
+// undoing an edit changes exactly one object in the world store and leaves a
+// WorldChange behind, which the renderer uses to patch just that object's
+// part of the GPU buffers instead of rebuilding them.
+
+#pragma once
+
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <vector>
+
+#include "WorldStore.h"
+
+namespace PlaneGame {
+
+// Handles change when an object is removed and brought back by an undo, so the
+// history refers to objects by an id of its own that never changes
+using EditorObjectId = uint32_t;
+inline constexpr EditorObjectId invalid_editor_object =
+    std::numeric_limits<uint32_t>::max();
+
+enum class EditType : uint8_t { add, move, remove };
+
+struct EditRecord {
+  EditType type = EditType::move;
+  EditorObjectId object = invalid_editor_object;
+  // Where it was before, unused by add
+  glm::vec3 from{0.0f};
+  // Where it is after, unused by remove
+  glm::vec3 to{0.0f};
+  // So a remove can be undone and an add redone
+  glm::vec3 half_extents{0.0f};
+};
+
+// One object changing in the world store, in the order they happened. The
+// values are copied in so later changes in the same frame can't affect them
+struct WorldChange {
+  enum Type : uint8_t { added, moved, removed };
+
+  Type type = moved;
+  WorldHandle handle;
+  // Where the object is in the dense arrays. For removed, where it was, and
+  // where the last one has now moved to
+  uint32_t dense_index = 0;
+  glm::vec3 center{0.0f};
+  glm::vec3 half_extents{0.0f};
+};
+
+class LevelEditor {
+ public:
+  explicit LevelEditor(AABBColliders& buildings) : buildings(buildings) {}
+
+  // Each of these does the edit, records it and drops whatever could have
+  // been redone. Move and Remove return false for stale handles
+
+  WorldHandle Add(glm::vec3 center, glm::vec3 half_extents);
+  // merge folds it into the last edit if that moved the same object, so a
+  // whole drag is one step to undo
+  bool Move(WorldHandle handle, glm::vec3 center, bool merge = false);
+  bool Remove(WorldHandle handle);
+
+  bool Undo();
+  bool Redo();
+  bool CanUndo() const { return cursor > 0; }
+  bool CanRedo() const { return cursor < history.size(); }
+
+  // Objects are kept track of from the first time they're edited, so loading
+  // a level doesn't have to give each of its buildings an id up front
+  EditorObjectId ObjectOf(WorldHandle handle);
+  // Invalid while the object is removed
+  WorldHandle HandleOf(EditorObjectId object) const;
+
+  // What changed since the last call, oldest first. Swapped out, so the
+  // vector passed in gets reused next time
+  void TakeChanges(std::vector<WorldChange>& out);
+  bool HasChanges() const { return !changes.empty(); }
+
+  // Forgets the history and every id, for when the level is reloaded
+  void Clear();
+  // The history is in local coordinates, so it has to move with the
+  // floating origin
+  void Translate(glm::vec3 offset);
+
+  size_t HistorySize() const { return history.size(); }
+  size_t Cursor() const { return cursor; }
+  size_t HistoryBytes() const { return history.capacity() * sizeof(EditRecord); }
+
+ private:
+  void Record(EditRecord const& record);
+  // Does record, or undoes it when forward is false
+  void Apply(EditRecord const& record, bool forward);
+
+  void PlaceObject(EditorObjectId object, glm::vec3 center, glm::vec3 half_extents);
+  void MoveObject(EditorObjectId object, glm::vec3 center);
+  void EraseObject(EditorObjectId object);
+
+  AABBColliders& buildings;
+
+  std::vector<EditRecord> history;
+  // Edits before it are done, the ones from it on have been undone
+  size_t cursor = 0;
+
+  // Indexed by EditorObjectId
+  std::vector<WorldHandle> object_handles;
+  // Indexed by handle slot, the other way around
+  std::vector<EditorObjectId> slot_objects;
+
+  std::vector<WorldChange> changes;
+};
+
+}  // namespace PlaneGame
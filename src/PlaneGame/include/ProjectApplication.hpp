@@ -7,6 +7,15 @@
 #include <Fwog/Texture.h>
 
 #include <Albuquerque/Application.hpp>
+#include <Albuquerque/Audio.hpp>
+#include <Albuquerque/DebugDraw.hpp>
+#include <Albuquerque/FloatingOrigin.hpp>
+#include <Albuquerque/GpuCulling.hpp>
+#include <Albuquerque/GpuPicking.hpp>
+#include <Albuquerque/HiZ.hpp>
+#include <Albuquerque/Profiler.hpp>
+#include <Albuquerque/Terrain.hpp>
+#include <Albuquerque/UniformRing.hpp>
 #include <functional>
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
@@ -21,7 +30,8 @@
 
 #include "SceneLoader.h"
 #include "ConfigReader.h"
-#include "miniaudio.h"
+#include "WorldStore.h"
+#include "LevelEditor.h"
 
 
 #include "Camera.h"
@@ -139,6 +149,14 @@ static bool sphereCollisionCheck(Sphere const& lhs, Sphere const& rhs) {
 
 static void SyncSphere(Sphere& sphere, glm::vec3 pos) { sphere.center = pos; }
 
+// For triggers the aircraft can pass all the way through in one tick
+static bool SegmentSphereCheck(glm::vec3 start, glm::vec3 end,
+                               Sphere const& sphere) {
+  float time_of_impact;
+  return SweepSphereSphere(start, end, 0.0f, sphere.center, sphere.radius,
+                           time_of_impact);
+}
+
 struct AABB {
   glm::vec3 halfExtents{1.0f, 1.0f, 1.0f};
   glm::vec3 center{0.0f, 0.0f, 0.0f};
@@ -208,33 +226,6 @@ static void SyncAABB(Collision::AABB& aabb, glm::vec3 pos) {
 
 
 
-class DrawCall
-{
-public:
-    
-    //DrawCall() = delete;
-    //DrawCall(Fwog::Buffer auto const& vertex_buffer, Fwog::Buffer auto const& index_buffer);
-
-
-    void SetBuffers(Fwog::Buffer const& vertex_buffer, Fwog::Buffer const& index_buffer);
-    void SetModelTransformation(glm::mat4 const& model);
-    void SetColor(glm::vec4 color);
-    void Draw(uint64_t stride, uint32_t index_buffer_index = 0, uint32_t object_buffer_index = 1) const;
-
-private:
-    struct ObjectUniforms {
-        glm::mat4 model{1.0f};
-        glm::vec4 color{1.0f, 0.0f, 0.0f, 1.0f};
-    };
-
-    ObjectUniforms uniform;
-    Fwog::TypedBuffer<ObjectUniforms> object_buffer{Fwog::BufferStorageFlag::DYNAMIC_STORAGE};
-
-    //To Do: Have this the keys to IDs of a buffer that are mapped by some resource manager
-    Fwog::Buffer const* vertex_buffer = nullptr;
-    Fwog::Buffer const* index_buffer = nullptr;
-};
-
 class Aircraft
 {
 
@@ -257,16 +248,20 @@ class ProjectApplication final : public Albuquerque::Application {
   void StartLevel();
 
   void RenderScene(double dt) override;
+  // Picks up the last pick that landed, and draws the ids for a new one if
+  // the editor asked for it. After culling, it draws the same lists
   void RenderMousePick();
 
   void RenderUI(double dt) override;
   void Update(double dt) override;
+  void FixedUpdate(double dt) override;
+  void UpdateScriptedCamera(uint32_t frame_index, double time) override;
 
   void UpdateEditorCamera(double dt);
 
   void MuteBackgroundMusicToggle(bool set_muted);
   //void SetBackgroundMusic(SoLoud::Wav& bgm);
-  void SetBackgroundMusic(ma_sound& bgm);
+  void SetBackgroundMusic(Albuquerque::AudioMusicId music);
 
  private:
   void LoadBuffers();
@@ -279,23 +274,11 @@ class ProjectApplication final : public Albuquerque::Application {
                       glm::vec3 scale = glm::vec3{1.0f, 1.0f, 1.0f},
                       glm::vec3 color = glm::vec3{0.0f, 0.0f, 0.8f});
 
-  // Adds the line to the specified buffer that is then draw I need to find a
-  // better name for this tbh
-  void AddDebugDrawLine(glm::vec3 ptA, glm::vec3 ptB, glm::vec3 color);
-  void DrawLineAABB(Collision::AABB const& aabb, glm::vec3 boxColor);
-  void DrawLineSphere(Collision::Sphere const& sphere, glm::vec3 sphereColor);
-
-  // Can call this to reset the collision count in order to call 'DrawLine'
-  // every frame without creating new buffers
-  void ClearLines();
-
   void LoadBuildings();
   void AddBuilding(glm::vec3 position,
                    glm::vec3 scale = glm::vec3{1.0f, 1.0f, 1.0f},
                    glm::vec3 color = glm::vec3{1.0f, 0.0f, 0.0f});
 
-  void CreateGroundChunks();
-
   Fwog::GraphicsPipeline CreatePipelineSkybox();
   void CreateSkybox();
 
@@ -305,6 +288,21 @@ class ProjectApplication final : public Albuquerque::Application {
   void LoadCheckpoints();
   // void ClearCheckpoints();
 
+  // Brings the GPU culling objects up to date with the world store
+  void UpdateCullObjects();
+  // Patches the building uniforms and culling objects the level editor
+  // changed, one object each. Skips the GPU side if everything gets refilled
+  // anyway
+  void ApplyEditorChanges();
+  // Undo/redo keys and the delete key, editor only
+  void UpdateLevelEditorInput();
+  void RenderLevelEditorUI();
+  // Rasterizes the buildings on the CPU and hides whatever they cover
+  void UpdateSoftwareOcclusion();
+  // Subtracts shift from every local position once the floating origin has
+  // moved by it. No GL in here, the buffers are refilled on the next frame
+  void RebaseOrigin(glm::vec3 shift);
+
   static float lerp(float start, float end, float t);
 
  private:
@@ -319,6 +317,8 @@ class ProjectApplication final : public Albuquerque::Application {
   std::optional<Fwog::GraphicsPipeline> pipeline_flat;
   std::optional<Fwog::GraphicsPipeline> pipeline_colored_indexed;
   std::optional<Fwog::GraphicsPipeline> pipeline_skybox;
+  std::optional<Fwog::GraphicsPipeline> pipeline_pick_ids;
+  std::optional<Fwog::GraphicsPipeline> pipeline_pick_terrain;
 
   // Draw with arrays and not indexed so we don't need indices
   std::optional<Fwog::Buffer> vertex_buffer_skybox;
@@ -358,10 +358,14 @@ class ProjectApplication final : public Albuquerque::Application {
     glm::mat4 viewProj;
     glm::vec3 eyePos;
   };
-  std::optional<Fwog::TypedBuffer<GlobalUniforms>> globalUniformsBuffer;
-  std::optional<Fwog::TypedBuffer<GlobalUniforms>> globalUniformsBuffer_skybox;
-
+  // Written during Update, pushed into the frame's uniform ring at the start
+  // of RenderScene
   GlobalUniforms globalStruct;
+  GlobalUniforms globalStruct_skybox;
+  Albuquerque::UniformSlice global_uniforms_slice;
+  // Same for the buildings, collectables and checkpoints, in object space
+  Albuquerque::UniformSlice object_globals_slice;
+  Albuquerque::UniformSlice global_uniforms_skybox_slice;
 
   static constexpr uint32_t num_points_world_axis = 6;
 
@@ -396,26 +400,26 @@ class ProjectApplication final : public Albuquerque::Application {
 
   // Ground Plane Stuff
   // Could these live in the same data?
-  static constexpr glm::vec3 planeScale = glm::vec3(4000.0f, 1.0f, 4000.0f);
-  // static constexpr glm::vec3 planeScale = glm::vec3(100.0f, 1.0f, 100.0f);
-  std::optional<Fwog::Buffer> vertex_buffer_plane;
-  std::optional<Fwog::Buffer> index_buffer_plane;
   std::optional<Fwog::Texture> groundAlbedo;
-  std::optional<Fwog::Buffer> objectBufferPlane;
 
-  std::optional<Fwog::Texture> skybox_texture;
-
-  // Want to test multiple ground chunks
-  struct ground_chunk {
-    std::optional<Fwog::Buffer> object_buffer;
+  // Streams in around the camera, flat where the level is and hills past it
+  std::optional<Albuquerque::Terrain> terrain;
 
-    ObjectUniforms ground_uniform;
-    glm::vec3 ground_center{0.0f, 0.0f, 0.0f};
+  // Everything below is in coordinates relative to this, it follows the
+  // aircraft so the floats stay small however far it flies
+  Albuquerque::FloatingOrigin floating_origin;
+  double last_rebase_ms = 0.0;
 
-    // To DO: albedo IDs?
-  };
+  // The object buffers (and the culling objects) are in object space, which
+  // is local space minus this. A rebase only changes it, so it costs the same
+  // however many objects there are, and they get drawn and culled through
+  // ObjectViewProj. Folded back in whenever the buffers are refilled anyway,
+  // or once it gets this many rebase distances long
+  glm::vec3 object_space_offset{0.0f};
+  static constexpr float max_object_space_offset_rebases = 8.0f;
+  glm::mat4 ObjectViewProj(glm::mat4 const& view_proj) const;
 
-  std::vector<ground_chunk> grond_chunk_list;
+  std::optional<Fwog::Texture> skybox_texture;
 
   // aircraft stuff
   struct PhysicsBody {
@@ -478,6 +482,15 @@ class ProjectApplication final : public Albuquerque::Application {
 
   glm::vec3 aircraftForward{worldForward};
   glm::vec3 aircraftPos{aircarftStartPos};
+
+  // State from the fixed update before the last one, rendering interpolates
+  // from this towards the current state
+  glm::vec3 aircraftPos_previous{aircarftStartPos};
+  glm::mat4 aircraft_rotation_previous{1.0f};
+
+  static constexpr double physics_tick_rate = 120.0;
+  // At 120Hz this lets a frame take ~66ms before the game starts slowing down
+  static constexpr uint32_t physics_max_steps_per_frame = 8;
   glm::vec3 aircraftScale{1.0f, 1.0f, 1.0f};
 
   // Multiply with the aircraftScale
@@ -497,76 +510,107 @@ class ProjectApplication final : public Albuquerque::Application {
   Utility::Scene scene_aircraft;
   Utility::Scene scene_wheels;
 
-  std::optional<Fwog::TypedBuffer<ObjectUniforms>> objectBufferaircraft;
-  std::optional<Fwog::TypedBuffer<ObjectUniforms>> object_buffer_propeller;
+  ObjectUniforms aircraft_uniforms;
+  ObjectUniforms propeller_uniforms;
 
   std::optional<Fwog::TypedBuffer<ObjectUniforms>> objectBufferWheels;
 
 
-  ma_engine miniAudioEngine;
+  Albuquerque::AudioSystem audio;
+  Albuquerque::AudioMusicId background_music = Albuquerque::invalid_audio_music;
+  Albuquerque::AudioMusicId level_editor_music = Albuquerque::invalid_audio_music;
+  Albuquerque::AudioMusicId current_music = Albuquerque::invalid_audio_music;
+  float music_fade_seconds = 1.5f;
 
-  //Don't worry we will refactor all of this
-  ma_sound plane_flying_sfx_ma;
-  ma_sound plane_crash_sfx_ma;
-  ma_sound plane_collectable_pickup_sfx_ma;
-  ma_sound background_music_ma;
-  ma_sound level_editor_music_ma;
+  Albuquerque::AudioClipId plane_flying_sfx = Albuquerque::invalid_audio_clip;
+  Albuquerque::AudioClipId plane_crash_sfx = Albuquerque::invalid_audio_clip;
+  Albuquerque::AudioClipId pickup_sfx = Albuquerque::invalid_audio_clip;
+  Albuquerque::AudioVoice plane_flying_voice;
 
-  ma_sound* curr_background_music_ptr = nullptr;
+  void StartEngineSound();
+  void StopEngineSound();
+  void PlayPickupSound(glm::vec3 position);
 
 
   bool is_background_music_muted = true;
 
   // Collision related stuff. Need to refactor
 
-  // Collision Drawing
-  static constexpr uint32_t max_num_draw_points = 65536;
-  uint32_t curr_num_draw_points = 0;
-
-  std::optional<Fwog::Buffer> vertex_buffer_draw_lines;
-  std::optional<Fwog::Buffer> vertex_buffer_draw_colors;
+  // Collision Drawing. Shapes added during Update are drawn and cleared in
+  // RenderScene
+  std::optional<Albuquerque::DebugDraw> debug_draw;
 
-  // Spheres
-  struct collectable {
-    glm::vec3 position{0.0f, 0.0f, 0.0f};
-    glm::vec3 scale{1.0f, 1.0f, 1.0f};
-    bool isCollected = false;
-
-    Collision::Sphere collider{position, scale.x};
-  };
+  // Collision data for every world object. Collectables are drawn
+  // instanced, the instance index is the dense index in the store
+  WorldStore world_store;
 
-  std::vector<collectable> collectableList;
+  // Edits to the buildings, with undo. What it changes is applied to the
+  // GPU buffers one object at a time in ApplyEditorChanges
+  LevelEditor level_editor{world_store.buildings};
+  std::vector<WorldChange> editor_changes;
+  WorldHandle editor_selected;
+  glm::vec3 editor_new_building_half_extents{20.0f, 40.0f, 20.0f};
+  // The position drag keeps folding into one move until it's let go
+  bool editor_merge_move = false;
 
   // Drawing with instancing
   Utility::Scene scene_collectable;
+  // Grows with the level, sized by slot count and doubled when it runs out
   std::optional<Fwog::TypedBuffer<ObjectUniforms>> collectableObjectBuffers;
-
-  // How many instances to draw
-  // uint32_t num_active_collectables{0};
-  static constexpr uint32_t max_num_collectables{4096};
+  // CPU copy of collectableObjectBuffers by handle slot like the buildings,
+  // so a rebase can move them without reading the buffer back. Picking one
+  // up removes it from the world store and its culler, which leaves the slot
+  // behind but never moves another collectable's uniforms
+  std::vector<ObjectUniforms> collectable_uniforms;
 
   bool renderAxis = false;
   bool draw_collectable_colliders = false;
   bool draw_player_colliders = false;
+  bool draw_building_colliders = false;
+  // What the frame pacer was last set to from the UI, 0 is uncapped
+  float fps_cap = 0.0f;
 
   static constexpr glm::vec3 default_building_color{0.29614, 0.43966, 0.52712};
-
-  struct buildingObject {
-    glm::vec3 building_center{50.0f, 0.0f, 100.0f};
-    glm::vec3 building_scale{10.0f, 100.0f, 10.0f};
-    Collision::AABB building_collider{building_scale * 0.5f, building_center};
-
-    DrawCall drawcall;
-
-    static std::optional<Fwog::Texture> buildingAlbedo;
-  };
+  static constexpr glm::vec3 selected_building_color{0.0f, 1.0f, 0.0f};
 
   std::optional<Fwog::Buffer> building_vertex_buffer;
   std::optional<Fwog::Buffer> building_index_buffer;
 
-  // buildingObject hello_building;
-  std::vector<buildingObject> buildingObjectList;
-
+  // Indexed by the building's handle slot, not the dense index, so removing
+  // a building never moves another one's uniforms
+  std::vector<ObjectUniforms> building_uniforms;
+  std::optional<Fwog::TypedBuffer<ObjectUniforms>> building_object_buffer;
+
+  // Buildings, collectables and checkpoints are frustum culled on the GPU and
+  // each drawn with one indirect call. The object index the cullers hand to
+  // the vertex shader is the building slot, the collectable slot and the
+  // checkpoint route index
+  std::optional<Albuquerque::GpuCuller> building_culler;
+  std::optional<Albuquerque::GpuCuller> collectable_culler;
+  std::optional<Albuquerque::GpuCuller> checkpoint_culler;
+  bool cull_objects_dirty = true;
+
+  // Scratch space so refilling the culling objects doesn't allocate
+  std::vector<Albuquerque::GpuCullObject> cull_objects;
+  std::vector<ObjectUniforms> checkpoint_uniforms;
+
+  // The scene is drawn offscreen so its depth can be turned into the Hi-Z
+  // pyramid the cullers test against next frame
+  std::optional<Fwog::Texture> scene_color;
+  std::optional<Fwog::Texture> scene_depth;
+  std::optional<Albuquerque::HiZPyramid> hiz_pyramid;
+
+  // Headless runs can't count on last frame's depth, so the buildings get
+  // rasterized on the CPU instead and the occluded ones are hidden. Indexed
+  // like the culling objects
+  bool use_software_occlusion = false;
+  Albuquerque::SoftwareOcclusion software_occlusion;
+  std::vector<uint8_t> building_occluded;
+  std::vector<uint8_t> collectable_occluded;
+  Albuquerque::GpuCuller::Stats building_software_stats;
+  Albuquerque::GpuCuller::Stats collectable_software_stats;
+
+  // Render state only, the collider is in world_store.checkpoints
   struct checkpointObject {
     static constexpr glm::vec3 activated_color_linear =
         glm::vec3(0.016f, 0.57758f, 0.00335f);
@@ -576,19 +620,10 @@ class ProjectApplication final : public Albuquerque::Application {
     // Based off the size of the actual model loaded in
     static constexpr float base_radius = 13.0f;
 
-    glm::vec3 center;
-    glm::vec3 scale;
     glm::vec3 color = non_activated_color_linear;
 
     glm::mat4 model;
     // glm::mat4 rotation_model_matrix{1.0f};
-
-    Collision::Sphere collider;
-    std::optional<Fwog::Buffer> object_buffer;
-
-    // First on the list is activated followed by the next. The load order from
-    // the level file is important
-    bool activated = false;
   };
 
   // Think maybe putting it here is easier to organize? Its like using the
@@ -598,10 +633,18 @@ class ProjectApplication final : public Albuquerque::Application {
 
   Utility::Scene scene_checkpoint_ring;
 
+  // Indexed by handle slot like building_uniforms
+  std::vector<checkpointObject> checkpoint_render_state;
+
+  // Checkpoints in the order they have to be flown through. First on the list
+  // is activated followed by the next. The load order from the level file is
+  // important
+  std::vector<WorldHandle> checkpoint_route;
   size_t curr_active_checkpoint = 0;
-  std::vector<checkpointObject> checkpointList;
   bool all_checkpoints_collected = false;
 
+  Collision::Sphere CheckpointCollider(size_t route_index) const;
+
   struct camera {
     glm::vec3 position;
     glm::vec3 target;
@@ -613,39 +656,24 @@ class ProjectApplication final : public Albuquerque::Application {
   camera editorCamera;
   camera gameplayCamera;
 
-  std::optional<Fwog::Texture> mousePick_Texture;
-  void MouseRaycast(camera const& cam);
-
-  // To Do: Rewrite this after fixing architecture to decouple collision,
-  // rendering and entity data
-
-  static buildingObject * RaycastCheck(
-      glm::vec3 startPosition, glm::vec3 normalizedRay,
-      std::vector<buildingObject> & aabb_list, float stepDistance = 1.0f,
-      size_t numSteps = 1000) {
-    // Reject all colliders that cannot possibly be hit
-    std::vector<buildingObject*> non_rejected;
-    for (auto& aabb : aabb_list) {
-      glm::vec3 dir = aabb.building_collider.center - startPosition;
-      if (glm::dot(dir, normalizedRay) > 0.0f) {
-        non_rejected.push_back(&aabb);
-      }
-    }
-
-    glm::vec3 currPosition = startPosition;
-    for (size_t i = 0; i < numSteps; ++i) {
-      currPosition += (i * stepDistance) * normalizedRay;
-
-      // Check if there is a hit for every step. If there is simply return that
-      // and negate the rest
-      for (auto & aabb : non_rejected) {
-        if (CheckPointOnAABB(currPosition, aabb->building_collider))
-          return aabb;
-      }
-    }
-
-    return nullptr;
-  }
+  // What the pick pass writes in the top bits of an id, see pick_id.frag.glsl
+  enum class pick_kinds : uint32_t { none, building, collectable, checkpoint };
+  // Matches PickUBO in pick_id.frag.glsl (std140)
+  struct PickUniforms {
+    uint32_t kind;
+    uint32_t padding[3];
+  };
+
+  // Clicks in the editor are answered by the GPU a frame or so later, by
+  // whatever mesh was actually drawn under the cursor
+  std::optional<Albuquerque::GpuPicker> mouse_picker;
+  uint32_t editor_picked_id = 0;
+  // Buildings, collectables and checkpoints from the culled lists. With
+  // pick_ids each group pushes its pick kind for pipeline_pick_ids
+  void DrawCulledObjects(Albuquerque::UniformRing& frame_uniforms,
+                         bool pick_ids);
+  // Recolours the old and new selection, just those two buildings
+  void SelectBuilding(WorldHandle handle);
 };
 
 }  // namespace PlaneGame
@@ -4,6 +4,8 @@
 #pragma once 
 
 #include "ConfigReader.h"
+#include "WorldStore.h"
+#include "LevelEditor.h"
 
 namespace PlaneGame
 {
@@ -19,4 +21,149 @@ namespace PlaneGame
     public:
         static void TestOne();
     };
+
+    class WorldStoreTester
+    {
+    public:
+        //Handles stay valid across swap removes and stale ones are rejected
+        static void TestHandles();
+
+        //The grid raycast finds the same closest box as testing every box, while boxes get added, moved and removed,
+        //and the floating origin moves
+        static void TestGridRaycast();
+
+        //Collecting removes from the store, and a list swap removed alongside it like the culler's stays in step
+        static void TestCollect();
+    };
+
+    class CollisionTester
+    {
+    public:
+        //Random moves against random boxes and spheres: anything a densely sampled discrete test finds, the sweep
+        //finds no later, its contact is real, and cutting the move into any number of steps gives the same contact
+        static void TestSweepProperties();
+    };
+
+    class GpuCullingTester
+    {
+    public:
+        //Instance ranges per mesh and the packed object layout the compute pass reads
+        static void TestCommandLayout();
+
+        //CPU copy of the shader's frustum test on objects inside, outside and straddling a plane
+        static void TestFrustum();
+    };
+
+    class OcclusionTester
+    {
+    public:
+        //Pyramid levels keep the farthest depth, including the leftover row and column of odd sizes
+        static void TestDownsample();
+
+        //Software rasterized wall hides a box behind it but not one beside it or in front of it
+        static void TestSoftwareOcclusion();
+    };
+
+    class TerrainTester
+    {
+    public:
+        //Stitched edges only use the vertices the coarser neighbour has
+        static void TestStitching();
+
+        //A patch and its parent put the same height on the vertices they share
+        static void TestSharedEdges();
+    };
+
+    class FloatingOriginTester
+    {
+    public:
+        //Rebases only past the distance, by whole snap steps, and world positions come out the same after it
+        static void TestRebase();
+    };
+
+    class InputRecordingTester
+    {
+    public:
+        //Frames come back from the file exactly as written, including the ones that only store a dt
+        static void TestRoundTrip();
+    };
+
+    class AudioTester
+    {
+    public:
+        //Mixing, one shots ending, pitch, voice stealing by priority and panning, straight on the mixer
+        static void TestMixer();
+
+        //Sounds play out and free their voices on miniaudio's null backend
+        static void TestNullBackend();
+
+        //A track streams to the end through a ring smaller than the file
+        static void TestMusicStream();
+    };
+
+    class ScriptingTester
+    {
+    public:
+        //Views write straight into the arrays, runaway and broken scripts get stopped and disabled without taking
+        //the others down, and sandboxes can't see each other or anything outside
+        static void TestSandbox();
+
+        //The memory limit turns into a script error instead of the game running out
+        static void TestMemoryLimit();
+    };
+
+    class LevelEditorTester
+    {
+    public:
+        //Undoing everything gets the level back exactly, redoing gets the edits back, and replaying the changes on
+        //a copy keeps it in the same order as the world store like the culler has to
+        static void TestUndoRedo();
+    };
+
+    class GpuPickingTester
+    {
+    public:
+        //The pick matrix puts the cursor in the middle of clip space and the region edges on its edges, and the
+        //region resolves to the id nearest the cursor
+        static void TestPickRegion();
+    };
+
+    //Not really tests, prints numbers for the shared job pool so regressions are easy to spot
+    class JobSystemBenchmark
+    {
+    public:
+        //Average cost of queueing and running an empty job
+        static void SpawnOverhead();
+
+        //Speedup of a ParallelFor over the same loop on one thread, divided by the thread count
+        static void ScalingEfficiency();
+    };
+
+    class CollisionBenchmark
+    {
+    public:
+        //Sweeping the aircraft through a city's worth of boxes, next to the discrete test it replaced
+        static void SweepCost();
+    };
+
+    class AudioBenchmark
+    {
+    public:
+        //Mixer CPU time for 100 spatial voices, as a share of one core
+        static void MixerCost();
+    };
+
+    class ScriptingBenchmark
+    {
+    public:
+        //10k scripted objects per tick through the array views, next to the same scripts building a table per object
+        static void ObjectUpdate();
+    };
+
+    class LevelEditorBenchmark
+    {
+    public:
+        //Cost of one edit and of a click raycast in a level of 100k buildings, should stay flat as the level grows
+        static void EditCost();
+    };
 }
\ No newline at end of file
@@ -0,0 +1,316 @@
+// Where the world objects (buildings, collectables, checkpoints) keep their
+// collision data. Everything the per-frame collision loops read is packed into
+// plain float arrays, one per axis, so the loops stream through memory and the
+// compiler can vectorize them. Render state (draw calls, GPU buffers) lives in
+// ProjectApplication, indexed by the handle slot so it never has to move.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace PlaneGame {
+
+// Index picks the slot, generation catches handles to objects that have since
+// been removed
+struct WorldHandle {
+  static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+  uint32_t index = invalid_index;
+  uint32_t generation = 0;
+
+  bool IsValid() const { return index != invalid_index; }
+  bool operator==(WorldHandle const&) const = default;
+};
+
+// Generational slot map bookkeeping. Only owns the index tables so every
+// collider pool can reuse it. Objects are kept densely packed: removing one
+// moves the last object into its place, so insert and remove are both O(1)
+// while the handles stay valid.
+class SlotMap {
+ public:
+  WorldHandle Insert();
+
+  // Returns false for stale handles. Otherwise removed_dense is where the
+  // removed object was and last_dense is the object that gets moved into it.
+  // If they are the same nothing moves.
+  bool Remove(WorldHandle handle, uint32_t& removed_dense, uint32_t& last_dense);
+
+  bool Contains(WorldHandle handle) const;
+  uint32_t DenseIndex(WorldHandle handle) const;
+  // For a slot that is known to be occupied, e.g. one a spatial index handed back
+  uint32_t SlotDenseIndex(uint32_t slot_index) const { return slots[slot_index].dense_index; }
+  // Whatever is in the slot right now, invalid if it's empty. For ids that
+  // only kept the slot, like the ones the pick pass draws
+  WorldHandle SlotHandle(uint32_t slot_index) const {
+    if (slot_index >= slots.size() || !slots[slot_index].occupied) return {};
+    return {slot_index, slots[slot_index].generation};
+  }
+  WorldHandle Handle(uint32_t dense_index) const { return dense_handles[dense_index]; }
+
+  uint32_t Size() const { return static_cast<uint32_t>(dense_handles.size()); }
+  // Highest slot index ever handed out + 1, for sizing arrays indexed by slot
+  uint32_t SlotCount() const { return static_cast<uint32_t>(slots.size()); }
+
+  std::vector<WorldHandle> const& Handles() const { return dense_handles; }
+
+  // Invalidates every handle but keeps the slots around for reuse
+  void Clear();
+
+ private:
+  struct Slot {
+    uint32_t dense_index = 0;
+    uint32_t generation = 0;
+    bool occupied = false;
+  };
+
+  std::vector<Slot> slots;
+  std::vector<uint32_t> free_slots;
+  std::vector<WorldHandle> dense_handles;
+};
+
+// Continuous tests for a sphere moving from start to end. Both give the
+// earliest time of impact along the move, 0 to 1, and are exact, so a move
+// split into smaller steps finds the same first contact. Touching at the
+// start counts as an impact at 0
+
+// Against a sphere. other_radius 0 and radius 0 make it segment vs sphere
+bool SweepSphereSphere(glm::vec3 start, glm::vec3 end, float radius,
+                       glm::vec3 center, float other_radius,
+                       float& time_of_impact);
+
+// Against a box. The squared distance to a box is a quadratic between the
+// points where the centre crosses one of its planes, so this solves each of
+// those pieces in order instead of iterating
+bool SweepSphereAABB(glm::vec3 start, glm::vec3 end, float radius,
+                     glm::vec3 center, glm::vec3 half_extents,
+                     float& time_of_impact);
+
+enum WorldFlags : uint32_t {
+  world_flag_none = 0,
+  // Collision skips it. Collectables that get picked up are removed instead,
+  // so the loops only ever go through the ones left
+  world_flag_collected = 1 << 0,
+};
+
+class SphereColliders {
+ public:
+  WorldHandle Add(glm::vec3 center, float radius, uint32_t flags = world_flag_none);
+  void Remove(WorldHandle handle);
+  void Clear();
+  // Moves every sphere, for when the floating origin moves
+  void Translate(glm::vec3 offset);
+
+  // Dense index of the first sphere overlapping the query sphere, ignoring
+  // any that have one of the skip flags set. -1 if nothing overlaps
+  int32_t FirstOverlap(glm::vec3 center, float radius, uint32_t skip_flags = world_flag_none) const;
+
+  // Dense index of the sphere a sphere moving from start to end touches
+  // first, -1 if none. The bounds of the move cull a block at a time, only
+  // what is left gets the exact test
+  int32_t Sweep(glm::vec3 start, glm::vec3 end, float radius,
+                uint32_t skip_flags = world_flag_none,
+                float* time_of_impact = nullptr) const;
+
+  glm::vec3 Center(uint32_t i) const { return {center_x[i], center_y[i], center_z[i]}; }
+
+  uint32_t Size() const { return slots.Size(); }
+
+  SlotMap slots;
+
+  // Hot, all indexed by dense index
+  std::vector<float> center_x;
+  std::vector<float> center_y;
+  std::vector<float> center_z;
+  std::vector<float> radius;
+  std::vector<uint32_t> flags;
+};
+
+// Uniform grid over x and z, each cell listing the ids of the boxes that reach
+// into it. Only cells that have something in them exist, so it costs nothing
+// where the world is empty. Adding, moving or removing a box only touches the
+// cells it covers, which is what lets the editor change one object in a world
+// of 100k without rebuilding anything. The cells stay put when the floating
+// origin moves: positions are taken relative to where the grid's origin is
+// now, so a rebase only moves that.
+class SpatialGrid {
+ public:
+  explicit SpatialGrid(float cell_size = 64.0f) : cell_size(cell_size) {}
+
+  void Insert(uint32_t id, glm::vec3 min, glm::vec3 max);
+  void Remove(uint32_t id);
+  // Only touches the cells if the box covers different ones afterwards
+  void Move(uint32_t id, glm::vec3 new_min, glm::vec3 new_max);
+  void Clear();
+  // Everything moved by offset, like AABBColliders::Translate. Doesn't touch
+  // a single cell
+  void Translate(glm::vec3 offset);
+
+  // Walks the cells the ray passes through, nearest first. visit(ids, exit)
+  // gets each cell's ids and the ray distance where it leaves the cell, and
+  // returns false to stop. Boxes too big for the grid come first with an exit
+  // of 0, and a box can turn up in more than one cell
+  template <typename Visit>
+  void WalkRay(glm::vec3 origin, glm::vec3 direction, float max_distance,
+               Visit&& visit) const;
+
+  uint32_t CellCount() const { return static_cast<uint32_t>(cells.size()); }
+
+ private:
+  // Boxes covering more cells than this go in oversized instead, so one huge
+  // ground plane doesn't fill thousands of cells
+  static constexpr int32_t max_cells_per_box = 64;
+
+  struct CellRange {
+    int32_t min_x, min_z, max_x, max_z;
+
+    bool operator==(CellRange const&) const = default;
+    int64_t Count() const {
+      return int64_t(max_x - min_x + 1) * int64_t(max_z - min_z + 1);
+    }
+  };
+
+  static uint64_t Key(int32_t x, int32_t z) {
+    return (uint64_t(uint32_t(x)) << 32) | uint32_t(z);
+  }
+  // Grid space is local space minus the origin, kept in doubles so it doesn't
+  // drift however many rebases there are
+  int32_t Cell(float position, double origin) const;
+  CellRange Range(glm::vec3 min, glm::vec3 max) const;
+  static void Erase(std::vector<uint32_t>& ids, uint32_t id);
+
+  float cell_size;
+  double origin_x = 0.0;
+  double origin_z = 0.0;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+  // Cells each id went into, by id. Removing goes by these rather than the
+  // box, which after a rebase could round into a neighbouring cell
+  std::vector<CellRange> ranges;
+  std::vector<uint32_t> oversized;
+  // Every cell that ever had something in it is inside these, rays stop
+  // walking once they leave them
+  CellRange bounds{0, 0, -1, -1};
+};
+
+class AABBColliders {
+ public:
+  WorldHandle Add(glm::vec3 center, glm::vec3 half_extents, uint32_t flags = world_flag_none);
+  void Remove(WorldHandle handle);
+  // Returns false for stale handles
+  bool Move(WorldHandle handle, glm::vec3 center);
+  void Clear();
+  // The grid only moves its origin, so this is the arrays and nothing more
+  void Translate(glm::vec3 offset);
+
+  // Dense index of the first box overlapping the sphere, -1 if none
+  int32_t FirstOverlap(glm::vec3 center, float radius) const;
+
+  // Same as SphereColliders::Sweep, against the boxes
+  int32_t Sweep(glm::vec3 start, glm::vec3 end, float radius,
+                float* time_of_impact = nullptr) const;
+
+  // Dense index of the closest box the ray hits within max_distance, -1 if
+  // none. direction has to be normalized. Only tests the boxes in the grid
+  // cells along the ray, and stops at the first cell the hit is inside of
+  int32_t Raycast(glm::vec3 origin, glm::vec3 direction, float max_distance,
+                  float* hit_distance = nullptr) const;
+
+  glm::vec3 Center(uint32_t i) const { return {center_x[i], center_y[i], center_z[i]}; }
+  glm::vec3 HalfExtents(uint32_t i) const { return {extent_x[i], extent_y[i], extent_z[i]}; }
+
+  uint32_t Size() const { return slots.Size(); }
+
+  SlotMap slots;
+
+  std::vector<float> center_x;
+  std::vector<float> center_y;
+  std::vector<float> center_z;
+  std::vector<float> extent_x;
+  std::vector<float> extent_y;
+  std::vector<float> extent_z;
+  std::vector<uint32_t> flags;
+
+  // Ids are slot indices, they don't move when something is removed
+  SpatialGrid grid;
+};
+
+struct WorldStore {
+  AABBColliders buildings;
+  SphereColliders collectables;
+  SphereColliders checkpoints;
+
+  void Clear() {
+    buildings.Clear();
+    collectables.Clear();
+    checkpoints.Clear();
+  }
+
+  void Translate(glm::vec3 offset) {
+    buildings.Translate(offset);
+    collectables.Translate(offset);
+    checkpoints.Translate(offset);
+  }
+};
+
+template <typename Visit>
+void SpatialGrid::WalkRay(glm::vec3 origin, glm::vec3 direction,
+                          float max_distance, Visit&& visit) const {
+  if (!oversized.empty() && !visit(oversized, 0.0f)) return;
+  if (cells.empty()) return;
+
+  // Standard grid traversal: step into whichever neighbouring cell the ray
+  // reaches first, keeping the distance to the next x and z boundary
+  int32_t x = Cell(origin.x, origin_x);
+  int32_t z = Cell(origin.z, origin_z);
+  double grid_x = double(origin.x) - origin_x;
+  double grid_z = double(origin.z) - origin_z;
+  int32_t step_x = direction.x > 0.0f ? 1 : -1;
+  int32_t step_z = direction.z > 0.0f ? 1 : -1;
+
+  constexpr float infinity = std::numeric_limits<float>::infinity();
+  float delta_x = direction.x != 0.0f ? cell_size / std::abs(direction.x) : infinity;
+  float delta_z = direction.z != 0.0f ? cell_size / std::abs(direction.z) : infinity;
+  float next_x = infinity;
+  float next_z = infinity;
+  if (direction.x != 0.0f) {
+    double boundary = double(x + (step_x > 0 ? 1 : 0)) * cell_size;
+    next_x = float((boundary - grid_x) / direction.x);
+  }
+  if (direction.z != 0.0f) {
+    double boundary = double(z + (step_z > 0 ? 1 : 0)) * cell_size;
+    next_z = float((boundary - grid_z) / direction.z);
+  }
+
+  float t = 0.0f;
+  while (t <= max_distance) {
+    float exit = std::min(next_x, next_z);
+
+    auto found = cells.find(Key(x, z));
+    if (found != cells.end() && !visit(found->second, exit)) return;
+
+    // Outside everything there is and heading further away
+    bool past_x = x < bounds.min_x || x > bounds.max_x;
+    bool past_z = z < bounds.min_z || z > bounds.max_z;
+    if (past_x && (direction.x == 0.0f || (x > bounds.max_x) == (step_x > 0)))
+      return;
+    if (past_z && (direction.z == 0.0f || (z > bounds.max_z) == (step_z > 0)))
+      return;
+    if (exit == infinity) return;
+
+    t = exit;
+    if (next_x < next_z) {
+      x += step_x;
+      next_x += delta_x;
+    } else {
+      z += step_z;
+      next_z += delta_z;
+    }
+  }
+}
+
+}  // namespace PlaneGame
@@ -267,27 +267,23 @@ Fwog::Texture PlaygroundApplication::MakeTexture(std::string_view texturePath, i
 
 
 
-ViewData::ViewData()
-{
-    viewBuffer = Fwog::TypedBuffer<ViewUniform>(Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    skyboxBuffer = Fwog::TypedBuffer<ViewUniform>(Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-}
-
 void ViewData::Update(Albuquerque::Camera const& camera)
 {
-    static ViewUniform viewUniform;
-
     glm::mat4 view = glm::lookAt(camera.camPos,  camera.camTarget,  camera.camUp);
     glm::mat4 viewSky = glm::mat4(glm::mat3(view));
     glm::mat4 proj = glm::perspective(PI / 2.0f, 1.6f, camera.nearPlane, camera.farPlane);
 
     viewUniform.viewProj = proj * view;
     viewUniform.eyePos = camera.camPos;
-    viewBuffer.value().UpdateData(viewUniform, 0);
 
-    viewUniform.viewProj = proj * viewSky;
+    skyboxUniform = viewUniform;
+    skyboxUniform.viewProj = proj * viewSky;
+}
 
-    skyboxBuffer.value().UpdateData(viewUniform, 0);
+void ViewData::Stream(Albuquerque::UniformRing& ring)
+{
+    viewSlice = ring.Push(viewUniform);
+    skyboxSlice = ring.Push(skyboxUniform);
 }
 
 void PlaygroundApplication::AfterCreatedUiContext()
@@ -337,24 +333,7 @@ bool PlaygroundApplication::LoadFwog()
     //It does not
     //std::cout << "Does this go to spdlog?\n";
 
-    line_renderer = LineRendererFwog();
-
-    constexpr float current_axis_length = 100000.0f;
-
-    //Do axis line as example
-    auto drawAxis = [&](float axisLength)
-    {
-        line_renderer->AddPoint(glm::vec3(0.0f, 0.0f, 0.0f));
-        line_renderer->AddPoint(glm::vec3(axisLength, 0.0f, 0.0f));
-
-        line_renderer->AddPoint(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        line_renderer->AddPoint(glm::vec3(0.0f, axisLength, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-
-        line_renderer->AddPoint(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        line_renderer->AddPoint(glm::vec3(0.0f, 0.0f, axisLength), glm::vec3(0.0f, 0.0f, 1.0f));
-    };
-
-    drawAxis(current_axis_length);
+    debug_draw.emplace(true);
 
 
 
@@ -518,30 +497,34 @@ void PlaygroundApplication::UpdateFwog(double dt)
     //}
 
     //Draws a line from origin to raycast point. Acts as a 'test' for both functions
-    auto rayCastTest = [&](Albuquerque::Camera const& currCamera, LineRendererFwog& lineRenderer)
+    auto rayCastTest = [&](Albuquerque::Camera const& currCamera)
     {
-        //This will **add** more lines there too... every frame as well which is cursed
-
         //TODO: Make IsKeyJustPressed check
         static bool wasClicked = false;
         if (IsMouseKeyPressed(GLFW_MOUSE_BUTTON_1) && !wasClicked) {
-            lineRenderer.Clear();
             wasClicked = true;
 
             //TODO: Check if normalization does anything even
             glm::vec3 ray = glm::normalize(RaycastScreenToWorld(currCamera));
-            glm::vec3 worldPoint = currCamera.camPos + ray;
-            lineRenderer.AddPoint(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
-            lineRenderer.AddPoint(worldPoint, glm::vec3(1.0f, 1.0f, 1.0f));
-
+            raycast_line_end = currCamera.camPos + ray;
+            has_raycast_line = true;
         }
         else if (!IsMouseKeyPressed(GLFW_MOUSE_BUTTON_1) && wasClicked)
         {
             wasClicked = false;
         }
+
+        if (has_raycast_line)
+            debug_draw->Line(glm::vec3(0.0f, 0.0f, 0.0f), raycast_line_end, glm::vec3(1.0f, 1.0f, 1.0f));
     };
 
-    rayCastTest(sceneCamera_, line_renderer.value());
+    rayCastTest(sceneCamera_);
+
+    //Debug draw is immediate mode so the axis goes in every frame
+    constexpr float current_axis_length = 100000.0f;
+    debug_draw->Line(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(current_axis_length, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    debug_draw->Line(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, current_axis_length, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    debug_draw->Line(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, current_axis_length), glm::vec3(0.0f, 0.0f, 1.0f));
 }
 
 void PlaygroundApplication::Update(double dt)
@@ -567,11 +550,17 @@ void PlaygroundApplication::RenderFwog(double dt)
     ss.anisotropy = Fwog::SampleCount::SAMPLES_16;
     static auto nearestSampler = Fwog::Sampler(ss);
 
+    if (fwogScene_)
+    {
+        viewData_->Stream(FrameUniforms());
+        voxelGrid_->Cull(viewData_.value(), FrameUniforms());
+    }
+
     //Could refactor this to be a function of a class
     auto drawObject = [&](Albuquerque::FwogHelpers::DrawObject const& object, Fwog::Texture const& textureAlbedo, Fwog::Sampler const& sampler, ViewData const& viewData)
     {
         Fwog::Cmd::BindGraphicsPipeline(pipelineTextured_.value());
-        Fwog::Cmd::BindUniformBuffer(0, viewData.viewBuffer.value());
+        Albuquerque::UniformRing::BindUniform(0, viewData.viewSlice);
         Fwog::Cmd::BindUniformBuffer(1, object.modelUniformBuffer.value());
 
         Fwog::Cmd::BindSampledImage(0, textureAlbedo, sampler);
@@ -595,7 +584,7 @@ void PlaygroundApplication::RenderFwog(double dt)
     auto drawSkybox = [&](Skybox const& skybox, Fwog::Sampler const& sampler)
     {
         Fwog::Cmd::BindGraphicsPipeline(skybox.pipeline.value());
-        Fwog::Cmd::BindUniformBuffer(0, viewData_->skyboxBuffer.value());
+        Albuquerque::UniformRing::BindUniform(0, viewData_->skyboxSlice);
 
         Fwog::Cmd::BindSampledImage(0, skybox.texture.value(), sampler);
         Fwog::Cmd::BindVertexBuffer(0, skybox.vertexBuffer.value(), 0, 3 * sizeof(float));
@@ -618,7 +607,7 @@ void PlaygroundApplication::RenderFwog(double dt)
         {
             if (fwogScene_)
             {
-                line_renderer->Draw(*viewData_);
+                debug_draw->Render(viewData_->viewSlice);
 
                 for (size_t i = 0; i < numCubes_; ++i)
                 {
@@ -694,80 +683,3 @@ glm::vec3 PlaygroundApplication::RaycastScreenToWorld(Albuquerque::Camera const&
     //Caller normalizes it, not the callee (as non-normalized gets the world point)
     return ray_world_vec3;
 }
-
-LineRendererFwog::LineRendererFwog()
-{
-    //To Do: Have this passed in as parameters
-    constexpr char vertexShaderPath[] = "./data/shaders/lines.vert.glsl";
-    constexpr char fragmentShaderPath[] = "./data/shaders/lines.frag.glsl";
-
-    //Create pipeline 
-    auto LoadFile = [](std::string_view path)
-    {
-        std::ifstream file{ path.data() };
-        std::string returnString { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
-        return returnString;
-    };
-
-    auto vertex_shader = Fwog::Shader(Fwog::PipelineStage::VERTEX_SHADER, LoadFile(vertexShaderPath));
-    auto fragment_shader = Fwog::Shader(Fwog::PipelineStage::FRAGMENT_SHADER, LoadFile(fragmentShaderPath));
-
-    static constexpr auto sceneInputBindingDescs = std::array{
-    Fwog::VertexInputBindingDescription{
-        // position
-        .location = 0,
-            .binding = 0,
-            .format = Fwog::Format::R32G32B32_FLOAT,
-            .offset = 0
-    },
-    Fwog::VertexInputBindingDescription{
-        .location = 1,
-            .binding = 1,
-            .format = Fwog::Format::R32G32B32_FLOAT,
-            .offset = 0,
-    }};
-
-    auto inputDescs = sceneInputBindingDescs;
-    auto primDescs = Fwog::InputAssemblyState{ Fwog::PrimitiveTopology::LINE_LIST };
-
-    pipeline =  Fwog::GraphicsPipeline{{
-            .vertexShader = &vertex_shader,
-                .fragmentShader = &fragment_shader,
-                .inputAssemblyState = primDescs,
-                .vertexInputState = { inputDescs },
-                .depthState = { .depthTestEnable = true,
-                .depthWriteEnable = true,
-                .depthCompareOp = Fwog::CompareOp::LESS_OR_EQUAL },
-    }};
-
-    //Create buffers
-    vertex_buffer = Fwog::TypedBuffer<glm::vec3>(maxPoints, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-    color_buffer = Fwog::TypedBuffer<glm::vec3>(maxPoints, Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
-}
-
-void LineRendererFwog::AddPoint(glm::vec3 point_position, glm::vec3 point_color)
-{
-    vertex_buffer->UpdateData(point_position, point_count);
-    color_buffer->UpdateData(point_color, point_count);
-    ++point_count;
-
-    //TODO: Add consideration for when point_count > max amount... right now Fwog will crash instead
-}
-
-void LineRendererFwog::Draw(ViewData const& viewData)
-{
-    Fwog::Cmd::BindGraphicsPipeline(pipeline.value());
-    Fwog::Cmd::BindUniformBuffer(0, viewData.viewBuffer.value());
-    Fwog::Cmd::BindVertexBuffer(0, vertex_buffer.value(), 0, 3 * sizeof(float));
-    Fwog::Cmd::BindVertexBuffer(1, color_buffer.value(), 0, 3 * sizeof(float));
-    Fwog::Cmd::Draw(point_count, 1, 0, 0);
-}
-
-void LineRendererFwog::Clear()
-{
-    //Not needed. Just keep the old data and just don't pass it during rendering (and new data will override it)
-    //vertex_buffer->ClearSubData(Fwog::BufferClearInfo());
-    //color_buffer->ClearSubData(Fwog::BufferClearInfo());
-
-    point_count = 0;
-}
\ No newline at end of file
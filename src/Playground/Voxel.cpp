@@ -101,6 +101,23 @@ VoxelStuff::Grid::Grid(glm::vec3 gridOrigin)
 
     objectBuffer.emplace(std::span(objectUniforms), Fwog::BufferStorageFlag::DYNAMIC_STORAGE);
 
+    culler.emplace(std::vector<Albuquerque::GpuCullMesh>{{.index_count = static_cast<uint32_t>(voxelMeshBufferRef->indexCount)}});
+
+    //The cube mesh goes from -0.5 to 0.5
+    std::vector<Albuquerque::GpuCullObject> cullObjects;
+    cullObjects.reserve(voxelGrid.size());
+    for (size_t i = 0; i < voxelGrid.size(); ++i)
+    {
+        Transform const& transform = voxelGrid[i].transform;
+        cullObjects.push_back(Albuquerque::GpuCulling::PackAABB(transform.position, transform.scale * 0.5f, 0, static_cast<uint32_t>(i)));
+    }
+    culler->SetObjects(cullObjects);
+
+}
+
+void VoxelStuff::Grid::Cull(ViewData const& viewData, Albuquerque::UniformRing& frameUniforms)
+{
+    culler->Cull(viewData.viewUniform.viewProj, frameUniforms);
 }
 
 void VoxelStuff::Grid::Draw(Fwog::Texture const& textureAlbedo, Fwog::Sampler const& sampler, ViewData const& viewData)
@@ -113,7 +130,7 @@ void VoxelStuff::Grid::Draw(Fwog::Texture const& textureAlbedo, Fwog::Sampler co
     //To Do: Bind pipeline here
 
     Fwog::Cmd::BindGraphicsPipeline(pipeline.value());
-    Fwog::Cmd::BindUniformBuffer(0, viewData.viewBuffer.value());
+    Albuquerque::UniformRing::BindUniform(0, viewData.viewSlice);
     Fwog::Cmd::BindStorageBuffer(1, *objectBuffer);
 
     Fwog::Cmd::BindSampledImage(0, textureAlbedo, sampler);
@@ -121,6 +138,6 @@ void VoxelStuff::Grid::Draw(Fwog::Texture const& textureAlbedo, Fwog::Sampler co
 
     Fwog::Cmd::BindVertexBuffer(0, *voxelMeshBufferRef->vertexBuffer, 0, sizeof(Albuquerque::Primitives::Vertex));
     Fwog::Cmd::BindIndexBuffer(*voxelMeshBufferRef->indexBuffer, Fwog::IndexType::UNSIGNED_INT);
-    Fwog::Cmd::DrawIndexed(voxelMeshBufferRef->indexCount, voxelGrid.size(), 0, 0, 0);
+    culler->Draw();
 }
 
@@ -2,6 +2,7 @@
 
 #include <Albuquerque/Application.hpp>
 #include <Albuquerque/Camera.hpp>
+#include <Albuquerque/DebugDraw.hpp>
 #include <Albuquerque/DrawObject.hpp>
 #include <Voxel.hpp>
 
@@ -58,43 +59,6 @@ struct GameObject
 
 
 
-//More for debug lines and stuff I guess? Can have multiple instances. I'll make this a class later
-class LineRendererFwog
-{
-public:
-    LineRendererFwog();
-
-    void AddPoint(glm::vec3 point_position, glm::vec3 point_color = default_line_color);
-    void Clear();
-
-    //To Do: Decouple this from viewData
-    void Draw(ViewData const& viewData);
-
-private:
-
-    static constexpr size_t maxPoints = 1024;
-    static constexpr glm::vec3 default_line_color = glm::vec3(1.0f, 0.0f, 0.0f);
-
-    std::optional<Fwog::GraphicsPipeline> pipeline;
-
-    //These points are passed in in worldspace coordinates
-    std::optional<Fwog::TypedBuffer<glm::vec3>> vertex_buffer;
-    std::optional<Fwog::TypedBuffer<glm::vec3>> color_buffer;
-
-    size_t point_count = 0;
-
-
-    struct Tests
-    {
-        //Must be called after Fwog is initalized
-        //static void TestAddRemove();
-    };
-
-};
-
-
-
-
 class PlaygroundApplication final : public Albuquerque::Application
 {
 public:
@@ -150,5 +114,9 @@ private:
     std::optional<VoxelStuff::Grid> voxelGrid_;
 
 
-    std::optional<LineRendererFwog> line_renderer;
+    std::optional<Albuquerque::DebugDraw> debug_draw;
+
+    //Last mouse raycast, drawn every frame until the next click
+    bool has_raycast_line = false;
+    glm::vec3 raycast_line_end = glm::vec3(0.0f);
 };
\ No newline at end of file
@@ -23,23 +23,29 @@
 #include <Albuquerque/FwogHelpers.hpp>
 #include <Albuquerque/DrawObject.hpp>
 #include <Albuquerque/Primitives.hpp>
+#include <Albuquerque/UniformRing.hpp>
+#include <Albuquerque/GpuCulling.hpp>
 
 //Temporarily here before I move it again
 struct ViewData
 {
-    ViewData();
-
     struct ViewUniform {
         glm::mat4 viewProj;
         glm::vec3 eyePos;
     };
 
-    std::optional<Fwog::TypedBuffer<ViewUniform>> viewBuffer;
+    ViewUniform viewUniform{};
 
     //Skybox doesn't have translation
-    std::optional<Fwog::TypedBuffer<ViewUniform>> skyboxBuffer;
+    ViewUniform skyboxUniform{};
+
+    //Where this frame's copies live in the uniform ring, set by Stream
+    Albuquerque::UniformSlice viewSlice;
+    Albuquerque::UniformSlice skyboxSlice;
 
     void Update(Albuquerque::Camera const& camera);
+    //Once per frame before anything binds the slices
+    void Stream(Albuquerque::UniformRing& ring);
 };
 
 namespace VoxelStuff
@@ -96,8 +102,13 @@ namespace VoxelStuff
 
         std::optional<Fwog::GraphicsPipeline> pipeline;
 
+        //Frustum culls the voxels on the GPU, Draw only draws what is left
+        std::optional<Albuquerque::GpuCuller> culler;
+
         void Update();
 
+        //Has to be before the render pass Draw is in
+        void Cull(ViewData const& viewData, Albuquerque::UniformRing& frameUniforms);
         void Draw(Fwog::Texture const& textureAlbedo, Fwog::Sampler const& sampler, ViewData const& viewData);
 
         glm::vec3 gridOrigin = glm::vec3(0.0f, 0.0f, 0.0f);